@@ -62,6 +62,58 @@ class Buffer {
     this->size = data.size();
   }
 
+  // allocate `length` elements of T without initializing them
+  template <typename T>
+  void allocate(std::size_t length, GLenum usage) {
+    glNamedBufferData(this->buffer, sizeof(T) * length, nullptr, usage);
+    this->size = length;
+  }
+
+  // allocate immutable storage for `length` elements of T
+  // NOTE: immutable storage can not be respecified, so the buffer object is
+  // recreated
+  template <typename T>
+  void setStorage(std::size_t length, GLbitfield flags,
+                  const T* data = nullptr) {
+    release();
+    glCreateBuffers(1, &buffer);
+    glNamedBufferStorage(this->buffer, sizeof(T) * length, data, flags);
+    this->size = length;
+  }
+
+  template <typename T>
+  void setSubData(const T* data, std::size_t offset, std::size_t length) const {
+    glNamedBufferSubData(this->buffer, sizeof(T) * offset, sizeof(T) * length,
+                         data);
+  }
+
+  template <typename T>
+  void getSubData(T* data, std::size_t offset, std::size_t length) const {
+    glGetNamedBufferSubData(this->buffer, sizeof(T) * offset,
+                            sizeof(T) * length, data);
+  }
+
+  // copy `length` elements of T from another buffer
+  template <typename T>
+  void copySubData(const Buffer& source, std::size_t sourceOffset,
+                   std::size_t offset, std::size_t length) const {
+    glCopyNamedBufferSubData(source.buffer, this->buffer,
+                             sizeof(T) * sourceOffset, sizeof(T) * offset,
+                             sizeof(T) * length);
+  }
+
+  void* mapRange(GLintptr offset, GLsizeiptr length, GLbitfield access) const {
+    return glMapNamedBufferRange(this->buffer, offset, length, access);
+  }
+
+  void unmap() const { glUnmapNamedBuffer(this->buffer); }
+
+  // fill with zeros, size in bytes must be a multiple of 4
+  void clear() const {
+    glClearNamedBufferData(this->buffer, GL_R32UI, GL_RED_INTEGER,
+                           GL_UNSIGNED_INT, nullptr);
+  }
+
   void bindToShaderStorageBuffer(GLuint binding_point_index) const {
     glBindBufferBase(GL_SHADER_STORAGE_BUFFER, binding_point_index, buffer);
   }
@@ -0,0 +1,118 @@
+#ifndef _GCSS_GPU_TIMER_H
+#define _GCSS_GPU_TIMER_H
+#include <array>
+
+#include "glad/gl.h"
+
+namespace gcss {
+
+// GPU time between begin and end measured with timestamp queries, so that
+// timers may overlap. results are polled a few frames later without
+// stalling.
+class GpuTimer {
+ private:
+  static constexpr std::size_t N_QUERIES = 4;
+
+  struct Query {
+    GLuint begin = 0;
+    GLuint end = 0;
+    bool pending = false;
+    // queries issued before resetAverage are not averaged
+    uint64_t generation = 0;
+  };
+
+  std::array<Query, N_QUERIES> queries;
+  // index of the next query to issue and of the oldest pending one
+  std::size_t next;
+  std::size_t oldest;
+
+  // milliseconds
+  double last;
+  double average;
+  uint64_t nSamples;
+  uint64_t generation;
+
+ public:
+  GpuTimer()
+      : next{0},
+        oldest{0},
+        last{0},
+        average{0},
+        nSamples{0},
+        generation{0} {
+    for (auto& query : queries) {
+      glCreateQueries(GL_TIMESTAMP, 1, &query.begin);
+      glCreateQueries(GL_TIMESTAMP, 1, &query.end);
+    }
+  }
+
+  GpuTimer(const GpuTimer& other) = delete;
+
+  ~GpuTimer() {
+    for (auto& query : queries) {
+      glDeleteQueries(1, &query.begin);
+      glDeleteQueries(1, &query.end);
+    }
+  }
+
+  GpuTimer& operator=(const GpuTimer& other) = delete;
+
+  // the measurement is dropped if every query is still pending
+  void begin() {
+    if (queries[next].pending) {
+      return;
+    }
+    glQueryCounter(queries[next].begin, GL_TIMESTAMP);
+  }
+
+  void end() {
+    if (queries[next].pending) {
+      return;
+    }
+    glQueryCounter(queries[next].end, GL_TIMESTAMP);
+    queries[next].pending = true;
+    queries[next].generation = generation;
+    next = (next + 1) % N_QUERIES;
+  }
+
+  // collect finished measurements in order
+  void poll() {
+    while (queries[oldest].pending) {
+      Query& query = queries[oldest];
+      GLint available = 0;
+      glGetQueryObjectiv(query.end, GL_QUERY_RESULT_AVAILABLE, &available);
+      if (!available) {
+        break;
+      }
+
+      GLuint64 begin_ns, end_ns;
+      glGetQueryObjectui64v(query.begin, GL_QUERY_RESULT, &begin_ns);
+      glGetQueryObjectui64v(query.end, GL_QUERY_RESULT, &end_ns);
+      last = 1e-6 * static_cast<double>(end_ns - begin_ns);
+
+      // exponential moving average
+      if (query.generation == generation) {
+        average = nSamples == 0 ? last : 0.9 * average + 0.1 * last;
+        nSamples++;
+      }
+
+      query.pending = false;
+      oldest = (oldest + 1) % N_QUERIES;
+    }
+  }
+
+  // last finished measurement in milliseconds
+  double getLast() const { return last; }
+
+  double getAverage() const { return average; }
+  uint64_t getNumberOfSamples() const { return nSamples; }
+  void resetAverage() {
+    average = 0;
+    nSamples = 0;
+    generation++;
+  }
+};
+
+}  // namespace gcss
+
+#endif
@@ -0,0 +1,244 @@
+#ifndef _GCSS_MAPPED_FILE_H
+#define _GCSS_MAPPED_FILE_H
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+
+#include "spdlog/spdlog.h"
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace gcss {
+
+// memory mapping of a whole file, read-only unless created with create
+class MappedFile {
+ private:
+  std::byte* data;
+  std::size_t size;
+  bool writable;
+#ifdef _WIN32
+  HANDLE file;
+  HANDLE mapping;
+#else
+  int fd;
+#endif
+
+ public:
+  MappedFile()
+      : data{nullptr},
+        size{0},
+        writable{false},
+#ifdef _WIN32
+        file{INVALID_HANDLE_VALUE},
+        mapping{nullptr}
+#else
+        fd{-1}
+#endif
+  {
+  }
+
+  MappedFile(const std::filesystem::path& filepath) : MappedFile() {
+    open(filepath);
+  }
+
+  MappedFile(const MappedFile& other) = delete;
+
+  MappedFile(MappedFile&& other)
+      : data(other.data),
+        size(other.size),
+        writable(other.writable),
+#ifdef _WIN32
+        file(other.file),
+        mapping(other.mapping)
+#else
+        fd(other.fd)
+#endif
+  {
+    other.data = nullptr;
+    other.size = 0;
+    other.writable = false;
+#ifdef _WIN32
+    other.file = INVALID_HANDLE_VALUE;
+    other.mapping = nullptr;
+#else
+    other.fd = -1;
+#endif
+  }
+
+  ~MappedFile() { release(); }
+
+  MappedFile& operator=(const MappedFile& other) = delete;
+
+  MappedFile& operator=(MappedFile&& other) {
+    if (this != &other) {
+      release();
+
+      data = other.data;
+      size = other.size;
+      writable = other.writable;
+#ifdef _WIN32
+      file = other.file;
+      mapping = other.mapping;
+      other.file = INVALID_HANDLE_VALUE;
+      other.mapping = nullptr;
+#else
+      fd = other.fd;
+      other.fd = -1;
+#endif
+
+      other.data = nullptr;
+      other.size = 0;
+      other.writable = false;
+    }
+
+    return *this;
+  }
+
+  bool open(const std::filesystem::path& filepath) {
+    release();
+
+    const std::string filepath_str = filepath.generic_string();
+#ifdef _WIN32
+    file = CreateFileW(filepath.c_str(), GENERIC_READ, FILE_SHARE_READ,
+                       nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+      spdlog::error("[MappedFile] failed to open {}", filepath_str);
+      return false;
+    }
+    LARGE_INTEGER file_size;
+    GetFileSizeEx(file, &file_size);
+    size = static_cast<std::size_t>(file_size.QuadPart);
+    if (size > 0) {
+      mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+      data = mapping ? static_cast<std::byte*>(
+                           MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0))
+                     : nullptr;
+    }
+#else
+    fd = ::open(filepath_str.c_str(), O_RDONLY);
+    if (fd < 0) {
+      spdlog::error("[MappedFile] failed to open {}", filepath_str);
+      return false;
+    }
+    struct stat st;
+    fstat(fd, &st);
+    size = static_cast<std::size_t>(st.st_size);
+    if (size > 0) {
+      void* ptr = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+      data = ptr != MAP_FAILED ? static_cast<std::byte*>(ptr) : nullptr;
+    }
+#endif
+
+    if (size > 0 && !data) {
+      spdlog::error("[MappedFile] failed to map {}", filepath_str);
+      release();
+      return false;
+    }
+
+    return true;
+  }
+
+  // create or truncate a file of `size` bytes and map it for reading and
+  // writing. pages are written back by the OS, e.g. to keep data larger than
+  // RAM.
+  bool create(const std::filesystem::path& filepath, std::size_t size) {
+    release();
+
+    const std::string filepath_str = filepath.generic_string();
+#ifdef _WIN32
+    file = CreateFileW(filepath.c_str(), GENERIC_READ | GENERIC_WRITE, 0,
+                       nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+      spdlog::error("[MappedFile] failed to create {}", filepath_str);
+      return false;
+    }
+    this->size = size;
+    if (size > 0) {
+      const uint64_t size64 = size;
+      mapping = CreateFileMappingW(file, nullptr, PAGE_READWRITE,
+                                   static_cast<DWORD>(size64 >> 32),
+                                   static_cast<DWORD>(size64), nullptr);
+      data = mapping ? static_cast<std::byte*>(
+                           MapViewOfFile(mapping, FILE_MAP_WRITE, 0, 0, 0))
+                     : nullptr;
+    }
+#else
+    fd = ::open(filepath_str.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+      spdlog::error("[MappedFile] failed to create {}", filepath_str);
+      return false;
+    }
+    this->size = size;
+    if (size > 0) {
+      void* ptr = ftruncate(fd, size) == 0
+                      ? mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED,
+                             fd, 0)
+                      : MAP_FAILED;
+      data = ptr != MAP_FAILED ? static_cast<std::byte*>(ptr) : nullptr;
+    }
+#endif
+
+    if (size > 0 && !data) {
+      spdlog::error("[MappedFile] failed to map {}", filepath_str);
+      release();
+      return false;
+    }
+    writable = true;
+
+    return true;
+  }
+
+  void release() {
+#ifdef _WIN32
+    if (data) {
+      UnmapViewOfFile(data);
+    }
+    if (mapping) {
+      CloseHandle(mapping);
+      mapping = nullptr;
+    }
+    if (file != INVALID_HANDLE_VALUE) {
+      CloseHandle(file);
+      file = INVALID_HANDLE_VALUE;
+    }
+#else
+    if (data) {
+      munmap(data, size);
+    }
+    if (fd >= 0) {
+      ::close(fd);
+      fd = -1;
+    }
+#endif
+    data = nullptr;
+    size = 0;
+    writable = false;
+  }
+
+  bool isOpen() const {
+#ifdef _WIN32
+    return file != INVALID_HANDLE_VALUE;
+#else
+    return fd >= 0;
+#endif
+  }
+
+  const std::byte* getData() const { return data; }
+
+  // nullptr unless the file was created with create
+  std::byte* getWritableData() { return writable ? data : nullptr; }
+
+  std::size_t getSize() const { return size; }
+};
+
+}  // namespace gcss
+
+#endif
@@ -0,0 +1,138 @@
+#ifndef _GCSS_MORTON_REORDER_H
+#define _GCSS_MORTON_REORDER_H
+#include <cmath>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "glad/gl.h"
+#include "glm/glm.hpp"
+//
+#include "buffer.h"
+#include "radix-sort.h"
+#include "shader.h"
+
+namespace gcss {
+
+// cost and benefit of the last reorder, in milliseconds of GPU time
+struct ReorderReport {
+  double reorderTime = 0;
+  // average time of a frame before and since the last reorder
+  double frameTimeBefore = 0;
+  double frameTimeAfter = 0;
+
+  // frames until the reorder pays for itself, negative if it does not
+  double getBreakEvenFrames() const {
+    const double saving = frameTimeBefore - frameTimeAfter;
+    return saving > 0 ? reorderTime / saving : -1;
+  }
+};
+
+// sorts particles along a Morton curve over their bounding box, so that
+// neighboring threads read nearby particles and rasterize nearby points.
+// particles are arrays of `stride` vec4s starting with the position.
+class MortonReorder {
+ private:
+  // 30 or 63
+  uint32_t bits;
+
+  ComputeShader computeBounds;
+  Pipeline computeBoundsPipeline;
+  ComputeShader computeMortonCodes;
+  Pipeline computeMortonCodesPipeline;
+  ComputeShader permuteParticles;
+  Pipeline permuteParticlesPipeline;
+  RadixSort sort;
+
+  Buffer bounds;
+  Buffer codes;
+  // old index of each new position
+  Buffer indices;
+  Buffer permuted;
+
+  static std::filesystem::path getShaderPath(const std::string& filename) {
+    return std::filesystem::path(CMAKE_SOURCE_DIR) / "shaders" / "reorder" /
+           filename;
+  }
+
+ public:
+  MortonReorder()
+      : bits{30},
+        computeBounds{getShaderPath("compute-bounds.comp")},
+        computeMortonCodes{getShaderPath("compute-morton-codes.comp")},
+        permuteParticles{getShaderPath("permute-particles.comp")} {
+    computeBoundsPipeline.attachComputeShader(computeBounds);
+    computeMortonCodesPipeline.attachComputeShader(computeMortonCodes);
+    permuteParticlesPipeline.attachComputeShader(permuteParticles);
+
+    bounds.setData(std::vector<GLuint>(6), GL_DYNAMIC_COPY);
+  }
+
+  uint32_t getBits() const { return bits; }
+  // 30 bit codes sort in 8 passes, 63 bit codes in 16
+  void setBits(uint32_t bits) { this->bits = bits > 30 ? 63 : 30; }
+
+  // sort particles by Morton code and permute them. binding points 0 to 4 are
+  // overwritten.
+  void reorder(const Buffer& particles, uint32_t nParticles, uint32_t stride) {
+    if (codes.getLength() < nParticles) {
+      codes.allocate<glm::uvec2>(nParticles, GL_DYNAMIC_COPY);
+      indices.allocate<GLuint>(nParticles, GL_DYNAMIC_COPY);
+    }
+
+    // bounding box
+    const GLuint initial_bounds[6] = {0xffffffff, 0xffffffff, 0xffffffff,
+                                      0,          0,          0};
+    bounds.setSubData(initial_bounds, 0, 6);
+    particles.bindToShaderStorageBuffer(0);
+    bounds.bindToShaderStorageBuffer(1);
+    computeBounds.setUniform("nParticles", nParticles);
+    computeBounds.setUniform("stride", stride);
+    computeBoundsPipeline.activate();
+    glDispatchCompute(std::ceil(nParticles / 128.0f), 1, 1);
+    computeBoundsPipeline.deactivate();
+
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+    // codes and identity permutation
+    codes.bindToShaderStorageBuffer(2);
+    indices.bindToShaderStorageBuffer(3);
+    computeMortonCodes.setUniform("nParticles", nParticles);
+    computeMortonCodes.setUniform("stride", stride);
+    computeMortonCodes.setUniform("bits", bits);
+    computeMortonCodesPipeline.activate();
+    glDispatchCompute(std::ceil(nParticles / 128.0f), 1, 1);
+    computeMortonCodesPipeline.deactivate();
+
+    sort.sort(codes, indices, nParticles, bits);
+
+    permute(particles, nParticles, stride);
+  }
+
+  // apply the permutation of the last reorder to particles, e.g. to another
+  // buffer of per particle state
+  void permute(const Buffer& particles, uint32_t nParticles, uint32_t stride) {
+    if (permuted.getLength() < nParticles * stride) {
+      permuted.allocate<glm::vec4>(nParticles * stride, GL_DYNAMIC_COPY);
+    }
+
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+    particles.bindToShaderStorageBuffer(0);
+    permuted.bindToShaderStorageBuffer(1);
+    indices.bindToShaderStorageBuffer(3);
+    permuteParticles.setUniform("nParticles", nParticles);
+    permuteParticles.setUniform("stride", stride);
+    permuteParticlesPipeline.activate();
+    glDispatchCompute(std::ceil(nParticles / 128.0f), 1, 1);
+    permuteParticlesPipeline.deactivate();
+
+    glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+    particles.copySubData<glm::vec4>(permuted, 0, 0, nParticles * stride);
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+  }
+};
+
+}  // namespace gcss
+
+#endif
@@ -0,0 +1,224 @@
+#ifndef _GCSS_POINT_SPLATTER_H
+#define _GCSS_POINT_SPLATTER_H
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <vector>
+
+#include "glad/gl.h"
+#include "glm/glm.hpp"
+//
+#include "buffer.h"
+#include "quad.h"
+#include "scan.h"
+#include "shader.h"
+#include "texture.h"
+
+namespace gcss {
+
+// renders particles with compute shaders instead of GL_POINTS. particles are
+// projected and culled by a sandbox specific shader which calls emitPoint of
+// shaders/splatting/emit-point.glsl, binned into screen tiles, accumulated
+// with shared memory atomics, blurred to the point size and tone mapped. the
+// cost of rasterization does not depend on the point size.
+class PointSplatter {
+ private:
+  // same as TILE_SIZE in shaders/splatting/splatting.glsl
+  static constexpr uint32_t TILE_SIZE = 16;
+  static constexpr int MAX_RADIUS = 32;
+
+  glm::uvec2 resolution;
+  glm::uvec2 nTiles;
+  float pointSize;
+  float intensity;
+  float exposure;
+
+  ComputeShader projectPoints;
+  Pipeline projectPointsPipeline;
+  ExclusiveScan scan;
+  ComputeShader scatterPoints;
+  Pipeline scatterPointsPipeline;
+  ComputeShader rasterizeTiles;
+  Pipeline rasterizeTilesPipeline;
+  ComputeShader blurSplats;
+  Pipeline blurSplatsPipeline;
+  ComputeShader resolveSplats;
+  Pipeline resolveSplatsPipeline;
+
+  Buffer header;
+  Buffer tileCounts;
+  Buffer tileOffsets;
+  Buffer points;
+  Buffer sortedPoints;
+
+  Texture accumulation;
+  Texture blurred;
+  Texture output;
+
+  Quad quad;
+  VertexShader displayVertexShader;
+  FragmentShader displayFragmentShader;
+  Pipeline displayPipeline;
+
+  static std::filesystem::path getShaderPath(const std::string& filename) {
+    return std::filesystem::path(CMAKE_SOURCE_DIR) / "shaders" / "splatting" /
+           filename;
+  }
+
+  void blur(const Texture& in, const Texture& out,
+            const glm::vec2& direction) const {
+    const int radius =
+        std::min(static_cast<int>(std::ceil(0.5f * pointSize)), MAX_RADIUS);
+    const float sigma = std::max(radius / 3.0f, 0.5f);
+
+    in.bindToImageUnit(0, GL_READ_ONLY);
+    out.bindToImageUnit(1, GL_WRITE_ONLY);
+    blurSplats.setUniform("direction", direction);
+    blurSplats.setUniform("radius", radius);
+    blurSplats.setUniform("sigma", sigma);
+    blurSplatsPipeline.activate();
+    glDispatchCompute(std::ceil(resolution.x / 8.0f),
+                      std::ceil(resolution.y / 8.0f), 1);
+    blurSplatsPipeline.deactivate();
+
+    glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+  }
+
+ public:
+  // projectShader must include splatting/emit-point.glsl and read particles
+  // from binding 0
+  PointSplatter(const std::filesystem::path& projectShader)
+      : resolution{0},
+        nTiles{0},
+        pointSize{8.0f},
+        intensity{1.0f},
+        exposure{1.0f},
+        projectPoints{projectShader},
+        scatterPoints{getShaderPath("scatter-points.comp")},
+        rasterizeTiles{getShaderPath("rasterize-tiles.comp")},
+        blurSplats{getShaderPath("blur-splats.comp")},
+        resolveSplats{getShaderPath("resolve-splats.comp")},
+        displayVertexShader{getShaderPath("display.vert")},
+        displayFragmentShader{getShaderPath("display.frag")} {
+    projectPointsPipeline.attachComputeShader(projectPoints);
+    scatterPointsPipeline.attachComputeShader(scatterPoints);
+    rasterizeTilesPipeline.attachComputeShader(rasterizeTiles);
+    blurSplatsPipeline.attachComputeShader(blurSplats);
+    resolveSplatsPipeline.attachComputeShader(resolveSplats);
+
+    displayPipeline.attachVertexShader(displayVertexShader);
+    displayPipeline.attachFragmentShader(displayFragmentShader);
+
+    header.setData(std::vector<GLuint>(1), GL_DYNAMIC_COPY);
+
+    setResolution(glm::uvec2(512, 512));
+  }
+
+  // set sandbox specific uniforms, e.g. viewProjection
+  const ComputeShader& getProjectShader() const { return projectPoints; }
+
+  // diameter of a point in pixels
+  float getPointSize() const { return pointSize; }
+  void setPointSize(float pointSize) {
+    this->pointSize = std::max(pointSize, 0.0f);
+  }
+
+  float getIntensity() const { return intensity; }
+  void setIntensity(float intensity) { this->intensity = intensity; }
+
+  float getExposure() const { return exposure; }
+  void setExposure(float exposure) { this->exposure = exposure; }
+
+  void setResolution(const glm::uvec2& resolution) {
+    if (resolution == this->resolution || resolution.x == 0 ||
+        resolution.y == 0) {
+      return;
+    }
+    this->resolution = resolution;
+    nTiles = (resolution + glm::uvec2(TILE_SIZE - 1)) / TILE_SIZE;
+
+    const uint32_t n_tiles = nTiles.x * nTiles.y;
+    tileCounts.setData(std::vector<GLuint>(n_tiles), GL_DYNAMIC_COPY);
+    tileOffsets.setData(std::vector<GLuint>(n_tiles + 1), GL_DYNAMIC_COPY);
+
+    accumulation.initImage(resolution, GL_RGBA32F, GL_RGBA, GL_FLOAT);
+    blurred.initImage(resolution, GL_RGBA32F, GL_RGBA, GL_FLOAT);
+    output.initImage(resolution, GL_RGBA32F, GL_RGBA, GL_FLOAT);
+  }
+
+  // draw particles to the current framebuffer
+  void render(const Buffer& particles, uint32_t nParticles) {
+    if (points.getLength() < 4 * nParticles) {
+      points.setData(std::vector<GLuint>(4 * nParticles), GL_DYNAMIC_COPY);
+      sortedPoints.setData(std::vector<GLuint>(4 * nParticles),
+                           GL_DYNAMIC_COPY);
+    }
+
+    const glm::vec2 resolution_f = glm::vec2(resolution);
+    const uint32_t n_tiles = nTiles.x * nTiles.y;
+
+    header.clear();
+    tileCounts.clear();
+
+    particles.bindToShaderStorageBuffer(0);
+    header.bindToShaderStorageBuffer(4);
+    tileCounts.bindToShaderStorageBuffer(5);
+    points.bindToShaderStorageBuffer(6);
+
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+    // project, cull and count points per tile
+    projectPoints.setUniform("nParticles", nParticles);
+    projectPoints.setUniform("resolution", resolution_f);
+    projectPointsPipeline.activate();
+    glDispatchCompute(std::ceil(nParticles / 128.0f), 1, 1);
+    projectPointsPipeline.deactivate();
+
+    // offsets of tiles in sorted points
+    scan.run(tileCounts, tileOffsets, n_tiles);
+
+    // sort points by tile
+    tileOffsets.bindToShaderStorageBuffer(7);
+    sortedPoints.bindToShaderStorageBuffer(8);
+    scatterPoints.setUniform("resolution", resolution_f);
+    scatterPointsPipeline.activate();
+    glDispatchCompute(std::ceil(nParticles / 128.0f), 1, 1);
+    scatterPointsPipeline.deactivate();
+
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+    // accumulate points of each tile
+    accumulation.bindToImageUnit(0, GL_WRITE_ONLY);
+    rasterizeTiles.setUniform("resolution", resolution_f);
+    rasterizeTiles.setUniform("intensity", intensity);
+    rasterizeTilesPipeline.activate();
+    glDispatchCompute(nTiles.x, nTiles.y, 1);
+    rasterizeTilesPipeline.deactivate();
+
+    glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+
+    // spread points to the point size
+    if (pointSize > 1.0f) {
+      blur(accumulation, blurred, glm::vec2(1, 0));
+      blur(blurred, accumulation, glm::vec2(0, 1));
+    }
+
+    // tone mapping
+    accumulation.bindToImageUnit(0, GL_READ_ONLY);
+    output.bindToImageUnit(1, GL_WRITE_ONLY);
+    resolveSplats.setUniform("exposure", exposure);
+    resolveSplatsPipeline.activate();
+    glDispatchCompute(std::ceil(resolution.x / 8.0f),
+                      std::ceil(resolution.y / 8.0f), 1);
+    resolveSplatsPipeline.deactivate();
+
+    glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+
+    output.bindToTextureUnit(0);
+    quad.draw(displayPipeline);
+  }
+};
+
+}  // namespace gcss
+
+#endif
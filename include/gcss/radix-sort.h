@@ -0,0 +1,119 @@
+#ifndef _GCSS_RADIX_SORT_H
+#define _GCSS_RADIX_SORT_H
+#include <filesystem>
+#include <string>
+#include <utility>
+
+#include "glad/gl.h"
+#include "glm/glm.hpp"
+//
+#include "buffer.h"
+#include "scan.h"
+#include "shader.h"
+
+namespace gcss {
+
+// stable LSD radix sort of uvec2 keys (low word first) and uint values on the
+// GPU. every pass sorts 4 bits: a histogram of digits per block, a scan of
+// the histograms and a scatter which ranks keys within a block.
+class RadixSort {
+ private:
+  // same as shaders/sort/radix-sort.glsl
+  static constexpr uint32_t RADIX_BITS = 4;
+  static constexpr uint32_t RADIX = 1 << RADIX_BITS;
+  static constexpr uint32_t BLOCK_SIZE = 1024;
+
+  ComputeShader histogram;
+  Pipeline histogramPipeline;
+  ComputeShader scatter;
+  Pipeline scatterPipeline;
+  ExclusiveScan scan;
+
+  Buffer blockCounts;
+  Buffer blockOffsets;
+  Buffer keysTemp;
+  Buffer valuesTemp;
+
+  static std::filesystem::path getShaderPath(const std::string& filename) {
+    return std::filesystem::path(CMAKE_SOURCE_DIR) / "shaders" / "sort" /
+           filename;
+  }
+
+ public:
+  RadixSort()
+      : histogram{getShaderPath("radix-histogram.comp")},
+        scatter{getShaderPath("radix-scatter.comp")} {
+    histogramPipeline.attachComputeShader(histogram);
+    scatterPipeline.attachComputeShader(scatter);
+  }
+
+  // sort by the lower `bits` bits of keys and permute values along. binding
+  // points 0 to 4 are overwritten.
+  void sort(const Buffer& keys, const Buffer& values, uint32_t n,
+            uint32_t bits) {
+    const uint32_t n_blocks = (n + BLOCK_SIZE - 1) / BLOCK_SIZE;
+    const uint32_t n_passes = (bits + RADIX_BITS - 1) / RADIX_BITS;
+    if (n == 0 || n_passes == 0) {
+      return;
+    }
+
+    if (keysTemp.getLength() < n) {
+      keysTemp.allocate<glm::uvec2>(n, GL_DYNAMIC_COPY);
+      valuesTemp.allocate<GLuint>(n, GL_DYNAMIC_COPY);
+    }
+    if (blockCounts.getLength() < RADIX * n_blocks) {
+      blockCounts.allocate<GLuint>(RADIX * n_blocks, GL_DYNAMIC_COPY);
+      blockOffsets.allocate<GLuint>(RADIX * n_blocks + 1, GL_DYNAMIC_COPY);
+    }
+
+    histogram.setUniform("n", n);
+    histogram.setUniform("nBlocks", n_blocks);
+    scatter.setUniform("n", n);
+    scatter.setUniform("nBlocks", n_blocks);
+
+    const Buffer* keys_in = &keys;
+    const Buffer* values_in = &values;
+    const Buffer* keys_out = &keysTemp;
+    const Buffer* values_out = &valuesTemp;
+    for (uint32_t pass = 0; pass < n_passes; ++pass) {
+      const uint32_t shift = pass * RADIX_BITS;
+
+      glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+      keys_in->bindToShaderStorageBuffer(0);
+      blockCounts.bindToShaderStorageBuffer(2);
+      histogram.setUniform("shift", shift);
+      histogramPipeline.activate();
+      glDispatchCompute(n_blocks, 1, 1);
+      histogramPipeline.deactivate();
+
+      scan.run(blockCounts, blockOffsets, RADIX * n_blocks);
+
+      keys_in->bindToShaderStorageBuffer(0);
+      values_in->bindToShaderStorageBuffer(1);
+      blockOffsets.bindToShaderStorageBuffer(2);
+      keys_out->bindToShaderStorageBuffer(3);
+      values_out->bindToShaderStorageBuffer(4);
+      scatter.setUniform("shift", shift);
+      scatterPipeline.activate();
+      glDispatchCompute(n_blocks, 1, 1);
+      scatterPipeline.deactivate();
+
+      std::swap(keys_in, keys_out);
+      std::swap(values_in, values_out);
+    }
+
+    // result of an odd number of passes is in the temporary buffers
+    if (keys_in != &keys) {
+      glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+      keys.copySubData<glm::uvec2>(keysTemp, 0, 0, n);
+      values.copySubData<GLuint>(valuesTemp, 0, 0, n);
+    }
+
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+  }
+};
+
+}  // namespace gcss
+
+#endif
@@ -0,0 +1,37 @@
+#ifndef _GCSS_RANDOM_H
+#define _GCSS_RANDOM_H
+#include <cstdint>
+
+namespace gcss {
+
+// PCG hash, Jarzynski and Olano 2020
+inline uint32_t pcgHash(uint32_t x) {
+  const uint32_t state = x * 747796405u + 2891336453u;
+  const uint32_t word = ((state >> ((state >> 28u) + 4u)) ^ state) * 277803737u;
+  return (word >> 22u) ^ word;
+}
+
+// counter based random numbers. the n-th number of a stream only depends on
+// the seed, the index of the stream and n, and shaders/random/random.glsl
+// gives bit identical streams on the GPU.
+class Random {
+ private:
+  uint32_t key;
+  uint32_t counter;
+
+ public:
+  // index selects the stream, e.g. one per particle
+  Random(uint32_t seed, uint32_t index)
+      : key{pcgHash(pcgHash(seed) + index)}, counter{0} {}
+
+  uint32_t nextUint() { return pcgHash(key ^ pcgHash(counter++)); }
+
+  // [0, 1) in multiples of 2^-24, exact on both sides
+  float nextFloat() {
+    return static_cast<float>(nextUint() >> 8) / 16777216.0f;
+  }
+};
+
+}  // namespace gcss
+
+#endif
@@ -0,0 +1,154 @@
+#ifndef _GCSS_READBACK_H
+#define _GCSS_READBACK_H
+#include <cstddef>
+#include <limits>
+#include <vector>
+
+#include "glad/gl.h"
+#include "spdlog/spdlog.h"
+//
+#include "buffer.h"
+
+namespace gcss {
+
+// ring of persistently mapped staging buffers. GPU buffers are copied into a
+// free slot and a fence is inserted, the data is handed to the caller once the
+// fence has been signaled, so that the pipeline is never stalled by readback.
+class AsyncReadback {
+ public:
+  struct Region {
+    const Buffer* buffer;
+    GLintptr offset;
+    GLsizeiptr size;
+  };
+
+ private:
+  struct Slot {
+    Buffer staging;
+    GLsizeiptr capacity = 0;
+    GLsizeiptr size = 0;
+    const std::byte* mapped = nullptr;
+    GLsync fence = nullptr;
+    uint64_t tag = 0;
+  };
+
+  std::vector<Slot> slots;
+  // index of the oldest in-flight slot
+  std::size_t head;
+  std::size_t nInFlight;
+
+  void allocate(Slot& slot, GLsizeiptr size) {
+    if (slot.mapped) {
+      slot.staging.unmap();
+    }
+
+    const GLbitfield flags =
+        GL_MAP_READ_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    slot.staging.setStorage<std::byte>(size, flags | GL_CLIENT_STORAGE_BIT);
+    slot.mapped = static_cast<const std::byte*>(
+        slot.staging.mapRange(0, size, flags));
+    slot.capacity = size;
+  }
+
+ public:
+  AsyncReadback(std::size_t nSlots = 3)
+      : slots(nSlots), head{0}, nInFlight{0} {}
+
+  AsyncReadback(const AsyncReadback& other) = delete;
+
+  ~AsyncReadback() { release(); }
+
+  AsyncReadback& operator=(const AsyncReadback& other) = delete;
+
+  void release() {
+    for (auto& slot : slots) {
+      if (slot.fence) {
+        glDeleteSync(slot.fence);
+        slot.fence = nullptr;
+      }
+      if (slot.mapped) {
+        slot.staging.unmap();
+        slot.mapped = nullptr;
+      }
+    }
+    nInFlight = 0;
+  }
+
+  std::size_t getNumberOfSlots() const { return slots.size(); }
+
+  std::size_t getNumberOfInFlight() const { return nInFlight; }
+
+  bool isFull() const { return nInFlight == slots.size(); }
+
+  // copy regions back to back into a free slot. returns false when every slot
+  // is still in flight, the caller decides whether to skip or to wait.
+  bool request(const std::vector<Region>& regions, uint64_t tag) {
+    if (isFull()) {
+      return false;
+    }
+
+    GLsizeiptr size = 0;
+    for (const auto& region : regions) {
+      size += region.size;
+    }
+
+    Slot& slot = slots[(head + nInFlight) % slots.size()];
+    if (slot.capacity < size) {
+      allocate(slot, size);
+    }
+
+    // make shader writes visible to the copy
+    glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+
+    GLintptr dst_offset = 0;
+    for (const auto& region : regions) {
+      glCopyNamedBufferSubData(region.buffer->getName(),
+                               slot.staging.getName(), region.offset,
+                               dst_offset, region.size);
+      dst_offset += region.size;
+    }
+    slot.size = size;
+    slot.tag = tag;
+    slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    nInFlight++;
+
+    return true;
+  }
+
+  // hand completed slots to callback(tag, data, size) in submission order.
+  // the data pointer is only valid during the callback.
+  template <typename F>
+  void poll(F&& callback, bool wait = false) {
+    while (nInFlight > 0) {
+      Slot& slot = slots[head];
+      const GLuint64 timeout =
+          wait ? std::numeric_limits<GLuint64>::max() : 0;
+      const GLenum status =
+          glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, timeout);
+      if (status == GL_TIMEOUT_EXPIRED) {
+        break;
+      }
+      if (status == GL_WAIT_FAILED) {
+        spdlog::error("[AsyncReadback] failed to wait fence");
+      }
+
+      glDeleteSync(slot.fence);
+      slot.fence = nullptr;
+
+      callback(slot.tag, slot.mapped, static_cast<std::size_t>(slot.size));
+
+      head = (head + 1) % slots.size();
+      nInFlight--;
+    }
+  }
+
+  // block until every in-flight slot has been handed out
+  template <typename F>
+  void flush(F&& callback) {
+    poll(std::forward<F>(callback), true);
+  }
+};
+
+}  // namespace gcss
+
+#endif
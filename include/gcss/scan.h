@@ -0,0 +1,103 @@
+#ifndef _GCSS_SCAN_H
+#define _GCSS_SCAN_H
+#include <deque>
+#include <filesystem>
+#include <string>
+
+#include "glad/gl.h"
+//
+#include "buffer.h"
+#include "shader.h"
+
+namespace gcss {
+
+// exclusive prefix sum of uints on the GPU. inputs up to a block are scanned
+// by a single workgroup, larger ones are reduced to block sums, which are
+// scanned the same way, and the blocks are then scanned in parallel with
+// their offsets.
+class ExclusiveScan {
+ private:
+  // same as BLOCK_SIZE in scan.glsl
+  static constexpr uint32_t BLOCK_SIZE = 4096;
+
+  ComputeShader exclusiveScan;
+  Pipeline exclusiveScanPipeline;
+  ComputeShader reduceBlocks;
+  Pipeline reduceBlocksPipeline;
+  ComputeShader scanBlocks;
+  Pipeline scanBlocksPipeline;
+
+  // block sums and their offsets of each level, a deque keeps the buffers
+  // of outer levels in place while inner ones are added
+  std::deque<Buffer> blockSums;
+  std::deque<Buffer> blockOffsets;
+
+  static std::filesystem::path getShaderPath(const std::string& filename) {
+    return std::filesystem::path(CMAKE_SOURCE_DIR) / "shaders" / "scan" /
+           filename;
+  }
+
+  void run(const Buffer& counts, const Buffer& offsets, uint32_t n,
+           std::size_t level) {
+    counts.bindToShaderStorageBuffer(0);
+    offsets.bindToShaderStorageBuffer(1);
+
+    if (n <= BLOCK_SIZE) {
+      exclusiveScan.setUniform("n", n);
+      exclusiveScanPipeline.activate();
+      glDispatchCompute(1, 1, 1);
+      exclusiveScanPipeline.deactivate();
+      glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+      return;
+    }
+
+    const uint32_t n_blocks = (n + BLOCK_SIZE - 1) / BLOCK_SIZE;
+    if (blockSums.size() <= level) {
+      blockSums.emplace_back();
+      blockOffsets.emplace_back();
+    }
+    if (blockSums[level].getLength() < n_blocks) {
+      blockSums[level].allocate<GLuint>(n_blocks, GL_DYNAMIC_COPY);
+      blockOffsets[level].allocate<GLuint>(n_blocks + 1, GL_DYNAMIC_COPY);
+    }
+
+    blockSums[level].bindToShaderStorageBuffer(2);
+    reduceBlocks.setUniform("n", n);
+    reduceBlocksPipeline.activate();
+    glDispatchCompute(n_blocks, 1, 1);
+    reduceBlocksPipeline.deactivate();
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+    run(blockSums[level], blockOffsets[level], n_blocks, level + 1);
+
+    counts.bindToShaderStorageBuffer(0);
+    offsets.bindToShaderStorageBuffer(1);
+    blockOffsets[level].bindToShaderStorageBuffer(3);
+    scanBlocks.setUniform("n", n);
+    scanBlocksPipeline.activate();
+    glDispatchCompute(n_blocks, 1, 1);
+    scanBlocksPipeline.deactivate();
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+  }
+
+ public:
+  ExclusiveScan()
+      : exclusiveScan{getShaderPath("exclusive-scan.comp")},
+        reduceBlocks{getShaderPath("reduce-blocks.comp")},
+        scanBlocks{getShaderPath("scan-blocks.comp")} {
+    exclusiveScanPipeline.attachComputeShader(exclusiveScan);
+    reduceBlocksPipeline.attachComputeShader(reduceBlocks);
+    scanBlocksPipeline.attachComputeShader(scanBlocks);
+  }
+
+  // offsets must have room for n + 1 elements, offsets[n] is the total.
+  // binding points 0 to 3 are overwritten.
+  void run(const Buffer& counts, const Buffer& offsets, uint32_t n) {
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+    run(counts, offsets, n, 0);
+  }
+};
+
+}  // namespace gcss
+
+#endif
@@ -1,10 +1,12 @@
 #ifndef _GCSS_SHADER_H
 #define _GCSS_SHADER_H
+#include <algorithm>
 #include <filesystem>
 #include <fstream>
 #include <iostream>
 #include <sstream>
 #include <variant>
+#include <vector>
 
 #include "glad/gl.h"
 #include "glm/glm.hpp"
@@ -29,9 +31,73 @@ class Shader {
                        std::istreambuf_iterator<char>());
   }
 
+  // included files are searched relative to the including file, then in
+  // shaders/ of the repository
+  static std::filesystem::path findInclude(
+      const std::filesystem::path& name,
+      const std::filesystem::path& directory) {
+    if (std::filesystem::exists(directory / name)) {
+      return std::filesystem::canonical(directory / name);
+    }
+#ifdef CMAKE_SOURCE_DIR
+    const std::filesystem::path shared =
+        std::filesystem::path(CMAKE_SOURCE_DIR) / "shaders" / name;
+    if (std::filesystem::exists(shared)) {
+      return std::filesystem::canonical(shared);
+    }
+#endif
+    spdlog::error("[Shader] failed to find include {}", name.generic_string());
+    std::exit(EXIT_FAILURE);
+  }
+
+  // expand #include "name" recursively, every file is included at most once
+  static std::string preprocess(const std::filesystem::path& filepath,
+                                std::vector<std::filesystem::path>& included) {
+    std::istringstream source(loadStringFromFile(filepath));
+    std::string result;
+    std::string line;
+    while (std::getline(source, line)) {
+      const std::size_t first = line.find_first_not_of(" \t");
+      if (first == std::string::npos ||
+          line.compare(first, 8, "#include") != 0) {
+        result += line + "\n";
+        continue;
+      }
+
+      const std::size_t begin = line.find('"', first);
+      const std::size_t end = line.find('"', begin + 1);
+      if (begin == std::string::npos || end == std::string::npos) {
+        spdlog::error("[Shader] invalid include in {}: {}",
+                      filepath.generic_string(), line);
+        std::exit(EXIT_FAILURE);
+      }
+
+      const std::filesystem::path include = findInclude(
+          line.substr(begin + 1, end - begin - 1), filepath.parent_path());
+      if (std::find(included.begin(), included.end(), include) ==
+          included.end()) {
+        included.push_back(include);
+        result += preprocess(include, included);
+      }
+    }
+    return result;
+  }
+
  public:
-  Shader(GLenum type, const std::filesystem::path& filepath) {
-    const std::string shader_source = loadStringFromFile(filepath);
+  // defines are source lines inserted after #version, e.g. "#define N 4\n",
+  // so that one file compiles into several variants
+  Shader(GLenum type, const std::filesystem::path& filepath,
+         const std::string& defines = "") {
+    std::vector<std::filesystem::path> included;
+    std::string shader_source = preprocess(filepath, included);
+    if (!defines.empty()) {
+      const std::size_t version = shader_source.find("#version");
+      const std::size_t line_end = version == std::string::npos
+                                       ? std::string::npos
+                                       : shader_source.find('\n', version);
+      shader_source.insert(line_end == std::string::npos ? 0 : line_end + 1,
+                           defines);
+    }
     const char* shader_source_c = shader_source.c_str();
     program = glCreateShaderProgramv(type, 1, &shader_source_c);
     spdlog::info("[Shader] program {:x} created", program);
@@ -82,7 +148,8 @@ class Shader {
 
   void setUniform(const std::string& uniform_name,
                   const std::variant<bool, GLint, GLuint, GLfloat, glm::vec2,
-                                     glm::vec3, glm::mat4>& value) const {
+                                     glm::vec3, glm::ivec2, glm::uvec2,
+                                     glm::mat4>& value) const {
     // get location of uniform variable
     const GLint location = glGetUniformLocation(program, uniform_name.c_str());
 
@@ -111,6 +178,12 @@ class Shader {
       void operator()(const glm::vec3& value) {
         glProgramUniform3fv(program, location, 1, glm::value_ptr(value));
       }
+      void operator()(const glm::ivec2& value) {
+        glProgramUniform2iv(program, location, 1, glm::value_ptr(value));
+      }
+      void operator()(const glm::uvec2& value) {
+        glProgramUniform2uiv(program, location, 1, glm::value_ptr(value));
+      }
       void operator()(const glm::mat4& value) {
         glProgramUniformMatrix4fv(program, location, 1, GL_FALSE,
                                   glm::value_ptr(value));
@@ -122,26 +195,30 @@ class Shader {
 
 class VertexShader : public Shader {
  public:
-  VertexShader(const std::filesystem::path& filepath)
-      : Shader(GL_VERTEX_SHADER, filepath) {}
+  VertexShader(const std::filesystem::path& filepath,
+               const std::string& defines = "")
+      : Shader(GL_VERTEX_SHADER, filepath, defines) {}
 };
 
 class GeometryShader : public Shader {
  public:
-  GeometryShader(const std::filesystem::path& filepath)
-      : Shader(GL_GEOMETRY_SHADER, filepath) {}
+  GeometryShader(const std::filesystem::path& filepath,
+                 const std::string& defines = "")
+      : Shader(GL_GEOMETRY_SHADER, filepath, defines) {}
 };
 
 class FragmentShader : public Shader {
  public:
-  FragmentShader(const std::filesystem::path& filepath)
-      : Shader(GL_FRAGMENT_SHADER, filepath) {}
+  FragmentShader(const std::filesystem::path& filepath,
+                 const std::string& defines = "")
+      : Shader(GL_FRAGMENT_SHADER, filepath, defines) {}
 };
 
 class ComputeShader : public Shader {
  public:
-  ComputeShader(const std::filesystem::path& filepath)
-      : Shader(GL_COMPUTE_SHADER, filepath) {}
+  ComputeShader(const std::filesystem::path& filepath,
+                const std::string& defines = "")
+      : Shader(GL_COMPUTE_SHADER, filepath, defines) {}
 };
 
 class Pipeline {
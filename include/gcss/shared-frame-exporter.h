@@ -0,0 +1,65 @@
+#ifndef _GCSS_SHARED_FRAME_EXPORTER_H
+#define _GCSS_SHARED_FRAME_EXPORTER_H
+#include <array>
+#include <cstdint>
+#include <deque>
+#include <string>
+
+#include "glad/gl.h"
+//
+#include "buffer.h"
+#include "readback.h"
+#include "shared-frame.h"
+
+namespace gcss {
+
+// publishes GPU buffers to other processes. buffers are copied back through
+// an AsyncReadback and written into shared memory once the copy has
+// finished, so the render loop never waits for a reader or for the GPU.
+class SharedFrameExporter {
+ private:
+  struct Pending {
+    uint32_t elementSize;
+    std::array<uint32_t, 3> dims;
+  };
+
+  SharedFramePublisher publisher;
+  AsyncReadback readback;
+  // metadata of in-flight requests in submission order
+  std::deque<Pending> pending;
+
+ public:
+  SharedFrameExporter(const std::string& name, const std::string& layout)
+      : publisher{name, layout} {}
+
+  const std::string& getName() const { return publisher.getName(); }
+
+  uint64_t getNumberOfFrames() const { return publisher.getNumberOfFrames(); }
+
+  // copy `size` bytes of buffer, frames are dropped while every readback slot
+  // is in flight
+  bool request(const Buffer& buffer, GLsizeiptr size, uint64_t step,
+               uint32_t elementSize, const std::array<uint32_t, 3>& dims) {
+    if (!readback.request({{&buffer, 0, size}}, step)) {
+      return false;
+    }
+    pending.push_back({elementSize, dims});
+    return true;
+  }
+
+  // publish finished copies
+  void poll(bool wait = false) {
+    readback.poll(
+        [&](uint64_t step, const std::byte* data, std::size_t size) {
+          const Pending frame = pending.front();
+          pending.pop_front();
+          publisher.publish(data, size, step, frame.elementSize,
+                            frame.dims.data());
+        },
+        wait);
+  }
+};
+
+}  // namespace gcss
+
+#endif
@@ -0,0 +1,300 @@
+#ifndef _GCSS_SHARED_FRAME_H
+#define _GCSS_SHARED_FRAME_H
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <string>
+#include <vector>
+
+#include "spdlog/spdlog.h"
+//
+#include "shared-memory.h"
+
+namespace gcss {
+
+// shared frame layout
+//
+// SharedFrameHeader
+// SharedFrameSlot * nSlots
+// payload of slotCapacity bytes * nSlots
+//
+// one process publishes frames into a ring of slots, any number of local
+// processes map the memory read-only. every slot is guarded by a seqlock: the
+// publisher makes its sequence odd while writing and even again afterwards,
+// so a reader knows that a frame was complete if the sequence was even and
+// unchanged around its read. latest points to the newest complete frame and
+// the publisher writes the other slots next, so readers rarely retry.
+
+using SharedFrameCounter = std::atomic<uint64_t>;
+static_assert(SharedFrameCounter::is_always_lock_free);
+
+struct SharedFrameHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t nSlots;
+  uint64_t slotCapacity;
+  // description of an element chosen by the publisher, e.g. "n-body Particle"
+  char layout[48];
+  // set once the publisher is gone or has moved to a larger object of the
+  // same name, readers have to open it again
+  std::atomic<uint32_t> closed;
+  // number of the latest complete frame, frames start at 1
+  alignas(64) SharedFrameCounter latest;
+};
+
+struct alignas(64) SharedFrameSlot {
+  // seqlock, odd while the slot is written
+  SharedFrameCounter sequence;
+  uint64_t frame;
+  // simulation step of the frame
+  uint64_t step;
+  // payload size in bytes
+  uint64_t size;
+  uint32_t elementSize;
+  // number of elements along each axis, e.g. {n, 1, 1} for particles
+  uint32_t dims[3];
+};
+
+// metadata of a frame as seen by a reader
+struct SharedFrameInfo {
+  uint64_t frame = 0;
+  uint64_t step = 0;
+  uint64_t size = 0;
+  uint32_t elementSize = 0;
+  uint32_t dims[3] = {0, 0, 0};
+};
+
+inline constexpr char SHARED_FRAME_MAGIC[8] = {'G', 'C', 'S', 'S',
+                                               'S', 'H', 'F', 'R'};
+inline constexpr uint32_t SHARED_FRAME_VERSION = 1;
+
+inline std::size_t getSharedFramePayloadOffset(uint32_t nSlots) {
+  return sizeof(SharedFrameHeader) + nSlots * sizeof(SharedFrameSlot);
+}
+
+// writes frames into shared memory, the object is removed on destruction
+class SharedFramePublisher {
+ private:
+  std::string name;
+  std::string layout;
+  uint32_t nSlots;
+  uint64_t nFrames;
+  SharedMemory memory;
+
+  SharedFrameHeader* getHeader() {
+    return reinterpret_cast<SharedFrameHeader*>(memory.getWritableData());
+  }
+
+  SharedFrameSlot* getSlot(uint32_t index) {
+    return reinterpret_cast<SharedFrameSlot*>(memory.getWritableData() +
+                                              sizeof(SharedFrameHeader)) +
+           index;
+  }
+
+  std::byte* getPayload(uint32_t index) {
+    return memory.getWritableData() + getSharedFramePayloadOffset(nSlots) +
+           index * getHeader()->slotCapacity;
+  }
+
+  void close() {
+    if (memory.isOpen()) {
+      getHeader()->closed.store(1, std::memory_order_release);
+      memory.release();
+    }
+  }
+
+  bool allocate(std::size_t slotCapacity) {
+    close();
+
+    // keep payloads aligned to cache lines
+    slotCapacity = (slotCapacity + 63) / 64 * 64;
+    if (!memory.create(name, getSharedFramePayloadOffset(nSlots) +
+                                 nSlots * slotCapacity)) {
+      return false;
+    }
+
+    SharedFrameHeader* header = new (memory.getWritableData())
+        SharedFrameHeader{};
+    header->version = SHARED_FRAME_VERSION;
+    header->nSlots = nSlots;
+    header->slotCapacity = slotCapacity;
+    std::strncpy(header->layout, layout.c_str(), sizeof(header->layout) - 1);
+    for (uint32_t i = 0; i < nSlots; ++i) {
+      new (getSlot(i)) SharedFrameSlot{};
+    }
+
+    // readers check the magic first
+    std::atomic_thread_fence(std::memory_order_release);
+    std::memcpy(header->magic, SHARED_FRAME_MAGIC, sizeof(header->magic));
+
+    return true;
+  }
+
+ public:
+  SharedFramePublisher(const std::string& name, const std::string& layout,
+                       uint32_t nSlots = 3)
+      : name{name},
+        layout{layout},
+        nSlots{std::max(nSlots, 2u)},
+        nFrames{0} {}
+
+  SharedFramePublisher(const SharedFramePublisher& other) = delete;
+
+  ~SharedFramePublisher() { close(); }
+
+  SharedFramePublisher& operator=(const SharedFramePublisher& other) = delete;
+
+  const std::string& getName() const { return name; }
+
+  uint64_t getNumberOfFrames() const { return nFrames; }
+
+  // copy a frame into the next slot. the object is created on the first
+  // frame and recreated when a frame does not fit.
+  bool publish(const std::byte* data, std::size_t size, uint64_t step,
+               uint32_t elementSize, const uint32_t dims[3]) {
+    if (!memory.isOpen() || size > getHeader()->slotCapacity) {
+      if (!allocate(std::max(size, std::size_t(1) << 20))) {
+        return false;
+      }
+    }
+
+    nFrames++;
+    const uint32_t index = nFrames % nSlots;
+    SharedFrameSlot* slot = getSlot(index);
+
+    const uint64_t sequence = slot->sequence.load(std::memory_order_relaxed);
+    slot->sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    slot->frame = nFrames;
+    slot->step = step;
+    slot->size = size;
+    slot->elementSize = elementSize;
+    std::copy_n(dims, 3, slot->dims);
+    std::memcpy(getPayload(index), data, size);
+
+    slot->sequence.store(sequence + 2, std::memory_order_release);
+    getHeader()->latest.store(nFrames, std::memory_order_release);
+
+    return true;
+  }
+};
+
+// read-only view of frames published by another process
+class SharedFrameReader {
+ private:
+  SharedMemory memory;
+
+  const SharedFrameHeader* getHeader() const {
+    return reinterpret_cast<const SharedFrameHeader*>(memory.getData());
+  }
+
+  const SharedFrameSlot* getSlot(uint32_t index) const {
+    return reinterpret_cast<const SharedFrameSlot*>(memory.getData() +
+                                                    sizeof(SharedFrameHeader)) +
+           index;
+  }
+
+ public:
+  SharedFrameReader() {}
+
+  SharedFrameReader(const std::string& name) { open(name); }
+
+  // fails if no publisher has created the object yet
+  bool open(const std::string& name) {
+    if (!memory.open(name)) {
+      return false;
+    }
+
+    const SharedFrameHeader* header = getHeader();
+    if (memory.getSize() < sizeof(SharedFrameHeader) ||
+        std::memcmp(header->magic, SHARED_FRAME_MAGIC, sizeof(header->magic)) ||
+        header->version != SHARED_FRAME_VERSION ||
+        memory.getSize() < getSharedFramePayloadOffset(header->nSlots) +
+                               header->nSlots * header->slotCapacity) {
+      spdlog::error("[SharedFrameReader] {} is not a shared frame", name);
+      memory.release();
+      return false;
+    }
+
+    return true;
+  }
+
+  void release() { memory.release(); }
+
+  bool isOpen() const { return memory.isOpen(); }
+
+  // the publisher is gone or has moved to a new object, open it again
+  bool isClosed() const {
+    return !isOpen() || getHeader()->closed.load(std::memory_order_acquire);
+  }
+
+  std::string getLayout() const {
+    return isOpen() ? std::string(getHeader()->layout,
+                                  strnlen(getHeader()->layout,
+                                          sizeof(getHeader()->layout)))
+                    : std::string();
+  }
+
+  // number of the latest complete frame, 0 before the first one
+  uint64_t getLatestFrame() const {
+    return isOpen() ? getHeader()->latest.load(std::memory_order_acquire) : 0;
+  }
+
+  // call f(info, data) on the latest frame in place, without a copy. the
+  // publisher may overwrite the slot meanwhile, so f can be called several
+  // times and only the results of the last call are valid, and only if read
+  // returns true.
+  template <typename F>
+  bool read(F&& f, uint32_t maxAttempts = 16) const {
+    if (!isOpen()) {
+      return false;
+    }
+    const SharedFrameHeader* header = getHeader();
+
+    for (uint32_t attempt = 0; attempt < maxAttempts; ++attempt) {
+      const uint64_t frame = header->latest.load(std::memory_order_acquire);
+      if (frame == 0) {
+        return false;
+      }
+      const uint32_t index = frame % header->nSlots;
+      const SharedFrameSlot* slot = getSlot(index);
+
+      const uint64_t sequence = slot->sequence.load(std::memory_order_acquire);
+      if (sequence % 2 == 1) {
+        continue;
+      }
+
+      SharedFrameInfo info;
+      info.frame = slot->frame;
+      info.step = slot->step;
+      info.size = std::min<uint64_t>(slot->size, header->slotCapacity);
+      info.elementSize = slot->elementSize;
+      std::copy_n(slot->dims, 3, info.dims);
+      f(info, memory.getData() + getSharedFramePayloadOffset(header->nSlots) +
+                  index * header->slotCapacity);
+
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (slot->sequence.load(std::memory_order_relaxed) == sequence) {
+        return true;
+      }
+    }
+
+    return false;
+  }
+
+  // copy the latest frame
+  bool copyLatest(SharedFrameInfo& info, std::vector<std::byte>& data) const {
+    return read([&](const SharedFrameInfo& frame_info, const std::byte* ptr) {
+      info = frame_info;
+      data.assign(ptr, ptr + frame_info.size);
+    });
+  }
+};
+
+}  // namespace gcss
+
+#endif
@@ -0,0 +1,172 @@
+#ifndef _GCSS_SHARED_MEMORY_H
+#define _GCSS_SHARED_MEMORY_H
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "spdlog/spdlog.h"
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace gcss {
+
+// named memory shared between processes on the same host, a POSIX shared
+// memory object or a named file mapping on Windows. names start with a slash,
+// e.g. "/gcss-n-body".
+class SharedMemory {
+ private:
+  std::string name;
+  std::byte* data;
+  std::size_t size;
+  bool owner;
+#ifdef _WIN32
+  HANDLE mapping;
+#endif
+
+ public:
+  SharedMemory()
+      : data{nullptr},
+        size{0},
+        owner{false}
+#ifdef _WIN32
+        ,
+        mapping{nullptr}
+#endif
+  {
+  }
+
+  SharedMemory(const SharedMemory& other) = delete;
+
+  ~SharedMemory() { release(); }
+
+  SharedMemory& operator=(const SharedMemory& other) = delete;
+
+  // create a zero initialized object of `size` bytes, an existing object of
+  // the same name is unlinked first. the object is removed on release.
+  bool create(const std::string& name, std::size_t size) {
+    release();
+
+#ifdef _WIN32
+    const uint64_t size64 = size;
+    mapping = CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE,
+                                 static_cast<DWORD>(size64 >> 32),
+                                 static_cast<DWORD>(size64),
+                                 name.substr(1).c_str());
+    data = mapping ? static_cast<std::byte*>(
+                         MapViewOfFile(mapping, FILE_MAP_WRITE, 0, 0, 0))
+                   : nullptr;
+#else
+    shm_unlink(name.c_str());
+    const int fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0644);
+    if (fd < 0) {
+      spdlog::error("[SharedMemory] failed to create {}", name);
+      return false;
+    }
+    void* ptr =
+        ftruncate(fd, size) == 0
+            ? mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0)
+            : MAP_FAILED;
+    // the mapping keeps the object alive
+    ::close(fd);
+    data = ptr != MAP_FAILED ? static_cast<std::byte*>(ptr) : nullptr;
+    if (!data) {
+      shm_unlink(name.c_str());
+    }
+#endif
+
+    if (!data) {
+      spdlog::error("[SharedMemory] failed to map {}", name);
+      release();
+      return false;
+    }
+    this->name = name;
+    this->size = size;
+    owner = true;
+
+    spdlog::info("[SharedMemory] created {} of {} bytes", name, size);
+
+    return true;
+  }
+
+  // map an object created by another process read-only
+  bool open(const std::string& name) {
+    release();
+
+#ifdef _WIN32
+    mapping = OpenFileMappingA(FILE_MAP_READ, FALSE, name.substr(1).c_str());
+    data = mapping ? static_cast<std::byte*>(
+                         MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0))
+                   : nullptr;
+    if (data) {
+      MEMORY_BASIC_INFORMATION info;
+      VirtualQuery(data, &info, sizeof(info));
+      size = info.RegionSize;
+    }
+#else
+    const int fd = shm_open(name.c_str(), O_RDONLY, 0);
+    if (fd >= 0) {
+      struct stat st;
+      fstat(fd, &st);
+      size = static_cast<std::size_t>(st.st_size);
+      void* ptr = size > 0 ? mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0)
+                           : MAP_FAILED;
+      ::close(fd);
+      data = ptr != MAP_FAILED ? static_cast<std::byte*>(ptr) : nullptr;
+    }
+#endif
+
+    if (!data) {
+      release();
+      return false;
+    }
+    this->name = name;
+
+    return true;
+  }
+
+  void release() {
+#ifdef _WIN32
+    if (data) {
+      UnmapViewOfFile(data);
+    }
+    if (mapping) {
+      CloseHandle(mapping);
+      mapping = nullptr;
+    }
+#else
+    if (data) {
+      munmap(data, size);
+    }
+    if (owner) {
+      shm_unlink(name.c_str());
+    }
+#endif
+    name.clear();
+    data = nullptr;
+    size = 0;
+    owner = false;
+  }
+
+  bool isOpen() const { return data != nullptr; }
+
+  const std::string& getName() const { return name; }
+
+  const std::byte* getData() const { return data; }
+
+  // nullptr unless the object was created by this process
+  std::byte* getWritableData() { return owner ? data : nullptr; }
+
+  std::size_t getSize() const { return size; }
+};
+
+}  // namespace gcss
+
+#endif
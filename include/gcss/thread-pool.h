@@ -0,0 +1,145 @@
+#ifndef _GCSS_THREAD_POOL_H
+#define _GCSS_THREAD_POOL_H
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <latch>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace gcss {
+
+// thread pool with a task deque per worker. workers pop their own tasks from
+// the back and steal from the front of the others when they run out of work.
+class ThreadPool {
+ private:
+  struct Queue {
+    std::mutex mutex;
+    std::deque<std::function<void()>> tasks;
+  };
+
+  std::vector<std::unique_ptr<Queue>> queues;
+  std::vector<std::thread> workers;
+
+  std::mutex sleepMutex;
+  std::condition_variable sleepCv;
+  std::atomic<std::size_t> nPending;
+  std::atomic<std::size_t> nextQueue;
+  bool stopping;
+
+  bool popOwn(std::size_t index, std::function<void()>& task) {
+    Queue& queue = *queues[index];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.tasks.empty()) {
+      return false;
+    }
+    task = std::move(queue.tasks.back());
+    queue.tasks.pop_back();
+    return true;
+  }
+
+  bool steal(std::size_t index, std::function<void()>& task) {
+    for (std::size_t i = 1; i < queues.size(); ++i) {
+      Queue& queue = *queues[(index + i) % queues.size()];
+      std::lock_guard<std::mutex> lock(queue.mutex);
+      if (!queue.tasks.empty()) {
+        task = std::move(queue.tasks.front());
+        queue.tasks.pop_front();
+        return true;
+      }
+    }
+    return false;
+  }
+
+  void run(std::size_t index) {
+    while (true) {
+      std::function<void()> task;
+      if (popOwn(index, task) || steal(index, task)) {
+        nPending--;
+        task();
+        continue;
+      }
+
+      std::unique_lock<std::mutex> lock(sleepMutex);
+      sleepCv.wait(lock, [&] { return stopping || nPending > 0; });
+      if (stopping && nPending == 0) {
+        return;
+      }
+    }
+  }
+
+ public:
+  ThreadPool(std::size_t nThreads = std::thread::hardware_concurrency())
+      : nPending{0}, nextQueue{0}, stopping{false} {
+    nThreads = std::max<std::size_t>(nThreads, 1);
+    for (std::size_t i = 0; i < nThreads; ++i) {
+      queues.push_back(std::make_unique<Queue>());
+    }
+    for (std::size_t i = 0; i < nThreads; ++i) {
+      workers.emplace_back(&ThreadPool::run, this, i);
+    }
+  }
+
+  ThreadPool(const ThreadPool& other) = delete;
+
+  ~ThreadPool() {
+    {
+      std::lock_guard<std::mutex> lock(sleepMutex);
+      stopping = true;
+    }
+    sleepCv.notify_all();
+    for (auto& worker : workers) {
+      worker.join();
+    }
+  }
+
+  ThreadPool& operator=(const ThreadPool& other) = delete;
+
+  std::size_t getNumberOfThreads() const { return workers.size(); }
+
+  void submit(std::function<void()> task) {
+    // count the task before it becomes visible, so that nPending never
+    // underflows when a worker picks it up immediately
+    {
+      std::lock_guard<std::mutex> lock(sleepMutex);
+      nPending++;
+    }
+    Queue& queue = *queues[nextQueue++ % queues.size()];
+    {
+      std::lock_guard<std::mutex> lock(queue.mutex);
+      queue.tasks.push_back(std::move(task));
+    }
+    sleepCv.notify_one();
+  }
+
+  // call f(begin, end) on blocks of [first, last) and wait for completion
+  template <typename F>
+  void parallelFor(std::size_t first, std::size_t last, std::size_t blockSize,
+                   F&& f) {
+    if (first >= last) {
+      return;
+    }
+    blockSize = std::max<std::size_t>(blockSize, 1);
+
+    const std::size_t n_blocks = (last - first + blockSize - 1) / blockSize;
+    std::latch done(n_blocks);
+    for (std::size_t block = 0; block < n_blocks; ++block) {
+      const std::size_t begin = first + block * blockSize;
+      const std::size_t end = std::min(begin + blockSize, last);
+      submit([&f, &done, begin, end] {
+        f(begin, end);
+        done.count_down();
+      });
+    }
+    done.wait();
+  }
+};
+
+}  // namespace gcss
+
+#endif
@@ -0,0 +1,229 @@
+#ifndef _GCSS_TRAJECTORY_RECORDER_H
+#define _GCSS_TRAJECTORY_RECORDER_H
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <vector>
+
+#include "glad/gl.h"
+#include "glm/glm.hpp"
+#include "spdlog/spdlog.h"
+//
+#include "buffer.h"
+#include "readback.h"
+#include "shader.h"
+#include "trajectory.h"
+
+namespace gcss {
+
+// same layout as layout_state in shaders/trajectory/*.comp
+struct TrajectoryState {
+  glm::vec4 segmentMin = glm::vec4(0);
+  glm::vec4 segmentMax = glm::vec4(0);
+  uint32_t frameMin[3] = {0xffffffff, 0xffffffff, 0xffffffff};
+  uint32_t frameMax[3] = {0, 0, 0};
+  uint32_t keyframe = 0;
+};
+
+// quantizes and delta encodes particle positions on the GPU, reads them back
+// asynchronously and hands them to a TrajectoryWriter
+class TrajectoryRecorder {
+ private:
+  uint32_t bits;
+  uint32_t keyframeInterval;
+  float margin;
+
+  uint32_t nParticles;
+  uint32_t stride;
+  uint64_t nRecorded;
+
+  ComputeShader computeBounds;
+  Pipeline computeBoundsPipeline;
+  ComputeShader resolveSegment;
+  Pipeline resolveSegmentPipeline;
+  ComputeShader quantizePositions;
+  Pipeline quantizePositionsPipeline;
+
+  Buffer state;
+  Buffer previous;
+  Buffer encoded;
+
+  AsyncReadback readback;
+  TrajectoryWriter writer;
+
+  void pushFrame(uint64_t step, const std::byte* data, std::size_t size) {
+    TrajectoryState header;
+    std::memcpy(&header, data, sizeof(header));
+
+    TrajectoryFrame frame;
+    frame.step = step;
+    frame.keyframe = header.keyframe != 0;
+    frame.bboxMin = glm::vec3(header.segmentMin);
+    frame.bboxMax = glm::vec3(header.segmentMax);
+    frame.packed.resize((size - sizeof(header)) / sizeof(uint32_t));
+    std::memcpy(frame.packed.data(), data + sizeof(header),
+                frame.packed.size() * sizeof(uint32_t));
+
+    writer.push(std::move(frame));
+  }
+
+ public:
+  TrajectoryRecorder()
+      : bits{16},
+        keyframeInterval{64},
+        margin{0.1f},
+        nParticles{0},
+        stride{1},
+        nRecorded{0},
+        computeBounds{std::filesystem::path(CMAKE_SOURCE_DIR) / "shaders" /
+                      "trajectory" / "compute-bounds.comp"},
+        resolveSegment{std::filesystem::path(CMAKE_SOURCE_DIR) / "shaders" /
+                       "trajectory" / "resolve-segment.comp"},
+        quantizePositions{std::filesystem::path(CMAKE_SOURCE_DIR) /
+                          "shaders" / "trajectory" /
+                          "quantize-positions.comp"} {
+    computeBoundsPipeline.attachComputeShader(computeBounds);
+    resolveSegmentPipeline.attachComputeShader(resolveSegment);
+    quantizePositionsPipeline.attachComputeShader(quantizePositions);
+  }
+
+  TrajectoryRecorder(const TrajectoryRecorder& other) = delete;
+
+  ~TrajectoryRecorder() { stop(); }
+
+  TrajectoryRecorder& operator=(const TrajectoryRecorder& other) = delete;
+
+  uint32_t getBits() const { return bits; }
+  void setBits(uint32_t bits) {
+    if (!TrajectoryCodec::isSupportedBits(bits)) {
+      spdlog::error("[TrajectoryRecorder] unsupported quantization bits {}",
+                    bits);
+      return;
+    }
+    if (isRecording()) {
+      spdlog::warn("[TrajectoryRecorder] bits takes effect on the next start");
+    }
+    this->bits = bits;
+  }
+
+  uint32_t getKeyframeInterval() const { return keyframeInterval; }
+  void setKeyframeInterval(uint32_t keyframeInterval) {
+    this->keyframeInterval = std::max(keyframeInterval, 1u);
+  }
+
+  // recording stops by itself when the writer fails
+  bool isRecording() const { return writer.isOpen() && !writer.hasFailed(); }
+
+  uint64_t getNumberOfRecordedFrames() const { return nRecorded; }
+
+  std::size_t getQueueLength() { return writer.getQueueLength(); }
+
+  // stride is the distance between particle positions in vec4s
+  bool start(const std::filesystem::path& filepath, uint32_t nParticles,
+             uint32_t stride) {
+    stop();
+
+    if (!writer.open(filepath, nParticles, bits)) {
+      return false;
+    }
+
+    this->nParticles = nParticles;
+    this->stride = stride;
+    this->nRecorded = 0;
+
+    state.setData(std::vector<TrajectoryState>(1), GL_DYNAMIC_COPY);
+    previous.setData(std::vector<uint32_t>(3 * nParticles), GL_DYNAMIC_COPY);
+    encoded.setData(std::vector<uint32_t>(
+                        TrajectoryCodec::getPackedLength(nParticles, bits)),
+                    GL_DYNAMIC_COPY);
+
+    return true;
+  }
+
+  void stop() {
+    if (!writer.isOpen()) {
+      return;
+    }
+
+    poll(true);
+    writer.close();
+  }
+
+  // record current positions of particles. slots, if given, holds the index
+  // in particles of each recorded particle, so that a particle keeps its
+  // place in the trajectory when particles are reordered.
+  void record(const Buffer& particles, uint64_t step,
+              const Buffer* slots = nullptr) {
+    if (!isRecording()) {
+      return;
+    }
+
+    // every frame must reach the writer, otherwise the delta chain breaks
+    poll();
+    if (readback.isFull()) {
+      spdlog::warn("[TrajectoryRecorder] readback is behind, waiting");
+      poll(true);
+    }
+
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+    particles.bindToShaderStorageBuffer(0);
+    state.bindToShaderStorageBuffer(1);
+    previous.bindToShaderStorageBuffer(2);
+    encoded.bindToShaderStorageBuffer(3);
+    if (slots) {
+      slots->bindToShaderStorageBuffer(4);
+    }
+
+    // bounding box of current positions
+    computeBounds.setUniform("nParticles", nParticles);
+    computeBounds.setUniform("stride", stride);
+    computeBoundsPipeline.activate();
+    glDispatchCompute(std::ceil(nParticles / 128.0f), 1, 1);
+    computeBoundsPipeline.deactivate();
+
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+    // decide keyframe and quantization grid
+    resolveSegment.setUniform("forceKeyframe",
+                              nRecorded % keyframeInterval == 0);
+    resolveSegment.setUniform("margin", margin);
+    resolveSegmentPipeline.activate();
+    glDispatchCompute(1, 1, 1);
+    resolveSegmentPipeline.deactivate();
+
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+    // quantize and delta encode
+    quantizePositions.setUniform("nParticles", nParticles);
+    quantizePositions.setUniform("stride", stride);
+    quantizePositions.setUniform("bits", bits);
+    quantizePositions.setUniform("useSlots", slots != nullptr);
+    quantizePositionsPipeline.activate();
+    const uint32_t n_invocations =
+        bits == 16 ? (nParticles + 1) / 2 : nParticles;
+    glDispatchCompute(std::ceil(n_invocations / 128.0f), 1, 1);
+    quantizePositionsPipeline.deactivate();
+
+    readback.request(
+        {{&state, 0, sizeof(TrajectoryState)},
+         {&encoded, 0,
+          static_cast<GLsizeiptr>(encoded.getLength() * sizeof(uint32_t))}},
+        step);
+    nRecorded++;
+  }
+
+  // hand finished readbacks to the writer thread
+  void poll(bool wait = false) {
+    readback.poll(
+        [&](uint64_t step, const std::byte* data, std::size_t size) {
+          pushFrame(step, data, size);
+        },
+        wait);
+  }
+};
+
+}  // namespace gcss
+
+#endif
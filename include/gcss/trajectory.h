@@ -0,0 +1,483 @@
+#ifndef _GCSS_TRAJECTORY_H
+#define _GCSS_TRAJECTORY_H
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "glm/glm.hpp"
+#include "spdlog/spdlog.h"
+//
+#include "mapped-file.h"
+
+namespace gcss {
+
+// trajectory file layout
+//
+// TrajectoryFileHeader
+// (TrajectoryFrameHeader, payload) * nFrames
+// TrajectoryIndexEntry * nFrames
+// TrajectoryFooter
+//
+// positions are quantized to a bits-bit grid relative to the bounding box of
+// the frame header. keyframes store the grid coordinates, other frames store
+// the zigzag encoded difference to the previous frame modulo 2^bits. every
+// value is LEB128 varint encoded in the payload.
+
+struct TrajectoryFileHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t nParticles;
+  uint32_t bits;
+  uint32_t reserved;
+};
+
+struct TrajectoryFrameHeader {
+  uint32_t magic;
+  uint32_t flags;
+  uint64_t step;
+  float bboxMin[3];
+  float bboxMax[3];
+  uint64_t payloadSize;
+};
+
+struct TrajectoryIndexEntry {
+  uint64_t step;
+  uint64_t offset;
+  uint32_t flags;
+  uint32_t reserved;
+};
+
+struct TrajectoryFooter {
+  uint64_t nFrames;
+  uint64_t indexOffset;
+  char magic[8];
+};
+
+struct TrajectoryFrame {
+  uint64_t step = 0;
+  bool keyframe = false;
+  glm::vec3 bboxMin = glm::vec3(0);
+  glm::vec3 bboxMax = glm::vec3(0);
+  // grid coordinates or deltas as packed by quantize-positions.comp
+  std::vector<uint32_t> packed;
+};
+
+class TrajectoryCodec {
+ public:
+  static constexpr char FILE_MAGIC[8] = {'G', 'C', 'S', 'S', 'T', 'R', 'J', 0};
+  static constexpr char INDEX_MAGIC[8] = {'G', 'C', 'S', 'S', 'I', 'D', 'X', 0};
+  static constexpr uint32_t FRAME_MAGIC = 0x4d415246;  // "FRAM"
+  static constexpr uint32_t VERSION = 1;
+  static constexpr uint32_t FLAG_KEYFRAME = 1;
+
+  static bool isSupportedBits(uint32_t bits) {
+    return bits == 16 || bits == 21;
+  }
+
+  // number of 32 bit words written by quantize-positions.comp
+  static std::size_t getPackedLength(uint32_t nParticles, uint32_t bits) {
+    return bits == 16 ? 3 * ((nParticles + 1) / 2)
+                      : 2 * static_cast<std::size_t>(nParticles);
+  }
+
+  static void unpack(const uint32_t* packed, uint32_t nParticles,
+                     uint32_t bits, std::vector<uint32_t>& values) {
+    values.resize(3 * static_cast<std::size_t>(nParticles));
+    if (bits == 16) {
+      // two particles in three words
+      for (std::size_t i = 0; i < values.size(); ++i) {
+        values[i] = (packed[i / 2] >> (16 * (i % 2))) & 0xffff;
+      }
+    } else {
+      const uint32_t mask = (1u << 21) - 1;
+      for (std::size_t i = 0; i < nParticles; ++i) {
+        const uint32_t w0 = packed[2 * i + 0];
+        const uint32_t w1 = packed[2 * i + 1];
+        values[3 * i + 0] = w0 & mask;
+        values[3 * i + 1] = ((w0 >> 21) | (w1 << 11)) & mask;
+        values[3 * i + 2] = (w1 >> 10) & mask;
+      }
+    }
+  }
+
+  static void encodeVarint(const std::vector<uint32_t>& values,
+                           std::vector<uint8_t>& bytes) {
+    bytes.clear();
+    bytes.reserve(values.size() + values.size() / 4);
+    for (uint32_t v : values) {
+      while (v >= 0x80) {
+        bytes.push_back(static_cast<uint8_t>(v | 0x80));
+        v >>= 7;
+      }
+      bytes.push_back(static_cast<uint8_t>(v));
+    }
+  }
+
+  static bool decodeVarint(const uint8_t* bytes, std::size_t size,
+                           std::vector<uint32_t>& values) {
+    std::size_t pos = 0;
+    for (auto& value : values) {
+      uint32_t v = 0;
+      uint32_t shift = 0;
+      while (true) {
+        if (pos >= size || shift > 28) {
+          return false;
+        }
+        const uint8_t b = bytes[pos++];
+        v |= static_cast<uint32_t>(b & 0x7f) << shift;
+        if (!(b & 0x80)) {
+          break;
+        }
+        shift += 7;
+      }
+      value = v;
+    }
+    return true;
+  }
+
+  // inverse of the zigzag mapping in quantize-positions.comp, applied modulo
+  // 2^bits
+  static uint32_t applyDelta(uint32_t previous, uint32_t zigzag,
+                             uint32_t bits) {
+    const uint32_t delta = (zigzag >> 1) ^ (0u - (zigzag & 1));
+    return (previous + delta) & ((1u << bits) - 1);
+  }
+};
+
+// streams frames to disk from a writer thread
+class TrajectoryWriter {
+ private:
+  std::filesystem::path filepath;
+  std::ofstream file;
+  uint32_t nParticles;
+  uint32_t bits;
+  uint64_t offset;
+  std::vector<TrajectoryIndexEntry> index;
+
+  std::thread thread;
+  std::mutex mutex;
+  std::condition_variable cv;
+  std::deque<TrajectoryFrame> queue;
+  bool closing;
+  // a write failed, later frames are dropped and no index is written
+  std::atomic<bool> failed;
+
+  void writeFrame(const TrajectoryFrame& frame, std::vector<uint32_t>& values,
+                  std::vector<uint8_t>& payload) {
+    TrajectoryCodec::unpack(frame.packed.data(), nParticles, bits, values);
+    TrajectoryCodec::encodeVarint(values, payload);
+
+    TrajectoryFrameHeader header{};
+    header.magic = TrajectoryCodec::FRAME_MAGIC;
+    header.flags = frame.keyframe ? TrajectoryCodec::FLAG_KEYFRAME : 0;
+    header.step = frame.step;
+    for (int i = 0; i < 3; ++i) {
+      header.bboxMin[i] = frame.bboxMin[i];
+      header.bboxMax[i] = frame.bboxMax[i];
+    }
+    header.payloadSize = payload.size();
+
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(payload.data()), payload.size());
+    if (!file) {
+      spdlog::error("[TrajectoryWriter] failed to write step {} to {}, "
+                    "recording stopped",
+                    frame.step, filepath.generic_string());
+      failed = true;
+      return;
+    }
+
+    index.push_back({frame.step, offset, header.flags, 0});
+    offset += sizeof(header) + payload.size();
+  }
+
+  void run() {
+    std::vector<uint32_t> values;
+    std::vector<uint8_t> payload;
+    while (true) {
+      TrajectoryFrame frame;
+      {
+        std::unique_lock<std::mutex> lock(mutex);
+        cv.wait(lock, [&] { return closing || !queue.empty(); });
+        if (queue.empty()) {
+          break;
+        }
+        frame = std::move(queue.front());
+        queue.pop_front();
+      }
+      if (!failed) {
+        writeFrame(frame, values, payload);
+      }
+    }
+  }
+
+ public:
+  TrajectoryWriter()
+      : nParticles{0}, bits{16}, offset{0}, closing{false}, failed{false} {}
+
+  TrajectoryWriter(const TrajectoryWriter& other) = delete;
+
+  ~TrajectoryWriter() { close(); }
+
+  TrajectoryWriter& operator=(const TrajectoryWriter& other) = delete;
+
+  bool open(const std::filesystem::path& filepath, uint32_t nParticles,
+            uint32_t bits) {
+    close();
+
+    if (!TrajectoryCodec::isSupportedBits(bits)) {
+      spdlog::error("[TrajectoryWriter] unsupported quantization bits {}",
+                    bits);
+      return false;
+    }
+
+    file.open(filepath, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+      spdlog::error("[TrajectoryWriter] failed to open {}",
+                    filepath.generic_string());
+      return false;
+    }
+
+    this->filepath = filepath;
+    this->nParticles = nParticles;
+    this->bits = bits;
+    index.clear();
+
+    TrajectoryFileHeader header{};
+    std::memcpy(header.magic, TrajectoryCodec::FILE_MAGIC,
+                sizeof(header.magic));
+    header.version = TrajectoryCodec::VERSION;
+    header.nParticles = nParticles;
+    header.bits = bits;
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    if (!file) {
+      spdlog::error("[TrajectoryWriter] failed to write {}",
+                    filepath.generic_string());
+      file.close();
+      return false;
+    }
+    offset = sizeof(header);
+
+    closing = false;
+    failed = false;
+    thread = std::thread(&TrajectoryWriter::run, this);
+
+    spdlog::info("[TrajectoryWriter] recording {} particles to {}", nParticles,
+                 filepath.generic_string());
+
+    return true;
+  }
+
+  bool isOpen() const { return file.is_open(); }
+
+  // a write failed since open, frames pushed since are dropped
+  bool hasFailed() const { return failed; }
+
+  void push(TrajectoryFrame&& frame) {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      queue.push_back(std::move(frame));
+    }
+    cv.notify_one();
+  }
+
+  std::size_t getQueueLength() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return queue.size();
+  }
+
+  // drain the queue and append the index
+  void close() {
+    if (!file.is_open()) {
+      return;
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      closing = true;
+    }
+    cv.notify_one();
+    if (thread.joinable()) {
+      thread.join();
+    }
+
+    if (failed) {
+      file.close();
+      spdlog::error("[TrajectoryWriter] {} is truncated after {} frames and "
+                    "has no index",
+                    filepath.generic_string(), index.size());
+      return;
+    }
+
+    TrajectoryFooter footer{};
+    footer.nFrames = index.size();
+    footer.indexOffset = offset;
+    std::memcpy(footer.magic, TrajectoryCodec::INDEX_MAGIC,
+                sizeof(footer.magic));
+    file.write(reinterpret_cast<const char*>(index.data()),
+               index.size() * sizeof(TrajectoryIndexEntry));
+    file.write(reinterpret_cast<const char*>(&footer), sizeof(footer));
+    // buffered frames are flushed by close, so its errors count too
+    file.close();
+    if (file.fail()) {
+      spdlog::error("[TrajectoryWriter] failed to write the index of {}",
+                    filepath.generic_string());
+      return;
+    }
+
+    spdlog::info("[TrajectoryWriter] wrote {} frames, {} bytes", index.size(),
+                 offset);
+  }
+};
+
+// random access to the frames of a trajectory file through a memory mapping
+class TrajectoryReader {
+ private:
+  MappedFile file;
+  TrajectoryFileHeader header;
+  std::vector<TrajectoryIndexEntry> index;
+
+  template <typename T>
+  bool read(std::size_t offset, T& value) const {
+    if (offset + sizeof(T) > file.getSize()) {
+      return false;
+    }
+    std::memcpy(&value, file.getData() + offset, sizeof(T));
+    return true;
+  }
+
+  // rebuild the index from the frame headers when the footer is missing,
+  // e.g. the writer did not shut down cleanly
+  void scanFrames() {
+    index.clear();
+    std::size_t offset = sizeof(TrajectoryFileHeader);
+    TrajectoryFrameHeader frame;
+    while (read(offset, frame) && frame.magic == TrajectoryCodec::FRAME_MAGIC &&
+           offset + sizeof(frame) + frame.payloadSize <= file.getSize()) {
+      index.push_back({frame.step, offset, frame.flags, 0});
+      offset += sizeof(frame) + frame.payloadSize;
+    }
+  }
+
+ public:
+  TrajectoryReader() : header{} {}
+
+  bool open(const std::filesystem::path& filepath) {
+    index.clear();
+    if (!file.open(filepath)) {
+      return false;
+    }
+
+    if (!read(0, header) ||
+        std::memcmp(header.magic, TrajectoryCodec::FILE_MAGIC,
+                    sizeof(header.magic)) != 0 ||
+        !TrajectoryCodec::isSupportedBits(header.bits)) {
+      spdlog::error("[TrajectoryReader] {} is not a trajectory file",
+                    filepath.generic_string());
+      file.release();
+      return false;
+    }
+
+    TrajectoryFooter footer;
+    const bool has_footer =
+        file.getSize() >= sizeof(header) + sizeof(footer) &&
+        read(file.getSize() - sizeof(footer), footer) &&
+        std::memcmp(footer.magic, TrajectoryCodec::INDEX_MAGIC,
+                    sizeof(footer.magic)) == 0 &&
+        footer.indexOffset + footer.nFrames * sizeof(TrajectoryIndexEntry) <=
+            file.getSize() - sizeof(footer);
+    if (has_footer) {
+      index.resize(footer.nFrames);
+      std::memcpy(index.data(), file.getData() + footer.indexOffset,
+                  footer.nFrames * sizeof(TrajectoryIndexEntry));
+    } else {
+      spdlog::warn("[TrajectoryReader] index of {} is missing, scanning frames",
+                   filepath.generic_string());
+      scanFrames();
+    }
+
+    return true;
+  }
+
+  uint32_t getNumberOfParticles() const { return header.nParticles; }
+
+  uint32_t getBits() const { return header.bits; }
+
+  std::size_t getNumberOfFrames() const { return index.size(); }
+
+  uint64_t getStep(std::size_t frame) const { return index.at(frame).step; }
+
+  // decode frame k starting from the nearest preceding keyframe
+  bool readFrame(std::size_t k, std::vector<glm::vec3>& positions) const {
+    if (k >= index.size()) {
+      return false;
+    }
+
+    std::size_t keyframe = k;
+    while (keyframe > 0 &&
+           !(index[keyframe].flags & TrajectoryCodec::FLAG_KEYFRAME)) {
+      keyframe--;
+    }
+    if (!(index[keyframe].flags & TrajectoryCodec::FLAG_KEYFRAME)) {
+      spdlog::error("[TrajectoryReader] no keyframe before frame {}", k);
+      return false;
+    }
+
+    const std::size_t n_values =
+        3 * static_cast<std::size_t>(header.nParticles);
+    std::vector<uint32_t> codes(n_values);
+    std::vector<uint32_t> values(n_values);
+    TrajectoryFrameHeader frame;
+    for (std::size_t i = keyframe; i <= k; ++i) {
+      const std::size_t offset = index[i].offset;
+      if (!read(offset, frame) || frame.magic != TrajectoryCodec::FRAME_MAGIC ||
+          offset + sizeof(frame) + frame.payloadSize > file.getSize()) {
+        spdlog::error("[TrajectoryReader] frame {} is corrupted", i);
+        return false;
+      }
+
+      const auto* payload =
+          reinterpret_cast<const uint8_t*>(file.getData() + offset) +
+          sizeof(frame);
+      if (!TrajectoryCodec::decodeVarint(payload, frame.payloadSize, values)) {
+        spdlog::error("[TrajectoryReader] failed to decode frame {}", i);
+        return false;
+      }
+
+      if (i == keyframe) {
+        codes.swap(values);
+      } else {
+        for (std::size_t j = 0; j < n_values; ++j) {
+          codes[j] =
+              TrajectoryCodec::applyDelta(codes[j], values[j], header.bits);
+        }
+      }
+    }
+
+    // dequantize with the grid of frame k
+    const float max_code = static_cast<float>((1u << header.bits) - 1);
+    const glm::vec3 bbox_min(frame.bboxMin[0], frame.bboxMin[1],
+                             frame.bboxMin[2]);
+    const glm::vec3 extent =
+        glm::vec3(frame.bboxMax[0], frame.bboxMax[1], frame.bboxMax[2]) -
+        bbox_min;
+    positions.resize(header.nParticles);
+    for (std::size_t i = 0; i < positions.size(); ++i) {
+      const glm::vec3 q(codes[3 * i + 0], codes[3 * i + 1], codes[3 * i + 2]);
+      positions[i] = bbox_min + q / max_code * extent;
+    }
+
+    return true;
+  }
+};
+
+}  // namespace gcss
+
+#endif
@@ -0,0 +1,111 @@
+#ifndef _GCSS_UPLOAD_H
+#define _GCSS_UPLOAD_H
+#include <cstddef>
+#include <limits>
+#include <vector>
+
+#include "glad/gl.h"
+#include "spdlog/spdlog.h"
+//
+#include "buffer.h"
+
+namespace gcss {
+
+// ring of persistently mapped staging buffers for uploads. the CPU writes
+// into one slot while the GPU still copies out of the others, a fence per
+// slot tells when it may be written again.
+class UploadRing {
+ private:
+  struct Slot {
+    Buffer staging;
+    std::size_t capacity = 0;
+    std::byte* mapped = nullptr;
+    GLsync fence = nullptr;
+  };
+
+  std::vector<Slot> slots;
+  std::size_t next;
+
+  void allocate(Slot& slot, std::size_t size) {
+    if (slot.mapped) {
+      slot.staging.unmap();
+    }
+
+    // readable as well, so that data can be combined in place
+    const GLbitfield flags = GL_MAP_READ_BIT | GL_MAP_WRITE_BIT |
+                             GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    slot.staging.setStorage<std::byte>(size, flags | GL_CLIENT_STORAGE_BIT);
+    slot.mapped =
+        static_cast<std::byte*>(slot.staging.mapRange(0, size, flags));
+    slot.capacity = size;
+  }
+
+  void wait(Slot& slot) {
+    if (!slot.fence) {
+      return;
+    }
+    const GLenum status =
+        glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT,
+                         std::numeric_limits<GLuint64>::max());
+    if (status == GL_WAIT_FAILED) {
+      spdlog::error("[UploadRing] failed to wait fence");
+    }
+    glDeleteSync(slot.fence);
+    slot.fence = nullptr;
+  }
+
+ public:
+  UploadRing(std::size_t nSlots = 2) : slots(nSlots), next{0} {}
+
+  UploadRing(const UploadRing& other) = delete;
+
+  ~UploadRing() { release(); }
+
+  UploadRing& operator=(const UploadRing& other) = delete;
+
+  void release() {
+    for (auto& slot : slots) {
+      if (slot.fence) {
+        glDeleteSync(slot.fence);
+        slot.fence = nullptr;
+      }
+      if (slot.mapped) {
+        slot.staging.unmap();
+        slot.mapped = nullptr;
+      }
+    }
+  }
+
+  // the next slot with room for size bytes, once the GPU is done with it
+  std::size_t acquire(std::size_t size) {
+    const std::size_t index = next;
+    next = (next + 1) % slots.size();
+
+    Slot& slot = slots[index];
+    wait(slot);
+    if (slot.capacity < size) {
+      allocate(slot, size);
+    }
+    return index;
+  }
+
+  std::byte* getData(std::size_t index) const { return slots[index].mapped; }
+
+  const Buffer& getBuffer(std::size_t index) const {
+    return slots[index].staging;
+  }
+
+  // call after the commands reading from the slot, it is reused once they
+  // are done
+  void submit(std::size_t index) {
+    Slot& slot = slots[index];
+    if (slot.fence) {
+      glDeleteSync(slot.fence);
+    }
+    slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+  }
+};
+
+}  // namespace gcss
+
+#endif
@@ -0,0 +1,73 @@
+// lists of active tiles, see active-tiles.h. a tile is the region updated by
+// one workgroup.
+
+// tiles updated in this step, starts with the DispatchIndirectCommand
+// updating them
+layout(std430, binding = 2) buffer layout_active_list {
+  uint dispatch_x;
+  uint dispatch_y;
+  uint dispatch_z;
+  uint active_count;
+  uint active_tiles[];
+};
+
+// tiles updated in the next step, same layout
+layout(std430, binding = 3) buffer layout_next_list {
+  uint next_dispatch_x;
+  uint next_dispatch_y;
+  uint next_dispatch_z;
+  uint next_count;
+  uint next_tiles[];
+};
+
+// step in which a tile has last been appended to the next list
+layout(std430, binding = 4) buffer layout_tile_marks { uint tile_marks[]; };
+
+// tiles per row and column
+uniform uvec2 nTiles;
+// current step, never 0
+uniform uint stamp;
+
+shared uint tile_changed;
+
+// tile of this workgroup, false for workgroups beyond the list
+bool getTile(out uint tile) {
+  uint index = gl_WorkGroupID.x + gl_WorkGroupID.y * gl_NumWorkGroups.x;
+  tile = index < active_count ? active_tiles[index] : 0;
+  return index < active_count;
+}
+
+ivec2 getTileOrigin(uint tile) {
+  return ivec2(tile % nTiles.x, tile / nTiles.x) *
+         ivec2(gl_WorkGroupSize.xy);
+}
+
+// every invocation of the workgroup has to call this. if any cell of the tile
+// has changed, the tile and its neighbors are appended to the next list, each
+// of them once per step.
+void appendChangedTile(uint tile, bool changed) {
+  if (gl_LocalInvocationIndex == 0) {
+    tile_changed = 0;
+  }
+  barrier();
+
+  if (changed) {
+    atomicOr(tile_changed, 1);
+  }
+  barrier();
+
+  if (tile_changed == 0 || gl_LocalInvocationIndex >= 9) return;
+
+  ivec2 neighbor = ivec2(tile % nTiles.x, tile / nTiles.x) +
+                   ivec2(gl_LocalInvocationIndex % 3,
+                         gl_LocalInvocationIndex / 3) -
+                   1;
+  if (any(lessThan(neighbor, ivec2(0))) ||
+      any(greaterThanEqual(neighbor, ivec2(nTiles))))
+    return;
+
+  uint index = neighbor.x + neighbor.y * nTiles.x;
+  if (atomicExchange(tile_marks[index], stamp) != stamp) {
+    next_tiles[atomicAdd(next_count, 1)] = index;
+  }
+}
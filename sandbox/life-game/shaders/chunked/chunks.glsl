@@ -0,0 +1,37 @@
+// chunks of 256 x 256 packed cells in a pool of slots, see chunked-world.h.
+// rows of a chunk go from y = 0 up, like rows of the board.
+
+const uint CHUNK_SIZE = 256;
+// words per row
+const uint CHUNK_WIDTH = CHUNK_SIZE / 32;
+const uint CHUNK_WORDS = CHUNK_WIDTH * CHUNK_SIZE;
+const uint NO_CHUNK = 0xffffffffu;
+// live cells within this many cells of an edge allocate the neighbor behind
+// it. along x this is the first or last word of a row.
+const uint BAND = 32;
+// flag of chunks with live cells, the other bits are the neighbors whose
+// band has live cells
+const uint ALIVE = 1u << 4;
+
+struct Chunk {
+  ivec2 coords;
+  // slots of the 3 x 3 chunks around, (dx + 1) + 3 * (dy + 1), NO_CHUNK if
+  // not allocated
+  uint neighbors[9];
+};
+
+layout(std430, binding = 2) readonly buffer layout_chunk_table {
+  Chunk chunks[];
+};
+
+// allocated slots
+layout(std430, binding = 3) readonly buffer layout_chunk_list {
+  uint chunk_list[];
+};
+// chunk of workgroup z = 0, lists longer than a dispatch are run in batches
+uniform uint firstChunk;
+
+// flags of the cells after the last step, per slot
+layout(std430, binding = 4) buffer layout_chunk_flags { uint chunk_flags[]; };
+
+uint getNeighborFlag(ivec2 d) { return 1u << ((d.x + 1) + 3 * (d.y + 1)); }
@@ -0,0 +1,38 @@
+// edits of a rectangle of the board, see board-editor.h. a shader including
+// this defines editCell, the new status of a cell of the rectangle.
+layout(local_size_x = 8, local_size_y = 8) in;
+
+layout(r8ui, binding = 0) uniform uimage2D cells;
+// 32 cells per texel, see packed/packed.glsl
+layout(r32ui, binding = 1) uniform uimage2D packedCells;
+uniform bool bitPacked;
+// edited cells, max excluded, on the board
+uniform ivec2 rectMin;
+uniform ivec2 rectMax;
+
+uint editCell(ivec2 cell, uint status);
+
+// one invocation per cell of the rectangle, or per word of it when bit
+// packed. bits of a word outside the rectangle are kept.
+void main() {
+  const ivec2 gidx = ivec2(gl_GlobalInvocationID.xy);
+  if (bitPacked) {
+    const ivec2 word = ivec2(rectMin.x / 32 + gidx.x, rectMin.y + gidx.y);
+    if (32 * word.x >= rectMax.x || word.y >= rectMax.y) return;
+
+    uint bits = imageLoad(packedCells, word).x;
+    const int first = max(rectMin.x - 32 * word.x, 0);
+    const int last = min(rectMax.x - 32 * word.x, 32);
+    for (int i = first; i < last; ++i) {
+      const uint status =
+          editCell(ivec2(32 * word.x + i, word.y), (bits >> i) & 1u);
+      bits = (bits & ~(1u << i)) | (status << i);
+    }
+    imageStore(packedCells, word, uvec4(bits));
+    return;
+  }
+
+  const ivec2 cell = rectMin + gidx;
+  if (any(greaterThanEqual(cell, rectMax))) return;
+  imageStore(cells, cell, uvec4(editCell(cell, imageLoad(cells, cell).x)));
+}
@@ -0,0 +1,18 @@
+// summed-area table, entry (x, y) is the number of live cells in
+// [0, x] x [0, y] of the table
+layout(std430, binding = 0) buffer SummedAreaTable { uint sat[]; };
+
+uniform ivec2 tableSize;
+
+// the table is extended by zeros before and by its last row and column after
+uint loadSum(ivec2 idx) {
+  if (any(lessThan(idx, ivec2(0)))) return 0;
+  idx = min(idx, tableSize - 1);
+  return sat[idx.x + idx.y * tableSize.x];
+}
+
+// live cells in the box [lo, hi], which may reach past the table
+uint boxSum(ivec2 lo, ivec2 hi) {
+  return loadSum(hi) - loadSum(ivec2(lo.x - 1, hi.y)) -
+         loadSum(ivec2(hi.x, lo.y - 1)) + loadSum(lo - 1);
+}
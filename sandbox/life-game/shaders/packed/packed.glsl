@@ -0,0 +1,48 @@
+// 32 cells per word, bit i of word x is cell 32 * x + i. cells beyond the
+// board width are always dead.
+
+// bits of word x which are on a board of width cells
+uint getWordMask(uint x, uint width) {
+  uint n = clamp(int(width) - int(32 * x), 0, 32);
+  return n == 32 ? 0xffffffffu : (1u << n) - 1u;
+}
+
+// west neighbors of the cells of center, i.e. bit i is cell 32 * x + i - 1
+uint shiftWest(uint west, uint center) { return (center << 1) | (west >> 31); }
+
+// east neighbors of the cells of center, i.e. bit i is cell 32 * x + i + 1
+uint shiftEast(uint center, uint east) { return (center >> 1) | (east << 31); }
+
+void fullAdd(uint a, uint b, uint c, out uint sum, out uint carry) {
+  uint ab = a ^ b;
+  sum = ab ^ c;
+  carry = (a & b) | (ab & c);
+}
+
+// B3/S23 for 32 cells at once. rows are the words above, at and below the
+// cells, x: west, y: center, z: east.
+uint nextGeneration(uvec3 above, uvec3 row, uvec3 below) {
+  // neighbors counted per row: above and below with 3, the row itself with 2
+  uint above_sum, above_carry;
+  fullAdd(shiftWest(above.x, above.y), above.y, shiftEast(above.y, above.z),
+          above_sum, above_carry);
+  uint below_sum, below_carry;
+  fullAdd(shiftWest(below.x, below.y), below.y, shiftEast(below.y, below.z),
+          below_sum, below_carry);
+  uint west = shiftWest(row.x, row.y);
+  uint east = shiftEast(row.y, row.z);
+  uint row_sum = west ^ east;
+  uint row_carry = west & east;
+
+  // count = ones + 2 * (twos_sum + 2 * twos_carry + ones_carry)
+  uint ones, ones_carry;
+  fullAdd(above_sum, below_sum, row_sum, ones, ones_carry);
+  uint twos_sum, twos_carry;
+  fullAdd(above_carry, below_carry, row_carry, twos_sum, twos_carry);
+
+  // count is 2 or 3 if exactly one of the twos is set
+  uint two_or_three = ~twos_carry & (twos_sum ^ ones_carry);
+
+  // birth with 3, survival with 2 or 3
+  return two_or_three & (ones | row.y);
+}
@@ -1,6 +1,15 @@
 #version 460 core
 
 layout(r8ui, binding = 0) uniform uimage2D cells;
+// 32 cells per texel, see packed/packed.glsl
+layout(r32ui, binding = 1) uniform uimage2D packedCells;
+uniform bool bitPacked;
+// live cells of 2^level x 2^level blocks, see density-pyramid.h
+layout(r32ui, binding = 2) uniform uimage2D density;
+// 0 draws single cells
+uniform uint level;
+// board size in cells
+uniform ivec2 size;
 uniform vec2 offset;
 uniform float scale;
 
@@ -8,12 +17,31 @@ in vec2 texCoords;
 
 out vec4 fragColor;
 
+uint loadCell(ivec2 idx) {
+  if (bitPacked) {
+    // x < 0 must not map to word 0
+    if (idx.x < 0) return 0;
+    return (imageLoad(packedCells, ivec2(idx.x / 32, idx.y)).x >>
+            (idx.x % 32)) & 1u;
+  }
+  return imageLoad(cells, idx).x;
+}
+
 void main() {
-  ivec2 size = imageSize(cells);
   vec2 uv = (2.0 * gl_FragCoord.xy - size) / size;
 
   ivec2 idx = ivec2(offset + uv * 0.5 * size / scale);
-  uint status = imageLoad(cells, idx).x;
+
+  if (level > 0) {
+    // fraction of live cells under the pixel, a single cell stays visible
+    uint count = imageLoad(density, idx >> level).x;
+    float fraction = float(count) / exp2(2.0 * float(level));
+    float brightness = count > 0 ? mix(0.25, 1.0, fraction) : 0.0;
+    fragColor = vec4(brightness * vec3(0, 1, 0), 1);
+    return;
+  }
+
+  uint status = loadCell(idx);
 
   fragColor = vec4(status * vec3(0, 1, 0), 1);
-}
\ No newline at end of file
+}
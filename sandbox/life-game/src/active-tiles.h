@@ -0,0 +1,196 @@
+#ifndef _ACTIVE_TILES_H
+#define _ACTIVE_TILES_H
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <numeric>
+#include <string>
+#include <vector>
+
+#include "glad/gl.h"
+#include "glm/glm.hpp"
+#include "spdlog/spdlog.h"
+//
+#include "gcss/buffer.h"
+#include "gcss/readback.h"
+#include "gcss/shader.h"
+#include "gcss/texture.h"
+
+using namespace gcss;
+
+// updates only tiles in which cells can change. a tile is the 8 x 8 texels of
+// one workgroup. whenever a cell of a tile changes, the update appends the
+// tile and its neighbors to the list of the next step, which doubles as the
+// indirect dispatch, so settled regions cost nothing and nothing is read
+// back. skipped tiles are also skipped in the output texture, which still
+// holds them from two generations ago, i.e. unchanged.
+class ActiveTiles {
+ public:
+  // same as the workgroup size of the active update shaders
+  static constexpr uint32_t TILE_SIZE = 8;
+  // same as MAX_GROUPS in finish-list.comp
+  static constexpr uint32_t MAX_GROUPS = 65535;
+
+ private:
+  glm::uvec2 nTiles;
+  // lists are rebuilt from all tiles on the next step
+  bool valid;
+  uint32_t stamp;
+
+  // DispatchIndirectCommand and count followed by tile indices, see
+  // active/tiles.glsl. the current list and the next one swap every step.
+  Buffer lists[2];
+  uint32_t current;
+  Buffer tileMarks;
+
+  ComputeShader updateCellsShader;
+  Pipeline updateCellsPipeline;
+  ComputeShader updatePackedShader;
+  Pipeline updatePackedPipeline;
+  ComputeShader finishList;
+  Pipeline finishListPipeline;
+  ComputeShader activateTiles;
+  Pipeline activateTilesPipeline;
+
+  // number of active tiles, read back for display only
+  AsyncReadback countReadback;
+  uint32_t nActive;
+
+  static std::filesystem::path getShaderPath(const std::string& filename) {
+    return std::filesystem::path(CMAKE_CURRENT_SOURCE_DIR) / "shaders" /
+           "active" / filename;
+  }
+
+  // every tile is active in the next step
+  void reset(const glm::uvec2& nTiles) {
+    this->nTiles = nTiles;
+    const uint32_t n_tiles = nTiles.x * nTiles.y;
+
+    std::vector<uint32_t> list(4 + n_tiles);
+    list[0] = std::min(n_tiles, MAX_GROUPS);
+    list[1] = (n_tiles + MAX_GROUPS - 1) / MAX_GROUPS;
+    list[2] = 1;
+    list[3] = n_tiles;
+    std::iota(list.begin() + 4, list.end(), 0);
+    lists[0].setData(list, GL_DYNAMIC_COPY);
+    std::fill(list.begin(), list.begin() + 4, 0);
+    lists[1].setData(list, GL_DYNAMIC_COPY);
+    current = 0;
+
+    tileMarks.allocate<uint32_t>(n_tiles, GL_DYNAMIC_COPY);
+    tileMarks.clear();
+    stamp = 0;
+
+    valid = true;
+    nActive = n_tiles;
+  }
+
+  void step(const Texture& cellsIn, const Texture& cellsOut,
+            ComputeShader& updateShader, const Pipeline& updatePipeline) {
+    const glm::uvec2 n_tiles =
+        (cellsIn.getResolution() + TILE_SIZE - 1u) / TILE_SIZE;
+    if (!valid || n_tiles != nTiles) {
+      reset(n_tiles);
+    }
+    stamp++;
+
+    cellsIn.bindToImageUnit(0, GL_READ_ONLY);
+    cellsOut.bindToImageUnit(1, GL_WRITE_ONLY);
+    lists[current].bindToShaderStorageBuffer(2);
+    lists[1 - current].bindToShaderStorageBuffer(3);
+    tileMarks.bindToShaderStorageBuffer(4);
+
+    updateShader.setUniform("nTiles", nTiles);
+    updateShader.setUniform("stamp", stamp);
+    glBindBuffer(GL_DISPATCH_INDIRECT_BUFFER, lists[current].getName());
+    updatePipeline.activate();
+    glDispatchComputeIndirect(0);
+    updatePipeline.deactivate();
+    glBindBuffer(GL_DISPATCH_INDIRECT_BUFFER, 0);
+
+    glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT |
+                    GL_SHADER_STORAGE_BARRIER_BIT);
+
+    finishListPipeline.activate();
+    glDispatchCompute(1, 1, 1);
+    finishListPipeline.deactivate();
+
+    glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_SHADER_STORAGE_BARRIER_BIT);
+    current = 1 - current;
+
+    // count of the list of the next step
+    if (!countReadback.isFull()) {
+      countReadback.request({{&lists[current], 3 * sizeof(uint32_t),
+                              sizeof(uint32_t)}},
+                            stamp);
+    }
+    countReadback.poll([&](uint64_t, const std::byte* data, std::size_t) {
+      std::memcpy(&nActive, data, sizeof(nActive));
+    });
+  }
+
+ public:
+  ActiveTiles()
+      : nTiles{0},
+        valid{false},
+        stamp{0},
+        current{0},
+        updateCellsShader{getShaderPath("update-cells.comp")},
+        updatePackedShader{getShaderPath("update-packed.comp")},
+        finishList{getShaderPath("finish-list.comp")},
+        activateTiles{getShaderPath("activate-tiles.comp")},
+        nActive{0} {
+    updateCellsPipeline.attachComputeShader(updateCellsShader);
+    updatePackedPipeline.attachComputeShader(updatePackedShader);
+    finishListPipeline.attachComputeShader(finishList);
+    activateTilesPipeline.attachComputeShader(activateTiles);
+  }
+
+  // cells were changed by something else, every tile is updated next
+  void invalidate() { valid = false; }
+
+  // texels from min up to max excluded were changed by something else, their
+  // tiles and the neighboring ones are updated next
+  void activate(const glm::ivec2& min, const glm::ivec2& max) {
+    if (!valid || stamp == 0) {
+      // every tile is updated next anyway
+      return;
+    }
+    const glm::uvec2 first_tile =
+        glm::uvec2(glm::max(min - 1, glm::ivec2(0))) / TILE_SIZE;
+    const glm::uvec2 last_tile =
+        glm::min(glm::uvec2(max) / TILE_SIZE + 1u, nTiles);
+    const glm::uvec2 n_tiles = last_tile - first_tile;
+
+    lists[current].bindToShaderStorageBuffer(2);
+    tileMarks.bindToShaderStorageBuffer(4);
+    activateTiles.setUniform("nTiles", nTiles);
+    activateTiles.setUniform("stamp", stamp);
+    activateTiles.setUniform("firstTile", first_tile);
+    activateTiles.setUniform("lastTile", last_tile);
+    activateTilesPipeline.activate();
+    glDispatchCompute(std::ceil(n_tiles.x / 8.0f), std::ceil(n_tiles.y / 8.0f),
+                      1);
+    activateTilesPipeline.deactivate();
+
+    glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_SHADER_STORAGE_BARRIER_BIT);
+  }
+
+  uint32_t getNumberOfActiveTiles() const { return nActive; }
+  uint32_t getNumberOfTiles() const { return nTiles.x * nTiles.y; }
+
+  // one generation of r8ui cells
+  void updateCells(const Texture& cellsIn, const Texture& cellsOut) {
+    step(cellsIn, cellsOut, updateCellsShader, updateCellsPipeline);
+  }
+
+  // one generation of packed cells, tiles are 8 x 8 words
+  void updatePackedCells(const Texture& cellsIn, const Texture& cellsOut,
+                         uint32_t width) {
+    updatePackedShader.setUniform("width", width);
+    step(cellsIn, cellsOut, updatePackedShader, updatePackedPipeline);
+  }
+};
+
+#endif
@@ -0,0 +1,375 @@
+#ifndef _BOARD_EDITOR_H
+#define _BOARD_EDITOR_H
+#include <algorithm>
+#include <cmath>
+#include <deque>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "glad/gl.h"
+#include "glm/glm.hpp"
+#include "spdlog/spdlog.h"
+//
+#include "gcss/buffer.h"
+#include "gcss/shader.h"
+#include "gcss/texture.h"
+
+using namespace gcss;
+
+// edits of the GPU board at a cost proportional to the edited cells. brush
+// strokes, fills and pattern stamps are dispatched over their rectangle
+// only. before a tile of the board is first changed in an undo step it is
+// copied into a pool buffer on the GPU, so an undo restores just the tiles
+// of the step with sub-rectangle uploads and nothing is read back. undoing
+// restores the tiles as they were before the step, the rest of the board
+// keeps its generation.
+class BoardEditor {
+ public:
+  // cells of a tile, whole words when bit packed
+  static constexpr uint32_t TILE_SIZE = 64;
+  static constexpr std::size_t MAX_UNDO_STEPS = 64;
+  // older steps are dropped beyond this, the latest one is always kept
+  static constexpr std::size_t MAX_POOL_BYTES = std::size_t(256) << 20;
+
+  // cells from min up to max excluded
+  struct Rect {
+    glm::ivec2 min;
+    glm::ivec2 max;
+
+    bool isEmpty() const { return glm::any(glm::lessThanEqual(max, min)); }
+
+    Rect unite(const Rect& other) const {
+      if (isEmpty()) return other;
+      if (other.isEmpty()) return *this;
+      return {glm::min(min, other.min), glm::max(max, other.max)};
+    }
+  };
+
+  // a pattern to stamp, rows of 'o' and '.' from the top like RLE
+  struct Stamp {
+    const char* name;
+    std::vector<std::string> rows;
+  };
+
+ private:
+  struct SavedTile {
+    glm::ivec2 tile;
+    // bytes into the pool
+    std::size_t offset;
+  };
+
+  // board the history belongs to
+  glm::uvec2 size;
+  GLint internalFormat;
+  glm::uvec2 nTiles;
+
+  // tiles saved by each step, the latest last
+  std::deque<std::vector<SavedTile>> steps;
+  // the next edit starts a new step
+  bool stepOpen;
+  // step each tile was last saved in, never 0
+  std::vector<uint32_t> tileSteps;
+  uint32_t stepId;
+
+  // saved tiles from poolBegin up to poolEnd
+  Buffer pool;
+  std::size_t poolCapacity;
+  std::size_t poolBegin;
+  std::size_t poolEnd;
+
+  Buffer pattern;
+
+  ComputeShader brushShader;
+  Pipeline brushPipeline;
+  ComputeShader fillShader;
+  Pipeline fillPipeline;
+  ComputeShader stampShader;
+  Pipeline stampPipeline;
+
+  static std::filesystem::path getShaderPath(const std::string& filename) {
+    return std::filesystem::path(CMAKE_CURRENT_SOURCE_DIR) / "shaders" /
+           "edit" / filename;
+  }
+
+  static bool isBitPacked(const Texture& cells) {
+    return cells.getInternalFormat() == GL_R32UI;
+  }
+
+  Rect clip(const Rect& rect) const {
+    return {glm::max(rect.min, glm::ivec2(0)),
+            glm::min(rect.max, glm::ivec2(size))};
+  }
+
+  // cells of a tile on the board
+  Rect getTileCells(const glm::ivec2& tile) const {
+    const glm::ivec2 min = tile * int(TILE_SIZE);
+    return clip({min, min + int(TILE_SIZE)});
+  }
+
+  // texels of a tile in the cells texture
+  Rect getTileTexels(const glm::ivec2& tile, bool bitPacked) const {
+    const Rect cells = getTileCells(tile);
+    if (!bitPacked) {
+      return cells;
+    }
+    return {glm::ivec2(cells.min.x / 32, cells.min.y),
+            glm::ivec2((cells.max.x + 31) / 32, cells.max.y)};
+  }
+
+  // drop the history if the board is not the one it was recorded on
+  void prepare(const Texture& cells, const glm::uvec2& size) {
+    if (size == this->size && cells.getInternalFormat() == internalFormat) {
+      return;
+    }
+    clearHistory();
+    this->size = size;
+    internalFormat = cells.getInternalFormat();
+    nTiles = (size + TILE_SIZE - 1u) / TILE_SIZE;
+    tileSteps.assign(nTiles.x * nTiles.y, 0);
+  }
+
+  // oldest steps beyond the limits, never the latest
+  void trim() {
+    while (steps.size() > 1 && (steps.size() > MAX_UNDO_STEPS ||
+                                poolEnd - poolBegin > MAX_POOL_BYTES)) {
+      steps.pop_front();
+      poolBegin = steps.front().empty() ? poolEnd : steps.front()[0].offset;
+    }
+  }
+
+  // room for bytes at poolEnd. the live range is moved to the front of a
+  // new pool, which drops the space of trimmed steps.
+  void reserve(std::size_t bytes) {
+    if (poolEnd + bytes <= poolCapacity) {
+      return;
+    }
+    const std::size_t live = poolEnd - poolBegin;
+    const std::size_t capacity =
+        std::max(2 * (live + bytes), std::size_t(1) << 20);
+    Buffer grown;
+    grown.allocate<uint8_t>(capacity, GL_DYNAMIC_COPY);
+    if (live > 0) {
+      grown.copySubData<uint8_t>(pool, poolBegin, 0, live);
+    }
+    for (auto& step : steps) {
+      for (SavedTile& saved : step) {
+        saved.offset -= poolBegin;
+      }
+    }
+    pool = std::move(grown);
+    poolCapacity = capacity;
+    poolEnd = live;
+    poolBegin = 0;
+  }
+
+  // copy the tiles of rect not saved in the current step yet into the pool
+  void save(const Texture& cells, const Rect& rect) {
+    if (!stepOpen) {
+      stepOpen = true;
+      stepId++;
+      steps.emplace_back();
+      trim();
+    }
+
+    const bool bit_packed = isBitPacked(cells);
+    const GLenum type = bit_packed ? GL_UNSIGNED_INT : GL_UNSIGNED_BYTE;
+    const std::size_t texel_size = bit_packed ? sizeof(uint32_t) : 1;
+    const glm::ivec2 first = rect.min / int(TILE_SIZE);
+    const glm::ivec2 last = (rect.max - 1) / int(TILE_SIZE);
+
+    glMemoryBarrier(GL_TEXTURE_UPDATE_BARRIER_BIT);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    for (int y = first.y; y <= last.y; ++y) {
+      for (int x = first.x; x <= last.x; ++x) {
+        uint32_t& tile_step = tileSteps[x + y * nTiles.x];
+        if (tile_step == stepId) {
+          continue;
+        }
+        tile_step = stepId;
+
+        const Rect texels = getTileTexels(glm::ivec2(x, y), bit_packed);
+        const glm::ivec2 extent = texels.max - texels.min;
+        const std::size_t bytes = extent.x * extent.y * texel_size;
+        reserve(bytes);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, pool.getName());
+        glGetTextureSubImage(cells.getTextureName(), 0, texels.min.x,
+                             texels.min.y, 0, extent.x, extent.y, 1,
+                             GL_RED_INTEGER, type, bytes,
+                             reinterpret_cast<void*>(poolEnd));
+        steps.back().push_back({glm::ivec2(x, y), poolEnd});
+        poolEnd += bytes;
+      }
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+  }
+
+  // save the tiles of rect and run an edit shader over it
+  Rect edit(const Texture& cells, const glm::uvec2& size, const Rect& rect,
+            ComputeShader& shader, const Pipeline& pipeline) {
+    prepare(cells, size);
+    const Rect clipped = clip(rect);
+    if (clipped.isEmpty()) {
+      return clipped;
+    }
+    save(cells, clipped);
+
+    const bool bit_packed = isBitPacked(cells);
+    // one invocation per word when bit packed
+    const glm::ivec2 extent = clipped.max - clipped.min;
+    const uint32_t n_words = (clipped.max.x - 1) / 32 - clipped.min.x / 32 + 1;
+    const glm::uvec2 n_invocations(bit_packed ? n_words : extent.x, extent.y);
+    cells.bindToImageUnit(bit_packed ? 1 : 0, GL_READ_WRITE);
+    shader.setUniform("bitPacked", bit_packed);
+    shader.setUniform("rectMin", clipped.min);
+    shader.setUniform("rectMax", clipped.max);
+    pipeline.activate();
+    glDispatchCompute(std::ceil(n_invocations.x / 8.0f),
+                      std::ceil(n_invocations.y / 8.0f), 1);
+    pipeline.deactivate();
+
+    glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT |
+                    GL_TEXTURE_UPDATE_BARRIER_BIT);
+    return clipped;
+  }
+
+ public:
+  BoardEditor()
+      : size{0},
+        internalFormat{0},
+        nTiles{0},
+        stepOpen{false},
+        stepId{0},
+        poolCapacity{0},
+        poolBegin{0},
+        poolEnd{0},
+        brushShader{getShaderPath("brush.comp")},
+        fillShader{getShaderPath("fill.comp")},
+        stampShader{getShaderPath("stamp.comp")} {
+    brushPipeline.attachComputeShader(brushShader);
+    fillPipeline.attachComputeShader(fillShader);
+    stampPipeline.attachComputeShader(stampShader);
+  }
+
+  static const std::vector<Stamp>& getStamps() {
+    static const std::vector<Stamp> stamps = {
+        {"Glider", {".o.", "..o", "ooo"}},
+        {"LWSS", {".o..o", "o....", "o...o", "oooo."}},
+        {"R-pentomino", {".oo", "oo.", ".o."}},
+        {"Acorn", {".o.....", "...o...", "oo..ooo"}},
+        {"Gosper glider gun",
+         {"........................o...........",
+          "......................o.o...........",
+          "............oo......oo............oo",
+          "...........o...o....oo............oo",
+          "oo........o.....o...oo..............",
+          "oo........o...o.oo....o.o...........",
+          "..........o.....o.......o...........",
+          "...........o...o....................",
+          "............oo......................"}},
+    };
+    return stamps;
+  }
+
+  // the next edit starts a new undo step, e.g. on pressing the mouse button
+  void beginEdit() { stepOpen = false; }
+
+  // the board was replaced, nothing of it can be undone
+  void clearHistory() {
+    steps.clear();
+    stepOpen = false;
+    poolBegin = 0;
+    poolEnd = 0;
+  }
+
+  std::size_t getNumberOfUndoSteps() const { return steps.size(); }
+
+  // bytes of saved tiles
+  std::size_t getUndoBytes() const { return poolEnd - poolBegin; }
+
+  // cells within radius of the segment from one board position to another
+  // become alive or dead. returns the edited cells.
+  Rect paint(const Texture& cells, const glm::uvec2& size,
+             const glm::vec2& from, const glm::vec2& to, float radius,
+             bool alive) {
+    brushShader.setUniform("from", from);
+    brushShader.setUniform("to", to);
+    brushShader.setUniform("radius", radius);
+    brushShader.setUniform("value", alive ? 1u : 0u);
+    const Rect rect = {
+        glm::ivec2(glm::floor(glm::min(from, to) - radius)),
+        glm::ivec2(glm::floor(glm::max(from, to) + radius)) + 1};
+    return edit(cells, size, rect, brushShader, brushPipeline);
+  }
+
+  // every cell of rect becomes alive or dead
+  Rect fill(const Texture& cells, const glm::uvec2& size, const Rect& rect,
+            bool alive) {
+    fillShader.setUniform("value", alive ? 1u : 0u);
+    return edit(cells, size, rect, fillShader, fillPipeline);
+  }
+
+  // live cells of a stamp centered at a board cell are added
+  Rect stamp(const Texture& cells, const glm::uvec2& size, const Stamp& stamp,
+             const glm::ivec2& center) {
+    uint32_t width = 0;
+    for (const std::string& row : stamp.rows) {
+      width = std::max(width, static_cast<uint32_t>(row.size()));
+    }
+    const uint32_t height = stamp.rows.size();
+    const uint32_t stride = std::max((width + 31) / 32, 1u);
+
+    // rows of the board run up, rows of the stamp down
+    std::vector<uint32_t> words(stride * std::max(height, 1u));
+    for (uint32_t r = 0; r < height; ++r) {
+      const std::string& row = stamp.rows[r];
+      for (uint32_t x = 0; x < row.size(); ++x) {
+        if (row[x] == 'o') {
+          words[x / 32 + (height - 1 - r) * stride] |= 1u << (x % 32);
+        }
+      }
+    }
+    pattern.setData(words, GL_DYNAMIC_DRAW);
+    pattern.bindToShaderStorageBuffer(0);
+
+    const glm::ivec2 origin = center - glm::ivec2(width, height) / 2;
+    stampShader.setUniform("origin", origin);
+    stampShader.setUniform("patternStride", stride);
+    return edit(cells, size, {origin, origin + glm::ivec2(width, height)},
+                stampShader, stampPipeline);
+  }
+
+  // restore the tiles of the latest step, returns the restored cells
+  Rect undo(const Texture& cells, const glm::uvec2& size) {
+    prepare(cells, size);
+    stepOpen = false;
+    if (steps.empty()) {
+      return {glm::ivec2(0), glm::ivec2(0)};
+    }
+
+    const bool bit_packed = isBitPacked(cells);
+    const GLenum type = bit_packed ? GL_UNSIGNED_INT : GL_UNSIGNED_BYTE;
+    Rect restored = {glm::ivec2(0), glm::ivec2(0)};
+    glMemoryBarrier(GL_TEXTURE_UPDATE_BARRIER_BIT);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pool.getName());
+    for (const SavedTile& saved : steps.back()) {
+      const Rect texels = getTileTexels(saved.tile, bit_packed);
+      const glm::ivec2 extent = texels.max - texels.min;
+      glTextureSubImage2D(cells.getTextureName(), 0, texels.min.x,
+                          texels.min.y, extent.x, extent.y, GL_RED_INTEGER,
+                          type, reinterpret_cast<void*>(saved.offset));
+      restored = restored.unite(getTileCells(saved.tile));
+    }
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    if (!steps.back().empty()) {
+      poolEnd = steps.back()[0].offset;
+    }
+    steps.pop_back();
+    spdlog::info("[BoardEditor] undo, {} steps left", steps.size());
+    return restored;
+  }
+};
+
+#endif
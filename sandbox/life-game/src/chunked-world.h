@@ -0,0 +1,478 @@
+#ifndef _CHUNKED_WORLD_H
+#define _CHUNKED_WORLD_H
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "glad/gl.h"
+#include "glm/glm.hpp"
+#include "spdlog/spdlog.h"
+//
+#include "gcss/buffer.h"
+#include "gcss/readback.h"
+#include "gcss/shader.h"
+#include "gcss/texture.h"
+
+using namespace gcss;
+
+// same layout as Chunk in chunked/chunks.glsl
+struct alignas(8) ChunkEntry {
+  glm::ivec2 coords;
+  // slots of the 3 x 3 chunks around, (dx + 1) + 3 * (dy + 1)
+  uint32_t neighbors[9];
+  uint32_t padding;
+};
+static_assert(sizeof(ChunkEntry) == 48);
+
+// unbounded world of packed cells in chunks of 256 x 256, allocated from a
+// pool of slots in a pair of storage buffers. the chunk table on the GPU
+// holds the neighbor slots of every chunk, so the update reads its halo
+// straight from the neighbors.
+//
+// every step also flags chunks with live cells near an edge. the flags are
+// read back asynchronously and the neighbors behind such edges are allocated,
+// chunks without live cells and without live neighbors nearby are freed.
+// cells need more generations to cross the band than the readback may lag
+// behind, so a chunk always exists before cells are born in it.
+class ChunkedWorld {
+ public:
+  // same as in chunked/chunks.glsl
+  static constexpr uint32_t CHUNK_SIZE = 256;
+  static constexpr uint32_t CHUNK_WIDTH = CHUNK_SIZE / 32;
+  static constexpr uint32_t CHUNK_WORDS = CHUNK_WIDTH * CHUNK_SIZE;
+  static constexpr uint32_t NO_CHUNK = 0xffffffffu;
+  static constexpr uint32_t ALIVE = 1u << 4;
+
+ private:
+  // generations of flags in flight, less than the band of 32 cells
+  static constexpr uint32_t N_READBACK_SLOTS = 4;
+
+  uint32_t capacity;
+  // slots the cells of a storage buffer can hold, the pool stops growing
+  // there and chunks beyond are not allocated
+  uint32_t maxCapacity;
+  bool full;
+  // workgroups of a dispatch along z, larger chunk lists are dispatched in
+  // batches
+  uint32_t maxGroupsZ;
+  std::vector<ChunkEntry> table;
+  // generation in which a slot was allocated, flags of earlier steps belong
+  // to a previous chunk
+  std::vector<uint64_t> allocatedAt;
+  std::vector<bool> used;
+  std::vector<uint32_t> freeSlots;
+  std::unordered_map<uint64_t, uint32_t> slots;
+  std::vector<uint32_t> chunkList;
+  // table and list have to be uploaded
+  bool dirty;
+
+  uint64_t generation;
+
+  Buffer cellsIn;
+  Buffer cellsOut;
+  Buffer tableBuffer;
+  Buffer listBuffer;
+  Buffer flags;
+  AsyncReadback flagsReadback;
+
+  ComputeShader updateChunks;
+  Pipeline updateChunksPipeline;
+  ComputeShader drawView;
+  Pipeline drawViewPipeline;
+
+  static std::filesystem::path getShaderPath(const std::string& filename) {
+    return std::filesystem::path(CMAKE_CURRENT_SOURCE_DIR) / "shaders" /
+           "chunked" / filename;
+  }
+
+  static uint64_t getKey(const glm::ivec2& coords) {
+    return (static_cast<uint64_t>(static_cast<uint32_t>(coords.x)) << 32) |
+           static_cast<uint32_t>(coords.y);
+  }
+
+  static uint32_t getDirection(int dx, int dy) {
+    return (dx + 1) + 3 * (dy + 1);
+  }
+
+  // double the pool up to maxCapacity, cells and flags are kept. returns
+  // false if the pool is full.
+  bool grow() {
+    const uint32_t new_capacity =
+        std::min(std::max(2 * capacity, 64u), maxCapacity);
+    if (new_capacity <= capacity) {
+      if (!full) {
+        spdlog::error("[ChunkedWorld] pool is full at {} chunks, the world "
+                      "stops growing",
+                      capacity);
+        full = true;
+      }
+      return false;
+    }
+
+    Buffer cells;
+    cells.allocate<uint32_t>(std::size_t(new_capacity) * CHUNK_WORDS,
+                             GL_DYNAMIC_COPY);
+    Buffer new_flags;
+    new_flags.allocate<uint32_t>(new_capacity, GL_DYNAMIC_COPY);
+    new_flags.clear();
+    if (capacity > 0) {
+      cells.copySubData<uint32_t>(cellsIn, 0, 0, capacity * CHUNK_WORDS);
+      new_flags.copySubData<uint32_t>(flags, 0, 0, capacity);
+    }
+    cellsIn = std::move(cells);
+    cellsOut.allocate<uint32_t>(std::size_t(new_capacity) * CHUNK_WORDS,
+                                GL_DYNAMIC_COPY);
+    flags = std::move(new_flags);
+
+    for (uint32_t slot = new_capacity; slot > capacity; --slot) {
+      freeSlots.push_back(slot - 1);
+    }
+    table.resize(new_capacity);
+    allocatedAt.resize(new_capacity, 0);
+    used.resize(new_capacity, false);
+    capacity = new_capacity;
+
+    spdlog::info("[ChunkedWorld] pool of {} chunks", capacity);
+    return true;
+  }
+
+  // a dead chunk, linked to its neighbors. NO_CHUNK if the pool is full.
+  uint32_t allocate(const glm::ivec2& coords) {
+    if (freeSlots.empty() && !grow()) {
+      return NO_CHUNK;
+    }
+    const uint32_t slot = freeSlots.back();
+    freeSlots.pop_back();
+
+    ChunkEntry& entry = table[slot];
+    entry.coords = coords;
+    for (int dy = -1; dy <= 1; ++dy) {
+      for (int dx = -1; dx <= 1; ++dx) {
+        const auto it = slots.find(getKey(coords + glm::ivec2(dx, dy)));
+        const uint32_t neighbor = it != slots.end() ? it->second : NO_CHUNK;
+        entry.neighbors[getDirection(dx, dy)] = neighbor;
+        if (neighbor != NO_CHUNK) {
+          table[neighbor].neighbors[getDirection(-dx, -dy)] = slot;
+        }
+      }
+    }
+    entry.neighbors[getDirection(0, 0)] = slot;
+
+    slots[getKey(coords)] = slot;
+    allocatedAt[slot] = generation;
+    used[slot] = true;
+    dirty = true;
+
+    glClearNamedBufferSubData(cellsIn.getName(), GL_R32UI,
+                              slot * CHUNK_WORDS * sizeof(uint32_t),
+                              CHUNK_WORDS * sizeof(uint32_t), GL_RED_INTEGER,
+                              GL_UNSIGNED_INT, nullptr);
+    const uint32_t no_flags = 0;
+    flags.setSubData(&no_flags, slot, 1);
+
+    return slot;
+  }
+
+  void free(uint32_t slot) {
+    const ChunkEntry& entry = table[slot];
+    for (int dy = -1; dy <= 1; ++dy) {
+      for (int dx = -1; dx <= 1; ++dx) {
+        const uint32_t neighbor = entry.neighbors[getDirection(dx, dy)];
+        if (neighbor != NO_CHUNK) {
+          table[neighbor].neighbors[getDirection(-dx, -dy)] = NO_CHUNK;
+        }
+      }
+    }
+
+    slots.erase(getKey(entry.coords));
+    used[slot] = false;
+    freeSlots.push_back(slot);
+    dirty = true;
+  }
+
+  uint32_t findOrAllocate(const glm::ivec2& coords) {
+    const auto it = slots.find(getKey(coords));
+    return it != slots.end() ? it->second : allocate(coords);
+  }
+
+  // allocate and free chunks by the flags of the step to `step`
+  void processFlags(uint64_t step, const uint32_t* data, std::size_t length) {
+    std::vector<bool> keep(capacity, false);
+    std::vector<glm::ivec2> missing;
+    for (uint32_t slot = 0; slot < std::min<std::size_t>(length, capacity);
+         ++slot) {
+      // chunks allocated since have no flags yet and are kept
+      if (!used[slot] || allocatedAt[slot] >= step) {
+        keep[slot] = used[slot];
+        continue;
+      }
+
+      const uint32_t chunk_flags = data[slot];
+      keep[slot] = keep[slot] || (chunk_flags & ALIVE);
+      for (int dy = -1; dy <= 1; ++dy) {
+        for (int dx = -1; dx <= 1; ++dx) {
+          const uint32_t direction = getDirection(dx, dy);
+          if (direction == getDirection(0, 0) ||
+              !(chunk_flags & (1u << direction))) {
+            continue;
+          }
+          const uint32_t neighbor = table[slot].neighbors[direction];
+          if (neighbor != NO_CHUNK) {
+            keep[neighbor] = true;
+          } else {
+            missing.push_back(table[slot].coords + glm::ivec2(dx, dy));
+          }
+        }
+      }
+    }
+    for (uint32_t slot = length; slot < capacity; ++slot) {
+      keep[slot] = used[slot];
+    }
+
+    for (uint32_t slot = 0; slot < capacity; ++slot) {
+      if (used[slot] && !keep[slot]) {
+        free(slot);
+      }
+    }
+    for (const glm::ivec2& coords : missing) {
+      findOrAllocate(coords);
+    }
+  }
+
+  void upload() {
+    if (!dirty) {
+      return;
+    }
+    chunkList.clear();
+    for (uint32_t slot = 0; slot < capacity; ++slot) {
+      if (used[slot]) {
+        chunkList.push_back(slot);
+      }
+    }
+    tableBuffer.setData(table, GL_DYNAMIC_DRAW);
+    listBuffer.setData(chunkList, GL_DYNAMIC_DRAW);
+    dirty = false;
+  }
+
+  // one workgroup of groups along z per chunk of chunkList
+  void dispatchChunks(ComputeShader& shader, Pipeline& pipeline,
+                      const glm::uvec2& groups) {
+    pipeline.activate();
+    for (std::size_t first = 0; first < chunkList.size();
+         first += maxGroupsZ) {
+      const std::size_t n_chunks =
+          std::min<std::size_t>(chunkList.size() - first, maxGroupsZ);
+      shader.setUniform("firstChunk", static_cast<uint32_t>(first));
+      glDispatchCompute(groups.x, groups.y, n_chunks);
+    }
+    pipeline.deactivate();
+  }
+
+  void bindChunks() const {
+    tableBuffer.bindToShaderStorageBuffer(2);
+    listBuffer.bindToShaderStorageBuffer(3);
+    flags.bindToShaderStorageBuffer(4);
+  }
+
+ public:
+  ChunkedWorld()
+      : capacity{0},
+        full{false},
+        dirty{true},
+        generation{0},
+        flagsReadback{N_READBACK_SLOTS},
+        updateChunks{getShaderPath("update-chunks.comp")},
+        drawView{getShaderPath("draw-view.comp")} {
+    updateChunksPipeline.attachComputeShader(updateChunks);
+    drawViewPipeline.attachComputeShader(drawView);
+
+    GLint max_groups_z;
+    glGetIntegeri_v(GL_MAX_COMPUTE_WORK_GROUP_COUNT, 2, &max_groups_z);
+    maxGroupsZ = max_groups_z;
+    // the index of a word has to fit a uint in the shaders too
+    GLint64 max_block_size;
+    glGetInteger64v(GL_MAX_SHADER_STORAGE_BLOCK_SIZE, &max_block_size);
+    maxCapacity = std::min<GLint64>(
+        max_block_size / (CHUNK_WORDS * sizeof(uint32_t)),
+        (uint64_t(1) << 32) / CHUNK_WORDS - 1);
+    spdlog::info("[ChunkedWorld] up to {} chunks, {} per dispatch",
+                 maxCapacity, maxGroupsZ);
+
+    grow();
+  }
+
+  // free every chunk
+  void clear() {
+    // flags in flight belong to the old chunks
+    flagsReadback.flush([](uint64_t, const std::byte*, std::size_t) {});
+    for (uint32_t slot = 0; slot < capacity; ++slot) {
+      if (used[slot]) {
+        free(slot);
+      }
+    }
+    generation = 0;
+    full = false;
+  }
+
+  // replace the world with a board of packed cells, packedWidth words per
+  // row, with cell (0, 0) at the origin
+  void setCells(const std::vector<uint32_t>& words, uint32_t packedWidth,
+                uint32_t height) {
+    clear();
+
+    const glm::ivec2 n_chunks((packedWidth + CHUNK_WIDTH - 1) / CHUNK_WIDTH,
+                              (height + CHUNK_SIZE - 1) / CHUNK_SIZE);
+    std::vector<uint32_t> chunk(CHUNK_WORDS);
+    // dead chunks around the board, cells at its edge may spread at once
+    for (int cy = -1; cy <= n_chunks.y; ++cy) {
+      for (int cx = -1; cx <= n_chunks.x; ++cx) {
+        const uint32_t slot = allocate(glm::ivec2(cx, cy));
+        if (slot == NO_CHUNK || cx < 0 || cy < 0 || cx == n_chunks.x ||
+            cy == n_chunks.y) {
+          continue;
+        }
+
+        bool alive = false;
+        for (uint32_t y = 0; y < CHUNK_SIZE; ++y) {
+          for (uint32_t x = 0; x < CHUNK_WIDTH; ++x) {
+            const uint32_t wx = cx * CHUNK_WIDTH + x;
+            const uint32_t wy = cy * CHUNK_SIZE + y;
+            const uint32_t word =
+                wx < packedWidth && wy < height ? words[wx + wy * packedWidth]
+                                                : 0;
+            chunk[x + y * CHUNK_WIDTH] = word;
+            alive = alive || word != 0;
+          }
+        }
+        cellsIn.setSubData(chunk.data(), slot * CHUNK_WORDS, CHUNK_WORDS);
+        const uint32_t chunk_flags = alive ? ALIVE : 0;
+        flags.setSubData(&chunk_flags, slot, 1);
+      }
+    }
+
+    spdlog::info("[ChunkedWorld] {} chunks", getNumberOfChunks());
+  }
+
+  // replace the cells of a chunk with CHUNK_WORDS packed cells of a buffer
+  // from offset on, allocating it if needed
+  void setChunk(const glm::ivec2& coords, const Buffer& source,
+                std::size_t offset) {
+    const uint32_t slot = findOrAllocate(coords);
+    if (slot == NO_CHUNK) {
+      return;
+    }
+    cellsIn.copySubData<uint32_t>(source, offset, slot * CHUNK_WORDS,
+                                  CHUNK_WORDS);
+    flags.setSubData(&ALIVE, slot, 1);
+  }
+
+  // allocate dead chunks around every chunk, cells at the edge of chunks set
+  // by setChunk may spread at once
+  void surroundChunks() {
+    std::vector<glm::ivec2> coords;
+    for (uint32_t slot = 0; slot < capacity; ++slot) {
+      if (used[slot]) {
+        coords.push_back(table[slot].coords);
+      }
+    }
+    for (const glm::ivec2& c : coords) {
+      for (int dy = -1; dy <= 1; ++dy) {
+        for (int dx = -1; dx <= 1; ++dx) {
+          findOrAllocate(c + glm::ivec2(dx, dy));
+        }
+      }
+    }
+  }
+
+  // pool of chunks of CHUNK_WORDS words each
+  const Buffer& getCells() const { return cellsIn; }
+
+  // allocated chunks, the one at coords[i] is in slot chunkSlots[i]
+  void getChunks(std::vector<glm::ivec2>& coords,
+                 std::vector<uint32_t>& chunkSlots) const {
+    coords.clear();
+    chunkSlots.clear();
+    for (uint32_t slot = 0; slot < capacity; ++slot) {
+      if (used[slot]) {
+        coords.push_back(table[slot].coords);
+        chunkSlots.push_back(slot);
+      }
+    }
+  }
+
+  uint64_t getGeneration() const { return generation; }
+
+  std::size_t getNumberOfChunks() const { return slots.size(); }
+
+  uint32_t getCapacity() const { return capacity; }
+
+  // one generation of every allocated chunk
+  void step() {
+    upload();
+    if (chunkList.empty()) {
+      return;
+    }
+
+    flags.clear();
+    cellsIn.bindToShaderStorageBuffer(0);
+    cellsOut.bindToShaderStorageBuffer(1);
+    bindChunks();
+    dispatchChunks(updateChunks, updateChunksPipeline,
+                   glm::uvec2(1, CHUNK_SIZE / 32));
+
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+    std::swap(cellsIn, cellsOut);
+    generation++;
+
+    const auto process = [&](uint64_t step, const std::byte* data,
+                             std::size_t size) {
+      processFlags(step, reinterpret_cast<const uint32_t*>(data),
+                   size / sizeof(uint32_t));
+    };
+    // waiting on a full ring bounds the lag of the flags
+    if (flagsReadback.isFull()) {
+      flagsReadback.poll(process, true);
+    }
+    flagsReadback.request(
+        {{&flags, 0, static_cast<GLsizeiptr>(capacity * sizeof(uint32_t))}},
+        generation);
+    flagsReadback.poll(process);
+  }
+
+  // fill a packed r32ui texture of size texels with blocks of
+  // 2^blockLevel x 2^blockLevel cells from origin on, see
+  // chunked/draw-view.comp. origin must be a multiple of the block size.
+  void draw(Texture& view, const glm::ivec2& origin, uint32_t blockLevel,
+            const glm::uvec2& size) {
+    upload();
+
+    const glm::uvec2 packed_size((size.x + 31) / 32, size.y);
+    if (view.getResolution() != packed_size) {
+      view.resize(packed_size);
+    }
+    glClearTexImage(view.getTextureName(), 0, GL_RED_INTEGER, GL_UNSIGNED_INT,
+                    nullptr);
+    if (chunkList.empty()) {
+      return;
+    }
+
+    cellsIn.bindToShaderStorageBuffer(0);
+    bindChunks();
+    view.bindToImageUnit(0, GL_READ_WRITE);
+    drawView.setUniform("origin", origin);
+    drawView.setUniform("blockLevel", blockLevel);
+    drawView.setUniform("size", size);
+    const uint32_t n_blocks = std::max(CHUNK_SIZE >> blockLevel, 1u);
+    dispatchChunks(drawView, drawViewPipeline,
+                   glm::uvec2(std::ceil(n_blocks / 8.0f)));
+
+    glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+  }
+};
+
+#endif
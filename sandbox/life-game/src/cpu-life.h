@@ -0,0 +1,307 @@
+#ifndef _CPU_LIFE_H
+#define _CPU_LIFE_H
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstring>
+#include <vector>
+
+#include "glad/gl.h"
+#include "glm/glm.hpp"
+#include "spdlog/spdlog.h"
+//
+#include "gcss/texture.h"
+#include "gcss/thread-pool.h"
+//
+#include "simd-words.h"
+
+using namespace gcss;
+
+// CPU implementation of packed/update-cells.comp. rows are packed 64 cells
+// per word, bit i of word x is cell 64 * x + i, and stepped with the same
+// adder network a SIMD vector of words at a time, bands of rows in parallel.
+// the board is split into blocks, a block is only stepped when it or one of
+// its neighbors changed in the last generation, so empty and settled regions
+// cost nothing. skipped blocks still hold the cells of two generations ago,
+// which are the same.
+class CpuLife {
+ public:
+  // words per block and rows per band. a band is one task, a block is the
+  // unit of skipping.
+  static constexpr uint32_t BLOCK_WORDS = 8;
+  static constexpr uint32_t BAND_HEIGHT = 32;
+
+  static_assert(BLOCK_WORDS % SimdWords::WIDTH == 0);
+
+ private:
+  ThreadPool& pool;
+
+  uint32_t width;
+  uint32_t height;
+  // words of a row, whole blocks
+  uint32_t nWords;
+  // a dead word on both sides of a row
+  uint32_t stride;
+  glm::uvec2 nBlocks;
+
+  // rows with a dead row above and below, the current generation and the
+  // previous one
+  std::vector<uint64_t> cells[2];
+  uint32_t current;
+  // cells of a word which are on the board
+  std::vector<uint64_t> masks;
+  // blocks which changed in the last generation, and the ones changing in
+  // the next
+  std::vector<uint8_t> changed[2];
+
+  uint64_t generation;
+  uint32_t nActiveBlocks;
+  double cellUpdatesPerSecond;
+
+  static void fullAdd(SimdWords a, SimdWords b, SimdWords c, SimdWords& sum,
+                      SimdWords& carry) {
+    const SimdWords ab = a ^ b;
+    sum = ab ^ c;
+    carry = (a & b) | (ab & c);
+  }
+
+  // B3/S23 of the words at row, same as nextGeneration in packed/packed.glsl
+  static SimdWords nextGeneration(const uint64_t* above, const uint64_t* row,
+                                  const uint64_t* below) {
+    const SimdWords above_center = SimdWords::load(above);
+    SimdWords above_sum, above_carry;
+    fullAdd(SimdWords::shiftWest(SimdWords::load(above - 1), above_center),
+            above_center,
+            SimdWords::shiftEast(above_center, SimdWords::load(above + 1)),
+            above_sum, above_carry);
+
+    const SimdWords below_center = SimdWords::load(below);
+    SimdWords below_sum, below_carry;
+    fullAdd(SimdWords::shiftWest(SimdWords::load(below - 1), below_center),
+            below_center,
+            SimdWords::shiftEast(below_center, SimdWords::load(below + 1)),
+            below_sum, below_carry);
+
+    const SimdWords center = SimdWords::load(row);
+    const SimdWords west =
+        SimdWords::shiftWest(SimdWords::load(row - 1), center);
+    const SimdWords east =
+        SimdWords::shiftEast(center, SimdWords::load(row + 1));
+    const SimdWords row_sum = west ^ east;
+    const SimdWords row_carry = west & east;
+
+    SimdWords ones, ones_carry;
+    fullAdd(above_sum, below_sum, row_sum, ones, ones_carry);
+    SimdWords twos_sum, twos_carry;
+    fullAdd(above_carry, below_carry, row_carry, twos_sum, twos_carry);
+
+    const SimdWords two_or_three =
+        SimdWords::andNot(twos_carry, twos_sum ^ ones_carry);
+    return two_or_three & (ones | center);
+  }
+
+  uint64_t* getRow(uint32_t index, uint32_t y) {
+    return cells[index].data() + (y + 1) * stride + 1;
+  }
+  const uint64_t* getRow(uint32_t index, uint32_t y) const {
+    return cells[index].data() + (y + 1) * stride + 1;
+  }
+
+  bool isActive(uint32_t bx, uint32_t by) const {
+    const std::vector<uint8_t>& last = changed[current];
+    const uint32_t x0 = bx > 0 ? bx - 1 : 0;
+    const uint32_t x1 = std::min(bx + 1, nBlocks.x - 1);
+    const uint32_t y0 = by > 0 ? by - 1 : 0;
+    const uint32_t y1 = std::min(by + 1, nBlocks.y - 1);
+    for (uint32_t y = y0; y <= y1; ++y) {
+      for (uint32_t x = x0; x <= x1; ++x) {
+        if (last[x + y * nBlocks.x]) {
+          return true;
+        }
+      }
+    }
+    return false;
+  }
+
+  // returns whether any cell of the block changed
+  bool updateBlock(uint32_t bx, uint32_t by) {
+    const uint32_t x0 = bx * BLOCK_WORDS;
+    const uint32_t y1 = std::min((by + 1) * BAND_HEIGHT, height);
+    SimdWords difference = SimdWords::zero();
+    for (uint32_t y = by * BAND_HEIGHT; y < y1; ++y) {
+      const uint64_t* row = getRow(current, y) + x0;
+      uint64_t* out = getRow(1 - current, y) + x0;
+      for (uint32_t x = 0; x < BLOCK_WORDS; x += SimdWords::WIDTH) {
+        const SimdWords next =
+            nextGeneration(row + x - stride, row + x, row + x + stride) &
+            SimdWords::load(masks.data() + x0 + x);
+        difference = difference | (next ^ SimdWords::load(row + x));
+        next.store(out + x);
+      }
+    }
+    return !difference.isZero();
+  }
+
+ public:
+  CpuLife(ThreadPool& pool)
+      : pool{pool},
+        width{0},
+        height{0},
+        nWords{0},
+        stride{0},
+        nBlocks{0},
+        current{0},
+        generation{0},
+        nActiveBlocks{0},
+        cellUpdatesPerSecond{0} {
+    spdlog::info("[CpuLife] {} threads, {}", pool.getNumberOfThreads(),
+                 SimdWords::NAME);
+  }
+
+  // packed cells with (width + 31) / 32 words per row like
+  // packed/packed.glsl, every block is stepped in the next generation
+  void setCells(const std::vector<uint32_t>& words, uint32_t width,
+                uint32_t height) {
+    this->width = width;
+    this->height = height;
+    nBlocks = glm::uvec2((width + 64 * BLOCK_WORDS - 1) / (64 * BLOCK_WORDS),
+                         (height + BAND_HEIGHT - 1) / BAND_HEIGHT);
+    nWords = nBlocks.x * BLOCK_WORDS;
+    stride = nWords + 2;
+
+    masks.resize(nWords);
+    for (uint32_t x = 0; x < nWords; ++x) {
+      const uint32_t n = std::min(std::max(width, 64 * x) - 64 * x, 64u);
+      masks[x] = n == 64 ? ~uint64_t(0) : (uint64_t(1) << n) - 1;
+    }
+
+    current = 0;
+    for (auto& c : cells) {
+      c.assign(std::size_t(height + 2) * stride, 0);
+    }
+    const uint32_t packed_width = (width + 31) / 32;
+    for (uint32_t y = 0; y < height; ++y) {
+      uint64_t* row = getRow(current, y);
+      for (uint32_t x = 0; x < packed_width; ++x) {
+        row[x / 2] |= uint64_t(words[x + y * packed_width]) << (32 * (x % 2));
+      }
+    }
+
+    for (auto& c : changed) {
+      c.assign(nBlocks.x * nBlocks.y, 1);
+    }
+    generation = 0;
+  }
+
+  // inverse of setCells
+  void getCells(std::vector<uint32_t>& words) const {
+    const uint32_t packed_width = (width + 31) / 32;
+    words.resize(packed_width * height);
+    for (uint32_t y = 0; y < height; ++y) {
+      const uint64_t* row = getRow(current, y);
+      for (uint32_t x = 0; x < packed_width; ++x) {
+        words[x + y * packed_width] =
+            static_cast<uint32_t>(row[x / 2] >> (32 * (x % 2)));
+      }
+    }
+  }
+
+  // r8ui cells or r32ui packed cells of a board width cells wide
+  void readTexture(const Texture& texture, uint32_t width) {
+    const glm::uvec2 resolution = texture.getResolution();
+    const uint32_t packed_width = (width + 31) / 32;
+    std::vector<uint32_t> words(packed_width * resolution.y);
+
+    glMemoryBarrier(GL_TEXTURE_UPDATE_BARRIER_BIT);
+    if (texture.getInternalFormat() == GL_R32UI) {
+      glGetTextureImage(texture.getTextureName(), 0, GL_RED_INTEGER,
+                        GL_UNSIGNED_INT, words.size() * sizeof(uint32_t),
+                        words.data());
+    } else {
+      std::vector<uint8_t> bytes(resolution.x * resolution.y);
+      glPixelStorei(GL_PACK_ALIGNMENT, 1);
+      glGetTextureImage(texture.getTextureName(), 0, GL_RED_INTEGER,
+                        GL_UNSIGNED_BYTE, bytes.size(), bytes.data());
+      for (uint32_t y = 0; y < resolution.y; ++y) {
+        for (uint32_t x = 0; x < width; ++x) {
+          words[x / 32 + y * packed_width] |=
+              uint32_t(bytes[x + y * resolution.x] != 0) << (x % 32);
+        }
+      }
+    }
+    setCells(words, width, resolution.y);
+  }
+
+  // into a texture of the same size and format as the one read
+  void writeTexture(Texture& texture) {
+    std::vector<uint32_t> words;
+    getCells(words);
+    const glm::uvec2 resolution = texture.getResolution();
+    if (texture.getInternalFormat() == GL_R32UI) {
+      texture.setImage(words, resolution, GL_R32UI, GL_RED_INTEGER,
+                       GL_UNSIGNED_INT);
+      return;
+    }
+
+    const uint32_t packed_width = (width + 31) / 32;
+    std::vector<uint8_t> bytes(resolution.x * resolution.y);
+    for (uint32_t y = 0; y < resolution.y; ++y) {
+      for (uint32_t x = 0; x < width; ++x) {
+        bytes[x + y * resolution.x] =
+            (words[x / 32 + y * packed_width] >> (x % 32)) & 1;
+      }
+    }
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    texture.setImage(bytes, resolution, GL_R8UI, GL_RED_INTEGER,
+                     GL_UNSIGNED_BYTE);
+  }
+
+  void step() {
+    const auto start = std::chrono::steady_clock::now();
+
+    std::atomic<uint32_t> n_active{0};
+    pool.parallelFor(0, nBlocks.y, 1, [&](std::size_t begin, std::size_t end) {
+      uint32_t active = 0;
+      for (uint32_t by = begin; by < end; ++by) {
+        for (uint32_t bx = 0; bx < nBlocks.x; ++bx) {
+          bool block_changed = false;
+          if (isActive(bx, by)) {
+            active++;
+            block_changed = updateBlock(bx, by);
+          }
+          changed[1 - current][bx + by * nBlocks.x] = block_changed;
+        }
+      }
+      n_active += active;
+    });
+    current = 1 - current;
+    generation++;
+    nActiveBlocks = n_active;
+
+    const std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - start;
+    cellUpdatesPerSecond =
+        static_cast<double>(width) * height / std::max(elapsed.count(), 1e-9);
+  }
+
+  uint64_t getGeneration() const { return generation; }
+
+  uint64_t getPopulation() const {
+    uint64_t population = 0;
+    for (const uint64_t word : cells[current]) {
+      population += std::popcount(word);
+    }
+    return population;
+  }
+
+  uint32_t getNumberOfBlocks() const { return nBlocks.x * nBlocks.y; }
+
+  // blocks stepped in the last generation
+  uint32_t getNumberOfActiveBlocks() const { return nActiveBlocks; }
+
+  // cells of the board per second of the last step, skipped blocks included
+  double getCellUpdatesPerSecond() const { return cellUpdatesPerSecond; }
+};
+
+#endif
@@ -0,0 +1,151 @@
+#ifndef _DENSITY_PYRAMID_H
+#define _DENSITY_PYRAMID_H
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <filesystem>
+#include <vector>
+
+#include "glad/gl.h"
+#include "glm/glm.hpp"
+//
+#include "gcss/shader.h"
+#include "gcss/texture.h"
+
+using namespace gcss;
+
+// live cells per 2^k x 2^k block of the board for k = 1 up to a single
+// texel, so that zoomed out every pixel shows the density of the cells it
+// covers at the same cost for any board size. rebuilt only when the board
+// changed since the last build.
+class DensityPyramid {
+ private:
+  // level k at k - 1, r32ui
+  std::vector<Texture> levels;
+  // generation of the board the pyramid was built from
+  uint64_t generation;
+  bool valid;
+  // cells changed since the build, from dirtyMin up to dirtyMax excluded
+  glm::ivec2 dirtyMin;
+  glm::ivec2 dirtyMax;
+
+  ComputeShader reduceCells;
+  Pipeline reduceCellsPipeline;
+  ComputeShader reduceCounts;
+  Pipeline reduceCountsPipeline;
+
+  static std::filesystem::path getShaderPath(const std::string& filename) {
+    return std::filesystem::path(CMAKE_CURRENT_SOURCE_DIR) / "shaders" /
+           "density" / filename;
+  }
+
+  void allocate(const glm::uvec2& size) {
+    if (!levels.empty() &&
+        levels.front().getResolution() == (size + 1u) / 2u) {
+      return;
+    }
+
+    levels.clear();
+    glm::uvec2 level_size = size;
+    while (level_size.x > 1 || level_size.y > 1) {
+      level_size = (level_size + 1u) / 2u;
+      levels.emplace_back(level_size, GL_R32UI, GL_RED_INTEGER,
+                          GL_UNSIGNED_INT);
+    }
+  }
+
+ public:
+  DensityPyramid()
+      : generation{0},
+        valid{false},
+        dirtyMin{0},
+        dirtyMax{0},
+        reduceCells{getShaderPath("reduce-cells.comp")},
+        reduceCounts{getShaderPath("reduce-counts.comp")} {
+    reduceCellsPipeline.attachComputeShader(reduceCells);
+    reduceCountsPipeline.attachComputeShader(reduceCounts);
+  }
+
+  // the board was changed other than by stepping it
+  void invalidate() { valid = false; }
+
+  // cells from min up to max excluded were changed other than by stepping
+  // the board, only their blocks are rebuilt
+  void invalidate(const glm::ivec2& min, const glm::ivec2& max) {
+    if (glm::any(glm::lessThan(dirtyMin, dirtyMax))) {
+      dirtyMin = glm::min(dirtyMin, min);
+      dirtyMax = glm::max(dirtyMax, max);
+    } else {
+      dirtyMin = min;
+      dirtyMax = max;
+    }
+  }
+
+  // levels of the board given by the cells of the current format and the
+  // board size in cells, skipped when generation was built already
+  void build(const Texture& cells, const Texture& packedCells, bool bitPacked,
+             const glm::uvec2& size, uint64_t generation) {
+    // changed cells, all of them unless only edits happened since the build
+    glm::ivec2 min(0);
+    glm::ivec2 max(size);
+    if (valid && this->generation == generation) {
+      if (glm::any(glm::greaterThanEqual(dirtyMin, dirtyMax))) {
+        return;
+      }
+      min = dirtyMin;
+      max = dirtyMax;
+    }
+    dirtyMin = dirtyMax = glm::ivec2(0);
+    this->generation = generation;
+    valid = true;
+    allocate(size);
+    if (levels.empty()) {
+      return;
+    }
+
+    // blocks of level k from min >> k up to ((max - 1) >> k) + 1
+    const auto dispatch = [&](ComputeShader& shader, int level) {
+      const glm::ivec2 first = min >> level;
+      const glm::ivec2 last = ((max - 1) >> level) + 1;
+      shader.setUniform("origin", first);
+      glDispatchCompute(std::ceil((last.x - first.x) / 8.0f),
+                        std::ceil((last.y - first.y) / 8.0f), 1);
+    };
+
+    cells.bindToImageUnit(0, GL_READ_ONLY);
+    packedCells.bindToImageUnit(1, GL_READ_ONLY);
+    levels[0].bindToImageUnit(2, GL_WRITE_ONLY);
+    reduceCells.setUniform("bitPacked", bitPacked);
+    reduceCellsPipeline.activate();
+    dispatch(reduceCells, 1);
+    reduceCellsPipeline.deactivate();
+
+    reduceCountsPipeline.activate();
+    for (std::size_t k = 1; k < levels.size(); ++k) {
+      glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+      levels[k - 1].bindToImageUnit(0, GL_READ_ONLY);
+      levels[k].bindToImageUnit(1, GL_WRITE_ONLY);
+      dispatch(reduceCounts, k + 1);
+    }
+    reduceCountsPipeline.deactivate();
+
+    glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+  }
+
+  // the level whose blocks are about the size of a pixel at scale on a board
+  // of size cells, 0 means single cells
+  static uint32_t getLevel(float scale, const glm::uvec2& size) {
+    if (scale >= 1) {
+      return 0;
+    }
+    const uint32_t n_levels =
+        std::bit_width(std::max({size.x, size.y, 1u}) - 1);
+    const float level = std::round(-std::log2(scale));
+    return std::min(static_cast<uint32_t>(level), n_levels);
+  }
+
+  // blocks of 2^level x 2^level cells, level >= 1
+  const Texture& getCounts(uint32_t level) const { return levels[level - 1]; }
+};
+
+#endif
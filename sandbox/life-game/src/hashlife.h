@@ -0,0 +1,748 @@
+#ifndef _HASHLIFE_H
+#define _HASHLIFE_H
+#include <algorithm>
+#include <charconv>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "spdlog/spdlog.h"
+
+// HashLife for B3/S23 on an unbounded plane. the universe is a quadtree of
+// hash-consed nodes, so identical squares exist once, and every node memoizes
+// its center 2^step generations ahead. repetitive or sparse patterns jump
+// 2^step generations in about as many node visits as the pattern has
+// distinct squares.
+//
+// a node of level n covers 2^n x 2^n cells, nw covers the lowest x and y, ne
+// the highest x and lowest y, sw the lowest x and highest y. the root is
+// centered at the origin, i.e. it covers [-2^(n-1), 2^(n-1)) on both axes.
+class HashLife {
+ public:
+  static constexpr uint32_t NONE = std::numeric_limits<uint32_t>::max();
+  // levels above do not fit into 64 bit coordinates
+  static constexpr uint32_t MAX_LEVEL = 60;
+
+ private:
+  // marks a slot on the free list
+  static constexpr uint8_t FREE = 0xff;
+
+  struct Node {
+    uint32_t nw, ne, sw, se;
+    // center 2^min(level - 2, stepExponent) generations ahead, NONE until
+    // computed
+    uint32_t result;
+    // step in which the node was last used, for garbage collection
+    uint32_t lastUse;
+    uint64_t population;
+    uint8_t level;
+  };
+
+  // nodes 0 and 1 are the dead and the live cell
+  std::vector<Node> nodes;
+  std::vector<uint32_t> freeNodes;
+  std::size_t nNodes;
+  // open addressing, indices of nodes keyed by their children
+  std::vector<uint32_t> table;
+  std::vector<uint32_t> emptyNodes;
+
+  uint32_t root;
+  uint32_t stepExponent;
+  uint64_t generation;
+  // incremented every step
+  uint32_t stamp;
+
+  // nodes are collected once there are more
+  std::size_t maxNodes;
+  // results used within the last steps survive a collection
+  uint32_t keepSteps;
+
+  static uint64_t hash(uint32_t nw, uint32_t ne, uint32_t sw, uint32_t se) {
+    uint64_t h = nw;
+    h = h * 0x9e3779b97f4a7c15ull + ne;
+    h = h * 0x9e3779b97f4a7c15ull + sw;
+    h = h * 0x9e3779b97f4a7c15ull + se;
+    return h ^ (h >> 29);
+  }
+
+  void insert(uint32_t index) {
+    const Node& node = nodes[index];
+    const std::size_t mask = table.size() - 1;
+    std::size_t slot = hash(node.nw, node.ne, node.sw, node.se) & mask;
+    while (table[slot] != NONE) {
+      slot = (slot + 1) & mask;
+    }
+    table[slot] = index;
+  }
+
+  void rehash(std::size_t size) {
+    table.assign(size, NONE);
+    for (uint32_t i = 2; i < nodes.size(); ++i) {
+      if (nodes[i].level != FREE) {
+        insert(i);
+      }
+    }
+  }
+
+  // the unique node with these children
+  uint32_t join(uint32_t nw, uint32_t ne, uint32_t sw, uint32_t se) {
+    const std::size_t mask = table.size() - 1;
+    std::size_t slot = hash(nw, ne, sw, se) & mask;
+    while (table[slot] != NONE) {
+      const Node& node = nodes[table[slot]];
+      if (node.nw == nw && node.ne == ne && node.sw == sw && node.se == se) {
+        return table[slot];
+      }
+      slot = (slot + 1) & mask;
+    }
+
+    Node node;
+    node.nw = nw;
+    node.ne = ne;
+    node.sw = sw;
+    node.se = se;
+    node.result = NONE;
+    node.lastUse = stamp;
+    node.population = nodes[nw].population + nodes[ne].population +
+                      nodes[sw].population + nodes[se].population;
+    node.level = nodes[nw].level + 1;
+
+    uint32_t index;
+    if (!freeNodes.empty()) {
+      index = freeNodes.back();
+      freeNodes.pop_back();
+      nodes[index] = node;
+    } else {
+      index = nodes.size();
+      nodes.push_back(node);
+    }
+    table[slot] = index;
+    nNodes++;
+
+    // keep the load factor below 1/2
+    if (2 * nNodes > table.size()) {
+      rehash(2 * table.size());
+    }
+
+    return index;
+  }
+
+  uint32_t getEmpty(uint32_t level) {
+    while (emptyNodes.size() <= level) {
+      const uint32_t e = emptyNodes.back();
+      emptyNodes.push_back(join(e, e, e, e));
+    }
+    return emptyNodes[level];
+  }
+
+  // the centered node one level up with this node in the middle
+  uint32_t expand(uint32_t index) {
+    const Node node = nodes[index];
+    const uint32_t e = getEmpty(node.level - 1);
+    return join(join(e, e, e, node.nw), join(e, e, node.ne, e),
+                join(e, node.sw, e, e), join(node.se, e, e, e));
+  }
+
+  // the centered node one level down
+  uint32_t getCenter(uint32_t index) {
+    const Node node = nodes[index];
+    return join(nodes[node.nw].se, nodes[node.ne].sw, nodes[node.sw].ne,
+                nodes[node.se].nw);
+  }
+
+  // one generation of the center 2x2 cells of a 4x4 node
+  uint32_t stepLevel2(uint32_t index) {
+    // bit x + 4 * y is cell (x, y)
+    uint32_t cells = 0;
+    const Node& node = nodes[index];
+    const uint32_t quadrants[4] = {node.nw, node.ne, node.sw, node.se};
+    for (uint32_t q = 0; q < 4; ++q) {
+      const Node& child = nodes[quadrants[q]];
+      const uint32_t x = 2 * (q % 2);
+      const uint32_t y = 2 * (q / 2);
+      cells |= child.nw << (x + 4 * y);
+      cells |= child.ne << (x + 1 + 4 * y);
+      cells |= child.sw << (x + 4 * (y + 1));
+      cells |= child.se << (x + 1 + 4 * (y + 1));
+    }
+
+    uint32_t next[4];
+    for (uint32_t i = 0; i < 4; ++i) {
+      const int x = 1 + i % 2;
+      const int y = 1 + i / 2;
+      uint32_t n_alive = 0;
+      for (int dy = -1; dy <= 1; ++dy) {
+        for (int dx = -1; dx <= 1; ++dx) {
+          if (dx != 0 || dy != 0) {
+            n_alive += (cells >> (x + dx + 4 * (y + dy))) & 1;
+          }
+        }
+      }
+      const uint32_t alive = (cells >> (x + 4 * y)) & 1;
+      next[i] = n_alive == 3 || (alive && n_alive == 2);
+    }
+    return join(next[0], next[1], next[2], next[3]);
+  }
+
+  // center of a node of level n >= 2, 2^(n - 2) generations ahead at full
+  // speed, i.e. up to level stepExponent + 2, and 2^stepExponent above.
+  // joins may reallocate nodes, so nodes are copied rather than referenced.
+  uint32_t getResult(uint32_t index) {
+    nodes[index].lastUse = stamp;
+    const Node n = nodes[index];
+    if (n.result != NONE) {
+      return n.result;
+    }
+    if (n.population == 0) {
+      const uint32_t result = getEmpty(n.level - 1);
+      return nodes[index].result = result;
+    }
+    if (n.level == 2) {
+      const uint32_t result = stepLevel2(index);
+      return nodes[index].result = result;
+    }
+
+    // nine overlapping subnodes one level down
+    const Node nw = nodes[n.nw];
+    const Node ne = nodes[n.ne];
+    const Node sw = nodes[n.sw];
+    const Node se = nodes[n.se];
+    uint32_t sub[9] = {
+        n.nw, join(nw.ne, ne.nw, nw.se, ne.sw), n.ne,
+        join(nw.sw, nw.se, sw.nw, sw.ne), join(nw.se, ne.sw, sw.ne, se.nw),
+        join(ne.sw, ne.se, se.nw, se.ne), n.sw,
+        join(sw.ne, se.nw, sw.se, se.sw), n.se};
+
+    // at full speed both halves advance, otherwise only the second one
+    const bool full_speed = n.level <= stepExponent + 2;
+    for (uint32_t& s : sub) {
+      s = full_speed ? getResult(s) : getCenter(s);
+    }
+
+    const uint32_t result =
+        join(getResult(join(sub[0], sub[1], sub[3], sub[4])),
+             getResult(join(sub[1], sub[2], sub[4], sub[5])),
+             getResult(join(sub[3], sub[4], sub[6], sub[7])),
+             getResult(join(sub[4], sub[5], sub[7], sub[8])));
+    return nodes[index].result = result;
+  }
+
+  // results up to level minLevel - 1 do not depend on the step
+  void clearResults(uint32_t minLevel = 0) {
+    for (uint32_t i = 2; i < nodes.size(); ++i) {
+      if (nodes[i].level != FREE && nodes[i].level >= minLevel) {
+        nodes[i].result = NONE;
+      }
+    }
+  }
+
+  void mark(uint32_t index, std::vector<bool>& marked, bool keepResults) {
+    if (index < 2 || marked[index]) {
+      return;
+    }
+    marked[index] = true;
+    const Node& node = nodes[index];
+    mark(node.nw, marked, keepResults);
+    mark(node.ne, marked, keepResults);
+    mark(node.sw, marked, keepResults);
+    mark(node.se, marked, keepResults);
+    if (keepResults && node.result != NONE) {
+      mark(node.result, marked, keepResults);
+    }
+  }
+
+  template <typename F>
+  uint32_t build(uint32_t level, int64_t x, int64_t y, int64_t width,
+                 int64_t height, F&& isAlive) {
+    const int64_t size = int64_t(1) << level;
+    if (x >= width || y >= height || x + size <= 0 || y + size <= 0) {
+      return getEmpty(level);
+    }
+    if (level == 0) {
+      return isAlive(x, y) ? 1 : 0;
+    }
+
+    const int64_t half = size / 2;
+    return join(build(level - 1, x, y, width, height, isAlive),
+                build(level - 1, x + half, y, width, height, isAlive),
+                build(level - 1, x, y + half, width, height, isAlive),
+                build(level - 1, x + half, y + half, width, height, isAlive));
+  }
+
+  // node of packed cells from cell (x, y) on, stride words per row
+  uint32_t buildWords(uint32_t level, uint32_t x, uint32_t y,
+                      const uint32_t* words, uint32_t stride) {
+    if (level == 0) {
+      return (words[x / 32 + y * stride] >> (x % 32)) & 1;
+    }
+
+    // squares without live cells are shared
+    const uint32_t size = 1u << level;
+    const uint32_t mask =
+        size >= 32 ? 0xffffffffu : ((1u << size) - 1) << (x % 32);
+    bool alive = false;
+    for (uint32_t j = 0; j < size && !alive; ++j) {
+      for (uint32_t i = x / 32; i < (x + size + 31) / 32 && !alive; ++i) {
+        alive = (words[i + (y + j) * stride] & mask) != 0;
+      }
+    }
+    if (!alive) {
+      return getEmpty(level);
+    }
+
+    const uint32_t half = size / 2;
+    return join(buildWords(level - 1, x, y, words, stride),
+                buildWords(level - 1, x + half, y, words, stride),
+                buildWords(level - 1, x, y + half, words, stride),
+                buildWords(level - 1, x + half, y + half, words, stride));
+  }
+
+  // node at (x, y) with the square of block at (blockX, blockY) replaced by
+  // block
+  uint32_t replace(uint32_t index, int64_t x, int64_t y, int64_t blockX,
+                   int64_t blockY, uint32_t block) {
+    const Node node = nodes[index];
+    if (node.level == nodes[block].level) {
+      return block;
+    }
+
+    const int64_t half = int64_t(1) << (node.level - 1);
+    const bool east = blockX >= x + half;
+    const bool south = blockY >= y + half;
+    uint32_t children[4] = {node.nw, node.ne, node.sw, node.se};
+    uint32_t& child = children[east + 2 * south];
+    child = replace(child, x + east * half, y + south * half, blockX, blockY,
+                    block);
+    return join(children[0], children[1], children[2], children[3]);
+  }
+
+  void setBlocks(uint32_t index, int64_t x, int64_t y, int64_t x0, int64_t y0,
+                 uint32_t blockLevel, uint32_t width, uint32_t height,
+                 uint32_t* words) const {
+    const Node& node = nodes[index];
+    const int64_t size = int64_t(1) << node.level;
+    const int64_t x1 = x0 + (int64_t(width) << blockLevel);
+    const int64_t y1 = y0 + (int64_t(height) << blockLevel);
+    if (node.population == 0 || x >= x1 || y >= y1 || x + size <= x0 ||
+        y + size <= y0) {
+      return;
+    }
+
+    if (node.level <= blockLevel) {
+      const uint32_t bx = (x - x0) >> blockLevel;
+      const uint32_t by = (y - y0) >> blockLevel;
+      words[bx / 32 + by * ((width + 31) / 32)] |= 1u << (bx % 32);
+      return;
+    }
+
+    const int64_t half = size / 2;
+    setBlocks(node.nw, x, y, x0, y0, blockLevel, width, height, words);
+    setBlocks(node.ne, x + half, y, x0, y0, blockLevel, width, height, words);
+    setBlocks(node.sw, x, y + half, x0, y0, blockLevel, width, height, words);
+    setBlocks(node.se, x + half, y + half, x0, y0, blockLevel, width, height,
+              words);
+  }
+
+  void collectBlocks(uint32_t index, int64_t x, int64_t y, uint32_t level,
+                     std::vector<std::pair<int64_t, int64_t>>& origins) const {
+    const Node& node = nodes[index];
+    if (node.population == 0) {
+      return;
+    }
+    if (node.level == level) {
+      origins.emplace_back(x, y);
+      return;
+    }
+
+    const int64_t half = int64_t(1) << (node.level - 1);
+    collectBlocks(node.nw, x, y, level, origins);
+    collectBlocks(node.ne, x + half, y, level, origins);
+    collectBlocks(node.sw, x, y + half, level, origins);
+    collectBlocks(node.se, x + half, y + half, level, origins);
+  }
+
+  // cell (x, y) of a node
+  bool getCell(uint32_t index, uint32_t x, uint32_t y) const {
+    while (nodes[index].level > 0) {
+      const Node& node = nodes[index];
+      const uint32_t half = 1u << (node.level - 1);
+      const bool east = x >= half;
+      const bool south = y >= half;
+      index = south ? (east ? node.se : node.sw) : (east ? node.ne : node.nw);
+      x -= east * half;
+      y -= south * half;
+    }
+    return index == 1;
+  }
+
+  // macrocell lines of a node and its children, returns the id of the node
+  uint32_t writeNode(uint32_t index,
+                     std::unordered_map<uint32_t, uint32_t>& ids,
+                     std::string& text) const {
+    const Node& node = nodes[index];
+    if (node.population == 0) {
+      return 0;
+    }
+    const auto it = ids.find(index);
+    if (it != ids.end()) {
+      return it->second;
+    }
+
+    if (node.level == 3) {
+      // rows from the top, without trailing dead cells
+      for (uint32_t row = 0; row < 8; ++row) {
+        std::string cells;
+        for (uint32_t x = 0; x < 8; ++x) {
+          cells += getCell(index, x, 7 - row) ? '*' : '.';
+        }
+        cells.erase(cells.find_last_not_of('.') + 1);
+        text += cells;
+        text += '$';
+      }
+      text += '\n';
+    } else {
+      // y runs down in the file, so its north is south here
+      const uint32_t nw = writeNode(node.sw, ids, text);
+      const uint32_t ne = writeNode(node.se, ids, text);
+      const uint32_t sw = writeNode(node.nw, ids, text);
+      const uint32_t se = writeNode(node.ne, ids, text);
+      text += std::to_string(node.level) + ' ' + std::to_string(nw) + ' ' +
+              std::to_string(ne) + ' ' + std::to_string(sw) + ' ' +
+              std::to_string(se) + '\n';
+    }
+
+    const uint32_t id = ids.size() + 1;
+    ids[index] = id;
+    return id;
+  }
+
+ public:
+  HashLife()
+      : nNodes{0},
+        stepExponent{0},
+        generation{0},
+        stamp{0},
+        maxNodes{1 << 22},
+        keepSteps{4} {
+    clear();
+  }
+
+  // drop every node
+  void clear() {
+    nodes.clear();
+    freeNodes.clear();
+    nNodes = 0;
+    table.assign(1 << 16, NONE);
+
+    for (uint32_t alive = 0; alive < 2; ++alive) {
+      Node leaf{};
+      leaf.result = NONE;
+      leaf.population = alive;
+      nodes.push_back(leaf);
+    }
+    emptyNodes.assign(1, 0);
+
+    root = getEmpty(3);
+    generation = 0;
+  }
+
+  // replace the universe with a width x height board at the origin
+  template <typename F>
+  void setCells(uint32_t width, uint32_t height, F&& isAlive) {
+    clear();
+
+    uint32_t level = 3;
+    while ((int64_t(1) << (level - 1)) < std::max(width, height)) {
+      level++;
+    }
+    // the board starts at the origin and the root is centered on it
+    const int64_t half = int64_t(1) << (level - 1);
+    root = build(level, -half, -half, width, height,
+                 [&](int64_t x, int64_t y) {
+                   return isAlive(static_cast<uint32_t>(x),
+                                  static_cast<uint32_t>(y));
+                 });
+  }
+
+  // replace the square of 2^level x 2^level cells at (x, y) with packed cells,
+  // 2^(level - 5) words per row. x and y must be multiples of the size and
+  // level at least 5.
+  void setBlock(int64_t x, int64_t y, uint32_t level, const uint32_t* words) {
+    const uint32_t block = buildWords(level, 0, 0, words, 1u << (level - 5));
+
+    const int64_t size = int64_t(1) << level;
+    while (true) {
+      const int64_t half = int64_t(1) << (nodes[root].level - 1);
+      if (nodes[root].level > level && x >= -half && y >= -half &&
+          x + size <= half && y + size <= half) {
+        break;
+      }
+      root = expand(root);
+    }
+    const int64_t half = int64_t(1) << (nodes[root].level - 1);
+    root = replace(root, -half, -half, x, y, block);
+  }
+
+  // origins of the squares of 2^level x 2^level cells with live cells,
+  // aligned to multiples of their size
+  void getNonEmptyBlocks(
+      uint32_t level, std::vector<std::pair<int64_t, int64_t>>& origins) const {
+    origins.clear();
+    const Node& node = nodes[root];
+    if (node.population == 0) {
+      return;
+    }
+
+    const int64_t half = int64_t(1) << (node.level - 1);
+    if (node.level <= level) {
+      // a small root lies within the four squares around the origin
+      const int64_t size = int64_t(1) << level;
+      for (const int64_t y : {-size, int64_t(0)}) {
+        for (const int64_t x : {-size, int64_t(0)}) {
+          origins.emplace_back(x, y);
+        }
+      }
+      return;
+    }
+    collectBlocks(root, -half, -half, level, origins);
+  }
+
+  // replace the universe with a Golly macrocell, [M2] with 8 x 8 leaves. y
+  // runs down in the file, i.e. cell (x, y) of the file is cell (x, -1 - y)
+  // here, and the root is centered at the origin in both.
+  bool readMacrocell(std::string_view text) {
+    clear();
+
+    // node of every id, 0 is the empty node of any level
+    std::vector<uint32_t> ids(1, 0);
+    uint64_t file_generation = 0;
+    std::size_t begin = 0;
+    while (begin < text.size()) {
+      std::size_t end = text.find('\n', begin);
+      if (end == std::string_view::npos) {
+        end = text.size();
+      }
+      std::string_view line = text.substr(begin, end - begin);
+      begin = end + 1;
+      if (!line.empty() && line.back() == '\r') {
+        line.remove_suffix(1);
+      }
+
+      if (line.empty() || line[0] == '[') {
+        continue;
+      }
+      if (line[0] == '#') {
+        if (line.starts_with("#G")) {
+          line.remove_prefix(2);
+          while (!line.empty() && line[0] == ' ') {
+            line.remove_prefix(1);
+          }
+          std::from_chars(line.data(), line.data() + line.size(),
+                          file_generation);
+        } else if (line.starts_with("#R") &&
+                   line.find("B3/S23") == std::string_view::npos) {
+          spdlog::warn("[HashLife] rule {} is run as B3/S23", line.substr(2));
+        }
+        continue;
+      }
+
+      if (line[0] == '.' || line[0] == '*' || line[0] == '$') {
+        // rows from the top, ended by $
+        uint8_t rows[8] = {};
+        uint32_t x = 0;
+        uint32_t y = 0;
+        for (const char c : line) {
+          if (c == '$') {
+            x = 0;
+            y++;
+            continue;
+          }
+          if (c == '*' && x < 8 && y < 8) {
+            rows[y] |= 1u << x;
+          }
+          x++;
+        }
+        ids.push_back(build(3, 0, 0, 8, 8, [&](int64_t x, int64_t y) {
+          return (rows[7 - y] >> x) & 1;
+        }));
+        continue;
+      }
+
+      // level followed by the ids of nw, ne, sw and se of the file
+      uint32_t values[5];
+      const char* p = line.data();
+      const char* line_end = line.data() + line.size();
+      bool valid = true;
+      for (uint32_t& value : values) {
+        while (p < line_end && *p == ' ') {
+          p++;
+        }
+        const auto [next, error] = std::from_chars(p, line_end, value);
+        valid = valid && error == std::errc();
+        p = next;
+      }
+      const uint32_t level = values[0];
+      valid = valid && level >= 1 && level <= MAX_LEVEL;
+
+      uint32_t children[4];
+      for (uint32_t i = 0; valid && i < 4; ++i) {
+        const uint32_t id = values[i + 1];
+        if (level == 1) {
+          // cell states
+          children[i] = id != 0;
+        } else if (id == 0) {
+          children[i] = getEmpty(level - 1);
+        } else if (id < ids.size() && nodes[ids[id]].level == level - 1) {
+          children[i] = ids[id];
+        } else {
+          valid = false;
+        }
+      }
+      if (!valid) {
+        spdlog::error("[HashLife] invalid macrocell line {}: {}", ids.size(),
+                      line);
+        clear();
+        return false;
+      }
+
+      // y runs down in the file, so its north is south here
+      ids.push_back(join(children[2], children[3], children[0], children[1]));
+    }
+
+    if (ids.size() == 1) {
+      spdlog::error("[HashLife] macrocell without nodes");
+      return false;
+    }
+    root = ids.back();
+    while (nodes[root].level < 3) {
+      root = expand(root);
+    }
+    generation = file_generation;
+
+    return true;
+  }
+
+  // the universe as a Golly macrocell, see readMacrocell
+  std::string writeMacrocell() const {
+    std::string text = "[M2] (gcss life-game)\n#R B3/S23\n";
+    if (generation > 0) {
+      text += "#G " + std::to_string(generation) + "\n";
+    }
+    std::unordered_map<uint32_t, uint32_t> ids;
+    if (writeNode(root, ids, text) == 0) {
+      // an empty leaf, as the last node is the root
+      text += "$\n";
+    }
+    return text;
+  }
+
+  uint64_t getGeneration() const { return generation; }
+  uint64_t getPopulation() const { return nodes[root].population; }
+  std::size_t getNumberOfNodes() const { return nNodes; }
+
+  std::size_t getMaxNodes() const { return maxNodes; }
+  void setMaxNodes(std::size_t maxNodes) {
+    this->maxNodes = std::max<std::size_t>(maxNodes, 1 << 16);
+  }
+
+  // advance by 2^exponent generations
+  void step(uint32_t exponent) {
+    exponent = std::min(exponent, MAX_LEVEL - 3);
+    if (exponent != stepExponent) {
+      clearResults(std::min(exponent, stepExponent) + 3);
+      stepExponent = exponent;
+    }
+
+    // the pattern has to stay within the result, it moves at most one cell
+    // per generation. a root of level n with the pattern in its central
+    // 2^(n-2) square leaves a margin of 2^(n-3) >= 2^exponent.
+    while (nodes[root].level < exponent + 3 ||
+           nodes[getCenter(getCenter(root))].population !=
+               nodes[root].population) {
+      root = expand(root);
+    }
+    root = getResult(root);
+
+    generation += uint64_t(1) << exponent;
+    stamp++;
+
+    if (nNodes > maxNodes) {
+      collect();
+    }
+  }
+
+  // free nodes which are neither part of the universe nor results used in
+  // the last keepSteps steps
+  void collect() {
+    const std::size_t n_before = nNodes;
+
+    for (bool keep_results : {true, false}) {
+      std::vector<bool> marked(nodes.size(), false);
+      mark(root, marked, false);
+      for (uint32_t e : emptyNodes) {
+        mark(e, marked, false);
+      }
+      if (keep_results) {
+        for (uint32_t i = 2; i < nodes.size(); ++i) {
+          if (nodes[i].level != FREE && stamp - nodes[i].lastUse <= keepSteps) {
+            mark(i, marked, true);
+          }
+        }
+      }
+
+      for (uint32_t i = 2; i < nodes.size(); ++i) {
+        if (nodes[i].level != FREE && !marked[i]) {
+          nodes[i].level = FREE;
+          freeNodes.push_back(i);
+          nNodes--;
+        }
+      }
+      // results may point to freed nodes
+      for (uint32_t i = 2; i < nodes.size(); ++i) {
+        Node& node = nodes[i];
+        if (node.level != FREE && node.result != NONE &&
+            nodes[node.result].level == FREE) {
+          node.result = NONE;
+        }
+      }
+
+      // recent results alone may exceed the budget
+      if (4 * nNodes <= 3 * maxNodes) {
+        break;
+      }
+      clearResults();
+    }
+
+    std::size_t table_size = 1 << 16;
+    while (table_size < 2 * nNodes) {
+      table_size *= 2;
+    }
+    rehash(table_size);
+
+    spdlog::info("[HashLife] collected {} of {} nodes", n_before - nNodes,
+                 n_before);
+  }
+
+  // packed image of width x height blocks of 2^blockLevel x 2^blockLevel
+  // cells from (x0, y0) on, same layout as packed/packed.glsl. a block is
+  // alive if any of its cells is. x0 and y0 must be multiples of the block
+  // size.
+  void getBlocks(int64_t x0, int64_t y0, uint32_t blockLevel, uint32_t width,
+                 uint32_t height, std::vector<uint32_t>& words) const {
+    words.assign(std::size_t((width + 31) / 32) * height, 0);
+    getBlocks(x0, y0, blockLevel, width, height, words.data());
+  }
+
+  // same into words, which have to be zeroed
+  void getBlocks(int64_t x0, int64_t y0, uint32_t blockLevel, uint32_t width,
+                 uint32_t height, uint32_t* words) const {
+    const int64_t half = int64_t(1) << (nodes[root].level - 1);
+    setBlocks(root, -half, -half, x0, y0, blockLevel, width, height, words);
+  }
+};
+
+#endif
@@ -0,0 +1,355 @@
+#ifndef _LARGER_THAN_LIFE_H
+#define _LARGER_THAN_LIFE_H
+#include <charconv>
+#include <cmath>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "glad/gl.h"
+#include "glm/glm.hpp"
+#include "spdlog/spdlog.h"
+//
+#include "gcss/buffer.h"
+#include "gcss/shader.h"
+#include "gcss/texture.h"
+
+using namespace gcss;
+
+// a dead cell is born and a live cell survives when the number of live cells
+// in its neighborhood lies in one of the ranges of birth or survival.
+// Life-like rules are radius 1 without the center.
+struct LifeRule {
+  static constexpr uint32_t MAX_RADIUS = 500;
+
+  uint32_t radius = 1;
+  // |dx| + |dy| <= radius instead of max(|dx|, |dy|) <= radius
+  bool vonNeumann = false;
+  bool includeCenter = false;
+  // inclusive ranges of counts
+  std::vector<glm::uvec2> birth = {glm::uvec2(3, 3)};
+  std::vector<glm::uvec2> survival = {glm::uvec2(2, 3)};
+
+ private:
+  static bool parseNumber(std::string_view text, uint32_t& value) {
+    const auto [end, error] =
+        std::from_chars(text.data(), text.data() + text.size(), value);
+    return error == std::errc() && end == text.data() + text.size();
+  }
+
+  // "3", "34..58" or "34-58"
+  static bool parseRange(std::string_view text, glm::uvec2& range) {
+    std::size_t separator = text.find("..");
+    std::size_t length = 2;
+    if (separator == std::string_view::npos) {
+      separator = text.find('-');
+      length = 1;
+    }
+    if (separator == std::string_view::npos) {
+      if (!parseNumber(text, range.x)) return false;
+      range.y = range.x;
+      return true;
+    }
+    return parseNumber(text.substr(0, separator), range.x) &&
+           parseNumber(text.substr(separator + length), range.y) &&
+           range.x <= range.y;
+  }
+
+  // B3/S23, S23/B3 or 23/3 with single digit counts, V for the von Neumann
+  // neighborhood
+  static bool parseLifeLike(std::string_view text, LifeRule& rule) {
+    rule = LifeRule();
+    rule.birth.clear();
+    rule.survival.clear();
+    if (!text.empty() && (text.back() == 'V' || text.back() == 'v')) {
+      rule.vonNeumann = true;
+      text.remove_suffix(1);
+    }
+
+    const std::size_t slash = text.find('/');
+    if (slash == std::string_view::npos) return false;
+    std::string_view first = text.substr(0, slash);
+    std::string_view second = text.substr(slash + 1);
+    // survival comes first without letters
+    bool first_is_birth = false;
+    if (!first.empty() && (first[0] == 'B' || first[0] == 'b')) {
+      first_is_birth = true;
+      first.remove_prefix(1);
+      if (second.empty() || (second[0] != 'S' && second[0] != 's')) {
+        return false;
+      }
+      second.remove_prefix(1);
+    } else if (!first.empty() && (first[0] == 'S' || first[0] == 's')) {
+      first.remove_prefix(1);
+      if (second.empty() || (second[0] != 'B' && second[0] != 'b')) {
+        return false;
+      }
+      second.remove_prefix(1);
+    }
+
+    const uint32_t max_count = rule.vonNeumann ? 4 : 8;
+    const auto add = [&](std::string_view digits,
+                         std::vector<glm::uvec2>& ranges) {
+      for (const char c : digits) {
+        const uint32_t count = c - '0';
+        if (c < '0' || c > '9' || count > max_count) return false;
+        ranges.push_back(glm::uvec2(count));
+      }
+      return true;
+    };
+    return add(first, first_is_birth ? rule.birth : rule.survival) &&
+           add(second, first_is_birth ? rule.survival : rule.birth);
+  }
+
+  // Golly's R5,C0,M1,S34..58,B34..45,NM, also with - in ranges and several
+  // comma separated ranges per S and B
+  static bool parseLargerThanLife(std::string_view text, LifeRule& rule) {
+    rule = LifeRule();
+    rule.birth.clear();
+    rule.survival.clear();
+
+    std::vector<glm::uvec2>* ranges = nullptr;
+    while (!text.empty()) {
+      const std::size_t comma = text.find(',');
+      std::string_view field = text.substr(0, comma);
+      text = comma == std::string_view::npos ? std::string_view()
+                                             : text.substr(comma + 1);
+      if (field.empty()) return false;
+
+      // ranges continue the last S or B
+      if (field[0] >= '0' && field[0] <= '9') {
+        glm::uvec2 range;
+        if (!ranges || !parseRange(field, range)) return false;
+        ranges->push_back(range);
+        continue;
+      }
+
+      const char key = field[0] & ~0x20;
+      const std::string_view value = field.substr(1);
+      ranges = nullptr;
+      uint32_t number;
+      if (key == 'R') {
+        if (!parseNumber(value, rule.radius) || rule.radius == 0 ||
+            rule.radius > MAX_RADIUS) {
+          return false;
+        }
+      } else if (key == 'C') {
+        // only dead and alive
+        if (!parseNumber(value, number) || number > 2) return false;
+      } else if (key == 'M') {
+        if (!parseNumber(value, number) || number > 1) return false;
+        rule.includeCenter = number == 1;
+      } else if (key == 'S' || key == 'B') {
+        ranges = key == 'S' ? &rule.survival : &rule.birth;
+        glm::uvec2 range;
+        // an empty S or B never applies
+        if (!value.empty()) {
+          if (!parseRange(value, range)) return false;
+          ranges->push_back(range);
+        }
+      } else if (key == 'N') {
+        if (value == "M" || value == "m") {
+          rule.vonNeumann = false;
+        } else if (value == "N" || value == "n") {
+          rule.vonNeumann = true;
+        } else {
+          return false;
+        }
+      } else {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  static std::string rangesToString(const std::vector<glm::uvec2>& ranges) {
+    std::string result;
+    for (std::size_t i = 0; i < ranges.size(); ++i) {
+      if (i > 0) result += ",";
+      result += std::to_string(ranges[i].x);
+      if (ranges[i].y != ranges[i].x) {
+        result += ".." + std::to_string(ranges[i].y);
+      }
+    }
+    return result;
+  }
+
+  // condition on the count n in GLSL
+  static std::string rangesToGLSL(const std::vector<glm::uvec2>& ranges) {
+    if (ranges.empty()) return "false";
+    std::string result;
+    for (std::size_t i = 0; i < ranges.size(); ++i) {
+      if (i > 0) result += " || ";
+      result += "((n) >= " + std::to_string(ranges[i].x) + "u && (n) <= " +
+                std::to_string(ranges[i].y) + "u)";
+    }
+    return result;
+  }
+
+ public:
+  // Life-like B3/S23 or Larger than Life R5,C0,M1,S34..58,B34..45,NM
+  static bool parse(std::string_view text, LifeRule& rule) {
+    const bool larger = text.find(',') != std::string_view::npos ||
+                        (!text.empty() && (text[0] == 'R' || text[0] == 'r'));
+    const bool parsed =
+        larger ? parseLargerThanLife(text, rule) : parseLifeLike(text, rule);
+    if (!parsed) {
+      spdlog::error("[LifeRule] invalid rule {}", text);
+    }
+    return parsed;
+  }
+
+  bool isLifeLike() const {
+    if (radius != 1 || includeCenter) return false;
+    for (const auto* ranges : {&birth, &survival}) {
+      for (const glm::uvec2& range : *ranges) {
+        if (range.y > (vonNeumann ? 4u : 8u)) return false;
+      }
+    }
+    return true;
+  }
+
+  std::string toString() const {
+    if (isLifeLike()) {
+      std::string result = "B";
+      for (const auto* ranges : {&birth, &survival}) {
+        for (const glm::uvec2& range : *ranges) {
+          for (uint32_t n = range.x; n <= range.y; ++n) {
+            result += static_cast<char>('0' + n);
+          }
+        }
+        if (ranges == &birth) result += "/S";
+      }
+      return vonNeumann ? result + "V" : result;
+    }
+    return "R" + std::to_string(radius) + ",C0,M" +
+           std::to_string(includeCenter ? 1 : 0) + ",S" +
+           rangesToString(survival) + ",B" + rangesToString(birth) +
+           (vonNeumann ? ",NN" : ",NM");
+  }
+
+  // cells in the neighborhood, including the center
+  uint32_t getNeighborhoodSize() const {
+    return vonNeumann ? 2 * radius * (radius + 1) + 1
+                      : (2 * radius + 1) * (2 * radius + 1);
+  }
+
+  // defines of ltl/update-cells.comp
+  std::string getDefines() const {
+    std::string defines = "#define RADIUS " + std::to_string(radius) + "\n";
+    defines += "#define INCLUDE_CENTER " +
+               std::to_string(includeCenter ? 1 : 0) + "\n";
+    defines += "#define BIRTH(n) (" + rangesToGLSL(birth) + ")\n";
+    defines += "#define SURVIVAL(n) (" + rangesToGLSL(survival) + ")\n";
+    if (vonNeumann) {
+      defines += "#define VON_NEUMANN\n";
+    }
+    return defines;
+  }
+};
+
+// updates byte cells with any LifeRule. the neighbors of every cell are
+// counted with four reads of a summed-area table of the board, which is
+// built every generation in a row pass and a column pass, so the cost per
+// cell does not depend on the radius. von Neumann diamonds are boxes in a
+// table rotated by 45 degrees. rules are compiled into shader variants, a
+// variant is kept once compiled.
+class LargerThanLife {
+ private:
+  struct Variant {
+    ComputeShader shader;
+    Pipeline pipeline;
+
+    Variant(const std::filesystem::path& filepath, const std::string& defines)
+        : shader{filepath, defines} {
+      pipeline.attachComputeShader(shader);
+    }
+  };
+
+  LifeRule rule;
+  // by file and defines
+  std::unordered_map<std::string, Variant> variants;
+
+  Buffer table;
+
+  static std::filesystem::path getShaderPath(const std::string& filename) {
+    return std::filesystem::path(CMAKE_CURRENT_SOURCE_DIR) / "shaders" /
+           "ltl" / filename;
+  }
+
+  const Variant& getVariant(const std::string& filename,
+                            const std::string& defines) {
+    const std::string key = filename + "\n" + defines;
+    auto it = variants.find(key);
+    if (it == variants.end()) {
+      it = variants.try_emplace(key, getShaderPath(filename), defines).first;
+      spdlog::info("[LargerThanLife] compiled {} for {}", filename,
+                   rule.toString());
+    }
+    return it->second;
+  }
+
+ public:
+  LargerThanLife() {}
+
+  const LifeRule& getRule() const { return rule; }
+
+  void setRule(const LifeRule& rule) { this->rule = rule; }
+
+  // the rule is kept when the text is invalid
+  bool setRule(std::string_view text) {
+    LifeRule parsed;
+    if (!LifeRule::parse(text, parsed)) {
+      return false;
+    }
+    rule = parsed;
+    spdlog::info("[LargerThanLife] rule {}, {} cells per neighborhood",
+                 rule.toString(), rule.getNeighborhoodSize());
+    return true;
+  }
+
+  // one generation of cellsIn into cellsOut, both r8ui of the same size
+  void step(const Texture& cellsIn, const Texture& cellsOut) {
+    const glm::uvec2 resolution = cellsIn.getResolution();
+    const glm::ivec2 table_size =
+        rule.vonNeumann ? glm::ivec2(resolution.x + resolution.y - 1)
+                        : glm::ivec2(resolution);
+    const uint32_t table_length = table_size.x * table_size.y;
+    if (table.getLength() != table_length) {
+      table.allocate<uint32_t>(table_length, GL_DYNAMIC_COPY);
+    }
+
+    const std::string neighborhood =
+        rule.vonNeumann ? "#define VON_NEUMANN\n" : "";
+    const Variant& rows = getVariant("sat-rows.comp", neighborhood);
+    const Variant& columns = getVariant("sat-columns.comp", "");
+    const Variant& update = getVariant("update-cells.comp", rule.getDefines());
+
+    cellsIn.bindToImageUnit(0, GL_READ_ONLY);
+    table.bindToShaderStorageBuffer(0);
+
+    rows.shader.setUniform("tableSize", table_size);
+    rows.pipeline.activate();
+    glDispatchCompute(1, table_size.y, 1);
+    rows.pipeline.deactivate();
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+    columns.shader.setUniform("tableSize", table_size);
+    columns.pipeline.activate();
+    glDispatchCompute(std::ceil(table_size.x / 64.0f), 1, 1);
+    columns.pipeline.deactivate();
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+    cellsOut.bindToImageUnit(1, GL_WRITE_ONLY);
+    update.shader.setUniform("tableSize", table_size);
+    update.pipeline.activate();
+    glDispatchCompute(std::ceil(resolution.x / 8.0f),
+                      std::ceil(resolution.y / 8.0f), 1);
+    update.pipeline.deactivate();
+    glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+  }
+};
+
+#endif
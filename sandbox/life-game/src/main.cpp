@@ -14,6 +14,20 @@
 Renderer* RENDERER;
 int FPS = 24;
 
+// what the left mouse button does on the board
+enum class Tool : int {
+  MOVE = 0,
+  DRAW = 1,
+  ERASE = 2,
+  STAMP = 3,
+  FILL = 4,
+  CLEAR = 5,
+};
+Tool TOOL = Tool::MOVE;
+float BRUSH_RADIUS = 2.0f;
+// index into BoardEditor::getStamps()
+int STAMP = 0;
+
 static void glfwErrorCallback(int error, const char* description) {
   fprintf(stderr, "Glfw Error %d: %s\n", error, description);
 }
@@ -23,14 +37,53 @@ static void framebufferSizeCallback([[maybe_unused]] GLFWwindow* window,
   RENDERER->setResolution(glm::uvec2(width, height));
 }
 
+// a press on the board starts an undo step. strokes are drawn from the last position,
+// fills span from the press to the release.
+void handleEdit(const ImGuiIO& io) {
+  static bool pressed = false;
+  static glm::vec2 last_position;
+  const glm::vec2 position = RENDERER->getBoardPosition(
+      glm::vec2(io.MousePos.x, io.MousePos.y) *
+      glm::vec2(io.DisplayFramebufferScale.x, io.DisplayFramebufferScale.y));
+
+  if (io.MouseClicked[0] && !io.WantCaptureMouse) {
+    pressed = true;
+    last_position = position;
+    RENDERER->beginEdit();
+    if (TOOL == Tool::STAMP) {
+      RENDERER->stamp(STAMP, position);
+    }
+  }
+  if (!pressed) {
+    return;
+  }
+
+  if (TOOL == Tool::DRAW || TOOL == Tool::ERASE) {
+    RENDERER->paint(last_position, position, BRUSH_RADIUS,
+                    TOOL == Tool::DRAW);
+    last_position = position;
+  }
+  if (io.MouseReleased[0]) {
+    if (TOOL == Tool::FILL || TOOL == Tool::CLEAR) {
+      RENDERER->fill(last_position, position, TOOL == Tool::FILL);
+    }
+    pressed = false;
+  }
+}
+
 void handleInput(GLFWwindow* window, const ImGuiIO& io) {
   // close window
   if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS) {
     glfwSetWindowShouldClose(window, GLFW_TRUE);
   }
 
+  // edit
+  if (TOOL != Tool::MOVE) {
+    handleEdit(io);
+  }
+
   // move
-  if (!io.WantCaptureMouse &&
+  if (!io.WantCaptureMouse && TOOL == Tool::MOVE &&
       glfwGetMouseButton(window, GLFW_MOUSE_BUTTON_LEFT) == GLFW_PRESS) {
     RENDERER->move(100.0f * io.DeltaTime *
                    glm::vec2(-io.MouseDelta.x, io.MouseDelta.y));
@@ -100,7 +153,7 @@ int main() {
       const glm::uvec2 resolution = RENDERER->getResolution();
       ImGui::Text("Resolution: (%d, %d)", resolution.x, resolution.y);
 
-      const glm::vec2 offset = RENDERER->getOffset();
+      const glm::dvec2 offset = RENDERER->getOffset();
       ImGui::Text("Offset: (%f, %f)", offset.x, offset.y);
 
       const float scale = RENDERER->getScale();
@@ -110,9 +163,215 @@ int main() {
 
       ImGui::InputInt("FPS", &FPS);
 
+      static int cell_format = static_cast<int>(RENDERER->getCellFormat());
+      if (ImGui::Combo("Cells", &cell_format,
+                       "1 per byte\0"
+                       "32 per word\0")) {
+        RENDERER->setCellFormat(static_cast<CellFormat>(cell_format));
+      }
+
+      static bool temporal_blocking = RENDERER->getEnableTemporalBlocking();
+      if (ImGui::Checkbox("Temporal blocking", &temporal_blocking)) {
+        RENDERER->setEnableTemporalBlocking(temporal_blocking);
+      }
+
+      // only packed cells are blocked
+      if (temporal_blocking && cell_format == 1) {
+        int generations = RENDERER->getGenerationsPerDispatch();
+        if (ImGui::SliderInt("Generations per dispatch", &generations, 1,
+                             TemporalBlocking::MAX_STEPS)) {
+          RENDERER->setGenerationsPerDispatch(generations);
+        }
+        if (ImGui::Button("Tune")) {
+          RENDERER->tuneTemporalBlocking();
+        }
+      }
+
+      static bool active_tiles = RENDERER->getEnableActiveTiles();
+      if (ImGui::Checkbox("Active tiles", &active_tiles)) {
+        RENDERER->setEnableActiveTiles(active_tiles);
+      }
+
+      if (active_tiles) {
+        const ActiveTiles& tiles = RENDERER->getActiveTiles();
+        ImGui::Text("Active tiles: %u / %u", tiles.getNumberOfActiveTiles(),
+                    tiles.getNumberOfTiles());
+      }
+
+      // only 1 cell per byte on the board
+      static bool larger_than_life = RENDERER->getEnableLargerThanLife();
+      if (ImGui::Checkbox("Larger than Life", &larger_than_life)) {
+        RENDERER->setEnableLargerThanLife(larger_than_life);
+      }
+
+      if (larger_than_life) {
+        static char rule[256] = "R5,C0,M1,S34..58,B34..45,NM";
+        ImGui::InputText("Rule", rule, sizeof(rule));
+        if (ImGui::Button("Apply rule")) {
+          RENDERER->setRule(rule);
+        }
+        ImGui::Text("Current rule: %s",
+                    RENDERER->getRule().toString().c_str());
+      }
+
+      // B3/S23 on the board
+      static bool cpu_life = RENDERER->getEnableCpuLife();
+      if (ImGui::Checkbox("CPU engine", &cpu_life)) {
+        RENDERER->setEnableCpuLife(cpu_life);
+      }
+
+      if (cpu_life) {
+        const CpuLife& engine = RENDERER->getCpuLife();
+        ImGui::Text("%s, %.2f G cell updates/s", SimdWords::NAME,
+                    engine.getCellUpdatesPerSecond() * 1e-9);
+        ImGui::Text("Active blocks: %u / %u", engine.getNumberOfActiveBlocks(),
+                    engine.getNumberOfBlocks());
+      }
+
+      static int validation = -1;
+      if (ImGui::Button("Validate GPU update")) {
+        validation = RENDERER->validateUpdate(64);
+      }
+      if (validation >= 0) {
+        ImGui::SameLine();
+        ImGui::Text("%s",
+                    validation ? "same as the CPU" : "differs from the CPU");
+      }
+
+      static int simulation = static_cast<int>(RENDERER->getSimulation());
+      if (ImGui::Combo("Simulation", &simulation,
+                       "board\0"
+                       "HashLife\0"
+                       "chunked world\0")) {
+        RENDERER->setSimulation(static_cast<Simulation>(simulation));
+      }
+
+      if (simulation == static_cast<int>(Simulation::HASHLIFE)) {
+        int step = RENDERER->getHashLifeStep();
+        if (ImGui::SliderInt("log2 generations per update", &step, 0, 40)) {
+          RENDERER->setHashLifeStep(step);
+        }
+
+        const HashLife& hash_life = RENDERER->getHashLife();
+        ImGui::Text("Generation: %llu", static_cast<unsigned long long>(
+                                            hash_life.getGeneration()));
+        ImGui::Text("Population: %llu", static_cast<unsigned long long>(
+                                            hash_life.getPopulation()));
+        ImGui::Text("Nodes: %zu", hash_life.getNumberOfNodes());
+      }
+
+      if (simulation == static_cast<int>(Simulation::CHUNKED)) {
+        const ChunkedWorld& world = RENDERER->getChunkedWorld();
+        ImGui::Text("Generation: %llu",
+                    static_cast<unsigned long long>(world.getGeneration()));
+        ImGui::Text("Chunks: %zu / %u", world.getNumberOfChunks(),
+                    world.getCapacity());
+      }
+
+      static int seed = RENDERER->getSeed();
+      if (ImGui::InputInt("Seed", &seed)) {
+        RENDERER->setSeed(seed);
+      }
+
+      // next seed on every click
       if (ImGui::Button("Randomize cells")) {
+        RENDERER->setSeed(++seed);
         RENDERER->randomizeCells();
       }
+
+      ImGui::Separator();
+
+      // edits of the board with the left mouse button
+      int tool = static_cast<int>(TOOL);
+      if (ImGui::Combo("Left mouse", &tool,
+                       "move\0"
+                       "draw\0"
+                       "erase\0"
+                       "stamp\0"
+                       "fill region\0"
+                       "clear region\0")) {
+        TOOL = static_cast<Tool>(tool);
+      }
+
+      if (TOOL == Tool::DRAW || TOOL == Tool::ERASE) {
+        ImGui::SliderFloat("Brush radius", &BRUSH_RADIUS, 0.5f, 64.0f);
+      }
+
+      if (TOOL == Tool::STAMP) {
+        const auto& stamps = BoardEditor::getStamps();
+        if (ImGui::BeginCombo("Stamp", stamps[STAMP].name)) {
+          for (std::size_t i = 0; i < stamps.size(); ++i) {
+            if (ImGui::Selectable(stamps[i].name, STAMP == int(i))) {
+              STAMP = i;
+            }
+          }
+          ImGui::EndCombo();
+        }
+      }
+
+      const BoardEditor& editor = RENDERER->getBoardEditor();
+      if (ImGui::Button("Undo edit")) {
+        RENDERER->undoEdit();
+      }
+      ImGui::SameLine();
+      ImGui::Text("%zu steps, %.1f MB", editor.getNumberOfUndoSteps(),
+                  editor.getUndoBytes() / (1024.0 * 1024.0));
+
+      ImGui::Separator();
+
+      // .rle, or .mc for HashLife
+      static char pattern_path[256] = "pattern.rle";
+      ImGui::InputText("Pattern file", pattern_path, sizeof(pattern_path));
+      if (ImGui::Button("Load")) {
+        RENDERER->loadPattern(pattern_path);
+      }
+      ImGui::SameLine();
+      if (ImGui::Button("Save")) {
+        RENDERER->savePattern(pattern_path);
+      }
+      ImGui::Text("Pending saves: %u", RENDERER->getNumberOfPendingSaves());
+
+      ImGui::Separator();
+
+      static bool soup_search = RENDERER->getEnableSoupSearch();
+      if (ImGui::Checkbox("Soup search", &soup_search)) {
+        RENDERER->setEnableSoupSearch(soup_search);
+      }
+
+      if (soup_search) {
+        const SoupSearch& search = RENDERER->getSoupSearch();
+        ImGui::Text("Soups: %u (%.0f soups/s)", search.getNumberOfSoups(),
+                    search.getSoupsPerSecond());
+        ImGui::Text("Unsettled: %u, escaped: %u",
+                    search.getNumberOfUnstable(),
+                    search.getNumberOfEscaped());
+
+        // most common outcomes
+        const auto& census = search.getCensus();
+        for (std::size_t i = 0; i < std::min<std::size_t>(census.size(), 8);
+             ++i) {
+          ImGui::Text("  p%u, %u cells: %u", census[i].period,
+                      census[i].population, census[i].count);
+        }
+
+        const auto& interesting = search.getInterestingSoups();
+        ImGui::Text("Interesting: %u", search.getNumberOfInteresting());
+        if (!interesting.empty() && ImGui::Button("Show latest interesting")) {
+          RENDERER->showSoup(interesting.back().soup);
+        }
+      }
+
+      ImGui::Separator();
+
+      static bool enable_export = RENDERER->getEnableExport();
+      if (ImGui::Checkbox("Export to shared memory", &enable_export)) {
+        RENDERER->setEnableExport(enable_export);
+      }
+
+      ImGui::Text("Exported frames to %s: %lu",
+                  RENDERER->getExportName().c_str(),
+                  static_cast<unsigned long>(
+                      RENDERER->getNumberOfExportedFrames()));
     }
     ImGui::End();
 
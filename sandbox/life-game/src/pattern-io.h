@@ -0,0 +1,1023 @@
+#ifndef _PATTERN_IO_H
+#define _PATTERN_IO_H
+#include <atomic>
+#include <bit>
+#include <charconv>
+#include <chrono>
+#include <cstring>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "glad/gl.h"
+#include "glm/glm.hpp"
+#include "spdlog/spdlog.h"
+//
+#include "gcss/buffer.h"
+#include "gcss/mapped-file.h"
+#include "gcss/readback.h"
+#include "gcss/shader.h"
+#include "gcss/texture.h"
+#include "gcss/thread-pool.h"
+#include "gcss/upload.h"
+//
+#include "chunked-world.h"
+#include "hashlife.h"
+
+using namespace gcss;
+
+// patterns are streamed in tiles of the size and layout of chunks of
+// ChunkedWorld, 256 x 256 packed cells with rows from y = 0 up. files have y
+// running down, so cell (x, y) of a file is cell (x, -1 - y) of the world.
+constexpr uint32_t TILE_SIZE = ChunkedWorld::CHUNK_SIZE;
+constexpr uint32_t TILE_WIDTH = ChunkedWorld::CHUNK_WIDTH;
+constexpr uint32_t TILE_WORDS = ChunkedWorld::CHUNK_WORDS;
+
+inline int64_t floorDiv(int64_t a, int64_t b) {
+  return a >= 0 ? a / b : -((-a + b - 1) / b);
+}
+
+// RLE files, mapped and decoded in parallel. the text is split into pieces
+// at tokens, a first pass finds the row and column every piece starts at,
+// then the pieces of a band of 256 rows are decoded at once into a row of
+// tiles. pieces share only the words at their ends, which are combined
+// atomically, every other word is written once.
+class RleReader {
+ private:
+  static constexpr std::size_t PIECE_SIZE = 1 << 16;
+  static constexpr uint64_t NO_ROW = std::numeric_limits<uint64_t>::max();
+
+  struct Piece {
+    const char* begin;
+    const char* end;
+    // cell the piece starts at and the row it ends in, rows from the top
+    uint64_t row;
+    uint64_t x;
+    uint64_t lastRow;
+  };
+
+  MappedFile file;
+  // cells of the header
+  uint64_t width;
+  uint64_t height;
+  // file cell of the first cell from #CXRLE Pos, y down
+  int64_t positionX;
+  int64_t positionY;
+  std::vector<Piece> pieces;
+
+  // first band and tile in file coordinates, and the offset of the pattern
+  // within them
+  int64_t firstBand;
+  int64_t firstTile;
+  uint32_t shiftX;
+  uint32_t shiftY;
+
+  static bool isSpace(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+  }
+
+  static bool isTag(char c) {
+    return c == '$' || c == '!' || c == '.' || (c >= 'a' && c <= 'z') ||
+           (c >= 'A' && c <= 'Z');
+  }
+
+  // value of `key = value` within a header line
+  static bool findValue(std::string_view line, std::string_view key,
+                        std::string_view& value) {
+    std::size_t begin = 0;
+    while (begin < line.size()) {
+      std::size_t end = line.find_first_of(", ", begin);
+      if (end == std::string_view::npos) {
+        end = line.size();
+      }
+      std::string_view field = line.substr(begin, end - begin);
+      begin = end + 1;
+      if (field != key) {
+        continue;
+      }
+      // skip the = with spaces around
+      const std::size_t first = line.find_first_not_of(" =", end);
+      if (first == std::string_view::npos) {
+        return false;
+      }
+      const std::size_t last = line.find_first_of(", ", first);
+      value = line.substr(first, last == std::string_view::npos
+                                     ? std::string_view::npos
+                                     : last - first);
+      return true;
+    }
+    return false;
+  }
+
+  template <typename T>
+  static bool parseValue(std::string_view text, T& value) {
+    return std::from_chars(text.data(), text.data() + text.size(), value).ec ==
+           std::errc();
+  }
+
+  // header lines, p ends up at the first line of runs
+  bool parseHeader(const char*& p, const char* end) {
+    while (p < end) {
+      const char* eol = static_cast<const char*>(std::memchr(p, '\n', end - p));
+      if (!eol) {
+        eol = end;
+      }
+      std::string_view line(p, eol - p);
+      p = eol < end ? eol + 1 : end;
+
+      if (line.starts_with("#CXRLE")) {
+        std::string_view position;
+        const std::size_t pos = line.find("Pos=");
+        if (pos != std::string_view::npos) {
+          position = line.substr(pos + 4);
+          const std::size_t comma = position.find(',');
+          if (comma != std::string_view::npos) {
+            parseValue(position.substr(0, comma), positionX);
+            const std::string_view y = position.substr(comma + 1);
+            parseValue(y.substr(0, y.find_first_of(" \r")), positionY);
+          }
+        }
+        continue;
+      }
+      if (line.empty() || line[0] == '#' || line[0] == '\r') {
+        continue;
+      }
+
+      std::string_view x;
+      std::string_view y;
+      if (!findValue(line, "x", x) || !findValue(line, "y", y) ||
+          !parseValue(x, width) || !parseValue(y, height)) {
+        spdlog::error("[RleReader] invalid header: {}", line);
+        return false;
+      }
+      std::string_view rule;
+      if (findValue(line, "rule", rule) &&
+          rule.substr(0, rule.find('\r')) != "B3/S23" &&
+          rule.substr(0, rule.find('\r')) != "23/3") {
+        spdlog::warn("[RleReader] rule {} is run as B3/S23", rule);
+      }
+      return true;
+    }
+
+    spdlog::error("[RleReader] missing header");
+    return false;
+  }
+
+  // run through tokens from p on until end, a `!` or the end of row stopRow,
+  // calling alive(row, x, n) for every run of n live cells. returns whether
+  // `!` was reached.
+  template <typename F>
+  static bool parse(const char*& p, const char* end, uint64_t& row,
+                    uint64_t& x, uint64_t stopRow, F&& alive) {
+    // locals, stores through the references could alias the text
+    const char* q = p;
+    uint64_t r = row;
+    uint64_t c = x;
+    uint64_t n = 0;
+    bool finished = false;
+    for (; q < end; ++q) {
+      const char token = *q;
+      if (token >= '0' && token <= '9') {
+        n = 10 * n + (token - '0');
+        continue;
+      }
+
+      const uint64_t count = n > 0 ? n : 1;
+      if (token == 'b' || token == '.') {
+        c += count;
+      } else if (token == '$') {
+        r += count;
+        c = 0;
+        if (r >= stopRow) {
+          ++q;
+          break;
+        }
+      } else if (token == '!') {
+        finished = true;
+        break;
+      } else if (isTag(token)) {
+        alive(r, c, count);
+        c += count;
+      } else {
+        // spaces and anything else between tokens keep the count
+        continue;
+      }
+      n = 0;
+    }
+    p = q;
+    row = r;
+    x = c;
+    return finished;
+  }
+
+  // rows a piece advances by and the column it ends at, relative to its
+  // start if it ends no row. only row ends and what follows the last one are
+  // parsed. returns whether the pattern ends within the piece.
+  static bool measure(const char* begin, const char* end, uint64_t& rows,
+                      uint64_t& x) {
+    const char* stop =
+        static_cast<const char*>(std::memchr(begin, '!', end - begin));
+    const bool finished = stop != nullptr;
+    if (!finished) {
+      stop = end;
+    }
+
+    rows = 0;
+    const char* last = begin;
+    for (const char* p = begin;
+         (p = static_cast<const char*>(std::memchr(p, '$', stop - p)));
+         ++p) {
+      // count in front of the $, pieces start after a tag
+      const char* q = p;
+      while (q > begin && isSpace(q[-1])) {
+        q--;
+      }
+      uint64_t count = 0;
+      for (uint64_t scale = 1; q > begin && q[-1] >= '0' && q[-1] <= '9';
+           scale *= 10) {
+        count += (*--q - '0') * scale;
+      }
+      rows += count > 0 ? count : 1;
+      last = p + 1;
+    }
+
+    uint64_t row = 0;
+    x = 0;
+    parse(last, stop, row, x, NO_ROW, [](uint64_t, uint64_t, uint64_t) {});
+    return finished;
+  }
+
+ public:
+  RleReader()
+      : width{0},
+        height{0},
+        positionX{0},
+        positionY{0},
+        firstBand{0},
+        firstTile{0},
+        shiftX{0},
+        shiftY{0} {}
+
+  // map the file, read the header and locate the pieces
+  bool open(const std::filesystem::path& filepath, ThreadPool& threadPool) {
+    if (!file.open(filepath)) {
+      return false;
+    }
+    const char* p = reinterpret_cast<const char*>(file.getData());
+    const char* end = p + file.getSize();
+    if (!parseHeader(p, end)) {
+      return false;
+    }
+
+    // pieces start right after a tag, so that no count is split
+    pieces.clear();
+    const char* begin = p;
+    while (begin < end) {
+      const char* split =
+          end - begin > static_cast<std::ptrdiff_t>(PIECE_SIZE)
+              ? begin + PIECE_SIZE
+              : end;
+      while (split < end && !isTag(*split)) {
+        split++;
+      }
+      split = std::min(split + 1, end);
+      pieces.push_back({begin, split, 0, 0, 0});
+      begin = split;
+    }
+
+    // rows and columns each piece advances by, in parallel
+    std::vector<uint64_t> rows(pieces.size());
+    std::vector<uint64_t> xs(pieces.size());
+    std::vector<char> finished(pieces.size());
+    threadPool.parallelFor(
+        0, pieces.size(), 16, [&](std::size_t first, std::size_t last) {
+          for (std::size_t i = first; i < last; ++i) {
+            finished[i] =
+                measure(pieces[i].begin, pieces[i].end, rows[i], xs[i]);
+          }
+        });
+
+    uint64_t row = 0;
+    uint64_t x = 0;
+    for (std::size_t i = 0; i < pieces.size(); ++i) {
+      pieces[i].row = row;
+      pieces[i].x = x;
+      x = rows[i] > 0 ? xs[i] : x + xs[i];
+      row += rows[i];
+      pieces[i].lastRow = row;
+      if (finished[i]) {
+        pieces.resize(i + 1);
+        break;
+      }
+    }
+
+    firstBand = floorDiv(positionY, TILE_SIZE);
+    firstTile = floorDiv(positionX, TILE_SIZE);
+    shiftY = positionY - firstBand * TILE_SIZE;
+    shiftX = positionX - firstTile * TILE_SIZE;
+
+    spdlog::info("[RleReader] {} x {} cells in {} pieces", width, height,
+                 pieces.size());
+
+    return true;
+  }
+
+  // world cells of the pattern, [min, max)
+  glm::ivec2 getMin() const {
+    return glm::ivec2(positionX, -positionY - static_cast<int64_t>(height));
+  }
+  glm::ivec2 getMax() const {
+    return glm::ivec2(positionX + static_cast<int64_t>(width), -positionY);
+  }
+
+  uint32_t getNumberOfBands() const {
+    return height > 0 ? (shiftY + height + TILE_SIZE - 1) / TILE_SIZE : 0;
+  }
+
+  // tiles per band
+  uint32_t getNumberOfTiles() const {
+    return width > 0 ? (shiftX + width + TILE_SIZE - 1) / TILE_SIZE : 0;
+  }
+
+  // chunk coordinates of a tile of a band
+  glm::ivec2 getTileCoords(uint32_t band, uint32_t tile) const {
+    return glm::ivec2(firstTile + tile, -1 - (firstBand + band));
+  }
+
+  // decode a band into getNumberOfTiles() tiles of TILE_WORDS words, tiles
+  // with live cells are marked in nonEmpty
+  void decodeBand(uint32_t band, uint32_t* words, uint8_t* nonEmpty,
+                  ThreadPool& threadPool) const {
+    const uint32_t n_tiles = getNumberOfTiles();
+    threadPool.parallelFor(0, n_tiles, 64,
+                           [&](std::size_t first, std::size_t last) {
+                             std::memset(words + first * TILE_WORDS, 0,
+                                         (last - first) * TILE_WORDS * 4);
+                             std::memset(nonEmpty + first, 0, last - first);
+                           });
+
+    // rows of the band, the first one may start above the pattern
+    const int64_t row_begin = int64_t(band) * TILE_SIZE - shiftY;
+    const int64_t row_end = row_begin + TILE_SIZE;
+
+    // pieces from the first one ending within the band
+    std::size_t first_piece = 0;
+    std::size_t lo = 0;
+    std::size_t hi = pieces.size();
+    while (lo < hi) {
+      const std::size_t mid = (lo + hi) / 2;
+      if (static_cast<int64_t>(pieces[mid].lastRow) < row_begin) {
+        lo = mid + 1;
+      } else {
+        hi = mid;
+      }
+    }
+    first_piece = lo;
+    std::size_t last_piece = first_piece;
+    while (last_piece < pieces.size() &&
+           static_cast<int64_t>(pieces[last_piece].row) < row_end) {
+      last_piece++;
+    }
+
+    const auto decode = [&](const Piece& piece) {
+      // the word being filled, written when the next one starts
+      constexpr std::size_t NO_WORD = std::numeric_limits<std::size_t>::max();
+      std::size_t index = NO_WORD;
+      uint32_t bits = 0;
+      bool first_word = true;
+      const auto flush = [&](bool shared) {
+        if (shared) {
+          std::atomic_ref<uint32_t>(words[index])
+              .fetch_or(bits, std::memory_order_relaxed);
+        } else {
+          words[index] = bits;
+        }
+        std::atomic_ref<uint8_t>(nonEmpty[index / TILE_WORDS])
+            .store(1, std::memory_order_relaxed);
+        bits = 0;
+      };
+
+      const auto alive = [&](uint64_t row, uint64_t x, uint64_t n) {
+        const int64_t v = static_cast<int64_t>(row) - row_begin;
+        if (v < 0 || x >= width) {
+          return;
+        }
+        const uint32_t ly = TILE_SIZE - 1 - v;
+        const uint64_t u0 = shiftX + x;
+        const uint64_t u1 = shiftX + std::min(x + n, width);
+        for (uint64_t w = u0 / 32; w <= (u1 - 1) / 32; ++w) {
+          const uint32_t lo_bit = w == u0 / 32 ? u0 % 32 : 0;
+          const uint32_t hi_bit = w == (u1 - 1) / 32 ? (u1 - 1) % 32 : 31;
+          const uint32_t mask =
+              (0xffffffffu >> (31 - hi_bit)) & (0xffffffffu << lo_bit);
+          const std::size_t i = (w / TILE_WIDTH) * TILE_WORDS +
+                                ly * TILE_WIDTH + w % TILE_WIDTH;
+          if (i != index) {
+            if (index != NO_WORD) {
+              flush(first_word);
+              first_word = false;
+            }
+            index = i;
+          }
+          bits |= mask;
+        }
+      };
+
+      const char* p = piece.begin;
+      uint64_t row = piece.row;
+      uint64_t x = piece.x;
+      parse(p, piece.end, row, x, static_cast<uint64_t>(row_end), alive);
+      if (index != NO_WORD) {
+        flush(true);
+      }
+    };
+
+    threadPool.parallelFor(first_piece, last_piece, 1,
+                           [&](std::size_t first, std::size_t last) {
+                             for (std::size_t i = first; i < last; ++i) {
+                               decode(pieces[i]);
+                             }
+                           });
+  }
+};
+
+// bit-packed rows to RLE, rows from the top. runs are found a word at a
+// time, dead words are skipped whole.
+class RleWriter {
+ private:
+  std::string text;
+  std::size_t lineBegin;
+  // ends of rows not written yet
+  uint64_t nRowEnds;
+
+  void append(uint64_t n, char tag) {
+    std::string token = n > 1 ? std::to_string(n) : std::string();
+    token += tag;
+    // lines of at most 70 characters
+    if (text.size() - lineBegin + token.size() > 70) {
+      text += '\n';
+      lineBegin = text.size();
+    }
+    text += token;
+  }
+
+  // first cell from x on which is alive or dead
+  static uint64_t find(const uint32_t* words, std::size_t nWords, uint64_t x,
+                       bool alive) {
+    for (std::size_t w = x / 32; w < nWords; ++w) {
+      uint32_t bits = alive ? words[w] : ~words[w];
+      if (w == x / 32) {
+        bits &= 0xffffffffu << (x % 32);
+      }
+      if (bits != 0) {
+        return 32 * w + std::countr_zero(bits);
+      }
+    }
+    return 32 * nWords;
+  }
+
+ public:
+  // comments are lines starting with #
+  RleWriter(uint64_t width, uint64_t height, const std::string& comments = "")
+      : text{comments}, nRowEnds{0} {
+    text += "x = " + std::to_string(width) + ", y = " +
+            std::to_string(height) + ", rule = B3/S23\n";
+    lineBegin = text.size();
+  }
+
+  // bit i of word w is cell 32 * w + i
+  void addRow(const uint32_t* words, std::size_t nWords) {
+    uint64_t x = 0;
+    while (true) {
+      const uint64_t begin = find(words, nWords, x, true);
+      if (begin == 32 * nWords) {
+        break;
+      }
+      const uint64_t end = find(words, nWords, begin, false);
+
+      if (nRowEnds > 0) {
+        append(nRowEnds, '$');
+        nRowEnds = 0;
+      }
+      if (begin > x) {
+        append(begin - x, 'b');
+      }
+      append(end - begin, 'o');
+      x = end;
+    }
+    nRowEnds++;
+  }
+
+  // trailing empty rows are dropped
+  std::string finish() {
+    text += "!\n";
+    return std::move(text);
+  }
+};
+
+// loads RLE and macrocell files into the board, the chunked world and
+// HashLife, and saves them. RLE is decoded band by band in parallel straight
+// into a persistently mapped upload buffer, and tiles with live cells are
+// copied on the GPU. saves are read back asynchronously and encoded and
+// written on worker threads.
+class PatternIO {
+ public:
+  struct Tile {
+    glm::ivec2 coords;
+    // index of the tile within its batch
+    uint32_t index;
+  };
+
+ private:
+  // tiles of a macrocell rasterized at once
+  static constexpr uint32_t BATCH_TILES = 64;
+
+  struct PendingSave {
+    std::filesystem::path filepath;
+    // board
+    glm::uvec2 resolution;
+    bool bitPacked;
+    // chunks of the chunked world in the order read back
+    std::vector<glm::ivec2> coords;
+    uint64_t generation;
+  };
+
+  // saves being encoded or written, counted down by the workers
+  std::atomic<uint32_t> nWriting;
+  ThreadPool& threadPool;
+  UploadRing uploadRing;
+
+  AsyncReadback saveReadback;
+  std::deque<PendingSave> pendingSaves;
+  Buffer savePack;
+
+  ComputeShader storeTiles;
+  Pipeline storeTilesPipeline;
+
+  // world cells of the last loaded pattern, [min, max)
+  glm::ivec2 boundsMin;
+  glm::ivec2 boundsMax;
+
+  static bool isMacrocell(const std::filesystem::path& filepath) {
+    return filepath.extension() == ".mc";
+  }
+
+  static bool writeFile(const std::filesystem::path& filepath,
+                        const std::string& text) {
+    std::ofstream file(filepath, std::ios::binary);
+    file.write(text.data(), text.size());
+    if (!file) {
+      spdlog::error("[PatternIO] failed to write {}", filepath.string());
+      return false;
+    }
+    spdlog::info("[PatternIO] wrote {} bytes to {}", text.size(),
+                 filepath.string());
+    return true;
+  }
+
+  // board rows from the top, cells of r8ui texels or packed words
+  static std::string encodeBoard(const std::byte* data,
+                                 const glm::uvec2& resolution,
+                                 bool bitPacked) {
+    const uint32_t n_words = (resolution.x + 31) / 32;
+    RleWriter writer(resolution.x, resolution.y);
+    std::vector<uint32_t> row(n_words);
+    for (uint32_t y = resolution.y; y-- > 0;) {
+      if (bitPacked) {
+        std::memcpy(row.data(), data + std::size_t(y) * n_words * 4,
+                    n_words * 4);
+      } else {
+        std::fill(row.begin(), row.end(), 0);
+        const std::byte* cells = data + std::size_t(y) * resolution.x;
+        for (uint32_t x = 0; x < resolution.x; ++x) {
+          row[x / 32] |= static_cast<uint32_t>(cells[x] != std::byte{0})
+                         << (x % 32);
+        }
+      }
+      writer.addRow(row.data(), row.size());
+    }
+    return writer.finish();
+  }
+
+  // chunks within their bounding box, the position of its top left cell in
+  // a #CXRLE line
+  static std::string encodeChunks(const uint32_t* words,
+                                  const std::vector<glm::ivec2>& coords,
+                                  uint64_t generation) {
+    if (coords.empty()) {
+      return RleWriter(0, 0).finish();
+    }
+    glm::ivec2 min = coords[0];
+    glm::ivec2 max = coords[0];
+    for (const glm::ivec2& c : coords) {
+      min = glm::min(min, c);
+      max = glm::max(max, c);
+    }
+    const glm::uvec2 n_chunks = glm::uvec2(max - min) + 1u;
+
+    // chunk of every chunk coordinate, grouped by rows of chunks
+    std::vector<uint32_t> order(std::size_t(n_chunks.x) * n_chunks.y,
+                                ChunkedWorld::NO_CHUNK);
+    for (uint32_t i = 0; i < coords.size(); ++i) {
+      const glm::uvec2 c = glm::uvec2(coords[i] - min);
+      order[c.x + c.y * n_chunks.x] = i;
+    }
+
+    const std::string comments =
+        "#CXRLE Pos=" + std::to_string(int64_t(min.x) * TILE_SIZE) + "," +
+        std::to_string(-(int64_t(max.y) + 1) * TILE_SIZE) +
+        " Gen=" + std::to_string(generation) + "\n";
+    RleWriter writer(uint64_t(n_chunks.x) * TILE_SIZE,
+                     uint64_t(n_chunks.y) * TILE_SIZE, comments);
+    std::vector<uint32_t> row(n_chunks.x * TILE_WIDTH);
+    for (uint32_t cy = n_chunks.y; cy-- > 0;) {
+      for (uint32_t ly = TILE_SIZE; ly-- > 0;) {
+        for (uint32_t cx = 0; cx < n_chunks.x; ++cx) {
+          const uint32_t i = order[cx + cy * n_chunks.x];
+          if (i == ChunkedWorld::NO_CHUNK) {
+            std::fill_n(row.begin() + cx * TILE_WIDTH, TILE_WIDTH, 0);
+          } else {
+            std::memcpy(row.data() + cx * TILE_WIDTH,
+                        words + std::size_t(i) * TILE_WORDS + ly * TILE_WIDTH,
+                        TILE_WIDTH * 4);
+          }
+        }
+        writer.addRow(row.data(), row.size());
+      }
+    }
+    return writer.finish();
+  }
+
+  // encode and write on a worker
+  void write(PendingSave&& save, std::vector<std::byte>&& data) {
+    nWriting++;
+    threadPool.submit([this, save = std::move(save), data = std::move(data)] {
+      // chunked worlds have no resolution
+      const std::string text =
+          save.resolution != glm::uvec2(0)
+              ? encodeBoard(data.data(), save.resolution, save.bitPacked)
+              : encodeChunks(reinterpret_cast<const uint32_t*>(data.data()),
+                             save.coords, save.generation);
+      writeFile(save.filepath, text);
+      nWriting--;
+      nWriting.notify_all();
+    });
+  }
+
+  void request(const std::vector<AsyncReadback::Region>& regions,
+               PendingSave&& save) {
+    if (saveReadback.isFull()) {
+      poll(true);
+    }
+    saveReadback.request(regions, 0);
+    pendingSaves.push_back(std::move(save));
+  }
+
+  void setBounds(const glm::ivec2& min, const glm::ivec2& max) {
+    boundsMin = min;
+    boundsMax = max;
+  }
+
+  // bounds of the 256 x 256 squares with live cells
+  bool setBounds(const HashLife& universe,
+                 std::vector<std::pair<int64_t, int64_t>>& origins) {
+    universe.getNonEmptyBlocks(8, origins);
+    if (origins.empty()) {
+      setBounds(glm::ivec2(0), glm::ivec2(0));
+      return true;
+    }
+    int64_t min[2] = {origins[0].first, origins[0].second};
+    int64_t max[2] = {min[0], min[1]};
+    for (const auto& [x, y] : origins) {
+      min[0] = std::min(min[0], x);
+      min[1] = std::min(min[1], y);
+      max[0] = std::max(max[0], x + TILE_SIZE);
+      max[1] = std::max(max[1], y + TILE_SIZE);
+    }
+    const int64_t limit = std::numeric_limits<int32_t>::max() - TILE_SIZE;
+    if (std::min(min[0], min[1]) < -limit ||
+        std::max(max[0], max[1]) > limit) {
+      spdlog::error("[PatternIO] pattern beyond 32 bit coordinates");
+      return false;
+    }
+    setBounds(glm::ivec2(min[0], min[1]), glm::ivec2(max[0], max[1]));
+    return true;
+  }
+
+  // stream the tiles of a file with live cells. begin() is called once the
+  // bounds are known and before any tile, sink(tiles, buffer, words) with
+  // batches of tiles of TILE_WORDS words. with upload, words are in a mapped
+  // upload buffer, otherwise in memory and buffer is nullptr.
+  template <typename Begin, typename Sink>
+  bool readTiles(const std::filesystem::path& filepath, bool upload,
+                 Begin&& begin, Sink&& sink) {
+    std::vector<uint32_t> memory;
+    std::vector<Tile> tiles;
+    const auto acquire = [&](std::size_t n_words) {
+      if (!upload) {
+        memory.resize(n_words);
+        return std::pair<std::size_t, uint32_t*>(0, memory.data());
+      }
+      const std::size_t slot = uploadRing.acquire(n_words * sizeof(uint32_t));
+      return std::pair<std::size_t, uint32_t*>(
+          slot, reinterpret_cast<uint32_t*>(uploadRing.getData(slot)));
+    };
+    const auto submit = [&](std::size_t slot, const uint32_t* words) {
+      sink(tiles, upload ? &uploadRing.getBuffer(slot) : nullptr, words);
+      if (upload) {
+        uploadRing.submit(slot);
+      }
+    };
+
+    if (isMacrocell(filepath)) {
+      MappedFile file;
+      HashLife universe;
+      std::vector<std::pair<int64_t, int64_t>> origins;
+      if (!file.open(filepath) ||
+          !universe.readMacrocell(std::string_view(
+              reinterpret_cast<const char*>(file.getData()),
+              file.getSize())) ||
+          !setBounds(universe, origins)) {
+        return false;
+      }
+      begin();
+
+      for (std::size_t first = 0; first < origins.size();
+           first += BATCH_TILES) {
+        const uint32_t n_tiles =
+            std::min<std::size_t>(BATCH_TILES, origins.size() - first);
+        const auto [slot, words] = acquire(n_tiles * TILE_WORDS);
+        threadPool.parallelFor(
+            0, n_tiles, 1, [&](std::size_t begin, std::size_t end) {
+              std::vector<uint32_t> tile;
+              for (std::size_t i = begin; i < end; ++i) {
+                const auto [x, y] = origins[first + i];
+                universe.getBlocks(x, y, 0, TILE_SIZE, TILE_SIZE, tile);
+                std::memcpy(words + i * TILE_WORDS, tile.data(),
+                            TILE_WORDS * sizeof(uint32_t));
+              }
+            });
+
+        tiles.clear();
+        for (uint32_t i = 0; i < n_tiles; ++i) {
+          const auto [x, y] = origins[first + i];
+          tiles.push_back({glm::ivec2(x / TILE_SIZE, y / TILE_SIZE), i});
+        }
+        submit(slot, words);
+      }
+      return true;
+    }
+
+    RleReader reader;
+    if (!reader.open(filepath, threadPool)) {
+      return false;
+    }
+    setBounds(reader.getMin(), reader.getMax());
+    begin();
+
+    const uint32_t n_tiles = reader.getNumberOfTiles();
+    std::vector<uint8_t> non_empty(n_tiles);
+    for (uint32_t band = 0; band < reader.getNumberOfBands(); ++band) {
+      const auto [slot, words] = acquire(std::size_t(n_tiles) * TILE_WORDS);
+      reader.decodeBand(band, words, non_empty.data(), threadPool);
+
+      tiles.clear();
+      for (uint32_t i = 0; i < n_tiles; ++i) {
+        if (non_empty[i]) {
+          tiles.push_back({reader.getTileCoords(band, i), i});
+        }
+      }
+      submit(slot, words);
+    }
+    return true;
+  }
+
+  template <typename F>
+  bool load(const std::filesystem::path& filepath, F&& f) {
+    const auto start = std::chrono::steady_clock::now();
+    if (!f()) {
+      spdlog::error("[PatternIO] failed to load {}", filepath.string());
+      return false;
+    }
+    const std::chrono::duration<double, std::milli> elapsed =
+        std::chrono::steady_clock::now() - start;
+    spdlog::info("[PatternIO] loaded {} of {} x {} cells in {:.1f} ms",
+                 filepath.string(), boundsMax.x - boundsMin.x,
+                 boundsMax.y - boundsMin.y, elapsed.count());
+    return true;
+  }
+
+ public:
+  PatternIO(ThreadPool& threadPool)
+      : nWriting{0},
+        threadPool{threadPool},
+        storeTiles{std::filesystem::path(CMAKE_CURRENT_SOURCE_DIR) /
+                   "shaders" / "pattern" / "store-tiles.comp"},
+        boundsMin{0},
+        boundsMax{0} {
+    storeTilesPipeline.attachComputeShader(storeTiles);
+  }
+
+  PatternIO(const PatternIO& other) = delete;
+
+  // pending saves are completed, the pool is not ours to drain
+  ~PatternIO() {
+    poll(true);
+    for (uint32_t n = nWriting; n > 0; n = nWriting) {
+      nWriting.wait(n);
+    }
+  }
+
+  PatternIO& operator=(const PatternIO& other) = delete;
+
+  // center of the last loaded pattern
+  glm::dvec2 getCenter() const {
+    return 0.5 * (glm::dvec2(boundsMin) + glm::dvec2(boundsMax));
+  }
+
+  // cells of the last loaded pattern
+  glm::uvec2 getSize() const { return glm::uvec2(boundsMax - boundsMin); }
+
+  // saves not written yet
+  uint32_t getNumberOfPendingSaves() const {
+    return pendingSaves.size() + nWriting;
+  }
+
+  // replace the board with a pattern centered on it, cut off at its edges.
+  // the texture of the other format is only bound.
+  bool loadBoard(const std::filesystem::path& filepath, const Texture& cells,
+                 const Texture& packedCells, bool bitPacked,
+                 const glm::uvec2& resolution) {
+    const Texture& target = bitPacked ? packedCells : cells;
+    // board cell of world cell (0, 0), words of tiles fall on words
+    glm::ivec2 shift(0);
+    const auto begin = [&] {
+      glClearTexImage(target.getTextureName(), 0, GL_RED_INTEGER,
+                      bitPacked ? GL_UNSIGNED_INT : GL_UNSIGNED_BYTE, nullptr);
+      shift = (glm::ivec2(resolution) - boundsMin - boundsMax) >> 1;
+      shift.x &= ~31;
+    };
+    const auto sink = [&](const std::vector<Tile>& tiles, const Buffer* buffer,
+                          const uint32_t*) {
+      buffer->bindToShaderStorageBuffer(0);
+      cells.bindToImageUnit(0, GL_WRITE_ONLY);
+      packedCells.bindToImageUnit(1, GL_WRITE_ONLY);
+      storeTiles.setUniform("size", glm::ivec2(resolution));
+      storeTiles.setUniform("bitPacked", bitPacked);
+      storeTilesPipeline.activate();
+      for (const Tile& tile : tiles) {
+        const glm::ivec2 origin = tile.coords * int(TILE_SIZE) + shift;
+        if (glm::any(glm::lessThanEqual(origin + int(TILE_SIZE),
+                                        glm::ivec2(0))) ||
+            glm::any(glm::greaterThanEqual(origin, glm::ivec2(resolution)))) {
+          continue;
+        }
+        storeTiles.setUniform("tile", tile.index);
+        storeTiles.setUniform("origin", origin);
+        glDispatchCompute(1, TILE_SIZE / 32, 1);
+      }
+      storeTilesPipeline.deactivate();
+    };
+
+    const bool loaded = load(filepath, [&] {
+      return readTiles(filepath, true, begin, sink);
+    });
+    glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+    return loaded;
+  }
+
+  // replace the world, tiles with live cells become chunks
+  bool loadChunkedWorld(const std::filesystem::path& filepath,
+                        ChunkedWorld& world) {
+    const auto begin = [&] { world.clear(); };
+    const auto sink = [&](const std::vector<Tile>& tiles, const Buffer* buffer,
+                          const uint32_t*) {
+      for (const Tile& tile : tiles) {
+        world.setChunk(tile.coords, *buffer, tile.index * TILE_WORDS);
+      }
+    };
+
+    return load(filepath, [&] {
+      if (!readTiles(filepath, true, begin, sink)) {
+        return false;
+      }
+      world.surroundChunks();
+      return true;
+    });
+  }
+
+  // replace the universe, macrocells are read into it directly
+  bool loadHashLife(const std::filesystem::path& filepath,
+                    HashLife& universe) {
+    if (isMacrocell(filepath)) {
+      return load(filepath, [&] {
+        MappedFile file;
+        std::vector<std::pair<int64_t, int64_t>> origins;
+        return file.open(filepath) &&
+               universe.readMacrocell(std::string_view(
+                   reinterpret_cast<const char*>(file.getData()),
+                   file.getSize())) &&
+               setBounds(universe, origins);
+      });
+    }
+
+    const auto begin = [&] { universe.clear(); };
+    const auto sink = [&](const std::vector<Tile>& tiles, const Buffer*,
+                          const uint32_t* words) {
+      for (const Tile& tile : tiles) {
+        universe.setBlock(int64_t(tile.coords.x) * TILE_SIZE,
+                          int64_t(tile.coords.y) * TILE_SIZE, 8,
+                          words + std::size_t(tile.index) * TILE_WORDS);
+      }
+    };
+    return load(filepath,
+                [&] { return readTiles(filepath, false, begin, sink); });
+  }
+
+  // save a board of r8ui cells or packed cells as RLE
+  void saveBoard(const std::filesystem::path& filepath, const Texture& cells,
+                 bool bitPacked, const glm::uvec2& resolution) {
+    if (isMacrocell(filepath)) {
+      spdlog::error("[PatternIO] macrocells are saved from HashLife only");
+      return;
+    }
+
+    const glm::uvec2 texels = cells.getResolution();
+    const std::size_t size =
+        std::size_t(texels.x) * texels.y * (bitPacked ? 4 : 1);
+    // whole words
+    const std::size_t length = (size + 3) / 4 * 4;
+    if (savePack.getLength() < length) {
+      savePack.allocate<std::byte>(length, GL_STREAM_COPY);
+    }
+    glMemoryBarrier(GL_TEXTURE_UPDATE_BARRIER_BIT);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, savePack.getName());
+    glGetTextureImage(cells.getTextureName(), 0, GL_RED_INTEGER,
+                      bitPacked ? GL_UNSIGNED_INT : GL_UNSIGNED_BYTE, size,
+                      nullptr);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    request({{&savePack, 0, static_cast<GLsizeiptr>(size)}},
+            {filepath, resolution, bitPacked, {}, 0});
+  }
+
+  // save every chunk as RLE
+  void saveChunkedWorld(const std::filesystem::path& filepath,
+                        const ChunkedWorld& world) {
+    if (isMacrocell(filepath)) {
+      spdlog::error("[PatternIO] macrocells are saved from HashLife only");
+      return;
+    }
+
+    PendingSave save{filepath, glm::uvec2(0), true, {}, world.getGeneration()};
+    std::vector<uint32_t> slots;
+    world.getChunks(save.coords, slots);
+    if (slots.empty()) {
+      write(std::move(save), {});
+      return;
+    }
+
+    std::vector<AsyncReadback::Region> regions;
+    for (const uint32_t slot : slots) {
+      regions.push_back({&world.getCells(),
+                         static_cast<GLintptr>(slot * TILE_WORDS * 4),
+                         static_cast<GLsizeiptr>(TILE_WORDS * 4)});
+    }
+    request(regions, std::move(save));
+  }
+
+  // save the universe as a macrocell, written on a worker
+  void saveHashLife(const std::filesystem::path& filepath,
+                    const HashLife& universe) {
+    if (!isMacrocell(filepath)) {
+      spdlog::error("[PatternIO] HashLife universes are saved as .mc");
+      return;
+    }
+
+    nWriting++;
+    threadPool.submit([this, filepath, text = universe.writeMacrocell()] {
+      writeFile(filepath, text);
+      nWriting--;
+      nWriting.notify_all();
+    });
+  }
+
+  // hand read back saves to the workers, call every frame
+  void poll(bool wait = false) {
+    saveReadback.poll(
+        [&](uint64_t, const std::byte* data, std::size_t size) {
+          PendingSave save = std::move(pendingSaves.front());
+          pendingSaves.pop_front();
+          write(std::move(save), std::vector<std::byte>(data, data + size));
+        },
+        wait);
+  }
+};
+
+#endif
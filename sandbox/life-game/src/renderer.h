@@ -1,35 +1,363 @@
 #ifndef _RENDERER_H
 #define _RENDERER_H
 #include <algorithm>
-#include <random>
+#include <bit>
+#include <cmath>
 #include <vector>
 
 #include "glad/gl.h"
 #include "glm/glm.hpp"
+#include "glm/gtc/type_precision.hpp"
 //
+#include "gcss/buffer.h"
 #include "gcss/quad.h"
+#include "gcss/shared-frame-exporter.h"
 #include "gcss/texture.h"
+#include "gcss/thread-pool.h"
+//
+#include "active-tiles.h"
+#include "board-editor.h"
+#include "chunked-world.h"
+#include "cpu-life.h"
+#include "density-pyramid.h"
+#include "hashlife.h"
+#include "larger-than-life.h"
+#include "pattern-io.h"
+#include "soup-search.h"
+#include "temporal-blocking.h"
 
 using namespace gcss;
 
+enum class CellFormat : int {
+  // one cell per r8ui texel
+  BYTE = 0,
+  // 32 cells per r32ui texel updated with bitwise adders, see
+  // packed/packed.glsl
+  PACKED = 1,
+};
+
+enum class Simulation : int {
+  // GPU board of the window size
+  BOARD = 0,
+  // unbounded CPU HashLife universe, see hashlife.h
+  HASHLIFE = 1,
+  // unbounded GPU world of chunks, see chunked-world.h
+  CHUNKED = 2,
+};
+
 class Renderer {
  private:
   glm::uvec2 resolution;
-  glm::vec2 offset;
+  // cell at the center of the window, in double so that unbounded worlds
+  // are panned by single cells far beyond the 2^24 of float
+  glm::dvec2 offset;
   float scale;
   uint32_t fps;
   double elapsed_time;
+  // seed of random cells
+  uint32_t seed;
 
+  // textures of the unused format are shrunk to a single texel
+  CellFormat cellFormat;
   Texture cellsIn;
   Texture cellsOut;
+  ComputeShader randomizeCellsShader;
+  Pipeline randomizeCellsPipeline;
   ComputeShader updateCells;
   Pipeline updateCellsPipeline;
 
+  Texture packedIn;
+  Texture packedOut;
+  ComputeShader randomizePackedShader;
+  Pipeline randomizePackedPipeline;
+  ComputeShader updatePacked;
+  Pipeline updatePackedPipeline;
+  ComputeShader unpackCells;
+  Pipeline unpackCellsPipeline;
+
+  // several generations of packed cells per dispatch
+  bool enableTemporalBlocking;
+  TemporalBlocking temporalBlocking;
+
+  // skip tiles of settled cells, not combined with temporal blocking
+  bool enableActiveTiles;
+  ActiveTiles activeTiles;
+
+  // byte cells follow any LifeRule instead of Conway's life
+  bool enableLargerThanLife;
+  LargerThanLife largerThanLife;
+
+  // workers of the CPU engine and of pattern files
+  ThreadPool threadPool;
+
+  // the board is stepped on the CPU and uploaded for display. the CPU cells
+  // are reloaded from the texture after it was changed otherwise.
+  bool enableCpuLife;
+  bool cpuLifeLoaded;
+  CpuLife cpuLife;
+
+  // unbounded worlds start from the board and are drawn through a view of
+  // the visible region
+  Simulation simulation;
+
+  // advances 2^hashLifeStep generations per update
+  HashLife hashLife;
+  uint32_t hashLifeStep;
+  std::vector<uint32_t> hashLifeWords;
+
+  ChunkedWorld chunkedWorld;
+
+  // loads and saves RLE and macrocell files
+  PatternIO patternIO;
+
+  // runs next to the board at every frame
+  bool enableSoupSearch;
+  SoupSearch soupSearch;
+
+  // packed texture of the visible region, refilled whenever it changes
+  Texture worldView;
+  // view the texture was filled for
+  uint64_t viewGeneration;
+  glm::dvec2 viewOffset;
+  float viewScale;
+  // zoomed out, a texel covers a block of 2^viewBlockLevel x 2^viewBlockLevel
+  // cells so that the texture stays about window sized
+  uint32_t viewBlockLevel;
+  // block of texel (0, 0)
+  glm::i64vec2 viewFirstBlock;
+  glm::uvec2 viewResolution;
+
+  // zoomed out, the board is drawn from the density of the cells under a
+  // pixel
+  DensityPyramid densityPyramid;
+
+  // brush, fill and stamp edits of the board with undo
+  BoardEditor boardEditor;
+
   Quad quad;
   VertexShader vertexShader;
   FragmentShader fragmentShader;
   Pipeline renderPipeline;
 
+  uint64_t generation;
+
+  // publish cells to other processes every generation, see
+  // shared-frame-reader
+  bool enableExport;
+  // cells packed into a buffer for readback
+  Buffer cellsPack;
+  SharedFrameExporter exporter;
+
+  // texels of a packed row
+  glm::uvec2 getPackedResolution() const {
+    return glm::uvec2((resolution.x + 31) / 32, resolution.y);
+  }
+
+  // current cells of the GPU board in its format
+  const Texture& getBoardCells() const {
+    return cellFormat == CellFormat::PACKED ? packedIn : cellsIn;
+  }
+
+  void allocateCells() {
+    const bool packed = cellFormat == CellFormat::PACKED;
+    cellsIn.resize(packed ? glm::uvec2(1) : resolution);
+    cellsOut.resize(packed ? glm::uvec2(1) : resolution);
+    packedIn.resize(packed ? getPackedResolution() : glm::uvec2(1));
+    packedOut.resize(packed ? getPackedResolution() : glm::uvec2(1));
+  }
+
+  // the whole GPU board was replaced, nothing of it can be undone
+  void invalidateBoard() {
+    activeTiles.invalidate();
+    cpuLifeLoaded = false;
+    densityPyramid.invalidate();
+    boardEditor.clearHistory();
+  }
+
+  // cells of the GPU board were edited, only their region is updated again.
+  // the CPU engine reads the board anew.
+  void invalidateCells(const BoardEditor::Rect& rect) {
+    if (rect.isEmpty()) {
+      return;
+    }
+    if (cellFormat == CellFormat::PACKED) {
+      activeTiles.activate(glm::ivec2(rect.min.x / 32, rect.min.y),
+                           glm::ivec2((rect.max.x + 31) / 32, rect.max.y));
+    } else {
+      activeTiles.activate(rect.min, rect.max);
+    }
+    cpuLifeLoaded = false;
+    densityPyramid.invalidate(rect.min, rect.max);
+  }
+
+  // randomize the GPU board
+  void randomizeBoard() {
+    invalidateBoard();
+
+    if (cellFormat == CellFormat::PACKED) {
+      const glm::uvec2 packed_resolution = getPackedResolution();
+      packedIn.bindToImageUnit(0, GL_WRITE_ONLY);
+      randomizePackedShader.setUniform("seed", seed);
+      randomizePackedShader.setUniform("width", resolution.x);
+      randomizePackedPipeline.activate();
+      glDispatchCompute(std::ceil(packed_resolution.x / 8.0f),
+                        std::ceil(packed_resolution.y / 8.0f), 1);
+      randomizePackedPipeline.deactivate();
+
+      glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+      return;
+    }
+
+    cellsIn.bindToImageUnit(0, GL_WRITE_ONLY);
+    randomizeCellsShader.setUniform("seed", seed);
+    randomizeCellsPipeline.activate();
+    glDispatchCompute(std::ceil(resolution.x / 8.0f),
+                      std::ceil(resolution.y / 8.0f), 1);
+    randomizeCellsPipeline.deactivate();
+
+    glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+  }
+
+  // board cells packed like packed/packed.glsl, getPackedResolution().x
+  // words per row
+  std::vector<uint32_t> readPackedBoard() {
+    const glm::uvec2 packed_resolution = getPackedResolution();
+    std::vector<uint32_t> words(packed_resolution.x * packed_resolution.y);
+
+    glMemoryBarrier(GL_TEXTURE_UPDATE_BARRIER_BIT);
+    if (cellFormat == CellFormat::PACKED) {
+      glGetTextureImage(packedIn.getTextureName(), 0, GL_RED_INTEGER,
+                        GL_UNSIGNED_INT, words.size() * sizeof(uint32_t),
+                        words.data());
+      return words;
+    }
+
+    std::vector<uint8_t> cells(resolution.x * resolution.y);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glGetTextureImage(cellsIn.getTextureName(), 0, GL_RED_INTEGER,
+                      GL_UNSIGNED_BYTE, cells.size(), cells.data());
+    for (uint32_t y = 0; y < resolution.y; ++y) {
+      for (uint32_t x = 0; x < resolution.x; ++x) {
+        if (cells[x + y * resolution.x]) {
+          words[x / 32 + y * packed_resolution.x] |= 1u << (x % 32);
+        }
+      }
+    }
+    return words;
+  }
+
+  // inverse of readPackedBoard
+  void writePackedBoard(const std::vector<uint32_t>& words) {
+    invalidateBoard();
+    const glm::uvec2 packed_resolution = getPackedResolution();
+    if (cellFormat == CellFormat::PACKED) {
+      packedIn.setImage(words, packed_resolution, GL_R32UI, GL_RED_INTEGER,
+                        GL_UNSIGNED_INT);
+      return;
+    }
+
+    std::vector<uint8_t> cells(resolution.x * resolution.y);
+    for (uint32_t y = 0; y < resolution.y; ++y) {
+      for (uint32_t x = 0; x < resolution.x; ++x) {
+        cells[x + y * resolution.x] =
+            (words[x / 32 + y * packed_resolution.x] >> (x % 32)) & 1;
+      }
+    }
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    cellsIn.setImage(cells, resolution, GL_R8UI, GL_RED_INTEGER,
+                     GL_UNSIGNED_BYTE);
+  }
+
+  // replace the world of the current simulation with the board
+  void loadWorld() {
+    const std::vector<uint32_t> words = readPackedBoard();
+    const uint32_t packed_width = getPackedResolution().x;
+
+    if (simulation == Simulation::HASHLIFE) {
+      hashLife.setCells(resolution.x, resolution.y,
+                        [&](uint32_t x, uint32_t y) {
+                          return (words[x / 32 + y * packed_width] >>
+                                  (x % 32)) & 1;
+                        });
+      spdlog::info("[Renderer] HashLife universe of {} cells in {} nodes",
+                   hashLife.getPopulation(), hashLife.getNumberOfNodes());
+    } else if (simulation == Simulation::CHUNKED) {
+      chunkedWorld.setCells(words, packed_width, resolution.y);
+    }
+
+    // refill the view
+    viewScale = 0;
+  }
+
+  uint64_t getWorldGeneration() const {
+    return simulation == Simulation::HASHLIFE ? hashLife.getGeneration()
+                                              : chunkedWorld.getGeneration();
+  }
+
+  void updateWorldView() {
+    if (viewGeneration == getWorldGeneration() && viewOffset == offset &&
+        viewScale == scale) {
+      return;
+    }
+    viewGeneration = getWorldGeneration();
+    viewOffset = offset;
+    viewScale = scale;
+
+    viewBlockLevel =
+        scale < 1 ? static_cast<uint32_t>(std::ceil(-std::log2(scale))) : 0;
+    const float block_size = std::ldexp(1.0f, viewBlockLevel);
+    const glm::vec2 extent = 0.5f * glm::vec2(resolution) / scale;
+    // cell of the corner, the block is found by an arithmetic shift, which
+    // rounds down like floor
+    const glm::i64vec2 first_cell(glm::floor(offset - glm::dvec2(extent)));
+    viewFirstBlock = first_cell >> static_cast<int64_t>(viewBlockLevel);
+    viewResolution = glm::uvec2(glm::ceil(2.0f * extent / block_size)) + 2u;
+
+    const glm::i64vec2 origin =
+        viewFirstBlock << static_cast<int64_t>(viewBlockLevel);
+    if (simulation == Simulation::HASHLIFE) {
+      hashLife.getBlocks(origin.x, origin.y, viewBlockLevel, viewResolution.x,
+                         viewResolution.y, hashLifeWords);
+      worldView.setImage(
+          hashLifeWords,
+          glm::uvec2((viewResolution.x + 31) / 32, viewResolution.y),
+          GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT);
+    } else {
+      chunkedWorld.draw(worldView, glm::ivec2(origin), viewBlockLevel,
+                        viewResolution);
+    }
+  }
+
+  // one byte per cell, row by row
+  void exportCells() {
+    const uint32_t size = resolution.x * resolution.y;
+    // packed cells are unpacked in whole words
+    const uint32_t length = (size + 3) / 4 * 4;
+    if (cellsPack.getLength() != length) {
+      cellsPack.allocate<GLubyte>(length, GL_STREAM_COPY);
+    }
+
+    if (cellFormat == CellFormat::PACKED) {
+      packedIn.bindToImageUnit(0, GL_READ_ONLY);
+      cellsPack.bindToShaderStorageBuffer(1);
+      unpackCells.setUniform("size", resolution);
+      unpackCellsPipeline.activate();
+      glDispatchCompute(std::ceil(size / 1024.0f), 1, 1);
+      unpackCellsPipeline.deactivate();
+      glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+    } else {
+      glMemoryBarrier(GL_TEXTURE_UPDATE_BARRIER_BIT);
+      glPixelStorei(GL_PACK_ALIGNMENT, 1);
+      glBindBuffer(GL_PIXEL_PACK_BUFFER, cellsPack.getName());
+      glGetTextureImage(cellsIn.getTextureName(), 0, GL_RED_INTEGER,
+                        GL_UNSIGNED_BYTE, size, nullptr);
+      glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    }
+
+    exporter.request(cellsPack, size, generation, 1,
+                     {resolution.x, resolution.y, 1});
+  }
+
  public:
   Renderer()
       : resolution{512, 512},
@@ -37,17 +365,53 @@ class Renderer {
         scale{1},
         fps{24},
         elapsed_time{0},
+        seed{0},
+        cellFormat{CellFormat::BYTE},
         cellsIn{glm::uvec2(512, 512), GL_R8UI, GL_RED_INTEGER,
                 GL_UNSIGNED_BYTE},
         cellsOut{glm::uvec2(512, 512), GL_R8UI, GL_RED_INTEGER,
                  GL_UNSIGNED_BYTE},
+        randomizeCellsShader{std::filesystem::path(CMAKE_CURRENT_SOURCE_DIR) /
+                             "shaders" / "randomize-cells.comp"},
         updateCells{std::filesystem::path(CMAKE_CURRENT_SOURCE_DIR) /
                     "shaders" / "update-cells.comp"},
+        packedIn{glm::uvec2(1), GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT},
+        packedOut{glm::uvec2(1), GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT},
+        randomizePackedShader{std::filesystem::path(CMAKE_CURRENT_SOURCE_DIR) /
+                              "shaders" / "packed" / "randomize-cells.comp"},
+        updatePacked{std::filesystem::path(CMAKE_CURRENT_SOURCE_DIR) /
+                     "shaders" / "packed" / "update-cells.comp"},
+        unpackCells{std::filesystem::path(CMAKE_CURRENT_SOURCE_DIR) /
+                    "shaders" / "packed" / "unpack-cells.comp"},
+        enableTemporalBlocking{false},
+        enableActiveTiles{false},
+        enableLargerThanLife{false},
+        enableCpuLife{false},
+        cpuLifeLoaded{false},
+        cpuLife{threadPool},
+        simulation{Simulation::BOARD},
+        hashLifeStep{0},
+        patternIO{threadPool},
+        enableSoupSearch{false},
+        worldView{glm::uvec2(1), GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT},
+        viewGeneration{0},
+        viewOffset{0},
+        viewScale{0},
+        viewBlockLevel{0},
+        viewFirstBlock{0},
+        viewResolution{0},
         vertexShader{std::filesystem::path(CMAKE_CURRENT_SOURCE_DIR) /
                      "shaders" / "render.vert"},
         fragmentShader{std::filesystem::path(CMAKE_CURRENT_SOURCE_DIR) /
-                       "shaders" / "render.frag"} {
+                       "shaders" / "render.frag"},
+        generation{0},
+        enableExport{false},
+        exporter{"/gcss-life-game", "life-game cell uint8"} {
+    randomizeCellsPipeline.attachComputeShader(randomizeCellsShader);
     updateCellsPipeline.attachComputeShader(updateCells);
+    randomizePackedPipeline.attachComputeShader(randomizePackedShader);
+    updatePackedPipeline.attachComputeShader(updatePacked);
+    unpackCellsPipeline.attachComputeShader(unpackCells);
 
     renderPipeline.attachVertexShader(vertexShader);
     renderPipeline.attachFragmentShader(fragmentShader);
@@ -55,48 +419,406 @@ class Renderer {
     randomizeCells();
   }
 
-  // randomize input cell
+  // randomize input cell on the GPU, the same seed gives the same cells in
+  // both formats. an unbounded world starts over from them.
   void randomizeCells() {
-    std::random_device rnd_dev;
-    std::mt19937 mt(rnd_dev());
-    std::uniform_real_distribution<float> dist(0, 1);
-    std::vector<uint8_t> input_cell_image(resolution.x * resolution.y);
-    for (std::size_t i = 0; i < input_cell_image.size(); ++i) {
-      input_cell_image[i] = dist(mt) > 0.5 ? 1 : 0;
-    }
-    cellsIn.setImage(input_cell_image, resolution, GL_R8UI, GL_RED_INTEGER,
-                     GL_UNSIGNED_BYTE);
+    randomizeBoard();
+    if (simulation != Simulation::BOARD) {
+      loadWorld();
+    }
   }
 
+  uint32_t getSeed() const { return seed; }
+  void setSeed(uint32_t seed) { this->seed = seed; }
+
   glm::uvec2 getResolution() const { return this->resolution; }
 
-  glm::vec2 getOffset() const { return this->offset; }
+  glm::dvec2 getOffset() const { return this->offset; }
 
   float getScale() const { return this->scale; }
 
+  // the board is randomized again, unbounded worlds are kept and only seen
+  // through a larger or smaller view
   void setResolution(const glm::uvec2& resolution) {
     this->resolution = resolution;
-    this->offset = 0.5f * glm::vec2(resolution);
+    if (simulation == Simulation::BOARD) {
+      this->offset = 0.5 * glm::dvec2(resolution);
+    }
+    viewScale = 0;
 
-    cellsIn.resize(resolution);
-    cellsOut.resize(resolution);
+    allocateCells();
+    randomizeBoard();
+  }
 
-    randomizeCells();
+  CellFormat getCellFormat() const { return cellFormat; }
+
+  bool getEnableTemporalBlocking() const { return enableTemporalBlocking; }
+  void setEnableTemporalBlocking(bool enableTemporalBlocking) {
+    this->enableTemporalBlocking = enableTemporalBlocking;
+  }
+
+  bool getEnableActiveTiles() const { return enableActiveTiles; }
+  void setEnableActiveTiles(bool enableActiveTiles) {
+    this->enableActiveTiles = enableActiveTiles;
+  }
+
+  const ActiveTiles& getActiveTiles() const { return activeTiles; }
+
+  bool getEnableLargerThanLife() const { return enableLargerThanLife; }
+  void setEnableLargerThanLife(bool enableLargerThanLife) {
+    this->enableLargerThanLife = enableLargerThanLife;
   }
 
-  void move(const glm::vec2& delta) { this->offset += delta / this->scale; }
+  const LifeRule& getRule() const { return largerThanLife.getRule(); }
+  // B3/S23 or R5,C0,M1,S34..58,B34..45,NM, see LifeRule::parse
+  bool setRule(const std::string& rule) { return largerThanLife.setRule(rule); }
+
+  // generations per update with temporal blocking, tuned on the first use
+  uint32_t getGenerationsPerDispatch() const {
+    return temporalBlocking.getNumberOfSteps();
+  }
+  void setGenerationsPerDispatch(uint32_t nSteps) {
+    temporalBlocking.setNumberOfSteps(nSteps);
+  }
+
+  // measure the best number of generations per dispatch on the current board
+  void tuneTemporalBlocking() {
+    if (cellFormat == CellFormat::PACKED) {
+      temporalBlocking.tune(packedIn, packedOut, resolution.x);
+    }
+  }
+
+  // board cells are randomized again with the current seed
+  void setCellFormat(const CellFormat& cellFormat) {
+    this->cellFormat = cellFormat;
+    allocateCells();
+    randomizeBoard();
+  }
+
+  Simulation getSimulation() const { return simulation; }
+  // unbounded worlds start from the current board
+  void setSimulation(const Simulation& simulation) {
+    this->simulation = simulation;
+    if (simulation != Simulation::BOARD) {
+      loadWorld();
+    }
+  }
+
+  // log2 of the generations per update
+  uint32_t getHashLifeStep() const { return hashLifeStep; }
+  void setHashLifeStep(uint32_t hashLifeStep) {
+    this->hashLifeStep = hashLifeStep;
+  }
+
+  const HashLife& getHashLife() const { return hashLife; }
+
+  const ChunkedWorld& getChunkedWorld() const { return chunkedWorld; }
+
+  // replace the cells of the current simulation with a .rle or .mc file. the
+  // pattern is centered on the board, unbounded worlds are viewed zoomed out
+  // until it fits.
+  bool loadPattern(const std::filesystem::path& filepath) {
+    bool loaded;
+    if (simulation == Simulation::HASHLIFE) {
+      loaded = patternIO.loadHashLife(filepath, hashLife);
+    } else if (simulation == Simulation::CHUNKED) {
+      loaded = patternIO.loadChunkedWorld(filepath, chunkedWorld);
+    } else {
+      loaded = patternIO.loadBoard(filepath, cellsIn, packedIn,
+                                   cellFormat == CellFormat::PACKED,
+                                   resolution);
+      invalidateBoard();
+    }
+
+    if (loaded && simulation != Simulation::BOARD) {
+      offset = patternIO.getCenter();
+      const glm::vec2 size = glm::max(glm::vec2(patternIO.getSize()), 1.0f);
+      const glm::vec2 fit = glm::vec2(resolution) / size;
+      scale = std::min(std::min(fit.x, fit.y), 1.0f);
+      viewScale = 0;
+    }
+    return loaded;
+  }
+
+  // save the cells of the current simulation in the background, the board
+  // and the chunked world as .rle and HashLife as .mc
+  void savePattern(const std::filesystem::path& filepath) {
+    if (simulation == Simulation::HASHLIFE) {
+      patternIO.saveHashLife(filepath, hashLife);
+    } else if (simulation == Simulation::CHUNKED) {
+      patternIO.saveChunkedWorld(filepath, chunkedWorld);
+    } else if (cellFormat == CellFormat::PACKED) {
+      patternIO.saveBoard(filepath, packedIn, true, resolution);
+    } else {
+      patternIO.saveBoard(filepath, cellsIn, false, resolution);
+    }
+  }
+
+  uint32_t getNumberOfPendingSaves() const {
+    return patternIO.getNumberOfPendingSaves();
+  }
+
+  bool getEnableCpuLife() const { return enableCpuLife; }
+  void setEnableCpuLife(bool enableCpuLife) {
+    this->enableCpuLife = enableCpuLife;
+    cpuLifeLoaded = false;
+  }
+
+  const CpuLife& getCpuLife() const { return cpuLife; }
+
+  // step the GPU board and the CPU engine nGenerations from the same cells
+  // and compare them bit by bit, B3/S23 only. the board keeps the GPU
+  // generations.
+  bool validateUpdate(uint32_t nGenerations) {
+    if (cellFormat == CellFormat::BYTE && enableLargerThanLife) {
+      spdlog::error("[Renderer] the CPU engine only runs B3/S23");
+      return false;
+    }
+
+    cpuLife.readTexture(cellFormat == CellFormat::PACKED ? packedIn : cellsIn,
+                        resolution.x);
+    cpuLifeLoaded = false;
+    uint32_t n_generations = 0;
+    while (n_generations < nGenerations) {
+      n_generations += updateBoard();
+    }
+    generation += n_generations;
+    for (uint32_t i = 0; i < n_generations; ++i) {
+      cpuLife.step();
+    }
+
+    std::vector<uint32_t> expected;
+    cpuLife.getCells(expected);
+    const std::vector<uint32_t> actual = readPackedBoard();
+    uint64_t n_different = 0;
+    for (std::size_t i = 0; i < actual.size(); ++i) {
+      n_different += std::popcount(actual[i] ^ expected[i]);
+    }
+    spdlog::info("[Renderer] {} generations on the GPU and the CPU differ in "
+                 "{} cells",
+                 n_generations, n_different);
+    return n_different == 0;
+  }
+
+  bool getEnableSoupSearch() const { return enableSoupSearch; }
+  // the search starts over from the current seed
+  void setEnableSoupSearch(bool enableSoupSearch) {
+    this->enableSoupSearch = enableSoupSearch;
+    if (enableSoupSearch) {
+      soupSearch.restart(seed);
+    }
+  }
+
+  const SoupSearch& getSoupSearch() const { return soupSearch; }
+
+  // replace the cells with a soup of the search in the middle of the board,
+  // an unbounded world starts over from it
+  void showSoup(uint32_t soup) {
+    const glm::uvec2 packed_resolution = getPackedResolution();
+    std::vector<uint32_t> words(packed_resolution.x * packed_resolution.y);
+    const auto rows = SoupSearch::getSoupRows(soupSearch.getSeed(), soup);
+    const glm::ivec2 first =
+        (glm::ivec2(resolution) - glm::ivec2(SoupSearch::SOUP_SIZE)) / 2;
+    for (uint32_t r = 0; r < SoupSearch::SOUP_SIZE; ++r) {
+      for (uint32_t i = 0; i < SoupSearch::SOUP_SIZE; ++i) {
+        const glm::ivec2 cell = first + glm::ivec2(i, r);
+        if (((rows[r] >> i) & 1) && cell.x >= 0 && cell.y >= 0 &&
+            cell.x < static_cast<int>(resolution.x) &&
+            cell.y < static_cast<int>(resolution.y)) {
+          words[cell.x / 32 + cell.y * packed_resolution.x] |=
+              1u << (cell.x % 32);
+        }
+      }
+    }
+    writePackedBoard(words);
+
+    if (simulation != Simulation::BOARD) {
+      loadWorld();
+    }
+  }
+
+  // board position under a window position with y down like the cursor,
+  // cell (x, y) spans x to x + 1
+  glm::vec2 getBoardPosition(const glm::vec2& cursor) const {
+    const glm::vec2 frag(cursor.x, resolution.y - cursor.y);
+    return glm::vec2(offset +
+                     glm::dvec2((frag - 0.5f * glm::vec2(resolution)) / scale));
+  }
+
+  // edits until the next call are undone together. edits apply to the GPU
+  // board only.
+  void beginEdit() { boardEditor.beginEdit(); }
+
+  // cells within radius of a stroke between board positions become alive or
+  // dead
+  void paint(const glm::vec2& from, const glm::vec2& to, float radius,
+             bool alive) {
+    if (simulation == Simulation::BOARD) {
+      invalidateCells(boardEditor.paint(getBoardCells(), resolution, from, to,
+                                        radius, alive));
+    }
+  }
+
+  // cells between two board positions become alive or dead
+  void fill(const glm::vec2& corner0, const glm::vec2& corner1, bool alive) {
+    if (simulation == Simulation::BOARD) {
+      const BoardEditor::Rect rect = {
+          glm::ivec2(glm::floor(glm::min(corner0, corner1))),
+          glm::ivec2(glm::floor(glm::max(corner0, corner1))) + 1};
+      invalidateCells(
+          boardEditor.fill(getBoardCells(), resolution, rect, alive));
+    }
+  }
+
+  // live cells of a stamp of BoardEditor::getStamps() centered at a board
+  // position are added
+  void stamp(uint32_t index, const glm::vec2& center) {
+    if (simulation == Simulation::BOARD) {
+      invalidateCells(boardEditor.stamp(getBoardCells(), resolution,
+                                        BoardEditor::getStamps().at(index),
+                                        glm::ivec2(glm::floor(center))));
+    }
+  }
+
+  // restore the cells of the latest edit
+  void undoEdit() {
+    if (simulation == Simulation::BOARD) {
+      invalidateCells(boardEditor.undo(getBoardCells(), resolution));
+    }
+  }
+
+  const BoardEditor& getBoardEditor() const { return boardEditor; }
+
+  void move(const glm::vec2& delta) {
+    this->offset += glm::dvec2(delta / this->scale);
+  }
 
   void zoom(const float delta) { this->scale += this->scale * delta; }
 
   void setFPS(uint32_t fps) { this->fps = fps; }
 
+  bool getEnableExport() const { return enableExport; }
+  void setEnableExport(bool enableExport) { this->enableExport = enableExport; }
+
+  const std::string& getExportName() const { return exporter.getName(); }
+
+  uint64_t getNumberOfExportedFrames() const {
+    return exporter.getNumberOfFrames();
+  }
+
+  // one invocation per 32 cells, returns the number of generations
+  uint32_t updatePackedCells() {
+    if (enableTemporalBlocking) {
+      if (!temporalBlocking.isTuned()) {
+        tuneTemporalBlocking();
+      }
+      temporalBlocking.step(packedIn, packedOut, resolution.x);
+      std::swap(packedIn, packedOut);
+      activeTiles.invalidate();
+      return temporalBlocking.getNumberOfSteps();
+    }
+
+    if (enableActiveTiles) {
+      activeTiles.updatePackedCells(packedIn, packedOut, resolution.x);
+      std::swap(packedIn, packedOut);
+      return 1;
+    }
+
+    const glm::uvec2 packed_resolution = getPackedResolution();
+    packedIn.bindToImageUnit(0, GL_READ_ONLY);
+    packedOut.bindToImageUnit(1, GL_WRITE_ONLY);
+    updatePacked.setUniform("width", resolution.x);
+    updatePackedPipeline.activate();
+    glDispatchCompute(std::ceil(packed_resolution.x / 8.0f),
+                      std::ceil(packed_resolution.y / 8.0f), 1);
+    updatePackedPipeline.deactivate();
+
+    glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+    std::swap(packedIn, packedOut);
+    activeTiles.invalidate();
+    return 1;
+  }
+
+  // one invocation per cell, returns the number of generations
+  uint32_t updateByteCells() {
+    if (enableLargerThanLife) {
+      largerThanLife.step(cellsIn, cellsOut);
+      activeTiles.invalidate();
+      std::swap(cellsIn, cellsOut);
+      return 1;
+    }
+
+    if (enableActiveTiles) {
+      activeTiles.updateCells(cellsIn, cellsOut);
+      std::swap(cellsIn, cellsOut);
+      return 1;
+    }
+
+    cellsIn.bindToImageUnit(0, GL_READ_ONLY);
+    cellsOut.bindToImageUnit(1, GL_WRITE_ONLY);
+    updateCellsPipeline.activate();
+    glDispatchCompute(std::ceil(resolution.x / 8.0f),
+                      std::ceil(resolution.y / 8.0f), 1);
+    updateCellsPipeline.deactivate();
+    activeTiles.invalidate();
+
+    // swap input/output texture
+    std::swap(cellsIn, cellsOut);
+    return 1;
+  }
+
+  // the GPU board in its format, returns the number of generations
+  uint32_t updateBoard() {
+    return cellFormat == CellFormat::PACKED ? updatePackedCells()
+                                            : updateByteCells();
+  }
+
+  // one generation of the board on the CPU
+  void updateCpuLife() {
+    Texture& cells = cellFormat == CellFormat::PACKED ? packedIn : cellsIn;
+    if (!cpuLifeLoaded) {
+      cpuLife.readTexture(cells, resolution.x);
+      cpuLifeLoaded = true;
+    }
+    cpuLife.step();
+    cpuLife.writeTexture(cells);
+    activeTiles.invalidate();
+  }
+
   void render(float delta_time) {
     // render quad
     glClear(GL_COLOR_BUFFER_BIT);
     glViewport(0, 0, resolution.x, resolution.y);
-    cellsIn.bindToImageUnit(0, GL_READ_ONLY);
-    fragmentShader.setUniform("offset", offset);
-    fragmentShader.setUniform("scale", scale);
+    fragmentShader.setUniform("size", glm::ivec2(resolution));
+    if (simulation != Simulation::BOARD) {
+      // texels of the view instead of cells
+      updateWorldView();
+      worldView.bindToImageUnit(1, GL_READ_ONLY);
+      const float block_size = std::ldexp(1.0f, viewBlockLevel);
+      fragmentShader.setUniform("bitPacked", true);
+      fragmentShader.setUniform("level", 0u);
+      // relative to the view in double, so that only the small difference is
+      // rounded to float
+      const glm::dvec2 view_origin(viewFirstBlock
+                                   << static_cast<int64_t>(viewBlockLevel));
+      fragmentShader.setUniform(
+          "offset", glm::vec2((offset - view_origin) / double(block_size)));
+      fragmentShader.setUniform("scale", scale * block_size);
+    } else {
+      const bool bit_packed = cellFormat == CellFormat::PACKED;
+      const uint32_t level = DensityPyramid::getLevel(scale, resolution);
+      if (level > 0) {
+        densityPyramid.build(cellsIn, packedIn, bit_packed, resolution,
+                             generation);
+        densityPyramid.getCounts(level).bindToImageUnit(2, GL_READ_ONLY);
+      }
+      cellsIn.bindToImageUnit(0, GL_READ_ONLY);
+      packedIn.bindToImageUnit(1, GL_READ_ONLY);
+      fragmentShader.setUniform("bitPacked", bit_packed);
+      fragmentShader.setUniform("level", level);
+      fragmentShader.setUniform("offset", glm::vec2(offset));
+      fragmentShader.setUniform("scale", scale);
+    }
     quad.draw(renderPipeline);
 
     // limit framerate
@@ -105,16 +827,29 @@ class Renderer {
       elapsed_time = 0;
 
       // update input cells
-      cellsIn.bindToImageUnit(0, GL_READ_ONLY);
-      cellsOut.bindToImageUnit(1, GL_WRITE_ONLY);
-      updateCellsPipeline.activate();
-      glDispatchCompute(std::ceil(resolution.x / 8.0f),
-                        std::ceil(resolution.y / 8.0f), 1);
-      updateCellsPipeline.deactivate();
+      if (simulation == Simulation::HASHLIFE) {
+        hashLife.step(hashLifeStep);
+      } else if (simulation == Simulation::CHUNKED) {
+        chunkedWorld.step();
+      } else if (enableCpuLife) {
+        updateCpuLife();
+        generation++;
+      } else {
+        generation += updateBoard();
+      }
 
-      // swap input/output texture
-      std::swap(cellsIn, cellsOut);
+      // the GPU board is exported
+      if (enableExport && simulation == Simulation::BOARD) {
+        exportCells();
+      }
     }
+    if (enableSoupSearch) {
+      soupSearch.step();
+      soupSearch.poll();
+    }
+
+    exporter.poll();
+    patternIO.poll();
   }
 };
 
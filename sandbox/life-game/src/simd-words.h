@@ -0,0 +1,178 @@
+#ifndef _SIMD_WORDS_H
+#define _SIMD_WORDS_H
+#include <cstdint>
+#include <cstring>
+
+#if defined(__AVX512F__) || defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// vector of 64 bit words of the widest instruction set enabled at compile
+// time, scalar fallback otherwise. loads and stores are unaligned. SSE2 is
+// the baseline of x86-64, the wider ones need GCSS_MARCH_NATIVE or similar
+// flags.
+
+#if defined(__AVX512F__)
+
+struct SimdWords {
+  static constexpr std::size_t WIDTH = 8;
+  static constexpr const char* NAME = "AVX-512";
+  __m512i v;
+
+  SimdWords() = default;
+  SimdWords(__m512i v) : v(v) {}
+
+  static SimdWords zero() { return _mm512_setzero_si512(); }
+
+  static SimdWords load(const uint64_t* p) { return _mm512_loadu_si512(p); }
+  void store(uint64_t* p) const { _mm512_storeu_si512(p, v); }
+
+  friend SimdWords operator&(SimdWords a, SimdWords b) {
+    return _mm512_and_si512(a.v, b.v);
+  }
+  friend SimdWords operator|(SimdWords a, SimdWords b) {
+    return _mm512_or_si512(a.v, b.v);
+  }
+  friend SimdWords operator^(SimdWords a, SimdWords b) {
+    return _mm512_xor_si512(a.v, b.v);
+  }
+  // ~a & b
+  // NOTE: maskz variants with a full mask avoid -Wmaybe-uninitialized of GCC
+  // 12 on _mm512_undefined_epi32 in the unmasked intrinsics
+  static SimdWords andNot(SimdWords a, SimdWords b) {
+    return _mm512_maskz_andnot_epi64(0xff, a.v, b.v);
+  }
+  // (center << 1) | (west >> 63)
+  static SimdWords shiftWest(SimdWords west, SimdWords center) {
+    return _mm512_or_si512(_mm512_maskz_slli_epi64(0xff, center.v, 1),
+                           _mm512_maskz_srli_epi64(0xff, west.v, 63));
+  }
+  // (center >> 1) | (east << 63)
+  static SimdWords shiftEast(SimdWords center, SimdWords east) {
+    return _mm512_or_si512(_mm512_maskz_srli_epi64(0xff, center.v, 1),
+                           _mm512_maskz_slli_epi64(0xff, east.v, 63));
+  }
+  bool isZero() const { return _mm512_test_epi64_mask(v, v) == 0; }
+};
+
+#elif defined(__AVX2__)
+
+struct SimdWords {
+  static constexpr std::size_t WIDTH = 4;
+  static constexpr const char* NAME = "AVX2";
+  __m256i v;
+
+  SimdWords() = default;
+  SimdWords(__m256i v) : v(v) {}
+
+  static SimdWords zero() { return _mm256_setzero_si256(); }
+
+  static SimdWords load(const uint64_t* p) {
+    return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+  }
+  void store(uint64_t* p) const {
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), v);
+  }
+
+  friend SimdWords operator&(SimdWords a, SimdWords b) {
+    return _mm256_and_si256(a.v, b.v);
+  }
+  friend SimdWords operator|(SimdWords a, SimdWords b) {
+    return _mm256_or_si256(a.v, b.v);
+  }
+  friend SimdWords operator^(SimdWords a, SimdWords b) {
+    return _mm256_xor_si256(a.v, b.v);
+  }
+  static SimdWords andNot(SimdWords a, SimdWords b) {
+    return _mm256_andnot_si256(a.v, b.v);
+  }
+  static SimdWords shiftWest(SimdWords west, SimdWords center) {
+    return _mm256_or_si256(_mm256_slli_epi64(center.v, 1),
+                           _mm256_srli_epi64(west.v, 63));
+  }
+  static SimdWords shiftEast(SimdWords center, SimdWords east) {
+    return _mm256_or_si256(_mm256_srli_epi64(center.v, 1),
+                           _mm256_slli_epi64(east.v, 63));
+  }
+  bool isZero() const { return _mm256_testz_si256(v, v); }
+};
+
+#elif defined(__SSE2__)
+
+struct SimdWords {
+  static constexpr std::size_t WIDTH = 2;
+  static constexpr const char* NAME = "SSE2";
+  __m128i v;
+
+  SimdWords() = default;
+  SimdWords(__m128i v) : v(v) {}
+
+  static SimdWords zero() { return _mm_setzero_si128(); }
+
+  static SimdWords load(const uint64_t* p) {
+    return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+  }
+  void store(uint64_t* p) const {
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(p), v);
+  }
+
+  friend SimdWords operator&(SimdWords a, SimdWords b) {
+    return _mm_and_si128(a.v, b.v);
+  }
+  friend SimdWords operator|(SimdWords a, SimdWords b) {
+    return _mm_or_si128(a.v, b.v);
+  }
+  friend SimdWords operator^(SimdWords a, SimdWords b) {
+    return _mm_xor_si128(a.v, b.v);
+  }
+  static SimdWords andNot(SimdWords a, SimdWords b) {
+    return _mm_andnot_si128(a.v, b.v);
+  }
+  static SimdWords shiftWest(SimdWords west, SimdWords center) {
+    return _mm_or_si128(_mm_slli_epi64(center.v, 1),
+                        _mm_srli_epi64(west.v, 63));
+  }
+  static SimdWords shiftEast(SimdWords center, SimdWords east) {
+    return _mm_or_si128(_mm_srli_epi64(center.v, 1),
+                        _mm_slli_epi64(east.v, 63));
+  }
+  // no ptest before SSE4.1
+  bool isZero() const {
+    return _mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_setzero_si128())) ==
+           0xffff;
+  }
+};
+
+#else
+
+struct SimdWords {
+  static constexpr std::size_t WIDTH = 1;
+  static constexpr const char* NAME = "scalar";
+  uint64_t v;
+
+  SimdWords() = default;
+  SimdWords(uint64_t v) : v(v) {}
+
+  static SimdWords zero() { return uint64_t(0); }
+
+  static SimdWords load(const uint64_t* p) { return *p; }
+  void store(uint64_t* p) const { *p = v; }
+
+  friend SimdWords operator&(SimdWords a, SimdWords b) { return a.v & b.v; }
+  friend SimdWords operator|(SimdWords a, SimdWords b) { return a.v | b.v; }
+  friend SimdWords operator^(SimdWords a, SimdWords b) { return a.v ^ b.v; }
+  static SimdWords andNot(SimdWords a, SimdWords b) { return ~a.v & b.v; }
+  static SimdWords shiftWest(SimdWords west, SimdWords center) {
+    return (center.v << 1) | (west.v >> 63);
+  }
+  static SimdWords shiftEast(SimdWords center, SimdWords east) {
+    return (center.v >> 1) | (east.v << 63);
+  }
+  bool isZero() const { return v == 0; }
+};
+
+#endif
+
+#endif
@@ -0,0 +1,236 @@
+#ifndef _SOUP_SEARCH_H
+#define _SOUP_SEARCH_H
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <vector>
+
+#include "glad/gl.h"
+#include "spdlog/spdlog.h"
+//
+#include "gcss/buffer.h"
+#include "gcss/random.h"
+#include "gcss/readback.h"
+#include "gcss/shader.h"
+
+using namespace gcss;
+
+// runs random soups on thousands of small boards at once, one workgroup per
+// board stepping it in shared memory. a board is settled once the hash of a
+// generation equals the hash of one of the last HISTORY - 1, it is then
+// counted in the census by period and population and gets the next soup
+// right away, so no board idles. soups which do not settle or oscillate with
+// a period above 2 are kept as interesting. B3/S23 only, with dead cells
+// around the board.
+class SoupSearch {
+ public:
+  // same as the defines in soup/search.comp
+  static constexpr uint32_t BOARD_SIZE = 64;
+  static constexpr uint32_t SOUP_SIZE = 16;
+  static constexpr uint32_t HISTORY = 32;
+  static constexpr uint32_t MAX_POPULATION = 1023;
+  static constexpr uint32_t MAX_INTERESTING = 1024;
+  // words of a Board in soup/search.comp
+  static constexpr uint32_t BOARD_WORDS =
+      4 + 2 * HISTORY + BOARD_SIZE * BOARD_SIZE / 32;
+  // words of Census before the counts
+  static constexpr uint32_t CENSUS_HEADER = 8;
+  static constexpr uint32_t MAX_BOARDS = 65535;
+
+  struct CensusEntry {
+    uint32_t period;
+    uint32_t population;
+    uint32_t count;
+  };
+
+  struct InterestingSoup {
+    uint32_t soup;
+    // 0 when it did not settle
+    uint32_t period;
+    uint32_t population;
+    uint32_t generation;
+  };
+
+ private:
+  uint32_t nBoards;
+  uint32_t seed;
+  uint32_t nStepsPerDispatch;
+  uint32_t maxGenerations;
+
+  Buffer boards;
+  Buffer census;
+  Buffer interesting;
+
+  ComputeShader searchShader;
+  Pipeline searchPipeline;
+
+  // tagged with the nanoseconds since start
+  AsyncReadback readback;
+  std::chrono::steady_clock::time_point start;
+
+  // as of the latest readback
+  uint32_t nFinished;
+  uint32_t nUnstable;
+  uint32_t nEscaped;
+  uint32_t nInteresting;
+  double soupsPerSecond;
+  // most common first
+  std::vector<CensusEntry> censusEntries;
+  std::vector<InterestingSoup> interestingSoups;
+
+  static uint32_t getCensusLength() {
+    return CENSUS_HEADER + (HISTORY - 1) * (MAX_POPULATION + 1);
+  }
+
+  void read(uint64_t tag, const std::byte* data) {
+    const uint32_t* words = reinterpret_cast<const uint32_t*>(data);
+    nFinished = words[1];
+    nUnstable = words[2];
+    nEscaped = words[3];
+    nInteresting = words[4];
+    soupsPerSecond = tag > 0 ? nFinished / (tag * 1e-9) : 0;
+
+    censusEntries.clear();
+    for (uint32_t period = 1; period < HISTORY; ++period) {
+      for (uint32_t population = 0; population <= MAX_POPULATION;
+           ++population) {
+        const uint32_t count =
+            words[CENSUS_HEADER + (period - 1) * (MAX_POPULATION + 1) +
+                  population];
+        if (count > 0) {
+          censusEntries.push_back({period, population, count});
+        }
+      }
+    }
+    std::sort(censusEntries.begin(), censusEntries.end(),
+              [](const CensusEntry& a, const CensusEntry& b) {
+                return a.count > b.count;
+              });
+
+    interestingSoups.resize(std::min(nInteresting, MAX_INTERESTING));
+    std::memcpy(interestingSoups.data(), words + getCensusLength(),
+                interestingSoups.size() * sizeof(InterestingSoup));
+  }
+
+ public:
+  SoupSearch()
+      : nBoards{4096},
+        seed{0},
+        nStepsPerDispatch{64},
+        maxGenerations{4096},
+        searchShader{std::filesystem::path(CMAKE_CURRENT_SOURCE_DIR) /
+                     "shaders" / "soup" / "search.comp"},
+        nFinished{0},
+        nUnstable{0},
+        nEscaped{0},
+        nInteresting{0},
+        soupsPerSecond{0} {
+    searchPipeline.attachComputeShader(searchShader);
+  }
+
+  // cells of a soup, bit i of row r is cell (i, r) of the soup
+  static std::array<uint32_t, SOUP_SIZE> getSoupRows(uint32_t seed,
+                                                     uint32_t soup) {
+    std::array<uint32_t, SOUP_SIZE> rows;
+    for (uint32_t r = 0; r < SOUP_SIZE; ++r) {
+      Random rng(seed, soup * SOUP_SIZE + r);
+      rows[r] = rng.nextUint() & 0xffffu;
+    }
+    return rows;
+  }
+
+  // start over from soup 0 of seed with an empty census
+  void restart(uint32_t seed) {
+    this->seed = seed;
+    readback.flush([](uint64_t, const std::byte*, std::size_t) {});
+
+    boards.allocate<uint32_t>(nBoards * BOARD_WORDS, GL_DYNAMIC_COPY);
+    boards.clear();
+    census.allocate<uint32_t>(getCensusLength(), GL_DYNAMIC_COPY);
+    census.clear();
+    interesting.allocate<InterestingSoup>(MAX_INTERESTING, GL_DYNAMIC_COPY);
+
+    nFinished = 0;
+    nUnstable = 0;
+    nEscaped = 0;
+    nInteresting = 0;
+    soupsPerSecond = 0;
+    censusEntries.clear();
+    interestingSoups.clear();
+    start = std::chrono::steady_clock::now();
+
+    spdlog::info("[SoupSearch] {} boards of {} x {} cells, seed {}", nBoards,
+                 BOARD_SIZE, BOARD_SIZE, seed);
+  }
+
+  uint32_t getSeed() const { return seed; }
+
+  uint32_t getNumberOfBoards() const { return nBoards; }
+  // takes effect on restart
+  void setNumberOfBoards(uint32_t nBoards) {
+    this->nBoards = std::clamp(nBoards, 1u, MAX_BOARDS);
+  }
+
+  uint32_t getNumberOfStepsPerDispatch() const { return nStepsPerDispatch; }
+  void setNumberOfStepsPerDispatch(uint32_t nSteps) {
+    nStepsPerDispatch = std::max(nSteps, 1u);
+  }
+
+  // soups still running after this many generations are given up on
+  uint32_t getMaxGenerations() const { return maxGenerations; }
+  void setMaxGenerations(uint32_t maxGenerations) {
+    this->maxGenerations = std::max(maxGenerations, 2u);
+  }
+
+  // nStepsPerDispatch generations of every board
+  void step() {
+    boards.bindToShaderStorageBuffer(0);
+    census.bindToShaderStorageBuffer(1);
+    interesting.bindToShaderStorageBuffer(2);
+    searchShader.setUniform("seed", seed);
+    searchShader.setUniform("nSteps", nStepsPerDispatch);
+    searchShader.setUniform("maxGenerations", maxGenerations);
+    searchPipeline.activate();
+    glDispatchCompute(nBoards, 1, 1);
+    searchPipeline.deactivate();
+
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+  }
+
+  // read the census back without stalling, it lags a few frames
+  void poll() {
+    readback.poll([&](uint64_t tag, const std::byte* data, std::size_t) {
+      read(tag, data);
+    });
+
+    if (!readback.isFull()) {
+      const std::chrono::nanoseconds elapsed =
+          std::chrono::steady_clock::now() - start;
+      readback.request(
+          {{&census, 0,
+            static_cast<GLsizeiptr>(getCensusLength() * sizeof(uint32_t))},
+           {&interesting, 0,
+            static_cast<GLsizeiptr>(MAX_INTERESTING *
+                                    sizeof(InterestingSoup))}},
+          elapsed.count());
+    }
+  }
+
+  uint32_t getNumberOfSoups() const { return nFinished; }
+  uint32_t getNumberOfUnstable() const { return nUnstable; }
+  uint32_t getNumberOfEscaped() const { return nEscaped; }
+  uint32_t getNumberOfInteresting() const { return nInteresting; }
+
+  double getSoupsPerSecond() const { return soupsPerSecond; }
+
+  const std::vector<CensusEntry>& getCensus() const { return censusEntries; }
+
+  // the first MAX_INTERESTING found
+  const std::vector<InterestingSoup>& getInterestingSoups() const {
+    return interestingSoups;
+  }
+};
+
+#endif
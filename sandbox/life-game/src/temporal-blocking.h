@@ -0,0 +1,111 @@
+#ifndef _TEMPORAL_BLOCKING_H
+#define _TEMPORAL_BLOCKING_H
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+
+#include "glad/gl.h"
+#include "glm/glm.hpp"
+#include "spdlog/spdlog.h"
+//
+#include "gcss/shader.h"
+#include "gcss/texture.h"
+
+using namespace gcss;
+
+// advances packed cells by k generations per dispatch. every workgroup loads
+// a tile with a halo of k rows into shared memory and steps it there, so
+// global memory is read and written once per k generations. larger k means
+// less traffic but more redundant work on the halo, the best k depends on the
+// device and is found by tune.
+class TemporalBlocking {
+ public:
+  // same as TILE_WIDTH, TILE_HEIGHT and MAX_STEPS in update-cells-blocked.comp
+  static constexpr uint32_t TILE_WIDTH = 32;
+  static constexpr uint32_t TILE_HEIGHT = 32;
+  static constexpr uint32_t MAX_STEPS = 16;
+
+ private:
+  uint32_t nSteps;
+  bool tuned;
+
+  ComputeShader updateCells;
+  Pipeline updateCellsPipeline;
+
+  void dispatch(const Texture& cellsIn, const Texture& cellsOut,
+                uint32_t width, uint32_t nSteps) const {
+    const glm::uvec2 packed_resolution = cellsIn.getResolution();
+    cellsIn.bindToImageUnit(0, GL_READ_ONLY);
+    cellsOut.bindToImageUnit(1, GL_WRITE_ONLY);
+    updateCells.setUniform("width", width);
+    updateCells.setUniform("nSteps", nSteps);
+    updateCellsPipeline.activate();
+    glDispatchCompute(
+        std::ceil(packed_resolution.x / static_cast<float>(TILE_WIDTH)),
+        std::ceil(packed_resolution.y / static_cast<float>(TILE_HEIGHT)), 1);
+    updateCellsPipeline.deactivate();
+
+    glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+  }
+
+ public:
+  TemporalBlocking()
+      : nSteps{1},
+        tuned{false},
+        updateCells{std::filesystem::path(CMAKE_CURRENT_SOURCE_DIR) /
+                    "shaders" / "packed" / "update-cells-blocked.comp"} {
+    updateCellsPipeline.attachComputeShader(updateCells);
+  }
+
+  // generations per dispatch
+  uint32_t getNumberOfSteps() const { return nSteps; }
+  void setNumberOfSteps(uint32_t nSteps) {
+    this->nSteps = std::clamp(nSteps, 1u, MAX_STEPS);
+    tuned = true;
+  }
+
+  bool isTuned() const { return tuned; }
+
+  // advance cellsIn by getNumberOfSteps generations into cellsOut, both are
+  // packed textures of the same size
+  void step(const Texture& cellsIn, const Texture& cellsOut,
+            uint32_t width) const {
+    dispatch(cellsIn, cellsOut, width, nSteps);
+  }
+
+  // time every power of two k on the given cells and keep the one with the
+  // most generations per second. cellsIn is not modified.
+  uint32_t tune(const Texture& cellsIn, const Texture& cellsOut,
+                uint32_t width) {
+    double best_rate = 0;
+    for (uint32_t k = 1; k <= MAX_STEPS; k *= 2) {
+      // warm up
+      dispatch(cellsIn, cellsOut, width, k);
+      glFinish();
+
+      const uint32_t n_dispatches = std::max(MAX_STEPS / k, 2u);
+      const auto start = std::chrono::steady_clock::now();
+      for (uint32_t i = 0; i < n_dispatches; ++i) {
+        dispatch(cellsIn, cellsOut, width, k);
+      }
+      glFinish();
+      const std::chrono::duration<double> elapsed =
+          std::chrono::steady_clock::now() - start;
+
+      const double rate = n_dispatches * k / elapsed.count();
+      spdlog::info("[TemporalBlocking] k = {}: {:.1f} generations/s", k, rate);
+      if (rate > best_rate) {
+        best_rate = rate;
+        nSteps = k;
+      }
+    }
+    tuned = true;
+
+    spdlog::info("[TemporalBlocking] {} generations per dispatch", nSteps);
+
+    return nSteps;
+  }
+};
+
+#endif
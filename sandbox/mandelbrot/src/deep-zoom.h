@@ -0,0 +1,209 @@
+#ifndef _DEEP_ZOOM_H
+#define _DEEP_ZOOM_H
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "glad/gl.h"
+#include "glm/glm.hpp"
+#include "spdlog/spdlog.h"
+//
+#include "gcss/buffer.h"
+#include "gcss/shader.h"
+#include "gcss/texture.h"
+//
+#include "fixed-point.h"
+#include "float-exp.h"
+
+using namespace gcss;
+
+// deep zooms by perturbation. a reference orbit is iterated on the CPU in
+// fixed point at the precision of the zoom and every pixel iterates only its
+// difference to it in float on the GPU, as a float times a power of 2 of its
+// own, so the scale is not limited by the range of float. a pixel whose
+// value gets smaller than its difference, where the difference loses its
+// precision and glitches, is rebased onto the start of the orbit. a series
+// in the offset of the pixel skips the iterations the whole view shares.
+// the reference is kept while the view stays within the radius of the
+// series.
+class DeepZoom {
+ public:
+  // terms of the series, same as N_TERMS in deep-zoom.comp
+  static constexpr uint32_t N_TERMS = 4;
+
+ private:
+  // reference point and the view it was computed for
+  FixedPoint referenceRe;
+  FixedPoint referenceIm;
+  FloatExp referenceScale;
+  uint32_t referenceIterations;
+  bool valid;
+  // offsets of pixels from the reference up to radius
+  FloatExp radius;
+
+  // orbit of the reference from 0, up to and including its escape
+  std::vector<glm::vec2> orbit;
+  Buffer orbitBuffer;
+
+  // terms of the difference after nSkipped iterations, the k-th one times
+  // u^(k + 1) for the offset radius * u of a pixel
+  uint32_t nSkipped;
+  ComplexExp series[N_TERMS];
+
+  ComputeShader deepZoomShader;
+  Pipeline deepZoomPipeline;
+
+  double referenceSeconds;
+
+  // the series is valid while its last term is below float precision of the
+  // first and the difference is small against the orbit
+  void computeSeries(uint32_t maxIterations) {
+    const ComplexExp r(radius);
+    ComplexExp terms[N_TERMS];
+    nSkipped = 0;
+    std::fill(series, series + N_TERMS, ComplexExp());
+    for (uint32_t n = 0; n + 1 < orbit.size() && n < maxIterations; ++n) {
+      const ComplexExp z2(2.0 * glm::dvec2(orbit[n]));
+      ComplexExp next[N_TERMS];
+      next[0] = z2 * terms[0] + r;
+      next[1] = z2 * terms[1] + terms[0] * terms[0];
+      next[2] = z2 * terms[2] + (terms[0] * terms[1]).twice();
+      next[3] = z2 * terms[3] + (terms[0] * terms[2]).twice() +
+                terms[1] * terms[1];
+
+      const double log2_first = next[0].log2();
+      if (next[N_TERMS - 1].log2() > log2_first - 24 ||
+          log2_first > std::log2(glm::length(orbit[n + 1])) - 10) {
+        break;
+      }
+      std::copy(next, next + N_TERMS, terms);
+      std::copy(next, next + N_TERMS, series);
+      nSkipped = n + 1;
+    }
+  }
+
+  void computeReference(const FixedPoint& centerRe,
+                        const FixedPoint& centerIm, const FloatExp& scale,
+                        float aspect, uint32_t maxIterations) {
+    const auto start = std::chrono::steady_clock::now();
+    referenceRe = centerRe;
+    referenceIm = centerIm;
+    referenceScale = scale;
+    referenceIterations = maxIterations;
+    // the view may move by 4 * scale before the reference is computed again
+    radius = scale * FloatExp(4.0 + std::sqrt(aspect * aspect + 1.0));
+    valid = true;
+
+    FixedPoint x(centerRe.getPrecision());
+    FixedPoint y(centerRe.getPrecision());
+    orbit.assign(1, glm::vec2(0));
+    for (uint32_t n = 0; n < maxIterations; ++n) {
+      const FixedPoint xy = x * y;
+      x = x * x - y * y + centerRe;
+      y = xy.twice() + centerIm;
+      const glm::vec2 z(x.toDouble(), y.toDouble());
+      orbit.push_back(z);
+      if (glm::dot(z, z) > 4.0f) {
+        break;
+      }
+    }
+    orbitBuffer.setData(orbit, GL_STATIC_DRAW);
+
+    computeSeries(maxIterations);
+
+    const std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - start;
+    referenceSeconds = elapsed.count();
+    spdlog::info("[DeepZoom] reference of {} iterations at {} limbs, {} "
+                 "skipped, {:.3f} s",
+                 orbit.size() - 1, centerRe.getPrecision(), nSkipped,
+                 referenceSeconds);
+  }
+
+ public:
+  DeepZoom()
+      : referenceIterations{0},
+        valid{false},
+        nSkipped{0},
+        deepZoomShader{std::filesystem::path(CMAKE_CURRENT_SOURCE_DIR) /
+                       "shaders" / "deep-zoom.comp"},
+        referenceSeconds{0} {
+    deepZoomPipeline.attachComputeShader(deepZoomShader);
+  }
+
+  // limbs after the point of a center at scale, 64 bits beyond the pixels
+  static std::size_t getPrecision(const FloatExp& scale) {
+    const double bits = std::max(-scale.log2(), 0.0) + 64;
+    return std::max<std::size_t>(2, std::ceil(bits / 32));
+  }
+
+  void invalidate() { valid = false; }
+
+  // iterations of the latest reference orbit
+  std::size_t getOrbitLength() const { return orbit.size() - 1; }
+  uint32_t getNumberOfSkippedIterations() const { return nSkipped; }
+  double getReferenceSeconds() const { return referenceSeconds; }
+
+  // image of the view at scale around a center of getPrecision(scale) limbs
+  void render(const Texture& image, const FixedPoint& centerRe,
+              const FixedPoint& centerIm, const FloatExp& scale,
+              uint32_t maxIterations) {
+    const glm::uvec2 resolution = image.getResolution();
+    const float aspect = float(resolution.x) / resolution.y;
+    const FloatExp corner = scale * FloatExp(std::sqrt(aspect * aspect + 1.0));
+
+    bool covered = valid && maxIterations == referenceIterations &&
+                   centerRe.getPrecision() == referenceRe.getPrecision() &&
+                   !(scale < referenceScale * FloatExp(0.25));
+    FloatExp offset_re, offset_im;
+    if (covered) {
+      offset_re = (centerRe - referenceRe).toFloatExp();
+      offset_im = (centerIm - referenceIm).toFloatExp();
+      covered = !(radius < offset_re.abs() + offset_im.abs() + corner);
+    }
+    if (!covered) {
+      computeReference(centerRe, centerIm, scale, aspect, maxIterations);
+      offset_re = offset_im = FloatExp();
+    }
+
+    image.bindToImageUnit(0, GL_WRITE_ONLY);
+    orbitBuffer.bindToShaderStorageBuffer(0);
+    deepZoomShader.setUniform("orbitLength",
+                              static_cast<uint32_t>(orbit.size()));
+    deepZoomShader.setUniform("max_iterations", maxIterations);
+    deepZoomShader.setUniform(
+        "offsetRatio",
+        glm::vec2((offset_re / radius).toDouble(),
+                  (offset_im / radius).toDouble()));
+    deepZoomShader.setUniform("scaleRatio",
+                              static_cast<float>((scale / radius).toDouble()));
+    deepZoomShader.setUniform("radiusMantissa",
+                              static_cast<float>(radius.mantissa));
+    deepZoomShader.setUniform("radiusExponent",
+                              static_cast<GLint>(radius.exponent));
+    deepZoomShader.setUniform("skippedIterations", nSkipped);
+    deepZoomShader.setUniform("seriesExponent",
+                              static_cast<GLint>(series[0].exponent));
+    for (uint32_t k = 0; k < N_TERMS; ++k) {
+      const std::string index = "[" + std::to_string(k) + "]";
+      deepZoomShader.setUniform("seriesMantissa" + index,
+                                glm::vec2(series[k].mantissa));
+      // relative to the first term, which is the largest
+      deepZoomShader.setUniform(
+          "seriesShift" + index,
+          static_cast<GLint>(std::max<int64_t>(
+              series[k].exponent - series[0].exponent, -1000)));
+    }
+    deepZoomPipeline.activate();
+    glDispatchCompute(std::ceil(resolution.x / 8.0f),
+                      std::ceil(resolution.y / 8.0f), 1);
+    deepZoomPipeline.deactivate();
+
+    glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+  }
+};
+
+#endif
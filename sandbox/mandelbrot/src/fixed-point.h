@@ -0,0 +1,245 @@
+#ifndef _FIXED_POINT_H
+#define _FIXED_POINT_H
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "float-exp.h"
+
+// signed fixed-point number of arbitrary precision, a 32 bit limb before
+// the point and a number of limbs after it. enough for the points of a
+// reference orbit, whose magnitudes stay small.
+class FixedPoint {
+ private:
+  bool negative;
+  // magnitude, least significant limb first, the last one is the integer
+  // part
+  std::vector<uint32_t> limbs;
+
+  static bool lessMagnitude(const std::vector<uint32_t>& a,
+                            const std::vector<uint32_t>& b) {
+    for (std::size_t i = a.size(); i-- > 0;) {
+      if (a[i] != b[i]) {
+        return a[i] < b[i];
+      }
+    }
+    return false;
+  }
+
+  // a += b
+  static void addMagnitude(std::vector<uint32_t>& a,
+                           const std::vector<uint32_t>& b) {
+    uint64_t carry = 0;
+    for (std::size_t i = 0; i < a.size(); ++i) {
+      const uint64_t sum = uint64_t(a[i]) + b[i] + carry;
+      a[i] = static_cast<uint32_t>(sum);
+      carry = sum >> 32;
+    }
+  }
+
+  // a -= b, a must not be less than b
+  static void subtractMagnitude(std::vector<uint32_t>& a,
+                                const std::vector<uint32_t>& b) {
+    int64_t borrow = 0;
+    for (std::size_t i = 0; i < a.size(); ++i) {
+      const int64_t difference = int64_t(a[i]) - b[i] - borrow;
+      a[i] = static_cast<uint32_t>(difference);
+      borrow = difference < 0;
+    }
+  }
+
+  bool isZero() const {
+    return std::all_of(limbs.begin(), limbs.end(),
+                       [](uint32_t limb) { return limb == 0; });
+  }
+
+  // divide the magnitude by a small divisor, returns the remainder
+  uint32_t divide(uint32_t divisor) {
+    uint64_t remainder = 0;
+    for (std::size_t i = limbs.size(); i-- > 0;) {
+      const uint64_t value = (remainder << 32) | limbs[i];
+      limbs[i] = static_cast<uint32_t>(value / divisor);
+      remainder = value % divisor;
+    }
+    return static_cast<uint32_t>(remainder);
+  }
+
+ public:
+  explicit FixedPoint(std::size_t nLimbs = 2)
+      : negative{false}, limbs(nLimbs + 1, 0) {}
+
+  // value * 2^exponent, bits below the precision are dropped
+  static FixedPoint fromFloatExp(const FloatExp& value, std::size_t nLimbs) {
+    FixedPoint result(nLimbs);
+    if (value.mantissa == 0) {
+      return result;
+    }
+    result.negative = value.mantissa < 0;
+
+    // 53 bit integer mantissa, bit 0 is bit `shift` of the limbs
+    const uint64_t bits =
+        static_cast<uint64_t>(std::ldexp(std::abs(value.mantissa), 53));
+    const int64_t shift = value.exponent - 53 + 32 * int64_t(nLimbs);
+    for (int64_t i = 0; i < 53; ++i) {
+      const int64_t bit = shift + i;
+      if (((bits >> i) & 1) && bit >= 0 &&
+          bit < 32 * int64_t(result.limbs.size())) {
+        result.limbs[bit / 32] |= 1u << (bit % 32);
+      }
+    }
+    return result;
+  }
+
+  static FixedPoint fromDouble(double value, std::size_t nLimbs) {
+    return fromFloatExp(FloatExp(value), nLimbs);
+  }
+
+  // decimal like -0.7436438870371587522, returns false when malformed
+  static bool parse(std::string_view text, std::size_t nLimbs,
+                    FixedPoint& result) {
+    result = FixedPoint(nLimbs);
+    std::size_t i = 0;
+    if (i < text.size() && (text[i] == '-' || text[i] == '+')) {
+      result.negative = text[i++] == '-';
+    }
+
+    uint32_t integer = 0;
+    std::size_t n_digits = 0;
+    for (; i < text.size() && std::isdigit(text[i]); ++i, ++n_digits) {
+      integer = 10 * integer + (text[i] - '0');
+      if (integer > 1000000) {
+        return false;
+      }
+    }
+
+    if (i < text.size() && text[i] == '.') {
+      const std::size_t first = ++i;
+      while (i < text.size() && std::isdigit(text[i])) {
+        ++i;
+      }
+      n_digits += i - first;
+      // from the last digit on, each one is divided down by 10
+      for (std::size_t j = i; j-- > first;) {
+        result.limbs.back() = text[j] - '0';
+        result.divide(10);
+      }
+    }
+    result.limbs.back() = integer;
+    if (result.isZero()) {
+      result.negative = false;
+    }
+    return n_digits > 0 && i == text.size();
+  }
+
+  // limbs after the point
+  std::size_t getPrecision() const { return limbs.size() - 1; }
+
+  // more limbs keep the value, fewer drop its lowest bits
+  void setPrecision(std::size_t nLimbs) {
+    const std::size_t n_limbs = getPrecision();
+    if (nLimbs > n_limbs) {
+      limbs.insert(limbs.begin(), nLimbs - n_limbs, 0);
+    } else {
+      limbs.erase(limbs.begin(), limbs.begin() + (n_limbs - nLimbs));
+    }
+  }
+
+  FixedPoint operator-() const {
+    FixedPoint result = *this;
+    result.negative = !negative && !isZero();
+    return result;
+  }
+
+  // operands of the same precision
+  friend FixedPoint operator+(const FixedPoint& a, const FixedPoint& b) {
+    FixedPoint result = a;
+    if (a.negative == b.negative) {
+      addMagnitude(result.limbs, b.limbs);
+    } else if (lessMagnitude(a.limbs, b.limbs)) {
+      result = b;
+      subtractMagnitude(result.limbs, a.limbs);
+    } else {
+      subtractMagnitude(result.limbs, b.limbs);
+    }
+    if (result.isZero()) {
+      result.negative = false;
+    }
+    return result;
+  }
+
+  friend FixedPoint operator-(const FixedPoint& a, const FixedPoint& b) {
+    return a + (-b);
+  }
+
+  // schoolbook product truncated to the precision of the operands
+  friend FixedPoint operator*(const FixedPoint& a, const FixedPoint& b) {
+    const std::size_t n = a.limbs.size();
+    std::vector<uint32_t> product(2 * n, 0);
+    for (std::size_t i = 0; i < n; ++i) {
+      if (a.limbs[i] == 0) {
+        continue;
+      }
+      uint64_t carry = 0;
+      for (std::size_t j = 0; j < n; ++j) {
+        const uint64_t t =
+            uint64_t(a.limbs[i]) * b.limbs[j] + product[i + j] + carry;
+        product[i + j] = static_cast<uint32_t>(t);
+        carry = t >> 32;
+      }
+      product[i + n] = static_cast<uint32_t>(carry);
+    }
+
+    FixedPoint result(n - 1);
+    std::copy(product.begin() + (n - 1), product.begin() + (2 * n - 1),
+              result.limbs.begin());
+    result.negative = a.negative != b.negative && !result.isZero();
+    return result;
+  }
+
+  // 2 * this
+  FixedPoint twice() const {
+    FixedPoint result = *this;
+    addMagnitude(result.limbs, limbs);
+    return result;
+  }
+
+  // the leading bits, three limbs fill a double even if the top one is small
+  FloatExp toFloatExp() const {
+    std::size_t top = limbs.size() - 1;
+    while (top > 0 && limbs[top] == 0) {
+      --top;
+    }
+    double mantissa = 0;
+    for (std::size_t k = 0; k < 3 && k <= top; ++k) {
+      mantissa += std::ldexp(double(limbs[top - k]), -32 * int(k));
+    }
+    return FloatExp(negative ? -mantissa : mantissa,
+                    32 * (int64_t(top) - int64_t(getPrecision())));
+  }
+
+  double toDouble() const { return toFloatExp().toDouble(); }
+
+  // decimal with a number of digits after the point
+  std::string toString(std::size_t nDigits) const {
+    std::string text = negative ? "-" : "";
+    text += std::to_string(limbs.back()) + ".";
+    FixedPoint fraction = *this;
+    for (std::size_t i = 0; i < nDigits; ++i) {
+      fraction.limbs.back() = 0;
+      uint64_t carry = 0;
+      for (uint32_t& limb : fraction.limbs) {
+        const uint64_t t = uint64_t(limb) * 10 + carry;
+        limb = static_cast<uint32_t>(t);
+        carry = t >> 32;
+      }
+      text += static_cast<char>('0' + fraction.limbs.back());
+    }
+    return text;
+  }
+};
+
+#endif
@@ -0,0 +1,150 @@
+#ifndef _FLOAT_EXP_H
+#define _FLOAT_EXP_H
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <string_view>
+
+#include "glm/glm.hpp"
+
+// mantissa * 2^exponent with the mantissa in [0.5, 1), for magnitudes
+// beyond the range of double like the scale of deep zooms
+struct FloatExp {
+  double mantissa;
+  int64_t exponent;
+
+  FloatExp() : mantissa{0}, exponent{0} {}
+
+  FloatExp(double mantissa, int64_t exponent = 0) {
+    int e = 0;
+    this->mantissa = std::frexp(mantissa, &e);
+    this->exponent = this->mantissa == 0 ? 0 : exponent + e;
+  }
+
+  friend FloatExp operator*(const FloatExp& a, const FloatExp& b) {
+    return FloatExp(a.mantissa * b.mantissa, a.exponent + b.exponent);
+  }
+
+  friend FloatExp operator/(const FloatExp& a, const FloatExp& b) {
+    return FloatExp(a.mantissa / b.mantissa, a.exponent - b.exponent);
+  }
+
+  friend FloatExp operator+(const FloatExp& a, const FloatExp& b) {
+    if (a.mantissa == 0) return b;
+    if (b.mantissa == 0) return a;
+    // the smaller one is shifted to the exponent of the larger one
+    if (a.exponent < b.exponent) return b + a;
+    const int64_t shift = std::max<int64_t>(b.exponent - a.exponent, -1100);
+    return FloatExp(a.mantissa + std::ldexp(b.mantissa, int(shift)),
+                    a.exponent);
+  }
+
+  friend FloatExp operator-(const FloatExp& a, const FloatExp& b) {
+    return a + FloatExp(-b.mantissa, b.exponent);
+  }
+
+  friend bool operator<(const FloatExp& a, const FloatExp& b) {
+    return (a - b).mantissa < 0;
+  }
+
+  // decimal like 1.5e-300, returns false when malformed
+  static bool parse(std::string_view text, FloatExp& result) {
+    const std::string mantissa_text(text.substr(0, text.find_first_of("eE")));
+    char* end;
+    const double mantissa = std::strtod(mantissa_text.c_str(), &end);
+    if (mantissa_text.empty() || *end != '\0') {
+      return false;
+    }
+    long exponent10 = 0;
+    if (mantissa_text.size() < text.size()) {
+      const std::string exponent_text(text.substr(mantissa_text.size() + 1));
+      exponent10 = std::strtol(exponent_text.c_str(), &end, 10);
+      if (exponent_text.empty() || *end != '\0' || std::abs(exponent10) > 1e8) {
+        return false;
+      }
+    }
+    // 10^exponent10 split into a power of 2 and the rest
+    const double exponent2 = exponent10 * std::log2(10.0);
+    const double whole = std::floor(exponent2);
+    result = FloatExp(mantissa * std::exp2(exponent2 - whole),
+                      static_cast<int64_t>(whole));
+    return true;
+  }
+
+  FloatExp abs() const { return FloatExp(std::abs(mantissa), exponent); }
+
+  // 0 or infinity beyond the range of double
+  double toDouble() const {
+    return std::ldexp(mantissa, static_cast<int>(std::clamp<int64_t>(
+                                    exponent, -4096, 4096)));
+  }
+
+  double log2() const { return std::log2(std::abs(mantissa)) + exponent; }
+
+  // scientific notation like 1.25e-300
+  std::string toString() const {
+    if (mantissa == 0) {
+      return "0";
+    }
+    const double log10 = std::log10(std::abs(mantissa)) +
+                         static_cast<double>(exponent) * std::log10(2.0);
+    const double decimal_exponent = std::floor(log10);
+    char text[64];
+    std::snprintf(text, sizeof(text), "%.6fe%lld",
+                  std::copysign(std::pow(10.0, log10 - decimal_exponent),
+                                mantissa),
+                  static_cast<long long>(decimal_exponent));
+    return text;
+  }
+};
+
+// complex number with a shared exponent, the larger part of the mantissa in
+// [0.5, 1)
+struct ComplexExp {
+  glm::dvec2 mantissa;
+  int64_t exponent;
+
+  ComplexExp() : mantissa{0}, exponent{0} {}
+
+  ComplexExp(const glm::dvec2& mantissa, int64_t exponent = 0) {
+    int e = 0;
+    std::frexp(std::max(std::abs(mantissa.x), std::abs(mantissa.y)), &e);
+    this->mantissa = glm::dvec2(std::ldexp(mantissa.x, -e),
+                                std::ldexp(mantissa.y, -e));
+    this->exponent = this->mantissa == glm::dvec2(0) ? 0 : exponent + e;
+  }
+
+  explicit ComplexExp(const FloatExp& real)
+      : ComplexExp(glm::dvec2(real.mantissa, 0), real.exponent) {}
+
+  friend ComplexExp operator*(const ComplexExp& a, const ComplexExp& b) {
+    return ComplexExp(glm::dvec2(a.mantissa.x * b.mantissa.x -
+                                     a.mantissa.y * b.mantissa.y,
+                                 a.mantissa.x * b.mantissa.y +
+                                     a.mantissa.y * b.mantissa.x),
+                      a.exponent + b.exponent);
+  }
+
+  friend ComplexExp operator+(const ComplexExp& a, const ComplexExp& b) {
+    if (a.mantissa == glm::dvec2(0)) return b;
+    if (b.mantissa == glm::dvec2(0)) return a;
+    if (a.exponent < b.exponent) return b + a;
+    const int shift = static_cast<int>(
+        std::max<int64_t>(b.exponent - a.exponent, -1100));
+    return ComplexExp(a.mantissa + glm::dvec2(std::ldexp(b.mantissa.x, shift),
+                                              std::ldexp(b.mantissa.y, shift)),
+                      a.exponent);
+  }
+
+  ComplexExp twice() const { return ComplexExp(mantissa, exponent + 1); }
+
+  // -infinity for 0
+  double log2() const {
+    return std::log2(glm::length(mantissa)) + static_cast<double>(exponent);
+  }
+};
+
+#endif
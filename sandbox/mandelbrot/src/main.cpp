@@ -13,7 +13,6 @@
 
 Renderer* RENDERER;
 int MAX_ITERATIONS = 100;
-float SCALE = 1.0f;
 
 static void glfwErrorCallback(int error, const char* description) {
   fprintf(stderr, "Glfw Error %d: %s\n", error, description);
@@ -102,15 +101,41 @@ int main() {
       const glm::uvec2 resolution = RENDERER->getResolution();
       ImGui::Text("Resolution: (%d, %d)", resolution.x, resolution.y);
 
-      const glm::vec2 center = RENDERER->getCenter();
-      ImGui::Text("Center: (%f, %f)", center.x, center.y);
+      ImGui::TextWrapped("Center: (%s)", RENDERER->getCenterString().c_str());
 
-      const float scale = RENDERER->getScale();
-      ImGui::Text("Scale: %f", scale);
+      ImGui::Text("Scale: %s", RENDERER->getScale().toString().c_str());
 
       ImGui::Separator();
 
       ImGui::InputInt("Max iterations", &MAX_ITERATIONS);
+
+      static bool deep_zoom = RENDERER->getEnableDeepZoom();
+      if (ImGui::Checkbox("Deep zoom", &deep_zoom)) {
+        RENDERER->setEnableDeepZoom(deep_zoom);
+      }
+
+      if (deep_zoom) {
+        const DeepZoom& engine = RENDERER->getDeepZoom();
+        ImGui::Text("Reference: %zu iterations in %.3f s",
+                    engine.getOrbitLength(), engine.getReferenceSeconds());
+        ImGui::Text("Series skips %u iterations",
+                    engine.getNumberOfSkippedIterations());
+      }
+
+      // jump to decimal coordinates like 1e-300 for the scale
+      static char center_re[1024] = "-0.75";
+      static char center_im[1024] = "0.1";
+      static char scale_text[64] = "1e-10";
+      ImGui::InputText("Re", center_re, sizeof(center_re));
+      ImGui::InputText("Im", center_im, sizeof(center_im));
+      ImGui::InputText("Scale", scale_text, sizeof(scale_text));
+      if (ImGui::Button("Go to")) {
+        FloatExp scale;
+        if (FloatExp::parse(scale_text, scale)) {
+          RENDERER->setScale(scale);
+        }
+        RENDERER->setCenter(center_re, center_im);
+      }
     }
     ImGui::End();
 
@@ -1,26 +1,37 @@
 #ifndef _RENDERER_H
 #define _RENDERER_H
 #include <algorithm>
+#include <string>
 
 #include "glad/gl.h"
 #include "glm/glm.hpp"
 //
 #include "gcss/quad.h"
 #include "gcss/texture.h"
+//
+#include "deep-zoom.h"
+#include "fixed-point.h"
+#include "float-exp.h"
 
 using namespace gcss;
 
 class Renderer {
  private:
   glm::uvec2 resolution;
-  glm::vec2 center;
-  float scale;
+  // precise enough for the pixels at scale, see DeepZoom::getPrecision
+  FixedPoint centerRe;
+  FixedPoint centerIm;
+  FloatExp scale;
   uint32_t maxIterations;
 
   Texture texture;
   ComputeShader mandelbrotShader;
   Pipeline mandelbrotPipeline;
 
+  // perturbation instead of iterating single precision c
+  bool enableDeepZoom;
+  DeepZoom deepZoom;
+
   Quad quad;
   VertexShader vertexShader;
   FragmentShader fragmentShader;
@@ -29,12 +40,14 @@ class Renderer {
  public:
   Renderer()
       : resolution{512, 512},
-        center{0, 0},
-        scale{1.0f},
+        centerRe{DeepZoom::getPrecision(1.0)},
+        centerIm{DeepZoom::getPrecision(1.0)},
+        scale{1.0},
         maxIterations{100u},
         texture{glm::vec2(512, 512), GL_RGBA32F, GL_RGBA, GL_FLOAT},
         mandelbrotShader(std::filesystem::path(CMAKE_CURRENT_SOURCE_DIR) /
                          "shaders" / "mandelbrot.comp"),
+        enableDeepZoom{true},
         vertexShader(std::filesystem::path(CMAKE_CURRENT_SOURCE_DIR) /
                      "shaders" / "render.vert"),
         fragmentShader(std::filesystem::path(CMAKE_CURRENT_SOURCE_DIR) /
@@ -47,35 +60,92 @@ class Renderer {
 
   glm::uvec2 getResolution() const { return this->resolution; }
 
-  glm::vec2 getCenter() const { return this->center; }
+  const FixedPoint& getCenterRe() const { return this->centerRe; }
+  const FixedPoint& getCenterIm() const { return this->centerIm; }
+
+  // decimal with enough digits for the pixels at the current scale
+  std::string getCenterString() const {
+    const std::size_t n_digits =
+        std::max(6.0, std::ceil(-scale.log2() * std::log10(2.0)) + 3);
+    return centerRe.toString(n_digits) + ", " + centerIm.toString(n_digits);
+  }
+
+  // decimal coordinates, returns false when one is malformed
+  bool setCenter(const std::string& re, const std::string& im) {
+    FixedPoint center_re, center_im;
+    const std::size_t n_limbs = centerRe.getPrecision();
+    if (!FixedPoint::parse(re, n_limbs, center_re) ||
+        !FixedPoint::parse(im, n_limbs, center_im)) {
+      return false;
+    }
+    centerRe = center_re;
+    centerIm = center_im;
+    return true;
+  }
+
+  const FloatExp& getScale() const { return this->scale; }
 
-  float getScale() const { return this->scale; }
+  void setScale(const FloatExp& scale) {
+    this->scale = scale.abs();
+    updatePrecision();
+  }
 
   void setResolution(const glm::uvec2& resolution) {
     this->resolution = resolution;
     texture.resize(resolution);
   }
 
-  void move(const glm::vec2& v) { center += scale * v; }
+  void move(const glm::vec2& v) {
+    const std::size_t n_limbs = centerRe.getPrecision();
+    centerRe = centerRe + FixedPoint::fromFloatExp(scale * v.x, n_limbs);
+    centerIm = centerIm + FixedPoint::fromFloatExp(scale * v.y, n_limbs);
+  }
+
+  void zoom(float delta) {
+    scale = scale * FloatExp(1.0 + delta);
+    updatePrecision();
+  }
 
-  void zoom(float delta) { scale += scale * delta; }
+  // the center only ever gains precision, zooming out and in again keeps it
+  void updatePrecision() {
+    const std::size_t n_limbs = DeepZoom::getPrecision(scale);
+    if (n_limbs > centerRe.getPrecision()) {
+      centerRe.setPrecision(n_limbs);
+      centerIm.setPrecision(n_limbs);
+    }
+  }
 
   void setMaxIterations(uint32_t n_iterations) {
-    this->maxIterations = std::min(n_iterations, 10000u);
+    // deep zooms need far more iterations
+    this->maxIterations = std::min(n_iterations, 1000000u);
   }
 
-  void render() const {
+  bool getEnableDeepZoom() const { return enableDeepZoom; }
+  void setEnableDeepZoom(bool enableDeepZoom) {
+    this->enableDeepZoom = enableDeepZoom;
+  }
+
+  const DeepZoom& getDeepZoom() const { return deepZoom; }
+
+  void render() {
     // run compute shader
-    texture.bindToImageUnit(0, GL_WRITE_ONLY);
-    mandelbrotShader.setUniform("center", center);
-    mandelbrotShader.setUniform("scale", scale);
-    mandelbrotShader.setUniform("max_iterations", maxIterations);
-    mandelbrotPipeline.activate();
-    glDispatchCompute(std::ceil(resolution.x / 8.0f),
-                      std::ceil(resolution.y / 8.0f), 1);
-    mandelbrotPipeline.deactivate();
-
-    glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+    if (enableDeepZoom) {
+      deepZoom.render(texture, centerRe, centerIm, scale, maxIterations);
+    } else {
+      // blocky below a scale of about 1e-6
+      texture.bindToImageUnit(0, GL_WRITE_ONLY);
+      mandelbrotShader.setUniform(
+          "center", glm::vec2(centerRe.toDouble(), centerIm.toDouble()));
+      mandelbrotShader.setUniform("scale",
+                                  static_cast<float>(scale.toDouble()));
+      mandelbrotShader.setUniform("max_iterations", maxIterations);
+      mandelbrotPipeline.activate();
+      glDispatchCompute(std::ceil(resolution.x / 8.0f),
+                        std::ceil(resolution.y / 8.0f), 1);
+      mandelbrotPipeline.deactivate();
+
+      glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+    }
 
     // render quad
     glClear(GL_COLOR_BUFFER_BIT);
@@ -0,0 +1,71 @@
+// per workgroup sums of diagnostics, Particle has to be declared by the
+// including shader
+struct Partial {
+  vec4 momentum;
+  vec4 angular_momentum;
+  // mass weighted position
+  vec4 moment;
+  // x: kinetic energy, y: potential energy, z: mass
+  vec4 energy;
+};
+
+layout(std430, binding = 1) writeonly buffer layout_partials {
+  Partial partials[];
+};
+
+shared vec4 local_momentum[128];
+shared vec4 local_angular_momentum[128];
+shared vec4 local_moment[128];
+shared vec4 local_energy[128];
+
+// sum particles of the workgroup into partials[widx]. every invocation has to
+// call this, invalid ones contribute nothing.
+void reduceDiagnostics(bool valid, Particle particle, float dt, uint widx) {
+  uint lidx = gl_LocalInvocationIndex;
+
+  vec4 momentum = vec4(0);
+  vec4 angular_momentum = vec4(0);
+  vec4 moment = vec4(0);
+  vec4 energy = vec4(0);
+  if (valid) {
+    float mass = particle.mass;
+    vec3 F = particle.force.xyz;
+    vec3 velocity_half = particle.velocity.xyz;
+
+    // leap-frog stores x(t + dt) and v(t + dt/2) with F(t), synchronize
+    // position and velocity to t where the potential has been evaluated
+    vec3 position = particle.position.xyz - velocity_half * dt;
+    vec3 velocity = velocity_half - 0.5 * F / mass * dt;
+
+    momentum.xyz = mass * velocity;
+    angular_momentum.xyz = cross(position, mass * velocity);
+    moment.xyz = mass * position;
+    energy.x = 0.5 * mass * dot(velocity, velocity);
+    // every pair is counted twice
+    energy.y = 0.5 * particle.force.w;
+    energy.z = mass;
+  }
+  local_momentum[lidx] = momentum;
+  local_angular_momentum[lidx] = angular_momentum;
+  local_moment[lidx] = moment;
+  local_energy[lidx] = energy;
+  barrier();
+
+  // reduce in workgroup
+  for (uint s = gl_WorkGroupSize.x / 2; s > 0; s >>= 1) {
+    if (lidx < s) {
+      local_momentum[lidx] += local_momentum[lidx + s];
+      local_angular_momentum[lidx] += local_angular_momentum[lidx + s];
+      local_moment[lidx] += local_moment[lidx + s];
+      local_energy[lidx] += local_energy[lidx + s];
+    }
+    barrier();
+  }
+
+  if (lidx == 0) {
+    partials[widx].momentum = local_momentum[0];
+    partials[widx].angular_momentum = local_angular_momentum[0];
+    partials[widx].moment = local_moment[0];
+    partials[widx].energy = local_energy[0];
+  }
+}
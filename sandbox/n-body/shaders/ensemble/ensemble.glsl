@@ -0,0 +1,20 @@
+// independent simulations of nParticles particles each, stored one after
+// another. workgroups of member m have gl_WorkGroupID.y == m.
+
+// same layout as EnsembleMember in ensemble.h
+struct Member {
+  float dt;
+  uint seed;
+};
+
+layout(std430, binding = 3) readonly buffer layout_members {
+  Member members[];
+};
+
+// particles per member
+uniform uint nParticles;
+
+uint getMember() { return gl_WorkGroupID.y; }
+
+// first particle of the member
+uint getFirst() { return getMember() * nParticles; }
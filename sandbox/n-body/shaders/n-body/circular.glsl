@@ -0,0 +1,37 @@
+#include "random/random.glsl"
+
+// same as placeParticlesCircular in initial-conditions.h, which draws the
+// same random numbers. Particle has to be declared by the including shader.
+Particle placeCircular(uint index, uint seed, uint gridSize) {
+  const float black_hole_mass = 100000.0;
+  const float G = 6.67430e-11;
+
+  Particle particle;
+  particle.force = vec4(0.0);
+  particle.id = index;
+
+  if (index == 0) {
+    particle.position = vec4(0.0);
+    particle.velocity = vec4(0.0);
+    particle.mass = black_hole_mass;
+    return particle;
+  }
+
+  Random rng = createRandom(seed, index);
+  float u = float(index % gridSize) / float(gridSize);
+  float v = float((index / gridSize) % gridSize) / float(gridSize);
+
+  float r = 0.5 * (u + 0.1 * (2.0 * nextFloat(rng)));
+  float theta = 2.0 * 3.14 * v + 0.1 * (2.0 * nextFloat(rng) - 1.0);
+  float mass = 1.0 * 0.5 * (2.0 * nextFloat(rng));
+  float z = 0.1 * (2.0 * nextFloat(rng) - 1.0);
+
+  vec3 position = r * vec3(cos(theta), sin(theta), z);
+  vec3 velocity =
+      sqrt((G * black_hole_mass) / r) * vec3(-sin(theta), cos(theta), 0.0);
+
+  particle.position = vec4(position, 0.0);
+  particle.velocity = vec4(velocity, 0.0);
+  particle.mass = mass;
+  return particle;
+}
@@ -0,0 +1,18 @@
+// gravitational force on a particle from particles_in[first, last), which has
+// to be declared by the including shader, and its potential energy
+const float G = 6.67430e-11;
+const float EPS = 1e-6;
+
+vec3 computeGravity(vec3 position, float mass, uint first, uint last,
+                    out float potential) {
+  vec3 F = vec3(0);
+  potential = 0;
+  for (uint i = first; i < last; ++i) {
+    vec3 v = particles_in[i].position.xyz - position;
+    float l = length(v);
+    float Gmm = G * mass * particles_in[i].mass;
+    F += Gmm * v / (l * l * l + EPS);
+    potential -= l > 0.0 ? Gmm / l : 0.0;
+  }
+  return F;
+}
@@ -14,65 +14,7 @@ out vec3 base_color;
 
 uniform mat4 viewProjection;
 
-// https://github.com/kbinani/colormap-shaders/blob/master/shaders/glsl/IDL_CB-RdBu.frag
-float colormap_red(float x) {
-	if (x < 0.09771832105856419) {
-		return 7.60263247863246E+02 * x + 1.02931623931624E+02;
-	} else if (x < 0.3017162107441106) {
-		return (-2.54380938558548E+02 * x + 4.29911571188803E+02) * x + 1.37642085716717E+02;
-	} else if (x < 0.4014205790737471) {
-		return 8.67103448276151E+01 * x + 2.18034482758611E+02;
-	} else if (x < 0.5019932233215039) {
-		return -6.15461538461498E+01 * x + 2.77547692307680E+02;
-	} else if (x < 0.5969483882550937) {
-		return -3.77588522588624E+02 * x + 4.36198819698878E+02;
-	} else if (x < 0.8046060096654594) {
-		return (-6.51345897546620E+02 * x + 2.09780968434337E+02) * x + 3.17674951640855E+02;
-	} else {
-		return -3.08431855203590E+02 * x + 3.12956742081421E+02;
-	}
-}
-
-float colormap_green(float x) {
-	if (x < 0.09881640500975222) {
-		return 2.41408547008547E+02 * x + 3.50427350427364E-01;
-	} else if (x < 0.5000816285610199) {
-		return ((((1.98531871433258E+04 * x - 2.64108262469187E+04) * x + 1.10991785969817E+04) * x - 1.92958444776211E+03) * x + 8.39569642882186E+02) * x - 4.82944517518776E+01;
-	} else if (x < 0.8922355473041534) {
-		return (((6.16712686949223E+03 * x - 1.59084026055125E+04) * x + 1.45172137257997E+04) * x - 5.80944127411621E+03) * x + 1.12477959061948E+03;
-	} else {
-		return -5.28313797313699E+02 * x + 5.78459299959206E+02;
-	}
-}
-
-float colormap_blue(float x) {
-	if (x < 0.1033699568661857) {
-		return 1.30256410256410E+02 * x + 3.08518518518519E+01;
-	} else if (x < 0.2037526071071625) {
-		return 3.38458128078815E+02 * x + 9.33004926108412E+00;
-	} else if (x < 0.2973267734050751) {
-		return (-1.06345054944861E+02 * x + 5.93327252747168E+02) * x - 3.81852747252658E+01;
-	} else if (x < 0.4029109179973602) {
-		return 6.68959706959723E+02 * x - 7.00740740740798E+01;
-	} else if (x < 0.5006715489526758) {
-		return 4.87348695652202E+02 * x + 3.09898550724286E+00;
-	} else if (x < 0.6004396902588283) {
-		return -6.85799999999829E+01 * x + 2.81436666666663E+02;
-	} else if (x < 0.702576607465744) {
-		return -1.81331701891043E+02 * x + 3.49137263626287E+02;
-	} else if (x < 0.9010407030582428) {
-		return (2.06124143164576E+02 * x - 5.78166906665595E+02) * x + 5.26198653917172E+02;
-	} else {
-		return -7.36990769230737E+02 * x + 8.36652307692262E+02;
-	}
-}
-
-vec4 colormap(float x) {
-	float r = clamp(colormap_red(x) / 255.0, 0.0, 1.0);
-	float g = clamp(colormap_green(x) / 255.0, 0.0, 1.0);
-	float b = clamp(colormap_blue(x) / 255.0, 0.0, 1.0);
-	return vec4(r, g, b, 1.0);
-}
+#include "colormap.glsl"
 
 void main() {
   float x = 1.0 - 0.6 * clamp(10000.0 * length(force), 0.0, 1.0);
@@ -0,0 +1,232 @@
+#ifndef _CPU_N_BODY_H
+#define _CPU_N_BODY_H
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+#include "glm/glm.hpp"
+//
+#include "gcss/thread-pool.h"
+//
+#include "particle.h"
+#include "simd.h"
+
+using namespace gcss;
+
+// CPU implementation of init-particles.comp and update-particles.comp.
+// particles are stored as SoA, forces are computed for SIMD vectors of i
+// particles against broadcast j particles, j is tiled to stay in cache.
+class CpuNBody {
+ public:
+  // particles exerting forces, SoA with gm = G * mass. particles with gm = 0
+  // have no effect.
+  struct Sources {
+    const float* x;
+    const float* y;
+    const float* z;
+    const float* gm;
+    std::size_t count;
+  };
+
+ private:
+  // particles per task
+  static constexpr std::size_t BLOCK_SIZE = 256;
+  // j particles per tile
+  static constexpr std::size_t TILE_SIZE = 1024;
+
+  static constexpr float G = 6.67430e-11;
+  static constexpr float EPS = 1e-6;
+
+  static_assert(BLOCK_SIZE % SimdFloat::WIDTH == 0);
+
+  ThreadPool pool;
+
+  uint32_t nParticles;
+  AlignedVector<float> x, y, z;
+  AlignedVector<float> vx, vy, vz;
+  AlignedVector<float> fx, fy, fz;
+  AlignedVector<float> potential;
+  AlignedVector<float> mass;
+  // G * mass
+  AlignedVector<float> gm;
+  std::vector<uint32_t> id;
+
+  // accumulate G * m_j * v / (l^3 + EPS) and -G * m_j / l over sources for
+  // particles [begin, end)
+  void accumulate(std::size_t begin, std::size_t end, const Sources& sources) {
+    const SimdFloat tiny(1e-30f);
+    const SimdFloat eps(EPS);
+    const SimdFloat zero(0.0f);
+
+    for (std::size_t tile = 0; tile < sources.count; tile += TILE_SIZE) {
+      const std::size_t tile_end =
+          std::min<std::size_t>(tile + TILE_SIZE, sources.count);
+
+      for (std::size_t i = begin; i < end; i += SimdFloat::WIDTH) {
+        const SimdFloat xi = SimdFloat::load(&x[i]);
+        const SimdFloat yi = SimdFloat::load(&y[i]);
+        const SimdFloat zi = SimdFloat::load(&z[i]);
+        SimdFloat ax = SimdFloat::load(&fx[i]);
+        SimdFloat ay = SimdFloat::load(&fy[i]);
+        SimdFloat az = SimdFloat::load(&fz[i]);
+        SimdFloat pot = SimdFloat::load(&potential[i]);
+
+        for (std::size_t j = tile; j < tile_end; ++j) {
+          const SimdFloat dx = SimdFloat(sources.x[j]) - xi;
+          const SimdFloat dy = SimdFloat(sources.y[j]) - yi;
+          const SimdFloat dz = SimdFloat(sources.z[j]) - zi;
+          const SimdFloat l2 =
+              SimdFloat::fma(dx, dx, SimdFloat::fma(dy, dy, dz * dz));
+
+          // avoid rsqrt(0) for i == j, v is zero there anyway
+          const SimdFloat l2_safe = SimdFloat::max(l2, tiny);
+          const SimdFloat inv_l = rsqrt(l2_safe);
+          const SimdFloat l = l2_safe * inv_l;
+
+          const SimdFloat gmj(sources.gm[j]);
+          const SimdFloat s = gmj / SimdFloat::fma(l2_safe, l, eps);
+          ax = SimdFloat::fma(s, dx, ax);
+          ay = SimdFloat::fma(s, dy, ay);
+          az = SimdFloat::fma(s, dz, az);
+          pot = pot - SimdFloat::selectGreater(l2, zero, gmj * inv_l);
+        }
+
+        ax.store(&fx[i]);
+        ay.store(&fy[i]);
+        az.store(&fz[i]);
+        pot.store(&potential[i]);
+      }
+    }
+  }
+
+  void computeForces() {
+    clearForces();
+    accumulateForces(getSources());
+    finishForces();
+  }
+
+ public:
+  CpuNBody(std::size_t nThreads = std::thread::hardware_concurrency())
+      : pool{nThreads}, nParticles{0} {}
+
+  static const char* getInstructionSet() { return SimdFloat::NAME; }
+
+  std::size_t getNumberOfThreads() const { return pool.getNumberOfThreads(); }
+
+  uint32_t getNumberOfParticles() const { return nParticles; }
+
+  void setParticles(const std::vector<Particle>& particles) {
+    nParticles = particles.size();
+
+    // pad to whole blocks, padding particles have no mass
+    const std::size_t n =
+        (nParticles + BLOCK_SIZE - 1) / BLOCK_SIZE * BLOCK_SIZE;
+    for (auto* v : {&x, &y, &z, &vx, &vy, &vz, &fx, &fy, &fz, &potential,
+                    &mass, &gm}) {
+      v->assign(n, 0.0f);
+    }
+    id.resize(nParticles);
+
+    for (std::size_t i = 0; i < nParticles; ++i) {
+      x[i] = particles[i].position.x;
+      y[i] = particles[i].position.y;
+      z[i] = particles[i].position.z;
+      vx[i] = particles[i].velocity.x;
+      vy[i] = particles[i].velocity.y;
+      vz[i] = particles[i].velocity.z;
+      fx[i] = particles[i].force.x;
+      fy[i] = particles[i].force.y;
+      fz[i] = particles[i].force.z;
+      potential[i] = particles[i].force.w;
+      mass[i] = particles[i].mass;
+      gm[i] = G * particles[i].mass;
+      id[i] = particles[i].id;
+    }
+  }
+
+  void getParticles(std::vector<Particle>& particles) const {
+    particles.resize(nParticles);
+    for (std::size_t i = 0; i < nParticles; ++i) {
+      particles[i].position = glm::vec4(x[i], y[i], z[i], 0);
+      particles[i].velocity = glm::vec4(vx[i], vy[i], vz[i], 0);
+      particles[i].force = glm::vec4(fx[i], fy[i], fz[i], potential[i]);
+      particles[i].mass = mass[i];
+      particles[i].id = id[i];
+    }
+  }
+
+  Sources getSources() const {
+    return {x.data(), y.data(), z.data(), gm.data(), x.size()};
+  }
+
+  // forces are computed by clearForces, accumulateForces for each set of
+  // sources and finishForces
+  void clearForces() {
+    pool.parallelFor(0, x.size(), BLOCK_SIZE,
+                     [&](std::size_t begin, std::size_t end) {
+                       for (auto* v : {&fx, &fy, &fz, &potential}) {
+                         std::fill(v->begin() + begin, v->begin() + end,
+                                   0.0f);
+                       }
+                     });
+  }
+
+  void accumulateForces(const Sources& sources) {
+    pool.parallelFor(0, x.size(), BLOCK_SIZE,
+                     [&](std::size_t begin, std::size_t end) {
+                       accumulate(begin, end, sources);
+                     });
+  }
+
+  // multiply by m_i
+  void finishForces() {
+    pool.parallelFor(0, nParticles, BLOCK_SIZE,
+                     [&](std::size_t begin, std::size_t end) {
+                       for (std::size_t i = begin; i < end; ++i) {
+                         fx[i] *= mass[i];
+                         fy[i] *= mass[i];
+                         fz[i] *= mass[i];
+                         potential[i] *= mass[i];
+                       }
+                     });
+  }
+
+  // v += F / m * dt
+  void kick(float dt) {
+    pool.parallelFor(0, nParticles, BLOCK_SIZE,
+                     [&](std::size_t begin, std::size_t end) {
+                       for (std::size_t i = begin; i < end; ++i) {
+                         vx[i] += fx[i] / mass[i] * dt;
+                         vy[i] += fy[i] / mass[i] * dt;
+                         vz[i] += fz[i] / mass[i] * dt;
+                       }
+                     });
+  }
+
+  // x += v * dt
+  void drift(float dt) {
+    pool.parallelFor(0, nParticles, BLOCK_SIZE,
+                     [&](std::size_t begin, std::size_t end) {
+                       for (std::size_t i = begin; i < end; ++i) {
+                         x[i] += vx[i] * dt;
+                         y[i] += vy[i] * dt;
+                         z[i] += vz[i] * dt;
+                       }
+                     });
+  }
+
+  // same as init-particles.comp
+  void initVelocity(float dt) {
+    computeForces();
+    kick(-dt);
+  }
+
+  // same as update-particles.comp, leap-frog scheme
+  void step(float dt) {
+    computeForces();
+    kick(dt);
+    drift(dt);
+  }
+};
+
+#endif
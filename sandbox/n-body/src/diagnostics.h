@@ -0,0 +1,226 @@
+#ifndef _DIAGNOSTICS_H
+#define _DIAGNOSTICS_H
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <optional>
+#include <vector>
+
+#include "glad/gl.h"
+#include "glm/glm.hpp"
+#include "spdlog/spdlog.h"
+//
+#include "gcss/buffer.h"
+#include "gcss/readback.h"
+#include "gcss/shader.h"
+
+using namespace gcss;
+
+// same layout as Sample in resolve-diagnostics.comp
+struct alignas(16) DiagnosticsSample {
+  glm::vec4 momentum = glm::vec4(0);
+  glm::vec4 angularMomentum = glm::vec4(0);
+  glm::vec4 centerOfMass = glm::vec4(0);
+  float kineticEnergy = 0;
+  float potentialEnergy = 0;
+  float totalMass = 0;
+  uint32_t step = 0;
+
+  float getTotalEnergy() const { return kineticEnergy + potentialEnergy; }
+};
+
+// energy, momentum, angular momentum and center of mass of the n-body system,
+// reduced on the GPU into a ring buffer which is read back asynchronously
+class Diagnostics {
+ private:
+  static constexpr uint32_t RING_SIZE = 256;
+  static constexpr std::size_t MAX_HISTORY = 1024;
+
+  uint64_t nSamples;
+  // samples before this index have been requested for readback
+  uint64_t nRequested;
+
+  ComputeShader reduceDiagnostics;
+  Pipeline reduceDiagnosticsPipeline;
+  ComputeShader resolveDiagnostics;
+  Pipeline resolveDiagnosticsPipeline;
+
+  Buffer partials;
+  Buffer samples;
+  AsyncReadback readback;
+
+  // first sample after reset, reference for the energy drift
+  std::optional<DiagnosticsSample> initial;
+  std::vector<DiagnosticsSample> history;
+  std::ofstream csv;
+
+  void requestReadback() {
+    if (nRequested == nSamples || readback.isFull()) {
+      return;
+    }
+
+    // samples which have been overwritten in the ring are lost
+    if (nSamples - nRequested > RING_SIZE) {
+      spdlog::warn("[Diagnostics] dropped {} samples",
+                   nSamples - nRequested - RING_SIZE);
+      nRequested = nSamples - RING_SIZE;
+    }
+
+    // requested samples may wrap around the ring
+    const GLsizeiptr sample_size = sizeof(DiagnosticsSample);
+    const GLintptr first = nRequested % RING_SIZE;
+    const GLsizeiptr count = nSamples - nRequested;
+    const GLsizeiptr n_contiguous =
+        std::min<GLsizeiptr>(count, RING_SIZE - first);
+
+    std::vector<AsyncReadback::Region> regions;
+    regions.push_back(
+        {&samples, first * sample_size, n_contiguous * sample_size});
+    if (n_contiguous < count) {
+      regions.push_back({&samples, 0, (count - n_contiguous) * sample_size});
+    }
+
+    if (readback.request(regions, nRequested)) {
+      nRequested = nSamples;
+    }
+  }
+
+  void receive(const std::byte* data, std::size_t size) {
+    const std::size_t count = size / sizeof(DiagnosticsSample);
+    for (std::size_t i = 0; i < count; ++i) {
+      DiagnosticsSample sample;
+      std::memcpy(&sample, data + i * sizeof(DiagnosticsSample),
+                  sizeof(DiagnosticsSample));
+
+      if (!initial) {
+        initial = sample;
+      }
+
+      if (history.size() == MAX_HISTORY) {
+        history.erase(history.begin());
+      }
+      history.push_back(sample);
+
+      if (csv.is_open()) {
+        writeCSV(sample);
+      }
+    }
+  }
+
+  void writeCSV(const DiagnosticsSample& sample) {
+    csv << sample.step << "," << sample.kineticEnergy << ","
+        << sample.potentialEnergy << "," << sample.getTotalEnergy() << ","
+        << sample.momentum.x << "," << sample.momentum.y << ","
+        << sample.momentum.z << "," << sample.angularMomentum.x << ","
+        << sample.angularMomentum.y << "," << sample.angularMomentum.z << ","
+        << sample.centerOfMass.x << "," << sample.centerOfMass.y << ","
+        << sample.centerOfMass.z << "\n";
+  }
+
+ public:
+  Diagnostics()
+      : nSamples{0},
+        nRequested{0},
+        reduceDiagnostics{std::filesystem::path(CMAKE_CURRENT_SOURCE_DIR) /
+                          "shaders" / "diagnostics" /
+                          "reduce-diagnostics.comp"},
+        resolveDiagnostics{std::filesystem::path(CMAKE_CURRENT_SOURCE_DIR) /
+                           "shaders" / "diagnostics" /
+                           "resolve-diagnostics.comp"} {
+    reduceDiagnosticsPipeline.attachComputeShader(reduceDiagnostics);
+    resolveDiagnosticsPipeline.attachComputeShader(resolveDiagnostics);
+
+    samples.setData(std::vector<DiagnosticsSample>(RING_SIZE),
+                    GL_DYNAMIC_COPY);
+  }
+
+  ~Diagnostics() { stopCSV(); }
+
+  // forget history, e.g. after particles have been regenerated
+  void reset() {
+    readback.poll([](uint64_t, const std::byte*, std::size_t) {}, true);
+    nRequested = nSamples;
+    initial.reset();
+    history.clear();
+  }
+
+  const std::vector<DiagnosticsSample>& getHistory() const { return history; }
+
+  // relative change of total energy since the first sample
+  float computeEnergyDrift(const DiagnosticsSample& sample) const {
+    if (!initial || initial->getTotalEnergy() == 0) {
+      return 0;
+    }
+    return (sample.getTotalEnergy() - initial->getTotalEnergy()) /
+           std::abs(initial->getTotalEnergy());
+  }
+
+  bool isLoggingCSV() const { return csv.is_open(); }
+
+  void startCSV(const std::filesystem::path& filepath) {
+    stopCSV();
+    csv.open(filepath);
+    if (!csv.is_open()) {
+      spdlog::error("[Diagnostics] failed to open {}",
+                    filepath.generic_string());
+      return;
+    }
+    csv << "step,kinetic_energy,potential_energy,total_energy,momentum_x,"
+           "momentum_y,momentum_z,angular_momentum_x,angular_momentum_y,"
+           "angular_momentum_z,center_of_mass_x,center_of_mass_y,"
+           "center_of_mass_z\n";
+  }
+
+  void stopCSV() {
+    if (csv.is_open()) {
+      csv.close();
+    }
+  }
+
+  // particles must contain the output of update-particles.comp with the given
+  // dt
+  void compute(const Buffer& particles, uint32_t nParticles, float dt,
+               uint64_t step) {
+    const uint32_t n_partials = std::ceil(nParticles / 128.0f);
+    if (partials.getLength() < 4 * n_partials) {
+      partials.setData(std::vector<glm::vec4>(4 * n_partials),
+                       GL_DYNAMIC_COPY);
+    }
+
+    particles.bindToShaderStorageBuffer(0);
+    partials.bindToShaderStorageBuffer(1);
+    samples.bindToShaderStorageBuffer(2);
+
+    // reduce particles in each workgroup
+    reduceDiagnostics.setUniform("nParticles", nParticles);
+    reduceDiagnostics.setUniform("dt", dt);
+    reduceDiagnosticsPipeline.activate();
+    glDispatchCompute(n_partials, 1, 1);
+    reduceDiagnosticsPipeline.deactivate();
+
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+    // reduce partial sums into the ring buffer
+    resolveDiagnostics.setUniform("nPartials", n_partials);
+    resolveDiagnostics.setUniform("slot",
+                                  static_cast<GLuint>(nSamples % RING_SIZE));
+    resolveDiagnostics.setUniform("step", static_cast<GLuint>(step));
+    resolveDiagnosticsPipeline.activate();
+    glDispatchCompute(1, 1, 1);
+    resolveDiagnosticsPipeline.deactivate();
+
+    nSamples++;
+
+    requestReadback();
+  }
+
+  // receive finished readbacks
+  void poll() {
+    readback.poll([&](uint64_t, const std::byte* data, std::size_t size) {
+      receive(data, size);
+    });
+    requestReadback();
+  }
+};
+
+#endif
@@ -0,0 +1,128 @@
+#ifndef _DISTRIBUTED_N_BODY_H
+#define _DISTRIBUTED_N_BODY_H
+#include <algorithm>
+#include <vector>
+
+#include "cpu-n-body.h"
+#include "particle.h"
+#include "ring-transport.h"
+
+// n-body split across the ranks of a ring. each rank owns a contiguous slice
+// of particles, and blocks of positions and masses travel once around the
+// ring per force evaluation. the next block is in flight while forces from
+// the current one are accumulated.
+class DistributedNBody {
+ private:
+  RingTransport& transport;
+
+  uint32_t nParticles;
+  // particles per rank, the last slice is padded with massless particles
+  uint32_t sliceLength;
+  uint32_t nLocal;
+  CpuNBody local;
+
+  // x, y, z and G * mass of sliceLength particles
+  std::vector<float> current;
+  std::vector<float> next;
+
+  void packBlock() {
+    const CpuNBody::Sources sources = local.getSources();
+    std::fill(current.begin(), current.end(), 0.0f);
+    std::copy_n(sources.x, nLocal, current.begin());
+    std::copy_n(sources.y, nLocal, current.begin() + sliceLength);
+    std::copy_n(sources.z, nLocal, current.begin() + 2 * sliceLength);
+    std::copy_n(sources.gm, nLocal, current.begin() + 3 * sliceLength);
+  }
+
+  CpuNBody::Sources getBlockSources(const std::vector<float>& block) const {
+    return {block.data(), block.data() + sliceLength,
+            block.data() + 2 * sliceLength, block.data() + 3 * sliceLength,
+            sliceLength};
+  }
+
+  void computeForces() {
+    const int n_ranks = transport.getNumberOfRanks();
+
+    local.clearForces();
+    packBlock();
+    for (int k = 0; k < n_ranks; ++k) {
+      const bool last = k == n_ranks - 1;
+      if (!last) {
+        transport.startShift(current, next);
+      }
+
+      local.accumulateForces(getBlockSources(current));
+
+      if (!last) {
+        transport.finishShift();
+        std::swap(current, next);
+      }
+    }
+    local.finishForces();
+  }
+
+ public:
+  // every rank passes the same particles and keeps its own slice
+  DistributedNBody(RingTransport& transport,
+                   const std::vector<Particle>& particles,
+                   std::size_t nThreads)
+      : transport{transport},
+        nParticles{0},
+        sliceLength{0},
+        nLocal{0},
+        local{nThreads} {
+    setParticles(particles);
+  }
+
+  static uint32_t getSliceLength(uint32_t nParticles, int nRanks) {
+    return (nParticles + nRanks - 1) / nRanks;
+  }
+
+  uint32_t getNumberOfParticles() const { return nParticles; }
+  uint32_t getNumberOfLocalParticles() const { return nLocal; }
+  std::size_t getNumberOfThreads() const { return local.getNumberOfThreads(); }
+
+  void setParticles(const std::vector<Particle>& particles) {
+    nParticles = particles.size();
+    sliceLength = getSliceLength(nParticles, transport.getNumberOfRanks());
+
+    const std::size_t first =
+        std::min<std::size_t>(transport.getRank() * sliceLength, nParticles);
+    const std::size_t last =
+        std::min<std::size_t>(first + sliceLength, nParticles);
+    nLocal = last - first;
+
+    local.setParticles(std::vector<Particle>(particles.begin() + first,
+                                             particles.begin() + last));
+
+    current.resize(4 * sliceLength);
+    next.resize(4 * sliceLength);
+  }
+
+  // same as CpuNBody::initVelocity
+  void initVelocity(float dt) {
+    computeForces();
+    local.kick(-dt);
+  }
+
+  // same as CpuNBody::step
+  void step(float dt) {
+    computeForces();
+    local.kick(dt);
+    local.drift(dt);
+  }
+
+  // all particles on rank 0, empty on the other ranks
+  void gather(std::vector<Particle>& particles) {
+    std::vector<Particle> slice;
+    local.getParticles(slice);
+    slice.resize(sliceLength);
+
+    transport.gather(slice, particles);
+    if (transport.getRank() == 0) {
+      particles.resize(nParticles);
+    }
+  }
+};
+
+#endif
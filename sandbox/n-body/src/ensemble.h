@@ -0,0 +1,239 @@
+#ifndef _ENSEMBLE_H
+#define _ENSEMBLE_H
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <vector>
+
+#include "glad/gl.h"
+#include "glm/glm.hpp"
+//
+#include "gcss/buffer.h"
+#include "gcss/readback.h"
+#include "gcss/shader.h"
+//
+#include "diagnostics.h"
+#include "initial-conditions.h"
+#include "particles.h"
+
+using namespace gcss;
+
+// same layout as Member in ensemble/ensemble.glsl
+struct EnsembleMember {
+  float dt = 0.01f;
+  // seed of initial particles
+  uint32_t seed = 0;
+};
+
+// independent n-body simulations of the same size in one buffer, e.g. to
+// sweep dt or initial conditions. every member has its own parameter block
+// and all members advance in a single dispatch, so that small simulations
+// still fill the GPU. diagnostics are reduced per member.
+class Ensemble {
+ private:
+  uint32_t nParticles;
+  std::vector<EnsembleMember> members;
+  uint64_t step;
+
+  ComputeShader placeParticles;
+  Pipeline placeParticlesPipeline;
+  ComputeShader initParticles;
+  Pipeline initParticlesPipeline;
+  ComputeShader updateParticles;
+  Pipeline updateParticlesPipeline;
+  ComputeShader reduceDiagnostics;
+  Pipeline reduceDiagnosticsPipeline;
+  ComputeShader resolveDiagnostics;
+  Pipeline resolveDiagnosticsPipeline;
+
+  Buffer membersBuffer;
+  Buffer particlesIn;
+  Buffer particlesOut;
+  Buffer partials;
+  Buffer samples;
+  AsyncReadback readback;
+
+  // diagnostics of every member, initial ones are the reference for drift
+  std::vector<DiagnosticsSample> initialSamples;
+  std::vector<DiagnosticsSample> latestSamples;
+
+  static std::filesystem::path getShaderPath(const std::string& filename) {
+    return std::filesystem::path(CMAKE_CURRENT_SOURCE_DIR) / "shaders" /
+           "ensemble" / filename;
+  }
+
+  uint32_t getNumberOfWorkgroups() const {
+    return std::ceil(nParticles / 128.0f);
+  }
+
+  void dispatch(const Pipeline& pipeline) const {
+    particlesIn.bindToShaderStorageBuffer(0);
+    particlesOut.bindToShaderStorageBuffer(1);
+    membersBuffer.bindToShaderStorageBuffer(3);
+
+    pipeline.activate();
+    glDispatchCompute(getNumberOfWorkgroups(), members.size(), 1);
+    pipeline.deactivate();
+
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+  }
+
+  // reduce diagnostics of particlesIn into samples and read them back
+  void computeDiagnostics() {
+    if (readback.isFull()) {
+      return;
+    }
+
+    particlesIn.bindToShaderStorageBuffer(0);
+    partials.bindToShaderStorageBuffer(1);
+    samples.bindToShaderStorageBuffer(2);
+    membersBuffer.bindToShaderStorageBuffer(3);
+
+    reduceDiagnostics.setUniform("nParticles", nParticles);
+    reduceDiagnosticsPipeline.activate();
+    glDispatchCompute(getNumberOfWorkgroups(), members.size(), 1);
+    reduceDiagnosticsPipeline.deactivate();
+
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+    resolveDiagnostics.setUniform("nPartials", getNumberOfWorkgroups());
+    resolveDiagnostics.setUniform("slot", 0u);
+    resolveDiagnostics.setUniform("step", static_cast<GLuint>(step));
+    resolveDiagnosticsPipeline.activate();
+    glDispatchCompute(members.size(), 1, 1);
+    resolveDiagnosticsPipeline.deactivate();
+
+    readback.request({{&samples, 0,
+                       static_cast<GLsizeiptr>(members.size() *
+                                               sizeof(DiagnosticsSample))}},
+                     step);
+  }
+
+  void receive(const std::byte* data, std::size_t size) {
+    const std::size_t count = size / sizeof(DiagnosticsSample);
+    latestSamples.resize(count);
+    std::memcpy(latestSamples.data(), data,
+                count * sizeof(DiagnosticsSample));
+    if (initialSamples.size() != count) {
+      initialSamples = latestSamples;
+    }
+  }
+
+ public:
+  Ensemble()
+      : nParticles{1024},
+        members(8),
+        step{0},
+        placeParticles{getShaderPath("place-particles.comp")},
+        initParticles{getShaderPath("init-particles.comp")},
+        updateParticles{getShaderPath("update-particles.comp")},
+        reduceDiagnostics{getShaderPath("reduce-diagnostics.comp")},
+        resolveDiagnostics{std::filesystem::path(CMAKE_CURRENT_SOURCE_DIR) /
+                           "shaders" / "diagnostics" /
+                           "resolve-diagnostics.comp"} {
+    placeParticlesPipeline.attachComputeShader(placeParticles);
+    initParticlesPipeline.attachComputeShader(initParticles);
+    updateParticlesPipeline.attachComputeShader(updateParticles);
+    reduceDiagnosticsPipeline.attachComputeShader(reduceDiagnostics);
+    resolveDiagnosticsPipeline.attachComputeShader(resolveDiagnostics);
+  }
+
+  // particles per member, takes effect with reset
+  uint32_t getNumberOfParticles() const { return nParticles; }
+  void setNumberOfParticles(uint32_t nParticles) {
+    this->nParticles = std::max(nParticles, 1u);
+  }
+
+  // takes effect with reset
+  std::size_t getNumberOfMembers() const { return members.size(); }
+  const EnsembleMember& getMember(uint32_t index) const {
+    return members[index];
+  }
+  void setMembers(const std::vector<EnsembleMember>& members) {
+    this->members = members;
+  }
+
+  // n members with dt evenly spaced in [dtMin, dtMax] and consecutive seeds
+  // from seed on
+  void sweep(uint32_t n, float dtMin, float dtMax, uint32_t seed) {
+    members.resize(std::max(n, 1u));
+    for (std::size_t i = 0; i < members.size(); ++i) {
+      const float t = members.size() > 1
+                          ? static_cast<float>(i) / (members.size() - 1)
+                          : 0.0f;
+      members[i].dt = dtMin + t * (dtMax - dtMin);
+      members[i].seed = seed + i;
+    }
+  }
+
+  uint64_t getStep() const { return step; }
+
+  // particles of member m are in [m * nParticles, (m + 1) * nParticles)
+  const Buffer& getParticles() const { return particlesIn; }
+
+  // place particles of every member and start from step 0
+  void reset() {
+    readback.flush([](uint64_t, const std::byte*, std::size_t) {});
+    initialSamples.clear();
+    latestSamples.clear();
+    step = 0;
+
+    const uint32_t n_total = nParticles * members.size();
+    membersBuffer.setData(members, GL_STATIC_DRAW);
+    particlesIn.allocate<Particle>(n_total, GL_DYNAMIC_DRAW);
+    particlesOut.allocate<Particle>(n_total, GL_DYNAMIC_DRAW);
+    partials.allocate<glm::vec4>(4 * getNumberOfWorkgroups() * members.size(),
+                                 GL_DYNAMIC_COPY);
+    samples.allocate<DiagnosticsSample>(members.size(), GL_DYNAMIC_COPY);
+
+    placeParticles.setUniform("nParticles", nParticles);
+    placeParticles.setUniform("gridSize", getCircularGridSize(nParticles));
+    dispatch(placeParticlesPipeline);
+
+    // init-particles.comp only writes velocity and force
+    glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+    particlesOut.copySubData<Particle>(particlesIn, 0, 0, n_total);
+
+    initParticles.setUniform("nParticles", nParticles);
+    dispatch(initParticlesPipeline);
+    std::swap(particlesIn, particlesOut);
+  }
+
+  // advance every member by one step of its own dt
+  void update(bool diagnostics) {
+    updateParticles.setUniform("nParticles", nParticles);
+    dispatch(updateParticlesPipeline);
+    std::swap(particlesIn, particlesOut);
+
+    if (diagnostics) {
+      computeDiagnostics();
+    }
+    step++;
+  }
+
+  // receive finished diagnostics
+  void poll() {
+    readback.poll([&](uint64_t, const std::byte* data, std::size_t size) {
+      receive(data, size);
+    });
+  }
+
+  // latest diagnostics of every member, empty until the first readback
+  const std::vector<DiagnosticsSample>& getSamples() const {
+    return latestSamples;
+  }
+
+  // relative change of total energy of a member since its first sample
+  float computeEnergyDrift(uint32_t member) const {
+    if (member >= latestSamples.size() ||
+        initialSamples[member].getTotalEnergy() == 0) {
+      return 0;
+    }
+    return (latestSamples[member].getTotalEnergy() -
+            initialSamples[member].getTotalEnergy()) /
+           std::abs(initialSamples[member].getTotalEnergy());
+  }
+};
+
+#endif
@@ -0,0 +1,62 @@
+#ifndef _INITIAL_CONDITIONS_H
+#define _INITIAL_CONDITIONS_H
+#include <cmath>
+#include <vector>
+
+#include "glm/glm.hpp"
+//
+#include "gcss/random.h"
+//
+#include "particle.h"
+
+using namespace gcss;
+
+// side of the grid particles are laid out on
+inline uint32_t getCircularGridSize(uint32_t nParticles) {
+  return std::sqrt(nParticles);
+}
+
+// particles orbiting a black hole at the origin. the same seed always gives
+// the same particles, so that processes can generate them independently.
+// shaders/n-body/place-particles-circular.comp generates them on the GPU
+// from the same random numbers.
+inline std::vector<Particle> placeParticlesCircular(uint32_t nParticles,
+                                                    uint32_t seed) {
+  const float black_hole_mass = 100000;
+
+  std::vector<Particle> data(nParticles);
+  const uint32_t grid_size = getCircularGridSize(nParticles);
+  for (std::size_t idx = 0; idx < data.size(); ++idx) {
+    Random rng(seed, idx);
+
+    const uint32_t i = idx % grid_size;
+    const uint32_t j = (idx / grid_size) % grid_size;
+    const float u = static_cast<float>(i) / grid_size;
+    const float v = static_cast<float>(j) / grid_size;
+
+    const float r = 0.5f * (u + 0.1f * (2.0f * rng.nextFloat()));
+    const float theta =
+        2.0f * 3.14f * v + 0.1f * (2.0f * rng.nextFloat() - 1.0f);
+    const float mass = 1.0f * 0.5f * (2.0f * rng.nextFloat());
+    const float z = 0.1f * (2.0f * rng.nextFloat() - 1.0f);
+
+    const glm::vec3 position =
+        r * glm::vec3(std::cos(theta), std::sin(theta), z);
+    const float G = 6.67430e-11;
+    const glm::vec3 velocity =
+        std::sqrt((G * black_hole_mass) / r) *
+        (glm::vec3(-std::sin(theta), std::cos(theta), 0));
+
+    data[idx].position = glm::vec4(position, 0);
+    data[idx].velocity = glm::vec4(velocity, 0);
+    data[idx].mass = mass;
+    data[idx].id = idx;
+  }
+  data[0].position = glm::vec4(0);
+  data[0].velocity = glm::vec4(0);
+  data[0].mass = black_hole_mass;
+
+  return data;
+}
+
+#endif
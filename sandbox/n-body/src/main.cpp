@@ -1,3 +1,4 @@
+#include <cfloat>
 #include <cstdio>
 #include <iostream>
 
@@ -143,9 +144,226 @@ int main() {
         RENDERER->setDt(DT);
       }
 
+      static int seed = RENDERER->getSeed();
+      if (ImGui::InputInt("Seed", &seed)) {
+        RENDERER->setSeed(seed);
+      }
+
       if (ImGui::Button("Reset particles")) {
         RENDERER->resetParticles();
       }
+
+      ImGui::Separator();
+
+      static int render_mode = static_cast<int>(RENDERER->getRenderMode());
+      if (ImGui::Combo("Render mode", &render_mode,
+                       "Points\0"
+                       "Splatting\0")) {
+        RENDERER->setRenderMode(static_cast<RenderMode>(render_mode));
+      }
+
+      static float splat_point_size = RENDERER->getSplatPointSize();
+      if (ImGui::SliderFloat("Splat point size", &splat_point_size, 0.0f,
+                             64.0f)) {
+        RENDERER->setSplatPointSize(splat_point_size);
+      }
+
+      static float splat_intensity = RENDERER->getSplatIntensity();
+      if (ImGui::InputFloat("Splat intensity", &splat_intensity)) {
+        splat_intensity = std::max(splat_intensity, 0.0f);
+        RENDERER->setSplatIntensity(splat_intensity);
+      }
+
+      static float splat_exposure = RENDERER->getSplatExposure();
+      if (ImGui::InputFloat("Splat exposure", &splat_exposure)) {
+        splat_exposure = std::max(splat_exposure, 0.0f);
+        RENDERER->setSplatExposure(splat_exposure);
+      }
+
+      ImGui::Separator();
+
+      static int backend = static_cast<int>(RENDERER->getBackend());
+      if (ImGui::Combo("Backend", &backend, "GPU\0CPU\0")) {
+        RENDERER->setBackend(static_cast<Backend>(backend));
+      }
+      ImGui::Text("CPU: %s, %d threads", RENDERER->getCpuInstructionSet(),
+                  static_cast<int>(RENDERER->getCpuNumberOfThreads()));
+
+      static ValidationResult validation;
+      if (ImGui::Button("Validate CPU backend")) {
+        validation = RENDERER->validateCpuBackend();
+      }
+      ImGui::Text("Max position error: %e", validation.maxPositionError);
+      ImGui::Text("Max velocity error: %e", validation.maxVelocityError);
+      ImGui::Text("Max relative force error: %e", validation.maxForceError);
+
+      ImGui::Separator();
+
+      static bool ensemble = RENDERER->getEnableEnsemble();
+      if (ImGui::Checkbox("Ensemble", &ensemble)) {
+        RENDERER->setEnableEnsemble(ensemble);
+      }
+
+      static int ensemble_members =
+          RENDERER->getEnsemble().getNumberOfMembers();
+      ImGui::InputInt("Members", &ensemble_members);
+      static int ensemble_particles =
+          RENDERER->getEnsemble().getNumberOfParticles();
+      ImGui::InputInt("Particles per member", &ensemble_particles);
+      static float ensemble_dt_min = RENDERER->getDt();
+      ImGui::InputFloat("dt min", &ensemble_dt_min, 0.0f, 0.0f, "%.5f");
+      static float ensemble_dt_max = RENDERER->getDt();
+      ImGui::InputFloat("dt max", &ensemble_dt_max, 0.0f, 0.0f, "%.5f");
+      if (ImGui::Button("Sweep")) {
+        ensemble_members = std::clamp(ensemble_members, 1, 4096);
+        ensemble_particles = std::clamp(ensemble_particles, 1, 1000000);
+        RENDERER->sweepEnsemble(ensemble_members, ensemble_particles,
+                                ensemble_dt_min, ensemble_dt_max);
+      }
+
+      if (ensemble) {
+        const Ensemble& e = RENDERER->getEnsemble();
+        static int ensemble_member = RENDERER->getEnsembleMember();
+        if (ImGui::SliderInt("Drawn member", &ensemble_member, 0,
+                             e.getNumberOfMembers() - 1)) {
+          RENDERER->setEnsembleMember(ensemble_member);
+        }
+
+        // seed, dt, total energy and energy drift of every member
+        const auto& samples = e.getSamples();
+        for (std::size_t i = 0; i < samples.size(); ++i) {
+          ImGui::Text("%3d: seed %u, dt %.5f, E %e, drift %e",
+                      static_cast<int>(i), e.getMember(i).seed,
+                      e.getMember(i).dt, samples[i].getTotalEnergy(),
+                      e.computeEnergyDrift(i));
+        }
+      }
+
+      ImGui::Separator();
+
+      static int reorder_interval = RENDERER->getReorderInterval();
+      if (ImGui::InputInt("Reorder every K steps", &reorder_interval)) {
+        reorder_interval = std::max(reorder_interval, 0);
+        RENDERER->setReorderInterval(reorder_interval);
+      }
+
+      static int reorder_bits = RENDERER->getReorderBits() == 30 ? 0 : 1;
+      if (ImGui::Combo("Morton code", &reorder_bits,
+                       "30 bit\0"
+                       "63 bit\0")) {
+        RENDERER->setReorderBits(reorder_bits == 0 ? 30 : 63);
+      }
+
+      const ReorderReport& reorder_report = RENDERER->getReorderReport();
+      ImGui::Text("Reorder: %.3f ms", reorder_report.reorderTime);
+      ImGui::Text("Step before/after: %.3f/%.3f ms",
+                  reorder_report.frameTimeBefore,
+                  reorder_report.frameTimeAfter);
+      if (reorder_report.getBreakEvenFrames() < 0) {
+        ImGui::Text("Break-even: no gain");
+      } else {
+        ImGui::Text("Break-even: %.1f steps",
+                    reorder_report.getBreakEvenFrames());
+      }
+
+      ImGui::Separator();
+
+      bool record_trajectory = RENDERER->isRecordingTrajectory();
+      if (ImGui::Checkbox("Record trajectory", &record_trajectory)) {
+        if (record_trajectory) {
+          RENDERER->startTrajectory("n-body.trj");
+        } else {
+          RENDERER->stopTrajectory();
+        }
+      }
+
+      static int trajectory_interval = RENDERER->getTrajectoryInterval();
+      if (ImGui::InputInt("Record every K steps", &trajectory_interval)) {
+        trajectory_interval = std::max(trajectory_interval, 1);
+        RENDERER->setTrajectoryInterval(trajectory_interval);
+      }
+
+      static int trajectory_bits = RENDERER->getTrajectoryBits() == 16 ? 0 : 1;
+      if (ImGui::Combo("Quantization", &trajectory_bits,
+                       "16 bit\0"
+                       "21 bit\0")) {
+        RENDERER->setTrajectoryBits(trajectory_bits == 0 ? 16 : 21);
+      }
+
+      ImGui::Text("Recorded frames: %lu", static_cast<unsigned long>(
+                      RENDERER->getNumberOfRecordedFrames()));
+
+      ImGui::Separator();
+
+      static bool enable_export = RENDERER->getEnableExport();
+      if (ImGui::Checkbox("Export to shared memory", &enable_export)) {
+        RENDERER->setEnableExport(enable_export);
+      }
+
+      static int export_interval = RENDERER->getExportInterval();
+      if (ImGui::InputInt("Export every K steps", &export_interval)) {
+        export_interval = std::max(export_interval, 1);
+        RENDERER->setExportInterval(export_interval);
+      }
+
+      ImGui::Text("Exported frames to %s: %lu",
+                  RENDERER->getExportName().c_str(),
+                  static_cast<unsigned long>(
+                      RENDERER->getNumberOfExportedFrames()));
+
+      ImGui::Separator();
+
+      static bool diagnostics = RENDERER->getDiagnosticsEnabled();
+      if (ImGui::Checkbox("Diagnostics", &diagnostics)) {
+        RENDERER->setDiagnosticsEnabled(diagnostics);
+      }
+
+      static int diagnostics_interval = RENDERER->getDiagnosticsInterval();
+      if (ImGui::InputInt("Diagnose every K steps", &diagnostics_interval)) {
+        diagnostics_interval = std::max(diagnostics_interval, 1);
+        RENDERER->setDiagnosticsInterval(diagnostics_interval);
+      }
+
+      bool log_csv = RENDERER->getDiagnostics().isLoggingCSV();
+      if (ImGui::Checkbox("Log diagnostics to CSV", &log_csv)) {
+        if (log_csv) {
+          RENDERER->startDiagnosticsCSV("n-body-diagnostics.csv");
+        } else {
+          RENDERER->stopDiagnosticsCSV();
+        }
+      }
+
+      const Diagnostics& diag = RENDERER->getDiagnostics();
+      const auto& history = diag.getHistory();
+      if (!history.empty()) {
+        const DiagnosticsSample& last = history.back();
+        ImGui::Text("Kinetic energy: %e", last.kineticEnergy);
+        ImGui::Text("Potential energy: %e", last.potentialEnergy);
+        ImGui::Text("Total energy: %e", last.getTotalEnergy());
+        ImGui::Text("Momentum: (%e, %e, %e)", last.momentum.x,
+                    last.momentum.y, last.momentum.z);
+        ImGui::Text("Angular momentum: (%e, %e, %e)", last.angularMomentum.x,
+                    last.angularMomentum.y, last.angularMomentum.z);
+        ImGui::Text("Center of mass: (%f, %f, %f)", last.centerOfMass.x,
+                    last.centerOfMass.y, last.centerOfMass.z);
+
+        std::vector<float> drift(history.size());
+        std::vector<float> momentum(history.size());
+        std::vector<float> angular_momentum(history.size());
+        for (std::size_t i = 0; i < history.size(); ++i) {
+          drift[i] = diag.computeEnergyDrift(history[i]);
+          momentum[i] = glm::length(glm::vec3(history[i].momentum));
+          angular_momentum[i] =
+              glm::length(glm::vec3(history[i].angularMomentum));
+        }
+        ImGui::PlotLines("Energy drift", drift.data(), drift.size(), 0,
+                         nullptr, FLT_MAX, FLT_MAX, ImVec2(0, 80));
+        ImGui::PlotLines("|Momentum|", momentum.data(), momentum.size(), 0,
+                         nullptr, FLT_MAX, FLT_MAX, ImVec2(0, 80));
+        ImGui::PlotLines("|Angular momentum|", angular_momentum.data(),
+                         angular_momentum.size(), 0, nullptr, FLT_MAX,
+                         FLT_MAX, ImVec2(0, 80));
+      }
     }
     ImGui::End();
 
@@ -0,0 +1,154 @@
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+
+#include "spdlog/spdlog.h"
+//
+#include "cpu-n-body.h"
+#include "distributed-n-body.h"
+#include "initial-conditions.h"
+#include "ring-transport.h"
+
+// headless n-body distributed over processes
+//
+// mpirun -np 8 n-body-distributed --particles 262144 --steps 10
+// n-body-distributed --transport shm --ranks 8 --particles 262144 --steps 10
+
+struct Options {
+#ifdef N_BODY_WITH_MPI
+  std::string transport = "mpi";
+#else
+  std::string transport = "shm";
+#endif
+  int nRanks = 1;
+  uint32_t nParticles = 65536;
+  uint32_t nSteps = 10;
+  float dt = 0.01f;
+  uint32_t seed = 0;
+  // 0: hardware threads divided by ranks
+  std::size_t nThreads = 0;
+  // compare with a single process run
+  bool validate = false;
+};
+
+static Options parseOptions(int argc, char** argv) {
+  Options options;
+  for (int i = 1; i < argc; ++i) {
+    const std::string arg = argv[i];
+    const bool has_value = i + 1 < argc;
+    if (arg == "--transport" && has_value) {
+      options.transport = argv[++i];
+    } else if (arg == "--ranks" && has_value) {
+      options.nRanks = std::max(std::atoi(argv[++i]), 1);
+    } else if (arg == "--particles" && has_value) {
+      options.nParticles = std::max(std::atoi(argv[++i]), 1);
+    } else if (arg == "--steps" && has_value) {
+      options.nSteps = std::max(std::atoi(argv[++i]), 0);
+    } else if (arg == "--dt" && has_value) {
+      options.dt = std::atof(argv[++i]);
+    } else if (arg == "--seed" && has_value) {
+      options.seed = std::atoi(argv[++i]);
+    } else if (arg == "--threads" && has_value) {
+      options.nThreads = std::max(std::atoi(argv[++i]), 0);
+    } else if (arg == "--validate") {
+      options.validate = true;
+    } else {
+      spdlog::warn("unknown option {}", arg);
+    }
+  }
+  return options;
+}
+
+static std::unique_ptr<RingTransport> createTransport(
+    const Options& options, [[maybe_unused]] int* argc,
+    [[maybe_unused]] char*** argv) {
+#ifdef N_BODY_WITH_MPI
+  if (options.transport == "mpi") {
+    return std::make_unique<MpiTransport>(argc, argv);
+  }
+#endif
+#ifdef N_BODY_WITH_FORK
+  if (options.transport == "shm") {
+    const uint32_t slice_length = DistributedNBody::getSliceLength(
+        options.nParticles, options.nRanks);
+    return std::make_unique<SharedMemoryTransport>(
+        options.nRanks, 4 * slice_length, slice_length);
+  }
+#endif
+  spdlog::error("transport {} is not available", options.transport);
+  std::exit(EXIT_FAILURE);
+}
+
+int main(int argc, char** argv) {
+  const Options options = parseOptions(argc, argv);
+  std::unique_ptr<RingTransport> transport =
+      createTransport(options, &argc, &argv);
+  const int rank = transport->getRank();
+  const int n_ranks = transport->getNumberOfRanks();
+
+  const std::size_t n_threads =
+      options.nThreads > 0
+          ? options.nThreads
+          : std::max<std::size_t>(
+                std::thread::hardware_concurrency() / n_ranks, 1);
+
+  // every rank generates the same particles
+  const std::vector<Particle> initial =
+      placeParticlesCircular(options.nParticles, options.seed);
+
+  DistributedNBody n_body(*transport, initial, n_threads);
+  if (rank == 0) {
+    spdlog::info("{} ranks over {}, {} threads per rank, {}, {} particles",
+                 n_ranks, transport->getName(), n_threads,
+                 CpuNBody::getInstructionSet(), options.nParticles);
+  }
+
+  n_body.initVelocity(options.dt);
+
+  const double interactions =
+      static_cast<double>(options.nParticles) * options.nParticles;
+  for (uint32_t step = 0; step < options.nSteps; ++step) {
+    transport->barrier();
+    const auto start = std::chrono::steady_clock::now();
+
+    n_body.step(options.dt);
+
+    transport->barrier();
+    const std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - start;
+    if (rank == 0) {
+      spdlog::info("step {}: {:.3f} ms, {:.3f} G interactions/s", step,
+                   1e3 * elapsed.count(),
+                   1e-9 * interactions / elapsed.count());
+    }
+  }
+
+  std::vector<Particle> result;
+  n_body.gather(result);
+
+  if (options.validate && rank == 0) {
+    CpuNBody reference(n_threads);
+    reference.setParticles(initial);
+    reference.initVelocity(options.dt);
+    for (uint32_t step = 0; step < options.nSteps; ++step) {
+      reference.step(options.dt);
+    }
+
+    std::vector<Particle> expected;
+    reference.getParticles(expected);
+
+    float max_error = 0;
+    for (std::size_t i = 0; i < expected.size(); ++i) {
+      max_error =
+          std::max(max_error, glm::length(glm::vec3(result[i].position -
+                                                    expected[i].position)));
+    }
+    spdlog::info("max position error against a single process: {}",
+                 max_error);
+  }
+
+  return 0;
+}
@@ -0,0 +1,16 @@
+#ifndef _PARTICLE_H
+#define _PARTICLE_H
+#include "glm/glm.hpp"
+
+// layout of a particle in the storage buffers, kept free of GL so the CPU
+// backends build without it
+struct alignas(16) Particle {
+  glm::vec4 position = glm::vec4(0);
+  glm::vec4 velocity = glm::vec4(0);
+  glm::vec4 force = glm::vec4(0);
+  float mass = 0;
+  // index the particle was placed at, kept when particles are reordered
+  uint32_t id = 0;
+};
+
+#endif
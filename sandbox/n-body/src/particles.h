@@ -3,16 +3,11 @@
 #include "gcss/buffer.h"
 #include "gcss/shader.h"
 #include "gcss/vertex-array-object.h"
+//
+#include "particle.h"
 
 using namespace gcss;
 
-struct alignas(16) Particle {
-  glm::vec4 position = glm::vec4(0);
-  glm::vec4 velocity = glm::vec4(0);
-  glm::vec4 force = glm::vec4(0);
-  float mass = 0;
-};
-
 class Particles {
  private:
   VertexArrayObject VAO;
@@ -39,9 +34,14 @@ class Particles {
   }
 
   void draw(const Pipeline& pipeline) const {
+    draw(pipeline, 0, particles->getLength());
+  }
+
+  // draw count particles from first on, e.g. one member of an ensemble
+  void draw(const Pipeline& pipeline, uint32_t first, uint32_t count) const {
     pipeline.activate();
     VAO.activate();
-    glDrawArrays(GL_POINTS, 0, particles->getLength());
+    glDrawArrays(GL_POINTS, first, count);
     VAO.deactivate();
     pipeline.deactivate();
   }
@@ -1,6 +1,6 @@
 #ifndef _RENDERER_H
 #define _RENDERER_H
-#include <random>
+#include <algorithm>
 #include <vector>
 
 #include "glad/gl.h"
@@ -8,19 +8,49 @@
 //
 #include "gcss/buffer.h"
 #include "gcss/camera.h"
+#include "gcss/gpu-timer.h"
+#include "gcss/morton-reorder.h"
+#include "gcss/point-splatter.h"
 #include "gcss/quad.h"
 #include "gcss/shader.h"
+#include "gcss/shared-frame-exporter.h"
+#include "gcss/trajectory-recorder.h"
 #include "gcss/vertex-array-object.h"
 //
+#include "cpu-n-body.h"
+#include "diagnostics.h"
+#include "ensemble.h"
+#include "initial-conditions.h"
 #include "particles.h"
 
 using namespace gcss;
 
+enum class RenderMode : int {
+  POINTS = 0,
+  SPLATTING = 1,
+};
+
+enum class Backend : int {
+  GPU = 0,
+  CPU = 1,
+};
+
+// difference between one step of update-particles.comp and CpuNBody
+struct ValidationResult {
+  float maxPositionError = 0;
+  float maxVelocityError = 0;
+  // relative to the magnitude of the force
+  float maxForceError = 0;
+};
+
 class Renderer {
  private:
   glm::uvec2 resolution;
   uint32_t nParticles;
   float dt;
+  uint64_t step;
+  // seed of initial particles
+  uint32_t seed;
 
   Camera camera;
 
@@ -28,6 +58,9 @@ class Renderer {
   Buffer particlesIn;
   Buffer particlesOut;
 
+  ComputeShader placeParticles;
+  Pipeline placeParticlesPipeline;
+
   ComputeShader initParticles;
   Pipeline initParticlesPipeline;
 
@@ -38,11 +71,106 @@ class Renderer {
   FragmentShader fragmentShader;
   Pipeline renderPipeline;
 
+  RenderMode renderMode;
+  PointSplatter splatter;
+
+  TrajectoryRecorder trajectory;
+  uint32_t trajectoryInterval;
+  // index of each particle by id, so that trajectories follow particles
+  // across a reorder
+  ComputeShader computeSlots;
+  Pipeline computeSlotsPipeline;
+  Buffer slotsBuffer;
+
+  // publish particles to other processes every Kth step, see
+  // shared-frame-reader
+  bool enableExport;
+  uint32_t exportInterval;
+  SharedFrameExporter exporter;
+
+  Diagnostics diagnostics;
+  bool diagnosticsEnabled;
+  uint32_t diagnosticsInterval;
+
+  Backend backend;
+  CpuNBody cpu;
+  std::vector<Particle> cpuParticles;
+
+  // many small simulations instead of the main one, one member is drawn
+  bool enableEnsemble;
+  Ensemble ensemble;
+  Particles ensembleParticles;
+  uint32_t ensembleMember;
+
+  // sort particles along a Morton curve every K steps on the GPU backend, 0
+  // disables it
+  uint32_t reorderInterval;
+  MortonReorder mortonReorder;
+  GpuTimer reorderTimer;
+  // steps without a reorder
+  GpuTimer frameTimer;
+  ReorderReport reorderReport;
+
+  // upload CPU particles for rendering
+  void uploadCpuParticles() {
+    cpu.getParticles(cpuParticles);
+    particlesIn.setSubData(cpuParticles.data(), 0, cpuParticles.size());
+  }
+
+  std::vector<Particle> downloadParticles(const Buffer& buffer) const {
+    std::vector<Particle> data(nParticles);
+    glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+    buffer.getSubData(data.data(), 0, data.size());
+    return data;
+  }
+
+  void recordTrajectory() {
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+    particlesIn.bindToShaderStorageBuffer(0);
+    slotsBuffer.bindToShaderStorageBuffer(4);
+    computeSlots.setUniform("nParticles", nParticles);
+    computeSlotsPipeline.activate();
+    glDispatchCompute(std::ceil(nParticles / 128.0f), 1, 1);
+    computeSlotsPipeline.deactivate();
+
+    trajectory.record(particlesIn, step, &slotsBuffer);
+  }
+
+  void updateParticlesOnGPU() {
+    particlesIn.bindToShaderStorageBuffer(0);
+    particlesOut.bindToShaderStorageBuffer(1);
+    updateParticles.setUniform("dt", dt);
+
+    updateParticlesPipeline.activate();
+    glDispatchCompute(std::ceil(nParticles / 128.0f), 1, 1);
+    updateParticlesPipeline.deactivate();
+
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+  }
+
+  void pollReorderTimers(bool reordered) {
+    frameTimer.poll();
+    reorderTimer.poll();
+
+    // frame time after a reorder is averaged until the next one
+    if (reordered) {
+      reorderReport.frameTimeBefore = frameTimer.getAverage();
+      frameTimer.resetAverage();
+    }
+    reorderReport.reorderTime = reorderTimer.getLast();
+    reorderReport.frameTimeAfter = frameTimer.getAverage();
+  }
+
  public:
   Renderer()
       : resolution{512, 512},
         nParticles{30000},
         dt{0.01f},
+        step{0},
+        seed{0},
+        placeParticles{std::filesystem::path(CMAKE_CURRENT_SOURCE_DIR) /
+                       "shaders" / "n-body" / "place-particles-circular.comp"},
         initParticles{std::filesystem::path(CMAKE_CURRENT_SOURCE_DIR) /
                       "shaders" / "n-body" / "init-particles.comp"},
         updateParticles{std::filesystem::path(CMAKE_CURRENT_SOURCE_DIR) /
@@ -50,11 +178,32 @@ class Renderer {
         vertexShader{std::filesystem::path(CMAKE_CURRENT_SOURCE_DIR) /
                      "shaders" / "render-particles.vert"},
         fragmentShader{std::filesystem::path(CMAKE_CURRENT_SOURCE_DIR) /
-                       "shaders" / "render-particles.frag"} {
+                       "shaders" / "render-particles.frag"},
+        renderMode{RenderMode::POINTS},
+        splatter{std::filesystem::path(CMAKE_CURRENT_SOURCE_DIR) / "shaders" /
+                 "splat-particles.comp"},
+        trajectoryInterval{1},
+        computeSlots{std::filesystem::path(CMAKE_CURRENT_SOURCE_DIR) /
+                     "shaders" / "compute-slots.comp"},
+        enableExport{false},
+        exportInterval{1},
+        exporter{"/gcss-n-body", "n-body Particle"},
+        diagnosticsEnabled{true},
+        diagnosticsInterval{1},
+        backend{Backend::GPU},
+        enableEnsemble{false},
+        ensembleMember{0},
+        reorderInterval{0} {
     particles.setParticles(&particlesIn);
 
+    // roughly the size and energy of points drawn by render-particles.*
+    splatter.setPointSize(32.0f);
+    splatter.setIntensity(8.0f);
+
+    placeParticlesPipeline.attachComputeShader(placeParticles);
     initParticlesPipeline.attachComputeShader(initParticles);
     updateParticlesPipeline.attachComputeShader(updateParticles);
+    computeSlotsPipeline.attachComputeShader(computeSlots);
 
     // NOTE: to use gl_PointSize
     glEnable(GL_PROGRAM_POINT_SIZE);
@@ -77,57 +226,245 @@ class Renderer {
 
   void setResolution(const glm::uvec2& resolution) {
     this->resolution = resolution;
+    splatter.setResolution(resolution);
   }
 
+  RenderMode getRenderMode() const { return renderMode; }
+  void setRenderMode(const RenderMode& renderMode) {
+    this->renderMode = renderMode;
+  }
+
+  float getSplatPointSize() const { return splatter.getPointSize(); }
+  void setSplatPointSize(float pointSize) { splatter.setPointSize(pointSize); }
+
+  float getSplatIntensity() const { return splatter.getIntensity(); }
+  void setSplatIntensity(float intensity) { splatter.setIntensity(intensity); }
+
+  float getSplatExposure() const { return splatter.getExposure(); }
+  void setSplatExposure(float exposure) { splatter.setExposure(exposure); }
+
   void setNumberOfParticles(uint32_t nParticles) {
     this->nParticles = nParticles;
 
+    // trajectory has a fixed number of particles
+    stopTrajectory();
+
     // regenerate particles
     placeParticlesCircular();
   }
 
   void setDt(float dt) { this->dt = dt; }
 
+  uint32_t getSeed() const { return seed; }
+  void setSeed(uint32_t seed) { this->seed = seed; }
+
   void resetParticles() { placeParticlesCircular(); }
 
-  void placeParticlesCircular() {
-    const float black_hole_mass = 100000;
+  bool isRecordingTrajectory() const { return trajectory.isRecording(); }
 
-    std::random_device rnd_dev;
-    std::mt19937 mt(rnd_dev());
-    std::uniform_real_distribution<float> dist(-1, 1);
+  void startTrajectory(const std::filesystem::path& filepath) {
+    slotsBuffer.allocate<GLuint>(nParticles, GL_DYNAMIC_COPY);
+    trajectory.start(filepath, nParticles,
+                     sizeof(Particle) / sizeof(glm::vec4));
+  }
 
-    std::vector<Particle> data(nParticles);
-    const int grid_size = std::sqrt(nParticles);
-    for (std::size_t idx = 0; idx < data.size(); ++idx) {
-      const int i = idx % grid_size;
-      const int j = (idx / grid_size) % grid_size;
-      const float u = static_cast<float>(i) / grid_size;
-      const float v = static_cast<float>(j) / grid_size;
+  void stopTrajectory() { trajectory.stop(); }
+
+  uint64_t getNumberOfRecordedFrames() const {
+    return trajectory.getNumberOfRecordedFrames();
+  }
+
+  uint32_t getTrajectoryInterval() const { return trajectoryInterval; }
+  void setTrajectoryInterval(uint32_t trajectoryInterval) {
+    this->trajectoryInterval = std::max(trajectoryInterval, 1u);
+  }
+
+  uint32_t getTrajectoryBits() const { return trajectory.getBits(); }
+  void setTrajectoryBits(uint32_t bits) { trajectory.setBits(bits); }
+
+  bool getEnableExport() const { return enableExport; }
+  void setEnableExport(bool enableExport) { this->enableExport = enableExport; }
+
+  uint32_t getExportInterval() const { return exportInterval; }
+  void setExportInterval(uint32_t exportInterval) {
+    this->exportInterval = std::max(exportInterval, 1u);
+  }
+
+  const std::string& getExportName() const { return exporter.getName(); }
+
+  uint64_t getNumberOfExportedFrames() const {
+    return exporter.getNumberOfFrames();
+  }
+
+  const Diagnostics& getDiagnostics() const { return diagnostics; }
+
+  bool getDiagnosticsEnabled() const { return diagnosticsEnabled; }
+  void setDiagnosticsEnabled(bool diagnosticsEnabled) {
+    this->diagnosticsEnabled = diagnosticsEnabled;
+  }
+
+  uint32_t getDiagnosticsInterval() const { return diagnosticsInterval; }
+  void setDiagnosticsInterval(uint32_t diagnosticsInterval) {
+    this->diagnosticsInterval = std::max(diagnosticsInterval, 1u);
+  }
+
+  void startDiagnosticsCSV(const std::filesystem::path& filepath) {
+    diagnostics.startCSV(filepath);
+  }
+
+  void stopDiagnosticsCSV() { diagnostics.stopCSV(); }
+
+  Backend getBackend() const { return backend; }
+  void setBackend(const Backend& backend) {
+    if (backend == this->backend) {
+      return;
+    }
+
+    // carry over the current state
+    if (backend == Backend::CPU) {
+      cpu.setParticles(downloadParticles(particlesIn));
+    } else {
+      uploadCpuParticles();
+      particlesOut.setSubData(cpuParticles.data(), 0, cpuParticles.size());
+    }
+    this->backend = backend;
+
+    // VAO has to point at the buffer which is currently particlesIn
+    particles.setParticles(&particlesIn);
+  }
+
+  const char* getCpuInstructionSet() const {
+    return CpuNBody::getInstructionSet();
+  }
+
+  std::size_t getCpuNumberOfThreads() const {
+    return cpu.getNumberOfThreads();
+  }
+
+  bool getEnableEnsemble() const { return enableEnsemble; }
+  void setEnableEnsemble(bool enableEnsemble) {
+    this->enableEnsemble = enableEnsemble;
+    if (enableEnsemble) {
+      resetEnsemble();
+    }
+  }
 
-      const float r = 0.5f * (u + 0.1f * (dist(mt) + 1.0f));
-      const float theta = 2.0f * 3.14f * v + 0.1f * dist(mt);
+  const Ensemble& getEnsemble() const { return ensemble; }
 
-      const float mass = 1.0f * 0.5f * (dist(mt) + 1.0f);
-      const glm::vec3 position =
-          r * glm::vec3(std::cos(theta), std::sin(theta), 0.1f * dist(mt));
-      const float G = 6.67430e-11;
-      const glm::vec3 velocity =
-          std::sqrt((G * black_hole_mass) / r) *
-          (glm::vec3(-std::sin(theta), std::cos(theta), 0));
+  // n members of nParticles particles with dt evenly spaced in [dtMin, dtMax]
+  // and seeds from the current one on
+  void sweepEnsemble(uint32_t n, uint32_t nParticles, float dtMin,
+                     float dtMax) {
+    ensemble.setNumberOfParticles(nParticles);
+    ensemble.sweep(n, dtMin, dtMax, seed);
+    resetEnsemble();
+  }
+
+  void resetEnsemble() {
+    ensemble.reset();
+    ensembleParticles.setParticles(&ensemble.getParticles());
+    ensembleMember =
+        std::min<uint32_t>(ensembleMember, ensemble.getNumberOfMembers() - 1);
+  }
+
+  uint32_t getEnsembleMember() const { return ensembleMember; }
+  void setEnsembleMember(uint32_t ensembleMember) {
+    this->ensembleMember =
+        std::min<uint32_t>(ensembleMember, ensemble.getNumberOfMembers() - 1);
+  }
+
+  uint32_t getReorderInterval() const { return reorderInterval; }
+  void setReorderInterval(uint32_t reorderInterval) {
+    this->reorderInterval = reorderInterval;
+  }
+
+  uint32_t getReorderBits() const { return mortonReorder.getBits(); }
+  void setReorderBits(uint32_t bits) { mortonReorder.setBits(bits); }
+
+  const ReorderReport& getReorderReport() const { return reorderReport; }
+
+  // advance the current state by one step on the GPU and on the CPU, and
+  // compare the results. the simulation itself is not advanced.
+  ValidationResult validateCpuBackend() {
+    if (backend == Backend::CPU) {
+      uploadCpuParticles();
+    }
+    const std::vector<Particle> state = downloadParticles(particlesIn);
+
+    updateParticlesOnGPU();
+    const std::vector<Particle> gpu_result = downloadParticles(particlesOut);
+
+    std::vector<Particle> cpu_result;
+    cpu.setParticles(state);
+    cpu.step(dt);
+    cpu.getParticles(cpu_result);
+
+    // restore the state of the CPU backend
+    if (backend == Backend::CPU) {
+      cpu.setParticles(state);
+    }
 
-      data[idx].position = glm::vec4(position, 0);
-      data[idx].velocity = glm::vec4(velocity, 0);
-      data[idx].mass = mass;
+    ValidationResult result;
+    for (std::size_t i = 0; i < state.size(); ++i) {
+      const Particle& g = gpu_result[i];
+      const Particle& c = cpu_result[i];
+      const glm::vec3 gpu_force = glm::vec3(g.force);
+      const glm::vec3 cpu_force = glm::vec3(c.force);
+
+      result.maxPositionError =
+          std::max(result.maxPositionError,
+                   glm::length(glm::vec3(g.position - c.position)));
+      result.maxVelocityError =
+          std::max(result.maxVelocityError,
+                   glm::length(glm::vec3(g.velocity - c.velocity)));
+      if (glm::length(gpu_force) > 0) {
+        result.maxForceError =
+            std::max(result.maxForceError, glm::length(gpu_force - cpu_force) /
+                                               glm::length(gpu_force));
+      }
     }
-    data[0].position = glm::vec4(0);
-    data[0].velocity = glm::vec4(0);
-    data[0].mass = black_hole_mass;
 
-    particlesIn.setData(data, GL_DYNAMIC_DRAW);
-    particlesOut.setData(data, GL_DYNAMIC_DRAW);
+    spdlog::info(
+        "[Renderer] CPU backend validation: position {}, velocity {}, force {}",
+        result.maxPositionError, result.maxVelocityError, result.maxForceError);
 
-    initVelocity();
+    return result;
+  }
+
+  // the same seed gives the same particles on both backends, up to rounding
+  // of transcendental functions
+  void placeParticlesCircular() {
+    if (backend == Backend::CPU) {
+      const std::vector<Particle> data =
+          ::placeParticlesCircular(nParticles, seed);
+
+      particlesIn.setData(data, GL_DYNAMIC_DRAW);
+      particlesOut.setData(data, GL_DYNAMIC_DRAW);
+
+      cpu.setParticles(data);
+      cpu.initVelocity(dt);
+      uploadCpuParticles();
+    } else {
+      particlesIn.allocate<Particle>(nParticles, GL_DYNAMIC_DRAW);
+      particlesOut.allocate<Particle>(nParticles, GL_DYNAMIC_DRAW);
+
+      // generate particles in place
+      particlesIn.bindToShaderStorageBuffer(0);
+      placeParticles.setUniform("nParticles", nParticles);
+      placeParticles.setUniform("seed", seed);
+      placeParticles.setUniform("gridSize", getCircularGridSize(nParticles));
+      placeParticlesPipeline.activate();
+      glDispatchCompute(std::ceil(nParticles / 128.0f), 1, 1);
+      placeParticlesPipeline.deactivate();
+
+      // init-particles.comp only writes velocity and force
+      glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+      particlesOut.copySubData<Particle>(particlesIn, 0, 0, nParticles);
+
+      initVelocity();
+    }
+
+    diagnostics.reset();
   }
 
   void initVelocity() {
@@ -153,28 +490,93 @@ class Renderer {
     camera.lookAround(d_phi, d_theta);
   }
 
+  // members of an ensemble are drawn as points
+  void renderEnsemble() {
+    const glm::mat4 view_projection =
+        camera.computeViewProjectionmatrix(resolution.x, resolution.y);
+    glClear(GL_COLOR_BUFFER_BIT);
+    glViewport(0, 0, resolution.x, resolution.y);
+    vertexShader.setUniform("viewProjection", view_projection);
+    const uint32_t n = ensemble.getNumberOfParticles();
+    ensembleParticles.draw(renderPipeline, ensembleMember * n, n);
+
+    ensemble.update(diagnosticsEnabled &&
+                    ensemble.getStep() % diagnosticsInterval == 0);
+    ensemble.poll();
+  }
+
   void render() {
+    if (enableEnsemble) {
+      renderEnsemble();
+      return;
+    }
+
+    const bool reorder_due = backend == Backend::GPU && reorderInterval > 0 &&
+                             (step + 1) % reorderInterval == 0;
+
+    // the cost of a reorder is measured separately from the steps it speeds
+    // up
+    if (!reorder_due) {
+      frameTimer.begin();
+    }
+
     // render particles
-    vertexShader.setUniform(
-        "viewProjection",
-        camera.computeViewProjectionmatrix(resolution.x, resolution.y));
+    const glm::mat4 view_projection =
+        camera.computeViewProjectionmatrix(resolution.x, resolution.y);
     glClear(GL_COLOR_BUFFER_BIT);
     glViewport(0, 0, resolution.x, resolution.y);
-    particles.draw(renderPipeline);
+    if (renderMode == RenderMode::SPLATTING) {
+      splatter.getProjectShader().setUniform("viewProjection", view_projection);
+      splatter.render(particlesIn, nParticles);
+    } else {
+      vertexShader.setUniform("viewProjection", view_projection);
+      particles.draw(renderPipeline);
+    }
 
     // update particles
-    particlesIn.bindToShaderStorageBuffer(0);
-    particlesOut.bindToShaderStorageBuffer(1);
-    updateParticles.setUniform("dt", dt);
+    if (backend == Backend::CPU) {
+      cpu.step(dt);
+      uploadCpuParticles();
+    } else {
+      updateParticlesOnGPU();
+
+      // swap in/out particles
+      std::swap(particlesIn, particlesOut);
+
+      // particlesOut is overwritten by the next step, so only particlesIn is
+      // permuted
+      if (reorder_due) {
+        reorderTimer.begin();
+        mortonReorder.reorder(particlesIn, nParticles,
+                              sizeof(Particle) / sizeof(glm::vec4));
+        reorderTimer.end();
+      }
+    }
 
-    updateParticlesPipeline.activate();
-    glDispatchCompute(std::ceil(nParticles / 128.0f), 1, 1);
-    updateParticlesPipeline.deactivate();
+    // energy and momentum
+    if (diagnosticsEnabled && step % diagnosticsInterval == 0) {
+      diagnostics.compute(particlesIn, nParticles, dt, step);
+    }
+    diagnostics.poll();
 
-    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+    // record every Kth step
+    if (trajectory.isRecording() && step % trajectoryInterval == 0) {
+      recordTrajectory();
+    }
+    trajectory.poll();
 
-    // swap in/out particles
-    std::swap(particlesIn, particlesOut);
+    // frames are dropped while the previous ones are still being copied
+    if (enableExport && step % exportInterval == 0) {
+      exporter.request(particlesIn, nParticles * sizeof(Particle), step,
+                       sizeof(Particle), {nParticles, 1, 1});
+    }
+    exporter.poll();
+    step++;
+
+    if (!reorder_due) {
+      frameTimer.end();
+    }
+    pollReorderTimers(reorder_due);
   }
 };
 
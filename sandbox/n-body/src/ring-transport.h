@@ -0,0 +1,263 @@
+#ifndef _RING_TRANSPORT_H
+#define _RING_TRANSPORT_H
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <thread>
+#include <vector>
+
+#include "spdlog/spdlog.h"
+//
+#include "particle.h"
+
+#ifdef N_BODY_WITH_MPI
+#include <mpi.h>
+#endif
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#define N_BODY_WITH_FORK
+#endif
+
+// ranks arranged in a ring. each rank sends blocks of floats to the next rank
+// and receives from the previous one, all blocks have the same length.
+class RingTransport {
+ public:
+  virtual ~RingTransport() = default;
+
+  virtual int getRank() const = 0;
+  virtual int getNumberOfRanks() const = 0;
+  virtual const char* getName() const = 0;
+
+  // send must not be modified and recv must not be read until finishShift
+  // returns
+  virtual void startShift(const std::vector<float>& send,
+                          std::vector<float>& recv) = 0;
+  virtual void finishShift() = 0;
+
+  // concatenate local particles of every rank on rank 0. every rank must pass
+  // the same number of particles.
+  virtual void gather(const std::vector<Particle>& local,
+                      std::vector<Particle>& all) = 0;
+
+  virtual void barrier() = 0;
+};
+
+#ifdef N_BODY_WITH_MPI
+
+class MpiTransport : public RingTransport {
+ private:
+  int rank;
+  int nRanks;
+  MPI_Request requests[2];
+
+ public:
+  MpiTransport(int* argc, char*** argv) {
+    MPI_Init(argc, argv);
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &nRanks);
+  }
+
+  ~MpiTransport() { MPI_Finalize(); }
+
+  int getRank() const override { return rank; }
+  int getNumberOfRanks() const override { return nRanks; }
+  const char* getName() const override { return "MPI"; }
+
+  void startShift(const std::vector<float>& send,
+                  std::vector<float>& recv) override {
+    const int next = (rank + 1) % nRanks;
+    const int prev = (rank + nRanks - 1) % nRanks;
+    MPI_Irecv(recv.data(), recv.size(), MPI_FLOAT, prev, 0, MPI_COMM_WORLD,
+              &requests[0]);
+    MPI_Isend(send.data(), send.size(), MPI_FLOAT, next, 0, MPI_COMM_WORLD,
+              &requests[1]);
+  }
+
+  void finishShift() override {
+    MPI_Waitall(2, requests, MPI_STATUSES_IGNORE);
+  }
+
+  void gather(const std::vector<Particle>& local,
+              std::vector<Particle>& all) override {
+    const int size = local.size() * sizeof(Particle);
+    if (rank == 0) {
+      all.resize(local.size() * nRanks);
+    }
+    MPI_Gather(local.data(), size, MPI_BYTE, all.data(), size, MPI_BYTE, 0,
+               MPI_COMM_WORLD);
+  }
+
+  void barrier() override { MPI_Barrier(MPI_COMM_WORLD); }
+};
+
+#endif
+
+#ifdef N_BODY_WITH_FORK
+
+// ranks are forked processes sharing an anonymous mapping. every rank
+// publishes its block into its own double buffered slot, and the next rank
+// copies it out.
+class SharedMemoryTransport : public RingTransport {
+ private:
+  using Counter = std::atomic<uint64_t>;
+  static_assert(Counter::is_always_lock_free);
+
+  // counters are placed on separate cache lines
+  struct alignas(64) PaddedCounter {
+    Counter value{0};
+  };
+
+  int rank;
+  int nRanks;
+  std::size_t blockLength;
+  std::size_t gatherLength;
+  std::vector<pid_t> children;
+
+  void* region;
+  std::size_t regionSize;
+  // published[r]: last shift whose block rank r has written
+  PaddedCounter* published;
+  // consumed[r]: last shift whose block of rank r has been read
+  PaddedCounter* consumed;
+  Counter* barrierCount;
+  Counter* barrierGeneration;
+  float* slots;
+  Particle* gathered;
+
+  uint64_t nShifts;
+  std::vector<float>* recv;
+
+  float* getSlot(int rank, uint64_t shift) const {
+    return slots + (2 * rank + shift % 2) * blockLength;
+  }
+
+  static void waitUntil(const Counter& counter, uint64_t value) {
+    while (counter.load(std::memory_order_acquire) < value) {
+      std::this_thread::yield();
+    }
+  }
+
+ public:
+  // fork nRanks - 1 processes. blockLength is the number of floats per block
+  // and gatherLength the number of particles per rank passed to gather.
+  SharedMemoryTransport(int nRanks, std::size_t blockLength,
+                        std::size_t gatherLength)
+      : rank{0},
+        nRanks{std::max(nRanks, 1)},
+        blockLength{blockLength},
+        gatherLength{gatherLength},
+        nShifts{0},
+        recv{nullptr} {
+    const std::size_t n_counters = 2 * this->nRanks + 2;
+    const std::size_t counters_size = n_counters * sizeof(PaddedCounter);
+    const std::size_t slots_size =
+        2 * this->nRanks * blockLength * sizeof(float);
+    const std::size_t gathered_size =
+        this->nRanks * gatherLength * sizeof(Particle);
+    regionSize = counters_size + slots_size + gathered_size;
+
+    region = mmap(nullptr, regionSize, PROT_READ | PROT_WRITE,
+                  MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (region == MAP_FAILED) {
+      spdlog::error("[SharedMemoryTransport] failed to map {} bytes",
+                    regionSize);
+      std::exit(EXIT_FAILURE);
+    }
+
+    std::byte* p = static_cast<std::byte*>(region);
+    PaddedCounter* counters = new (p) PaddedCounter[n_counters];
+    published = counters;
+    consumed = counters + this->nRanks;
+    barrierCount = &counters[2 * this->nRanks].value;
+    barrierGeneration = &counters[2 * this->nRanks + 1].value;
+
+    slots = reinterpret_cast<float*>(p + counters_size);
+    gathered = reinterpret_cast<Particle*>(p + counters_size + slots_size);
+
+    for (int r = 1; r < this->nRanks; ++r) {
+      const pid_t pid = fork();
+      if (pid == 0) {
+        rank = r;
+        children.clear();
+        break;
+      }
+      children.push_back(pid);
+    }
+  }
+
+  SharedMemoryTransport(const SharedMemoryTransport& other) = delete;
+
+  ~SharedMemoryTransport() {
+    if (rank == 0) {
+      for (const pid_t pid : children) {
+        waitpid(pid, nullptr, 0);
+      }
+    }
+    munmap(region, regionSize);
+  }
+
+  SharedMemoryTransport& operator=(const SharedMemoryTransport& other) =
+      delete;
+
+  int getRank() const override { return rank; }
+  int getNumberOfRanks() const override { return nRanks; }
+  const char* getName() const override { return "shared memory"; }
+
+  void startShift(const std::vector<float>& send,
+                  std::vector<float>& recv) override {
+    nShifts++;
+    this->recv = &recv;
+
+    // the next rank has to be done with the block written two shifts ago
+    if (nShifts > 2) {
+      waitUntil(consumed[rank].value, nShifts - 2);
+    }
+    std::memcpy(getSlot(rank, nShifts), send.data(),
+                blockLength * sizeof(float));
+    published[rank].value.store(nShifts, std::memory_order_release);
+  }
+
+  void finishShift() override {
+    const int prev = (rank + nRanks - 1) % nRanks;
+    waitUntil(published[prev].value, nShifts);
+    std::memcpy(recv->data(), getSlot(prev, nShifts),
+                blockLength * sizeof(float));
+    consumed[prev].value.store(nShifts, std::memory_order_release);
+  }
+
+  void gather(const std::vector<Particle>& local,
+              std::vector<Particle>& all) override {
+    std::memcpy(gathered + rank * gatherLength, local.data(),
+                std::min(local.size(), gatherLength) * sizeof(Particle));
+    barrier();
+    if (rank == 0) {
+      all.assign(gathered, gathered + nRanks * gatherLength);
+    }
+    // gathered must not be overwritten before rank 0 has copied it
+    barrier();
+  }
+
+  // sense reversing barrier
+  void barrier() override {
+    const uint64_t generation =
+        barrierGeneration->load(std::memory_order_acquire);
+    if (barrierCount->fetch_add(1, std::memory_order_acq_rel) + 1 ==
+        static_cast<uint64_t>(nRanks)) {
+      barrierCount->store(0, std::memory_order_relaxed);
+      barrierGeneration->fetch_add(1, std::memory_order_release);
+    } else {
+      waitUntil(*barrierGeneration, generation + 1);
+    }
+  }
+};
+
+#endif
+
+#endif
@@ -0,0 +1,219 @@
+#ifndef _SIMD_H
+#define _SIMD_H
+#include <cmath>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+#include <vector>
+
+#if defined(__AVX512F__) || (defined(__AVX2__) && defined(__FMA__))
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// float vector of the widest instruction set enabled at compile time, scalar
+// fallback otherwise. SSE2 is the baseline of x86-64, the wider ones need
+// GCSS_MARCH_NATIVE or similar flags.
+
+#if defined(__AVX512F__)
+
+// NOTE: maskz variants with a full mask avoid -Wmaybe-uninitialized of GCC 12
+// on _mm512_undefined_ps in the unmasked intrinsics
+struct SimdFloat {
+  static constexpr std::size_t WIDTH = 16;
+  static constexpr const char* NAME = "AVX-512";
+  __m512 v;
+
+  SimdFloat() = default;
+  SimdFloat(__m512 v) : v(v) {}
+  SimdFloat(float s) : v(_mm512_set1_ps(s)) {}
+
+  static SimdFloat load(const float* p) { return _mm512_load_ps(p); }
+  void store(float* p) const { _mm512_store_ps(p, v); }
+
+  friend SimdFloat operator+(SimdFloat a, SimdFloat b) {
+    return _mm512_add_ps(a.v, b.v);
+  }
+  friend SimdFloat operator-(SimdFloat a, SimdFloat b) {
+    return _mm512_sub_ps(a.v, b.v);
+  }
+  friend SimdFloat operator*(SimdFloat a, SimdFloat b) {
+    return _mm512_mul_ps(a.v, b.v);
+  }
+  friend SimdFloat operator/(SimdFloat a, SimdFloat b) {
+    return _mm512_div_ps(a.v, b.v);
+  }
+
+  // a * b + c
+  static SimdFloat fma(SimdFloat a, SimdFloat b, SimdFloat c) {
+    return _mm512_fmadd_ps(a.v, b.v, c.v);
+  }
+  static SimdFloat max(SimdFloat a, SimdFloat b) {
+    return _mm512_maskz_max_ps(0xffff, a.v, b.v);
+  }
+  // 14 bit approximation
+  static SimdFloat rsqrtApprox(SimdFloat a) {
+    return _mm512_maskz_rsqrt14_ps(0xffff, a.v);
+  }
+  // a > b ? x : 0
+  static SimdFloat selectGreater(SimdFloat a, SimdFloat b, SimdFloat x) {
+    const __mmask16 mask = _mm512_cmp_ps_mask(a.v, b.v, _CMP_GT_OQ);
+    return _mm512_maskz_mov_ps(mask, x.v);
+  }
+};
+
+#elif defined(__AVX2__) && defined(__FMA__)
+
+struct SimdFloat {
+  static constexpr std::size_t WIDTH = 8;
+  static constexpr const char* NAME = "AVX2";
+  __m256 v;
+
+  SimdFloat() = default;
+  SimdFloat(__m256 v) : v(v) {}
+  SimdFloat(float s) : v(_mm256_set1_ps(s)) {}
+
+  static SimdFloat load(const float* p) { return _mm256_load_ps(p); }
+  void store(float* p) const { _mm256_store_ps(p, v); }
+
+  friend SimdFloat operator+(SimdFloat a, SimdFloat b) {
+    return _mm256_add_ps(a.v, b.v);
+  }
+  friend SimdFloat operator-(SimdFloat a, SimdFloat b) {
+    return _mm256_sub_ps(a.v, b.v);
+  }
+  friend SimdFloat operator*(SimdFloat a, SimdFloat b) {
+    return _mm256_mul_ps(a.v, b.v);
+  }
+  friend SimdFloat operator/(SimdFloat a, SimdFloat b) {
+    return _mm256_div_ps(a.v, b.v);
+  }
+
+  static SimdFloat fma(SimdFloat a, SimdFloat b, SimdFloat c) {
+    return _mm256_fmadd_ps(a.v, b.v, c.v);
+  }
+  static SimdFloat max(SimdFloat a, SimdFloat b) {
+    return _mm256_max_ps(a.v, b.v);
+  }
+  // 12 bit approximation
+  static SimdFloat rsqrtApprox(SimdFloat a) { return _mm256_rsqrt_ps(a.v); }
+  static SimdFloat selectGreater(SimdFloat a, SimdFloat b, SimdFloat x) {
+    const __m256 mask = _mm256_cmp_ps(a.v, b.v, _CMP_GT_OQ);
+    return _mm256_and_ps(mask, x.v);
+  }
+};
+
+#elif defined(__SSE2__)
+
+struct SimdFloat {
+  static constexpr std::size_t WIDTH = 4;
+  static constexpr const char* NAME = "SSE2";
+  __m128 v;
+
+  SimdFloat() = default;
+  SimdFloat(__m128 v) : v(v) {}
+  SimdFloat(float s) : v(_mm_set1_ps(s)) {}
+
+  static SimdFloat load(const float* p) { return _mm_load_ps(p); }
+  void store(float* p) const { _mm_store_ps(p, v); }
+
+  friend SimdFloat operator+(SimdFloat a, SimdFloat b) {
+    return _mm_add_ps(a.v, b.v);
+  }
+  friend SimdFloat operator-(SimdFloat a, SimdFloat b) {
+    return _mm_sub_ps(a.v, b.v);
+  }
+  friend SimdFloat operator*(SimdFloat a, SimdFloat b) {
+    return _mm_mul_ps(a.v, b.v);
+  }
+  friend SimdFloat operator/(SimdFloat a, SimdFloat b) {
+    return _mm_div_ps(a.v, b.v);
+  }
+
+  // no fused multiply-add before FMA3
+  static SimdFloat fma(SimdFloat a, SimdFloat b, SimdFloat c) {
+    return _mm_add_ps(_mm_mul_ps(a.v, b.v), c.v);
+  }
+  static SimdFloat max(SimdFloat a, SimdFloat b) {
+    return _mm_max_ps(a.v, b.v);
+  }
+  // 12 bit approximation
+  static SimdFloat rsqrtApprox(SimdFloat a) { return _mm_rsqrt_ps(a.v); }
+  static SimdFloat selectGreater(SimdFloat a, SimdFloat b, SimdFloat x) {
+    const __m128 mask = _mm_cmpgt_ps(a.v, b.v);
+    return _mm_and_ps(mask, x.v);
+  }
+};
+
+#else
+
+struct SimdFloat {
+  static constexpr std::size_t WIDTH = 1;
+  static constexpr const char* NAME = "scalar";
+  float v;
+
+  SimdFloat() = default;
+  SimdFloat(float v) : v(v) {}
+
+  static SimdFloat load(const float* p) { return *p; }
+  void store(float* p) const { *p = v; }
+
+  friend SimdFloat operator+(SimdFloat a, SimdFloat b) { return a.v + b.v; }
+  friend SimdFloat operator-(SimdFloat a, SimdFloat b) { return a.v - b.v; }
+  friend SimdFloat operator*(SimdFloat a, SimdFloat b) { return a.v * b.v; }
+  friend SimdFloat operator/(SimdFloat a, SimdFloat b) { return a.v / b.v; }
+
+  static SimdFloat fma(SimdFloat a, SimdFloat b, SimdFloat c) {
+    return std::fma(a.v, b.v, c.v);
+  }
+  static SimdFloat max(SimdFloat a, SimdFloat b) {
+    return a.v > b.v ? a.v : b.v;
+  }
+  static SimdFloat rsqrtApprox(SimdFloat a) { return 1.0f / std::sqrt(a.v); }
+  static SimdFloat selectGreater(SimdFloat a, SimdFloat b, SimdFloat x) {
+    return a.v > b.v ? x.v : 0.0f;
+  }
+};
+
+#endif
+
+// reciprocal square root refined by one Newton-Raphson iteration
+inline SimdFloat rsqrt(SimdFloat a) {
+  const SimdFloat y = SimdFloat::rsqrtApprox(a);
+  return y * SimdFloat::fma(SimdFloat(-0.5f) * a, y * y, SimdFloat(1.5f));
+}
+
+// allocator for vectors which are loaded with aligned SIMD loads
+template <typename T, std::size_t ALIGNMENT = 64>
+struct AlignedAllocator {
+  using value_type = T;
+
+  AlignedAllocator() = default;
+  template <typename U>
+  AlignedAllocator(const AlignedAllocator<U, ALIGNMENT>&) {}
+
+  template <typename U>
+  struct rebind {
+    using other = AlignedAllocator<U, ALIGNMENT>;
+  };
+
+  T* allocate(std::size_t n) {
+    return static_cast<T*>(
+        ::operator new(n * sizeof(T), std::align_val_t(ALIGNMENT)));
+  }
+
+  void deallocate(T* p, std::size_t) {
+    ::operator delete(p, std::align_val_t(ALIGNMENT));
+  }
+
+  template <typename U>
+  bool operator==(const AlignedAllocator<U, ALIGNMENT>&) const {
+    return true;
+  }
+};
+
+template <typename T>
+using AlignedVector = std::vector<T, AlignedAllocator<T>>;
+
+#endif
@@ -0,0 +1,52 @@
+// lists of particle indices rebuilt by update-particles.comp every step
+
+// dead particles, emitters pop from the top
+layout(std430, binding = 7) buffer layout_free_list {
+  int free_count;
+  uint free_indices[];
+};
+
+// live particles, starts with the DrawArraysIndirectCommand drawing them
+layout(std430, binding = 8) buffer layout_alive_list {
+  uint draw_count;
+  uint draw_instance_count;
+  uint draw_first;
+  uint draw_base_instance;
+  uint alive_indices[];
+};
+
+shared uint group_n_alive;
+shared uint group_n_dead;
+shared uint group_alive_base;
+shared uint group_dead_base;
+
+// append a particle to one of the lists. every invocation of the workgroup
+// has to call this, invalid ones are not appended. one atomic per workgroup
+// and list goes to global memory.
+void appendToLists(uint index, bool valid, bool alive) {
+  if (gl_LocalInvocationIndex == 0) {
+    group_n_alive = 0;
+    group_n_dead = 0;
+  }
+  barrier();
+
+  uint slot = 0;
+  if (valid) {
+    slot = alive ? atomicAdd(group_n_alive, 1) : atomicAdd(group_n_dead, 1);
+  }
+  barrier();
+
+  if (gl_LocalInvocationIndex == 0) {
+    group_alive_base = atomicAdd(draw_count, group_n_alive);
+    group_dead_base = uint(atomicAdd(free_count, int(group_n_dead)));
+  }
+  barrier();
+
+  if (valid) {
+    if (alive) {
+      alive_indices[group_alive_base + slot] = index;
+    } else {
+      free_indices[group_dead_base + slot] = index;
+    }
+  }
+}
@@ -0,0 +1,46 @@
+// force sources and the grid binning them
+
+const uint ATTRACTOR = 0;
+const uint REPULSOR = 1;
+const uint VORTEX = 2;
+
+struct ForceSource {
+  vec4 position;
+  // rotation axis of vortex
+  vec4 axis;
+  uint type;
+  float strength;
+};
+
+layout(std430, binding = 1) readonly buffer layout_sources {
+  ForceSource sources[];
+};
+
+uniform uint nSources;
+uniform vec3 gridMin;
+uniform vec3 cellSize;
+uniform uint gridSize;
+
+const float FORCE_FIELD_EPS = 1e-3;
+
+// acceleration at p caused by a source
+vec3 evaluateSource(ForceSource source, vec3 p) {
+  vec3 v = source.position.xyz - p;
+  float s = source.strength / (dot(v, v) + FORCE_FIELD_EPS);
+  if (source.type == REPULSOR) {
+    return -s * v;
+  } else if (source.type == VORTEX) {
+    return s * cross(source.axis.xyz, v);
+  }
+  return s * v;
+}
+
+// points outside of the grid belong to the nearest boundary cell
+ivec3 getCell(vec3 p) {
+  return clamp(ivec3(floor((p - gridMin) / cellSize)), ivec3(0),
+               ivec3(gridSize - 1));
+}
+
+uint getCellIndex(ivec3 cell) {
+  return cell.x + gridSize * (cell.y + gridSize * cell.z);
+}
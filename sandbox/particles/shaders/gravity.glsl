@@ -0,0 +1,9 @@
+const float GRAVITY_EPS = 1e-3;
+
+// attraction towards center and damping by k
+vec3 computeGravity(vec3 position, vec3 velocity, float mass, vec3 center,
+                    float intensity, float k) {
+  vec3 v = center - position;
+  float l = length(v);
+  return mass * intensity * v / (l * l + GRAVITY_EPS) - k * velocity;
+}
@@ -0,0 +1,12 @@
+// same layout as Particle in particles.h
+struct Particle {
+  vec4 position;
+  vec4 velocity;
+  float mass;
+  // remaining time to live, infinite for particles which never die
+  float lifetime;
+  // index the particle was placed at, kept when particles are reordered
+  uint id;
+};
+
+bool isAlive(Particle particle) { return particle.lifetime > 0.0; }
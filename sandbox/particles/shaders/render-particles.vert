@@ -1,7 +1,15 @@
 #version 460 core
-layout(location = 0) in vec3 position;
-layout(location = 1) in vec3 velocity;
-layout(location = 2) in float mass;
+
+#include "particle.glsl"
+
+layout(std430, binding = 0) readonly buffer layout_particles {
+  Particle particles[];
+};
+// written by update-particles.comp, see emitters/lists.glsl
+layout(std430, binding = 8) readonly buffer layout_alive_list {
+  uvec4 draw_command;
+  uint alive_indices[];
+};
 
 out gl_PerVertex {
   vec4 gl_Position;
@@ -11,7 +19,9 @@ out gl_PerVertex {
 
 uniform mat4 viewProjection;
 
+// only live particles are drawn, vertices are pulled from the particle buffer
 void main() {
-  gl_Position = viewProjection * vec4(position.xyz, 1.0);
+  vec3 position = particles[alive_indices[gl_VertexID]].position.xyz;
+  gl_Position = viewProjection * vec4(position, 1.0);
   gl_PointSize = 8.0;
-}
\ No newline at end of file
+}
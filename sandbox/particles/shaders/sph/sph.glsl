@@ -0,0 +1,41 @@
+// smoothed particle hydrodynamics on a spatial hash grid
+
+uniform uint nParticles;
+uniform float smoothingLength;
+uniform float restDensity;
+uniform float stiffness;
+uniform float viscosity;
+
+const float PI = 3.14159265359;
+// cells per axis of the hash grid, cells wrap around
+const int HASH_GRID_SIZE = 64;
+// dead particles are sorted into an extra bucket after the grid, which is
+// never visited
+const uint DEAD_BUCKET = HASH_GRID_SIZE * HASH_GRID_SIZE * HASH_GRID_SIZE;
+
+// cells are as large as the smoothing length, so neighbors of a particle
+// are in the 3x3x3 cells around it
+ivec3 getCell(vec3 p) { return ivec3(floor(p / smoothingLength)); }
+
+// cells in a 3x3x3 neighborhood never share a bucket
+uint getBucket(ivec3 cell) {
+  ivec3 c = cell & ivec3(HASH_GRID_SIZE - 1);
+  return c.x + HASH_GRID_SIZE * (c.y + HASH_GRID_SIZE * c.z);
+}
+
+// kernels of Muller et al. 2003
+float poly6(float r2) {
+  float h2 = smoothingLength * smoothingLength;
+  if (r2 >= h2) return 0.0;
+  float d = h2 - r2;
+  return 315.0 / (64.0 * PI * pow(smoothingLength, 9.0)) * d * d * d;
+}
+
+vec3 spikyGradient(vec3 r, float l) {
+  float d = smoothingLength - l;
+  return -45.0 / (PI * pow(smoothingLength, 6.0)) * d * d * r / max(l, 1e-6);
+}
+
+float viscosityLaplacian(float l) {
+  return 45.0 / (PI * pow(smoothingLength, 6.0)) * (smoothingLength - l);
+}
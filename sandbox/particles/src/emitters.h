@@ -0,0 +1,135 @@
+#ifndef _EMITTERS_H
+#define _EMITTERS_H
+#include <filesystem>
+#include <vector>
+
+#include "glad/gl.h"
+#include "glm/glm.hpp"
+//
+#include "gcss/buffer.h"
+#include "gcss/shader.h"
+//
+#include "particles.h"
+
+using namespace gcss;
+
+// same layout as Emitter in emit-particles.comp
+struct alignas(16) Emitter {
+  glm::vec4 position = glm::vec4(0);
+  glm::vec4 velocity = glm::vec4(0, 0.5, 0, 0);
+  // particles per second
+  float rate = 10000;
+  float lifetime = 2;
+  // maximum random deviation of velocity
+  float spread = 0.2f;
+  // fraction of a particle carried over to the next step, updated on GPU
+  float accumulator = 0;
+};
+
+// emitters spawning particles into dead slots of the particle buffer.
+// update-particles.comp rebuilds a free list of dead particles and an alive
+// list of live ones every step, emission pops from the free list, and the
+// alive list doubles as the indirect draw command. nothing is read back.
+class Emitters {
+ private:
+  std::vector<Emitter> emitters;
+  // emitters have to be uploaded
+  bool dirty;
+
+  ComputeShader emitParticles;
+  Pipeline emitParticlesPipeline;
+  ComputeShader resetLists;
+  Pipeline resetListsPipeline;
+
+  Buffer emittersBuffer;
+  // free count followed by indices of dead particles
+  Buffer freeList;
+  // DrawArraysIndirectCommand followed by indices of live particles
+  Buffer aliveList;
+
+  static std::filesystem::path getShaderPath(const std::string& filename) {
+    return std::filesystem::path(CMAKE_CURRENT_SOURCE_DIR) / "shaders" /
+           "emitters" / filename;
+  }
+
+ public:
+  Emitters()
+      : dirty{false},
+        emitParticles{getShaderPath("emit-particles.comp")},
+        resetLists{getShaderPath("reset-lists.comp")} {
+    emitParticlesPipeline.attachComputeShader(emitParticles);
+    resetListsPipeline.attachComputeShader(resetLists);
+  }
+
+  std::size_t getNumberOfEmitters() const { return emitters.size(); }
+
+  const Emitter& getEmitter(uint32_t index) const { return emitters[index]; }
+
+  uint32_t addEmitter(const Emitter& emitter) {
+    emitters.push_back(emitter);
+    dirty = true;
+    return emitters.size() - 1;
+  }
+
+  void setEmitter(uint32_t index, const Emitter& emitter) {
+    emitters[index] = emitter;
+    dirty = true;
+  }
+
+  void removeEmitter(uint32_t index) {
+    emitters.erase(emitters.begin() + index);
+    dirty = true;
+  }
+
+  const Buffer& getAliveList() const { return aliveList; }
+
+  // room for every particle in both lists
+  void resize(uint32_t nParticles) {
+    freeList.allocate<GLuint>(nParticles + 1, GL_DYNAMIC_COPY);
+    aliveList.allocate<GLuint>(nParticles + 4, GL_DYNAMIC_COPY);
+  }
+
+  // spawn particles of every emitter into dead slots
+  void emit(const Buffer& particles, float dt, uint32_t seed) {
+    if (dirty) {
+      emittersBuffer.setData(emitters, GL_DYNAMIC_DRAW);
+      dirty = false;
+    }
+    if (emitters.empty()) {
+      return;
+    }
+
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+    particles.bindToShaderStorageBuffer(0);
+    bind();
+    emittersBuffer.bindToShaderStorageBuffer(9);
+    emitParticles.setUniform("dt", dt);
+    emitParticles.setUniform("seed", seed);
+    emitParticlesPipeline.activate();
+    glDispatchCompute(emitters.size(), 1, 1);
+    emitParticlesPipeline.deactivate();
+
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+  }
+
+  // empty both lists and bind them for update-particles.comp or
+  // place-particles.comp, which refill them
+  void beginUpdate() const {
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+    bind();
+    resetListsPipeline.activate();
+    glDispatchCompute(1, 1, 1);
+    resetListsPipeline.deactivate();
+
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+  }
+
+  void bind() const {
+    freeList.bindToShaderStorageBuffer(7);
+    aliveList.bindToShaderStorageBuffer(8);
+  }
+};
+
+#endif
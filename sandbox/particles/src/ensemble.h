@@ -0,0 +1,233 @@
+#ifndef _ENSEMBLE_H
+#define _ENSEMBLE_H
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <vector>
+
+#include "glad/gl.h"
+#include "glm/glm.hpp"
+//
+#include "gcss/buffer.h"
+#include "gcss/readback.h"
+#include "gcss/shader.h"
+//
+#include "particles.h"
+
+using namespace gcss;
+
+// same layout as Member in ensemble/ensemble.glsl
+struct alignas(16) EnsembleMember {
+  glm::vec4 gravityCenter = glm::vec4(0);
+  float gravityIntensity = 0.1f;
+  float k = 0.0f;
+  float dt = 0.01f;
+  // seed of initial particles
+  uint32_t seed = 0;
+};
+
+// same layout as Sample in ensemble/resolve-diagnostics.comp
+struct alignas(16) EnsembleSample {
+  glm::vec4 centerOfMass = glm::vec4(0);
+  float kineticEnergy = 0;
+  // root mean square distance to the gravity center
+  float radius = 0;
+  float totalMass = 0;
+  uint32_t step = 0;
+};
+
+// independent particle simulations of the same size in one buffer, e.g. to
+// sweep gravity, damping or dt. every member has its own parameter block and
+// all members advance in a single dispatch, so that small simulations still
+// fill the GPU. diagnostics are reduced per member.
+class Ensemble {
+ private:
+  uint32_t nParticles;
+  std::vector<EnsembleMember> members;
+  uint64_t step;
+
+  ComputeShader placeParticles;
+  Pipeline placeParticlesPipeline;
+  ComputeShader updateParticles;
+  Pipeline updateParticlesPipeline;
+  ComputeShader reduceDiagnostics;
+  Pipeline reduceDiagnosticsPipeline;
+  ComputeShader resolveDiagnostics;
+  Pipeline resolveDiagnosticsPipeline;
+
+  Buffer membersBuffer;
+  Buffer particles;
+  Buffer partials;
+  Buffer samples;
+  AsyncReadback readback;
+
+  // DrawArraysIndirectCommand followed by indices of the drawn member, see
+  // emitters/lists.glsl
+  Buffer drawList;
+  uint32_t drawnMember;
+
+  std::vector<EnsembleSample> latestSamples;
+
+  static std::filesystem::path getShaderPath(const std::string& filename) {
+    return std::filesystem::path(CMAKE_CURRENT_SOURCE_DIR) / "shaders" /
+           "ensemble" / filename;
+  }
+
+  uint32_t getNumberOfWorkgroups() const {
+    return std::ceil(nParticles / 128.0f);
+  }
+
+  void dispatch(const ComputeShader& shader, const Pipeline& pipeline) const {
+    particles.bindToShaderStorageBuffer(0);
+    membersBuffer.bindToShaderStorageBuffer(3);
+
+    shader.setUniform("nParticles", nParticles);
+    pipeline.activate();
+    glDispatchCompute(getNumberOfWorkgroups(), members.size(), 1);
+    pipeline.deactivate();
+
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+  }
+
+  void updateDrawList() {
+    std::vector<GLuint> list(4 + nParticles);
+    list[0] = nParticles;
+    list[1] = 1;
+    for (uint32_t i = 0; i < nParticles; ++i) {
+      list[4 + i] = drawnMember * nParticles + i;
+    }
+    drawList.setData(list, GL_STATIC_DRAW);
+  }
+
+  // reduce diagnostics of every member into samples and read them back
+  void computeDiagnostics() {
+    if (readback.isFull()) {
+      return;
+    }
+
+    partials.bindToShaderStorageBuffer(1);
+    dispatch(reduceDiagnostics, reduceDiagnosticsPipeline);
+
+    partials.bindToShaderStorageBuffer(1);
+    samples.bindToShaderStorageBuffer(2);
+    resolveDiagnostics.setUniform("nPartials", getNumberOfWorkgroups());
+    resolveDiagnostics.setUniform("step", static_cast<GLuint>(step));
+    resolveDiagnosticsPipeline.activate();
+    glDispatchCompute(members.size(), 1, 1);
+    resolveDiagnosticsPipeline.deactivate();
+
+    readback.request({{&samples, 0,
+                       static_cast<GLsizeiptr>(members.size() *
+                                               sizeof(EnsembleSample))}},
+                     step);
+  }
+
+ public:
+  Ensemble()
+      : nParticles{1024},
+        members(8),
+        step{0},
+        placeParticles{getShaderPath("place-particles.comp")},
+        updateParticles{getShaderPath("update-particles.comp")},
+        reduceDiagnostics{getShaderPath("reduce-diagnostics.comp")},
+        resolveDiagnostics{getShaderPath("resolve-diagnostics.comp")},
+        drawnMember{0} {
+    placeParticlesPipeline.attachComputeShader(placeParticles);
+    updateParticlesPipeline.attachComputeShader(updateParticles);
+    reduceDiagnosticsPipeline.attachComputeShader(reduceDiagnostics);
+    resolveDiagnosticsPipeline.attachComputeShader(resolveDiagnostics);
+  }
+
+  // particles per member, takes effect with reset
+  uint32_t getNumberOfParticles() const { return nParticles; }
+  void setNumberOfParticles(uint32_t nParticles) {
+    this->nParticles = std::max(nParticles, 1u);
+  }
+
+  // takes effect with reset
+  std::size_t getNumberOfMembers() const { return members.size(); }
+  const EnsembleMember& getMember(uint32_t index) const {
+    return members[index];
+  }
+  void setMembers(const std::vector<EnsembleMember>& members) {
+    this->members = members;
+  }
+
+  // n members with parameters evenly spaced between first and last and
+  // consecutive seeds from first.seed on
+  void sweep(uint32_t n, const EnsembleMember& first,
+             const EnsembleMember& last) {
+    members.resize(std::max(n, 1u));
+    for (std::size_t i = 0; i < members.size(); ++i) {
+      const float t = members.size() > 1
+                          ? static_cast<float>(i) / (members.size() - 1)
+                          : 0.0f;
+      EnsembleMember& member = members[i];
+      member.gravityCenter =
+          glm::mix(first.gravityCenter, last.gravityCenter, t);
+      member.gravityIntensity =
+          glm::mix(first.gravityIntensity, last.gravityIntensity, t);
+      member.k = glm::mix(first.k, last.k, t);
+      member.dt = glm::mix(first.dt, last.dt, t);
+      member.seed = first.seed + i;
+    }
+  }
+
+  uint64_t getStep() const { return step; }
+
+  // particles of member m are in [m * nParticles, (m + 1) * nParticles)
+  const Buffer& getParticles() const { return particles; }
+
+  uint32_t getDrawnMember() const { return drawnMember; }
+  void setDrawnMember(uint32_t drawnMember) {
+    this->drawnMember = std::min<uint32_t>(drawnMember, members.size() - 1);
+    updateDrawList();
+  }
+
+  // draw list of the drawn member for Particles::draw
+  const Buffer& getDrawList() const { return drawList; }
+
+  // place particles of every member and start from step 0
+  void reset() {
+    readback.flush([](uint64_t, const std::byte*, std::size_t) {});
+    latestSamples.clear();
+    step = 0;
+
+    const uint32_t n_total = nParticles * members.size();
+    membersBuffer.setData(members, GL_STATIC_DRAW);
+    particles.allocate<Particle>(n_total, GL_DYNAMIC_DRAW);
+    partials.allocate<glm::vec4>(2 * getNumberOfWorkgroups() * members.size(),
+                                 GL_DYNAMIC_COPY);
+    samples.allocate<EnsembleSample>(members.size(), GL_DYNAMIC_COPY);
+    setDrawnMember(drawnMember);
+
+    dispatch(placeParticles, placeParticlesPipeline);
+  }
+
+  // advance every member by one step of its own dt
+  void update(bool diagnostics) {
+    dispatch(updateParticles, updateParticlesPipeline);
+
+    if (diagnostics) {
+      computeDiagnostics();
+    }
+    step++;
+  }
+
+  // receive finished diagnostics
+  void poll() {
+    readback.poll([&](uint64_t, const std::byte* data, std::size_t size) {
+      latestSamples.resize(size / sizeof(EnsembleSample));
+      std::memcpy(latestSamples.data(), data,
+                  latestSamples.size() * sizeof(EnsembleSample));
+    });
+  }
+
+  // latest diagnostics of every member, empty until the first readback
+  const std::vector<EnsembleSample>& getSamples() const {
+    return latestSamples;
+  }
+};
+
+#endif
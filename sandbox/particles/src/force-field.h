@@ -0,0 +1,256 @@
+#ifndef _FORCE_FIELD_H
+#define _FORCE_FIELD_H
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <random>
+#include <vector>
+
+#include "glad/gl.h"
+#include "glm/glm.hpp"
+//
+#include "gcss/buffer.h"
+#include "gcss/scan.h"
+#include "gcss/shader.h"
+
+using namespace gcss;
+
+enum class ForceSourceType : uint32_t {
+  ATTRACTOR = 0,
+  REPULSOR = 1,
+  VORTEX = 2,
+};
+
+// same layout as ForceSource in force-field.glsl
+struct alignas(16) ForceSource {
+  glm::vec4 position = glm::vec4(0);
+  // rotation axis of vortex
+  glm::vec4 axis = glm::vec4(0, 0, 1, 0);
+  ForceSourceType type = ForceSourceType::ATTRACTOR;
+  float strength = 0;
+};
+
+// attractors, repulsors and vortices acting on particles. sources are binned
+// into a coarse grid on the GPU, particles evaluate sources of the
+// neighboring cells exactly and the others through a far field sampled at
+// cell centers. edits only upload the changed sources.
+class ForceField {
+ private:
+  static constexpr uint32_t GRID_SIZE = 16;
+  static constexpr uint32_t N_CELLS = GRID_SIZE * GRID_SIZE * GRID_SIZE;
+
+  glm::vec3 gridMin;
+  glm::vec3 gridMax;
+
+  std::vector<ForceSource> sources;
+  // indices of sources which differ from the GPU copy
+  std::vector<uint32_t> dirty;
+  // the whole buffer has to be uploaded
+  bool reallocate;
+  // grid has to be rebuilt
+  bool rebuild;
+
+  ComputeShader countSources;
+  Pipeline countSourcesPipeline;
+  ComputeShader scatterSources;
+  Pipeline scatterSourcesPipeline;
+  ComputeShader computeFarField;
+  Pipeline computeFarFieldPipeline;
+  ExclusiveScan scan;
+
+  Buffer sourcesBuffer;
+  Buffer sourceCells;
+  Buffer cellCounts;
+  Buffer cellOffsets;
+  Buffer sortedSources;
+  Buffer farField;
+
+  glm::vec3 getCellSize() const {
+    return (gridMax - gridMin) / static_cast<float>(GRID_SIZE);
+  }
+
+  void setGridUniforms(const ComputeShader& shader) const {
+    shader.setUniform("nSources", static_cast<GLuint>(sources.size()));
+    shader.setUniform("gridMin", gridMin);
+    shader.setUniform("cellSize", getCellSize());
+    shader.setUniform("gridSize", GRID_SIZE);
+  }
+
+  void markDirty(uint32_t index) {
+    dirty.push_back(index);
+    rebuild = true;
+  }
+
+  // upload changed sources, contiguous indices are uploaded together
+  void upload() {
+    if (reallocate) {
+      // keep room for additional sources
+      std::vector<ForceSource> data = sources;
+      data.resize(std::max<std::size_t>(2 * sources.size(), 1));
+      sourcesBuffer.setData(data, GL_DYNAMIC_DRAW);
+      sourceCells.setData(std::vector<glm::uvec2>(data.size()),
+                          GL_DYNAMIC_COPY);
+      sortedSources.setData(std::vector<GLuint>(data.size()),
+                            GL_DYNAMIC_COPY);
+      reallocate = false;
+      dirty.clear();
+      return;
+    }
+
+    std::sort(dirty.begin(), dirty.end());
+    dirty.erase(std::unique(dirty.begin(), dirty.end()), dirty.end());
+
+    std::size_t begin = 0;
+    while (begin < dirty.size()) {
+      std::size_t end = begin + 1;
+      while (end < dirty.size() && dirty[end] == dirty[end - 1] + 1) {
+        end++;
+      }
+
+      // removed sources beyond the end are not uploaded
+      const std::size_t first = dirty[begin];
+      const std::size_t last = std::min<std::size_t>(dirty[end - 1] + 1,
+                                                     sources.size());
+      if (first < last) {
+        sourcesBuffer.setSubData(sources.data() + first, first, last - first);
+      }
+      begin = end;
+    }
+    dirty.clear();
+  }
+
+  void buildGrid() {
+    const uint32_t n_sources = sources.size();
+
+    // count sources per cell
+    cellCounts.clear();
+    sourcesBuffer.bindToShaderStorageBuffer(1);
+    cellCounts.bindToShaderStorageBuffer(2);
+    sourceCells.bindToShaderStorageBuffer(3);
+    setGridUniforms(countSources);
+    countSourcesPipeline.activate();
+    glDispatchCompute(std::ceil(n_sources / 128.0f), 1, 1);
+    countSourcesPipeline.deactivate();
+
+    scan.run(cellCounts, cellOffsets, N_CELLS);
+
+    // sort sources by cell
+    cellOffsets.bindToShaderStorageBuffer(2);
+    sourceCells.bindToShaderStorageBuffer(3);
+    sortedSources.bindToShaderStorageBuffer(4);
+    scatterSources.setUniform("nSources", n_sources);
+    scatterSourcesPipeline.activate();
+    glDispatchCompute(std::ceil(n_sources / 128.0f), 1, 1);
+    scatterSourcesPipeline.deactivate();
+
+    // far field at cell centers
+    sourcesBuffer.bindToShaderStorageBuffer(1);
+    farField.bindToShaderStorageBuffer(5);
+    setGridUniforms(computeFarField);
+    computeFarFieldPipeline.activate();
+    glDispatchCompute(N_CELLS / 64, 1, 1);
+    computeFarFieldPipeline.deactivate();
+
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+  }
+
+ public:
+  ForceField()
+      : gridMin{-1.0f},
+        gridMax{1.0f},
+        reallocate{true},
+        rebuild{true},
+        countSources{std::filesystem::path(CMAKE_CURRENT_SOURCE_DIR) /
+                     "shaders" / "force-field" / "count-sources.comp"},
+        scatterSources{std::filesystem::path(CMAKE_CURRENT_SOURCE_DIR) /
+                       "shaders" / "force-field" / "scatter-sources.comp"},
+        computeFarField{std::filesystem::path(CMAKE_CURRENT_SOURCE_DIR) /
+                        "shaders" / "force-field" / "compute-far-field.comp"} {
+    countSourcesPipeline.attachComputeShader(countSources);
+    scatterSourcesPipeline.attachComputeShader(scatterSources);
+    computeFarFieldPipeline.attachComputeShader(computeFarField);
+
+    cellCounts.setData(std::vector<GLuint>(N_CELLS), GL_DYNAMIC_COPY);
+    cellOffsets.setData(std::vector<GLuint>(N_CELLS + 1), GL_DYNAMIC_COPY);
+    farField.setData(std::vector<glm::vec4>(N_CELLS), GL_DYNAMIC_COPY);
+  }
+
+  // sources outside of the bounds are binned into boundary cells
+  void setBounds(const glm::vec3& gridMin, const glm::vec3& gridMax) {
+    this->gridMin = gridMin;
+    this->gridMax = gridMax;
+    rebuild = true;
+  }
+
+  std::size_t getNumberOfSources() const { return sources.size(); }
+
+  const ForceSource& getSource(uint32_t index) const { return sources[index]; }
+
+  uint32_t addSource(const ForceSource& source) {
+    sources.push_back(source);
+    if (sources.size() > sourcesBuffer.getLength()) {
+      reallocate = true;
+    }
+    markDirty(sources.size() - 1);
+    return sources.size() - 1;
+  }
+
+  void setSource(uint32_t index, const ForceSource& source) {
+    sources[index] = source;
+    markDirty(index);
+  }
+
+  // the last source takes the place of the removed one
+  void removeSource(uint32_t index) {
+    sources[index] = sources.back();
+    sources.pop_back();
+    markDirty(index);
+  }
+
+  void clear() {
+    sources.clear();
+    dirty.clear();
+    rebuild = true;
+  }
+
+  // n sources of random type, strength and position within the bounds
+  void placeRandom(uint32_t n, float strength) {
+    std::random_device rnd_dev;
+    std::mt19937 mt(rnd_dev());
+    std::uniform_real_distribution<float> dist(0, 1);
+
+    clear();
+    sources.resize(n);
+    for (auto& source : sources) {
+      const glm::vec3 p(dist(mt), dist(mt), dist(mt));
+      source.position = glm::vec4(gridMin + p * (gridMax - gridMin), 0);
+      source.axis = glm::vec4(
+          glm::normalize(glm::vec3(dist(mt), dist(mt), dist(mt)) - 0.5f), 0);
+      source.type = static_cast<ForceSourceType>(mt() % 3);
+      source.strength = strength * dist(mt);
+    }
+    reallocate = true;
+  }
+
+  // upload edits and rebuild the grid if anything changed
+  void update() {
+    if (reallocate || !dirty.empty()) {
+      upload();
+    }
+    if (rebuild) {
+      buildGrid();
+      rebuild = false;
+    }
+  }
+
+  // bind buffers and set uniforms of update-particles.comp
+  void bind(const ComputeShader& shader) const {
+    sourcesBuffer.bindToShaderStorageBuffer(1);
+    cellOffsets.bindToShaderStorageBuffer(2);
+    sortedSources.bindToShaderStorageBuffer(4);
+    farField.bindToShaderStorageBuffer(5);
+    setGridUniforms(shader);
+  }
+};
+
+#endif
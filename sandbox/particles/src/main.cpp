@@ -160,7 +160,9 @@ int main() {
 
       static int n_particles = RENDERER->getNParticles();
       if (ImGui::InputInt("Number of particles", &n_particles)) {
-        n_particles = std::clamp(n_particles, 0, 10000000);
+        n_particles = std::clamp(
+            n_particles, 0,
+            RENDERER->getEnableOutOfCore() ? 1000000000 : 10000000);
         RENDERER->setNParticles(n_particles);
       }
 
@@ -184,9 +186,292 @@ int main() {
         RENDERER->setBaseColor(base_color);
       }
 
+      ImGui::Separator();
+
+      static int render_mode = static_cast<int>(RENDERER->getRenderMode());
+      if (ImGui::Combo("Render mode", &render_mode,
+                       "Points\0"
+                       "Splatting\0")) {
+        RENDERER->setRenderMode(static_cast<RenderMode>(render_mode));
+      }
+
+      static float splat_point_size = RENDERER->getSplatPointSize();
+      if (ImGui::SliderFloat("Splat point size", &splat_point_size, 0.0f,
+                             64.0f)) {
+        RENDERER->setSplatPointSize(splat_point_size);
+      }
+
+      static float splat_intensity = RENDERER->getSplatIntensity();
+      if (ImGui::InputFloat("Splat intensity", &splat_intensity)) {
+        splat_intensity = std::max(splat_intensity, 0.0f);
+        RENDERER->setSplatIntensity(splat_intensity);
+      }
+
+      static float splat_exposure = RENDERER->getSplatExposure();
+      if (ImGui::InputFloat("Splat exposure", &splat_exposure)) {
+        splat_exposure = std::max(splat_exposure, 0.0f);
+        RENDERER->setSplatExposure(splat_exposure);
+      }
+
+      ImGui::Separator();
+
+      static bool enable_emitters = RENDERER->getEnableEmitters();
+      if (ImGui::Checkbox("Emitters", &enable_emitters)) {
+        RENDERER->setEnableEmitters(enable_emitters);
+      }
+
+      if (ImGui::Button("Add emitter")) {
+        RENDERER->addEmitter(Emitter());
+      }
+
+      // edit a single emitter
+      const int n_emitters = RENDERER->getNumberOfEmitters();
+      if (n_emitters > 0) {
+        static int emitter_index = 0;
+        ImGui::InputInt("Emitter index", &emitter_index);
+        emitter_index = std::clamp(emitter_index, 0, n_emitters - 1);
+
+        Emitter emitter = RENDERER->getEmitter(emitter_index);
+        bool changed = ImGui::InputFloat3("Emitter position",
+                                          glm::value_ptr(emitter.position));
+        changed |= ImGui::InputFloat3("Emitter velocity",
+                                      glm::value_ptr(emitter.velocity));
+        changed |= ImGui::InputFloat("Rate", &emitter.rate);
+        changed |= ImGui::InputFloat("Lifetime", &emitter.lifetime);
+        changed |= ImGui::InputFloat("Spread", &emitter.spread);
+        if (changed) {
+          emitter.rate = std::max(emitter.rate, 0.0f);
+          RENDERER->setEmitter(emitter_index, emitter);
+        }
+
+        if (ImGui::Button("Remove emitter")) {
+          RENDERER->removeEmitter(emitter_index);
+        }
+      }
+
+      ImGui::Separator();
+
+      static bool enable_sph = RENDERER->getEnableSph();
+      if (ImGui::Checkbox("SPH", &enable_sph)) {
+        RENDERER->setEnableSph(enable_sph);
+      }
+
+      static float smoothing_length = RENDERER->getSphSmoothingLength();
+      if (ImGui::InputFloat("Smoothing length", &smoothing_length, 0.0f,
+                            0.0f, "%.4f")) {
+        smoothing_length = std::max(smoothing_length, 1e-4f);
+        RENDERER->setSphSmoothingLength(smoothing_length);
+      }
+
+      // particles are placed with a density of the number of particles
+      static float rest_density = RENDERER->getSphRestDensity();
+      if (ImGui::InputFloat("Rest density", &rest_density, 0.0f, 0.0f,
+                            "%.0f")) {
+        RENDERER->setSphRestDensity(rest_density);
+      }
+
+      static float stiffness = RENDERER->getSphStiffness();
+      if (ImGui::InputFloat("Stiffness", &stiffness)) {
+        RENDERER->setSphStiffness(stiffness);
+      }
+
+      static float viscosity = RENDERER->getSphViscosity();
+      if (ImGui::InputFloat("Viscosity", &viscosity, 0.0f, 0.0f, "%.5f")) {
+        RENDERER->setSphViscosity(viscosity);
+      }
+
+      ImGui::Separator();
+
+      static int force_field_mode =
+          static_cast<int>(RENDERER->getForceFieldMode());
+      if (ImGui::Combo("Force field", &force_field_mode,
+                       "Off\0"
+                       "Grid\0"
+                       "Exact\0")) {
+        RENDERER->setForceFieldMode(
+            static_cast<ForceFieldMode>(force_field_mode));
+      }
+
+      static int n_sources = 1000;
+      ImGui::InputInt("Number of sources", &n_sources);
+      n_sources = std::clamp(n_sources, 0, 100000);
+      static float source_strength = 0.01f;
+      ImGui::InputFloat("Source strength", &source_strength);
+      if (ImGui::Button("Place sources")) {
+        RENDERER->placeForceSources(n_sources, source_strength);
+      }
+
+      static int n_animated_sources = RENDERER->getNumberOfAnimatedSources();
+      if (ImGui::InputInt("Animated sources per step", &n_animated_sources)) {
+        n_animated_sources = std::max(n_animated_sources, 0);
+        RENDERER->setNumberOfAnimatedSources(n_animated_sources);
+      }
+
+      // edit a single source
+      const int n_placed = RENDERER->getNumberOfForceSources();
+      if (n_placed > 0) {
+        static int source_index = 0;
+        ImGui::InputInt("Source index", &source_index);
+        source_index = std::clamp(source_index, 0, n_placed - 1);
+
+        ForceSource source = RENDERER->getForceSource(source_index);
+        int source_type = static_cast<int>(source.type);
+        bool changed = ImGui::Combo("Source type", &source_type,
+                                    "Attractor\0"
+                                    "Repulsor\0"
+                                    "Vortex\0");
+        source.type = static_cast<ForceSourceType>(source_type);
+        changed |= ImGui::InputFloat3("Source position",
+                                      glm::value_ptr(source.position));
+        changed |=
+            ImGui::InputFloat3("Vortex axis", glm::value_ptr(source.axis));
+        changed |= ImGui::InputFloat("Strength", &source.strength);
+        if (changed) {
+          RENDERER->setForceSource(source_index, source);
+        }
+      }
+
+      static int seed = RENDERER->getSeed();
+      if (ImGui::InputInt("Seed", &seed)) {
+        RENDERER->setSeed(seed);
+      }
+
       if (ImGui::Button("Reset particles")) {
         RENDERER->placeParticles();
       }
+
+      ImGui::Separator();
+
+      static bool out_of_core = RENDERER->getEnableOutOfCore();
+      if (ImGui::Checkbox("Out-of-core", &out_of_core)) {
+        RENDERER->setEnableOutOfCore(out_of_core);
+      }
+
+      static bool out_of_core_mapped = RENDERER->getOutOfCoreMapped();
+      if (ImGui::Checkbox("Memory-mapped file", &out_of_core_mapped)) {
+        RENDERER->setOutOfCoreMapped(out_of_core_mapped);
+      }
+
+      static int chunk_length = RENDERER->getOutOfCoreChunkLength();
+      if (ImGui::InputInt("Chunk length", &chunk_length)) {
+        chunk_length = std::max(chunk_length, 128);
+        RENDERER->setOutOfCoreChunkLength(chunk_length);
+      }
+
+      if (out_of_core) {
+        ImGui::Text("Step: %.1f ms, %.2f GB/s",
+                    1e3 * RENDERER->getOutOfCoreStepTime(),
+                    1e-9 * RENDERER->getOutOfCoreBandwidth());
+      }
+
+      ImGui::Separator();
+
+      static bool ensemble = RENDERER->getEnableEnsemble();
+      if (ImGui::Checkbox("Ensemble", &ensemble)) {
+        RENDERER->setEnableEnsemble(ensemble);
+      }
+
+      static int ensemble_members =
+          RENDERER->getEnsemble().getNumberOfMembers();
+      ImGui::InputInt("Members", &ensemble_members);
+      static int ensemble_particles =
+          RENDERER->getEnsemble().getNumberOfParticles();
+      ImGui::InputInt("Particles per member", &ensemble_particles);
+      // gravity intensity, k and dt of the first and the last member
+      static float ensemble_min[3] = {RENDERER->getGravityIntensity(),
+                                      RENDERER->getK(), RENDERER->getDt()};
+      ImGui::InputFloat3("Gravity, k, dt min", ensemble_min);
+      static float ensemble_max[3] = {RENDERER->getGravityIntensity(),
+                                      RENDERER->getK(), RENDERER->getDt()};
+      ImGui::InputFloat3("Gravity, k, dt max", ensemble_max);
+      if (ImGui::Button("Sweep")) {
+        ensemble_members = std::clamp(ensemble_members, 1, 4096);
+        ensemble_particles = std::clamp(ensemble_particles, 1, 1000000);
+
+        EnsembleMember first, last;
+        first.gravityCenter = last.gravityCenter =
+            glm::vec4(RENDERER->getGravityCenter(), 0);
+        first.gravityIntensity = ensemble_min[0];
+        first.k = ensemble_min[1];
+        first.dt = ensemble_min[2];
+        last.gravityIntensity = ensemble_max[0];
+        last.k = ensemble_max[1];
+        last.dt = ensemble_max[2];
+        RENDERER->sweepEnsemble(ensemble_members, ensemble_particles, first,
+                                last);
+      }
+
+      if (ensemble) {
+        const Ensemble& e = RENDERER->getEnsemble();
+        static int ensemble_member = RENDERER->getEnsembleMember();
+        if (ImGui::SliderInt("Drawn member", &ensemble_member, 0,
+                             e.getNumberOfMembers() - 1)) {
+          RENDERER->setEnsembleMember(ensemble_member);
+        }
+
+        // parameters, kinetic energy and radius of every member
+        const auto& samples = e.getSamples();
+        for (std::size_t i = 0; i < samples.size(); ++i) {
+          const EnsembleMember& member = e.getMember(i);
+          ImGui::Text("%3d: G %.3f, k %.3f, dt %.4f, KE %e, r %.4f",
+                      static_cast<int>(i), member.gravityIntensity, member.k,
+                      member.dt, samples[i].kineticEnergy, samples[i].radius);
+        }
+      }
+
+      ImGui::Separator();
+
+      static int reorder_interval = RENDERER->getReorderInterval();
+      if (ImGui::InputInt("Reorder every K steps", &reorder_interval)) {
+        reorder_interval = std::max(reorder_interval, 0);
+        RENDERER->setReorderInterval(reorder_interval);
+      }
+
+      static int reorder_bits = RENDERER->getReorderBits() == 30 ? 0 : 1;
+      if (ImGui::Combo("Morton code", &reorder_bits,
+                       "30 bit\0"
+                       "63 bit\0")) {
+        RENDERER->setReorderBits(reorder_bits == 0 ? 30 : 63);
+      }
+
+      const ReorderReport& reorder_report = RENDERER->getReorderReport();
+      ImGui::Text("Reorder: %.3f ms", reorder_report.reorderTime);
+      ImGui::Text("Step before/after: %.3f/%.3f ms",
+                  reorder_report.frameTimeBefore,
+                  reorder_report.frameTimeAfter);
+      if (reorder_report.getBreakEvenFrames() < 0) {
+        ImGui::Text("Break-even: no gain");
+      } else {
+        ImGui::Text("Break-even: %.1f steps",
+                    reorder_report.getBreakEvenFrames());
+      }
+
+      ImGui::Separator();
+
+      bool record_trajectory = RENDERER->isRecordingTrajectory();
+      if (ImGui::Checkbox("Record trajectory", &record_trajectory)) {
+        if (record_trajectory) {
+          RENDERER->startTrajectory("particles.trj");
+        } else {
+          RENDERER->stopTrajectory();
+        }
+      }
+
+      static int trajectory_interval = RENDERER->getTrajectoryInterval();
+      if (ImGui::InputInt("Record every K steps", &trajectory_interval)) {
+        trajectory_interval = std::max(trajectory_interval, 1);
+        RENDERER->setTrajectoryInterval(trajectory_interval);
+      }
+
+      static int trajectory_bits = RENDERER->getTrajectoryBits() == 16 ? 0 : 1;
+      if (ImGui::Combo("Quantization", &trajectory_bits,
+                       "16 bit\0"
+                       "21 bit\0")) {
+        RENDERER->setTrajectoryBits(trajectory_bits == 0 ? 16 : 21);
+      }
+
+      ImGui::Text("Recorded frames: %lu", static_cast<unsigned long>(
+                      RENDERER->getNumberOfRecordedFrames()));
     }
     ImGui::End();
 
@@ -0,0 +1,287 @@
+#ifndef _OUT_OF_CORE_H
+#define _OUT_OF_CORE_H
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <limits>
+#include <vector>
+
+#include "glad/gl.h"
+#include "glm/glm.hpp"
+#include "spdlog/spdlog.h"
+//
+#include "gcss/buffer.h"
+#include "gcss/mapped-file.h"
+#include "gcss/random.h"
+#include "gcss/thread-pool.h"
+//
+#include "particles.h"
+
+using namespace gcss;
+
+// particles kept in host memory, optionally a memory mapped file, and
+// streamed through a fixed ring of GPU chunks. while chunk i is updated,
+// chunk i + 1 is uploaded and chunk i - 1 is read back, so the number of
+// particles is bounded by host memory and a step by the bus bandwidth.
+class OutOfCore {
+ private:
+  static constexpr std::size_t N_SLOTS = 3;
+
+  // a chunk on the GPU and its persistently mapped staging buffer, which
+  // holds the upload until it is copied to the chunk and then the result
+  struct Slot {
+    Buffer chunk;
+    Buffer staging;
+    Particle* mapped = nullptr;
+    GLsync fence = nullptr;
+  };
+
+  uint32_t nParticles;
+  uint32_t chunkLength;
+
+  std::vector<Particle> hostMemory;
+  MappedFile hostFile;
+  Particle* host;
+
+  std::array<Slot, N_SLOTS> slots;
+
+  // the first particles of every chunk are kept on the GPU for rendering
+  uint32_t previewLength;
+  uint32_t previewPerChunk;
+  Buffer preview;
+  // DrawArraysIndirectCommand followed by indices, see emitters/lists.glsl
+  Buffer previewList;
+
+  // workers of the renderer, not ours
+  ThreadPool& pool;
+
+  // wall clock time of the last step in seconds
+  double stepTime;
+
+  uint32_t getNumberOfChunks() const {
+    return (nParticles + chunkLength - 1) / chunkLength;
+  }
+
+  uint32_t getChunkLength(uint32_t chunk) const {
+    return std::min(chunkLength, nParticles - chunk * chunkLength);
+  }
+
+  Slot& getSlot(uint32_t chunk) { return slots[chunk % N_SLOTS]; }
+
+  void releaseSlots() {
+    for (auto& slot : slots) {
+      if (slot.fence) {
+        glDeleteSync(slot.fence);
+        slot.fence = nullptr;
+      }
+      if (slot.mapped) {
+        slot.staging.unmap();
+        slot.mapped = nullptr;
+      }
+    }
+  }
+
+  void allocateSlots() {
+    releaseSlots();
+
+    const GLbitfield flags = GL_MAP_READ_BIT | GL_MAP_WRITE_BIT |
+                             GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    for (auto& slot : slots) {
+      slot.chunk.allocate<Particle>(chunkLength, GL_DYNAMIC_COPY);
+      slot.staging.setStorage<Particle>(chunkLength,
+                                        flags | GL_CLIENT_STORAGE_BIT);
+      slot.mapped = static_cast<Particle*>(
+          slot.staging.mapRange(0, chunkLength * sizeof(Particle), flags));
+    }
+  }
+
+  void allocatePreview() {
+    const uint32_t n_chunks = getNumberOfChunks();
+    previewPerChunk = std::min(
+        chunkLength, std::max(previewLength / std::max(n_chunks, 1u), 1u));
+
+    std::vector<GLuint> list(4);
+    for (uint32_t chunk = 0; chunk < n_chunks; ++chunk) {
+      const uint32_t n = std::min(previewPerChunk, getChunkLength(chunk));
+      for (uint32_t i = 0; i < n; ++i) {
+        list.push_back(chunk * previewPerChunk + i);
+      }
+    }
+    list[0] = list.size() - 4;
+    list[1] = 1;
+
+    preview.allocate<Particle>(n_chunks * previewPerChunk, GL_DYNAMIC_COPY);
+    previewList.setData(list, GL_STATIC_DRAW);
+
+    // initial state until the first step
+    for (uint32_t chunk = 0; chunk < n_chunks; ++chunk) {
+      preview.setSubData(host + std::size_t(chunk) * chunkLength,
+                         chunk * previewPerChunk,
+                         std::min(previewPerChunk, getChunkLength(chunk)));
+    }
+  }
+
+  // memcpy to the staging buffer is coherent, the copy to the chunk follows
+  // in command order
+  void upload(uint32_t chunk) {
+    Slot& slot = getSlot(chunk);
+    const uint32_t length = getChunkLength(chunk);
+    std::memcpy(slot.mapped, host + std::size_t(chunk) * chunkLength,
+                length * sizeof(Particle));
+    slot.chunk.copySubData<Particle>(slot.staging, 0, 0, length);
+  }
+
+  void download(uint32_t chunk) {
+    Slot& slot = getSlot(chunk);
+    glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT,
+                     std::numeric_limits<GLuint64>::max());
+    glDeleteSync(slot.fence);
+    slot.fence = nullptr;
+
+    std::memcpy(host + std::size_t(chunk) * chunkLength, slot.mapped,
+                getChunkLength(chunk) * sizeof(Particle));
+  }
+
+ public:
+  OutOfCore(ThreadPool& pool)
+      : nParticles{0},
+        chunkLength{1 << 20},
+        host{nullptr},
+        previewLength{1 << 20},
+        previewPerChunk{0},
+        pool{pool},
+        stepTime{0} {}
+
+  OutOfCore(const OutOfCore& other) = delete;
+
+  ~OutOfCore() { releaseSlots(); }
+
+  OutOfCore& operator=(const OutOfCore& other) = delete;
+
+  uint32_t getNumberOfParticles() const { return nParticles; }
+
+  uint32_t getChunkLength() const { return chunkLength; }
+
+  // takes effect with the next call of place
+  void setChunkLength(uint32_t chunkLength) {
+    this->chunkLength = std::max(chunkLength, 128u);
+  }
+
+  const Buffer& getPreview() const { return preview; }
+  const Buffer& getPreviewList() const { return previewList; }
+  uint32_t getPreviewLength() const {
+    return getNumberOfChunks() * previewPerChunk;
+  }
+
+  double getStepTime() const { return stepTime; }
+
+  // bytes moved over the bus per second in the last step
+  double getBandwidth() const {
+    return stepTime > 0 ? 2.0 * nParticles * sizeof(Particle) / stepTime : 0;
+  }
+
+  // free host memory and GPU chunks
+  void release() {
+    releaseSlots();
+    for (auto& slot : slots) {
+      slot.chunk.allocate<Particle>(0, GL_DYNAMIC_COPY);
+      // immutable storage can not be respecified
+      slot.staging = Buffer();
+    }
+    preview.allocate<Particle>(0, GL_DYNAMIC_COPY);
+
+    nParticles = 0;
+    hostMemory.clear();
+    hostMemory.shrink_to_fit();
+    hostFile.release();
+    host = nullptr;
+  }
+
+  // same particles as place-particles.comp with the same seed. with an empty
+  // filepath particles are kept in RAM, otherwise in a file mapped into
+  // memory.
+  bool place(uint32_t nParticles, uint32_t seed,
+             const std::filesystem::path& filepath = {}) {
+    release();
+
+    if (filepath.empty()) {
+      hostMemory.resize(nParticles);
+      host = hostMemory.data();
+    } else {
+      if (!hostFile.create(filepath,
+                           std::size_t(nParticles) * sizeof(Particle))) {
+        return false;
+      }
+      host = reinterpret_cast<Particle*>(hostFile.getWritableData());
+    }
+    this->nParticles = nParticles;
+
+    pool.parallelFor(0, nParticles, 1 << 16,
+                     [&](std::size_t begin, std::size_t end) {
+                       for (std::size_t i = begin; i < end; ++i) {
+                         Random rng(seed, i);
+                         Particle p;
+                         p.position.x = rng.nextFloat() - 0.5f;
+                         p.position.y = rng.nextFloat() - 0.5f;
+                         p.position.z = rng.nextFloat() - 0.5f;
+                         p.mass = 1.0f;
+                         p.lifetime = std::numeric_limits<float>::infinity();
+                         p.id = i;
+                         host[i] = p;
+                       }
+                     });
+
+    allocateSlots();
+    allocatePreview();
+
+    spdlog::info("[OutOfCore] {} particles in {} chunks of {}", nParticles,
+                 getNumberOfChunks(), chunkLength);
+
+    return true;
+  }
+
+  // stream every chunk through the GPU once. update(chunk, length) dispatches
+  // a shader on the particles of the chunk bound by the caller.
+  template <typename F>
+  void step(F&& update) {
+    const uint32_t n_chunks = getNumberOfChunks();
+    if (n_chunks == 0) {
+      return;
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+
+    upload(0);
+    for (uint32_t chunk = 0; chunk < n_chunks; ++chunk) {
+      Slot& slot = getSlot(chunk);
+      const uint32_t length = getChunkLength(chunk);
+
+      glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+      update(slot.chunk, length);
+
+      glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+      preview.copySubData<Particle>(slot.chunk, 0, chunk * previewPerChunk,
+                                    std::min(previewPerChunk, length));
+      slot.staging.copySubData<Particle>(slot.chunk, 0, 0, length);
+      glMemoryBarrier(GL_CLIENT_MAPPED_BUFFER_BARRIER_BIT);
+      slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+      // the slot of chunk + 1 was freed by the download of chunk - 2
+      if (chunk + 1 < n_chunks) {
+        upload(chunk + 1);
+      }
+      if (chunk > 0) {
+        download(chunk - 1);
+      }
+    }
+    download(n_chunks - 1);
+
+    const std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - start;
+    stepTime = elapsed.count();
+  }
+};
+
+#endif
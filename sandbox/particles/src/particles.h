@@ -7,40 +7,46 @@
 
 using namespace gcss;
 
+// same layout as Particle in particle.glsl
 struct alignas(16) Particle {
   glm::vec4 position = glm::vec4(0);
   glm::vec4 velocity = glm::vec4(0);
   float mass = 0;
+  // remaining time to live, infinite for particles which never die
+  float lifetime = 0;
+  // index the particle was placed at, kept when particles are reordered
+  uint32_t id = 0;
 };
 
+// live particles are drawn with glDrawArraysIndirect, the vertex shader
+// pulls them from the particle buffer through the alive list
 class Particles {
  private:
+  // no attributes, but drawing needs a vertex array object
   VertexArrayObject VAO;
   const Buffer* buffer;
 
  public:
   Particles() {}
 
-  void setParticles(const Buffer* buffer) {
-    this->buffer = buffer;
-    VAO.bindVertexBuffer(*buffer, 0, 0, sizeof(Particle));
+  void setParticles(const Buffer* buffer) { this->buffer = buffer; }
 
-    // position
-    VAO.activateVertexAttribution(0, 0, 3, GL_FLOAT, 0);
+  // aliveList starts with a DrawArraysIndirectCommand followed by indices of
+  // live particles
+  void draw(const Pipeline& pipeline, const Buffer& aliveList) const {
+    buffer->bindToShaderStorageBuffer(0);
+    aliveList.bindToShaderStorageBuffer(8);
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, aliveList.getName());
 
-    // velocity
-    VAO.activateVertexAttribution(0, 1, 3, GL_FLOAT, 4 * sizeof(GLfloat));
+    glMemoryBarrier(GL_COMMAND_BARRIER_BIT);
 
-    // mass
-    VAO.activateVertexAttribution(0, 2, 1, GL_FLOAT, 8 * sizeof(GLfloat));
-  }
-
-  void draw(const Pipeline& pipeline) const {
     pipeline.activate();
     VAO.activate();
-    glDrawArrays(GL_POINTS, 0, buffer->getLength());
+    glDrawArraysIndirect(GL_POINTS, nullptr);
     VAO.deactivate();
     pipeline.deactivate();
+
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
   }
 };
 
@@ -1,5 +1,6 @@
 #ifndef _RENDERER_H
 #define _RENDERER_H
+#include <limits>
 #include <random>
 #include <vector>
 
@@ -8,11 +9,33 @@
 //
 #include "gcss/buffer.h"
 #include "gcss/camera.h"
+#include "gcss/gpu-timer.h"
+#include "gcss/morton-reorder.h"
+#include "gcss/point-splatter.h"
+#include "gcss/thread-pool.h"
+#include "gcss/trajectory-recorder.h"
 //
+#include "emitters.h"
+#include "ensemble.h"
+#include "force-field.h"
+#include "out-of-core.h"
 #include "particles.h"
+#include "sph.h"
 
 using namespace gcss;
 
+enum class ForceFieldMode : int {
+  OFF = 0,
+  GRID = 1,
+  // every particle evaluates every source, for reference
+  EXACT = 2,
+};
+
+enum class RenderMode : int {
+  POINTS = 0,
+  SPLATTING = 1,
+};
+
 class Renderer {
  private:
   glm::uvec2 resolution;
@@ -24,12 +47,16 @@ class Renderer {
   bool increaseK;
   bool pause;
   glm::vec3 baseColor;
+  // seed of initial particles
+  uint32_t seed;
 
   Camera camera;
 
   Particles particles;
   Buffer particlesBuffer;
 
+  ComputeShader placeParticlesShader;
+  Pipeline placeParticlesPipeline;
   ComputeShader updateParticles;
   Pipeline updateParticlesPipeline;
 
@@ -37,7 +64,155 @@ class Renderer {
   FragmentShader fragmentShader;
   Pipeline renderPipeline;
 
+  RenderMode renderMode;
+  PointSplatter splatter;
+
+  ForceField forceField;
+  ForceFieldMode forceFieldMode;
+  // sources moved per step to exercise partial updates
+  uint32_t nAnimatedSources;
+  std::mt19937 animationRng;
+
+  bool enableSph;
+  Sph sph;
+
+  // particles spawn from emitters instead of being placed at once
+  bool enableEmitters;
+  Emitters emitters;
+
+  // particles live in host memory and are streamed through the GPU in
+  // chunks, sph, emitters, reordering and trajectories are not available
+  bool enableOutOfCore;
+  // keep out-of-core particles in a memory mapped file instead of RAM
+  bool outOfCoreMapped;
+  // workers of the CPU side of out-of-core particles
+  ThreadPool threadPool;
+  OutOfCore outOfCore;
+
+  // many small simulations instead of the main one, one member is drawn
+  bool enableEnsemble;
+  Ensemble ensemble;
+  Particles ensembleParticles;
+
+  // sort particles along a Morton curve every K steps, 0 disables it. ids of
+  // particles travel with them, so trajectories follow the same particle
+  // across a reorder.
+  uint32_t reorderInterval;
+  MortonReorder mortonReorder;
+  GpuTimer reorderTimer;
+  // steps without a reorder
+  GpuTimer frameTimer;
+  ReorderReport reorderReport;
+
   float elapsed_time;
+  uint64_t step;
+
+  TrajectoryRecorder trajectory;
+  uint32_t trajectoryInterval;
+  // index of each particle id after reorders and sph, recorded in id order
+  ComputeShader computeSlots;
+  Pipeline computeSlotsPipeline;
+  Buffer slotsBuffer;
+
+  void setUpdateUniforms() {
+    updateParticles.setUniform("nParticles", nParticles);
+    updateParticles.setUniform("forceFieldMode",
+                               static_cast<GLuint>(forceFieldMode));
+    updateParticles.setUniform("enableSph", enableSph && !enableOutOfCore);
+    updateParticles.setUniform("updateLists", !enableOutOfCore);
+    updateParticles.setUniform("gravityCenter", gravityCenter);
+    updateParticles.setUniform("gravityIntensity", gravityIntensity);
+    updateParticles.setUniform("increaseK", increaseK);
+    updateParticles.setUniform("k", k);
+    updateParticles.setUniform("dt", dt);
+  }
+
+  void stepInCore(bool reorder_due) {
+    if (enableEmitters) {
+      emitters.emit(particlesBuffer, dt, static_cast<uint32_t>(step));
+    }
+
+    // free and alive lists are rebuilt by update-particles.comp after the
+    // reorder
+    if (reorder_due) {
+      reorderTimer.begin();
+      mortonReorder.reorder(particlesBuffer, nParticles,
+                            sizeof(Particle) / sizeof(glm::vec4));
+      reorderTimer.end();
+    }
+
+    // sph reorders particles, so it runs before buffers are bound
+    if (enableSph) {
+      sph.update(particlesBuffer, nParticles);
+      sph.bind();
+    }
+
+    if (forceFieldMode != ForceFieldMode::OFF) {
+      animateForceSources();
+      forceField.update();
+      forceField.bind(updateParticles);
+    }
+
+    // free and alive lists are rebuilt in the order after sph
+    emitters.beginUpdate();
+
+    particlesBuffer.bindToShaderStorageBuffer(0);
+    setUpdateUniforms();
+    updateParticlesPipeline.activate();
+    glDispatchCompute(std::ceil(nParticles / 128.0f), 1, 1);
+    updateParticlesPipeline.deactivate();
+
+    // record every Kth step
+    if (trajectory.isRecording() && step % trajectoryInterval == 0) {
+      recordTrajectory();
+    }
+  }
+
+  // particles are independent of each other apart from sph, so chunks are
+  // updated one after another
+  void stepOutOfCore() {
+    if (forceFieldMode != ForceFieldMode::OFF) {
+      animateForceSources();
+      forceField.update();
+      forceField.bind(updateParticles);
+    }
+
+    setUpdateUniforms();
+    outOfCore.step([&](const Buffer& chunk, uint32_t length) {
+      chunk.bindToShaderStorageBuffer(0);
+      updateParticles.setUniform("nParticles", length);
+      updateParticlesPipeline.activate();
+      glDispatchCompute(std::ceil(length / 128.0f), 1, 1);
+      updateParticlesPipeline.deactivate();
+    });
+  }
+
+  // particles are recorded by id, as reorders and sph move them around
+  void recordTrajectory() {
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+    particlesBuffer.bindToShaderStorageBuffer(0);
+    slotsBuffer.bindToShaderStorageBuffer(4);
+    computeSlots.setUniform("nParticles", nParticles);
+    computeSlotsPipeline.activate();
+    glDispatchCompute(std::ceil(nParticles / 128.0f), 1, 1);
+    computeSlotsPipeline.deactivate();
+
+    trajectory.record(particlesBuffer, step, &slotsBuffer);
+  }
+
+  void pollReorderTimers(bool reordered) {
+    frameTimer.poll();
+    reorderTimer.poll();
+
+    // frame time after a reorder is averaged until the next one
+    if (reordered) {
+      reorderReport.frameTimeBefore = frameTimer.getAverage();
+      frameTimer.resetAverage();
+    }
+    reorderReport.reorderTime = reorderTimer.getLast();
+    reorderReport.frameTimeAfter = frameTimer.getAverage();
+  }
 
  public:
   Renderer()
@@ -50,16 +225,37 @@ class Renderer {
         increaseK{false},
         pause{false},
         baseColor{0.2, 0.4, 0.8},
+        seed{0},
+        placeParticlesShader{std::filesystem::path(CMAKE_CURRENT_SOURCE_DIR) /
+                             "shaders" / "place-particles.comp"},
         updateParticles{std::filesystem::path(CMAKE_CURRENT_SOURCE_DIR) /
                         "shaders" / "update-particles.comp"},
         vertexShader{std::filesystem::path(CMAKE_CURRENT_SOURCE_DIR) /
                      "shaders" / "render-particles.vert"},
         fragmentShader{std::filesystem::path(CMAKE_CURRENT_SOURCE_DIR) /
                        "shaders" / "render-particles.frag"},
-        elapsed_time{0} {
+        renderMode{RenderMode::POINTS},
+        splatter{std::filesystem::path(CMAKE_CURRENT_SOURCE_DIR) / "shaders" /
+                 "splat-particles.comp"},
+        forceFieldMode{ForceFieldMode::OFF},
+        nAnimatedSources{0},
+        enableSph{false},
+        enableEmitters{false},
+        enableOutOfCore{false},
+        outOfCoreMapped{false},
+        outOfCore{threadPool},
+        enableEnsemble{false},
+        reorderInterval{0},
+        elapsed_time{0},
+        step{0},
+        trajectoryInterval{1},
+        computeSlots{std::filesystem::path(CMAKE_CURRENT_SOURCE_DIR) /
+                     "shaders" / "compute-slots.comp"} {
     particles.setParticles(&particlesBuffer);
 
+    placeParticlesPipeline.attachComputeShader(placeParticlesShader);
     updateParticlesPipeline.attachComputeShader(updateParticles);
+    computeSlotsPipeline.attachComputeShader(computeSlots);
 
     glEnable(GL_PROGRAM_POINT_SIZE);
     glEnable(GL_BLEND);
@@ -74,11 +270,28 @@ class Renderer {
   glm::uvec2 getResolution() const { return this->resolution; }
   void setResolution(const glm::uvec2& resolution) {
     this->resolution = resolution;
+    splatter.setResolution(resolution);
+  }
+
+  RenderMode getRenderMode() const { return renderMode; }
+  void setRenderMode(const RenderMode& renderMode) {
+    this->renderMode = renderMode;
   }
 
+  float getSplatPointSize() const { return splatter.getPointSize(); }
+  void setSplatPointSize(float pointSize) { splatter.setPointSize(pointSize); }
+
+  float getSplatIntensity() const { return splatter.getIntensity(); }
+  void setSplatIntensity(float intensity) { splatter.setIntensity(intensity); }
+
+  float getSplatExposure() const { return splatter.getExposure(); }
+  void setSplatExposure(float exposure) { splatter.setExposure(exposure); }
+
   uint32_t getNParticles() const { return nParticles; }
   void setNParticles(uint32_t nParticles) {
     this->nParticles = nParticles;
+    // trajectory has a fixed number of particles
+    stopTrajectory();
     placeParticles();
   }
 
@@ -102,9 +315,186 @@ class Renderer {
 
   void setPause(bool pause) { this->pause = pause; }
 
+  uint32_t getSeed() const { return seed; }
+  void setSeed(uint32_t seed) { this->seed = seed; }
+
   glm::vec3 getBaseColor() const { return baseColor; }
   void setBaseColor(const glm::vec3& baseColor) { this->baseColor = baseColor; }
 
+  ForceFieldMode getForceFieldMode() const { return forceFieldMode; }
+  void setForceFieldMode(const ForceFieldMode& forceFieldMode) {
+    this->forceFieldMode = forceFieldMode;
+  }
+
+  std::size_t getNumberOfForceSources() const {
+    return forceField.getNumberOfSources();
+  }
+
+  void placeForceSources(uint32_t n, float strength) {
+    forceField.placeRandom(n, strength);
+  }
+
+  const ForceSource& getForceSource(uint32_t index) const {
+    return forceField.getSource(index);
+  }
+  void setForceSource(uint32_t index, const ForceSource& source) {
+    forceField.setSource(index, source);
+  }
+
+  uint32_t getNumberOfAnimatedSources() const { return nAnimatedSources; }
+  void setNumberOfAnimatedSources(uint32_t nAnimatedSources) {
+    this->nAnimatedSources = nAnimatedSources;
+  }
+
+  // random walk of a few sources
+  void animateForceSources() {
+    const std::size_t n_sources = forceField.getNumberOfSources();
+    if (n_sources == 0) {
+      return;
+    }
+
+    std::uniform_real_distribution<float> dist(-1, 1);
+    for (uint32_t i = 0; i < nAnimatedSources; ++i) {
+      const uint32_t index = animationRng() % n_sources;
+      ForceSource source = forceField.getSource(index);
+      source.position +=
+          glm::vec4(0.01f * glm::vec3(dist(animationRng), dist(animationRng),
+                                      dist(animationRng)),
+                    0);
+      forceField.setSource(index, source);
+    }
+  }
+
+  bool getEnableSph() const { return enableSph; }
+  void setEnableSph(bool enableSph) { this->enableSph = enableSph; }
+
+  float getSphSmoothingLength() const { return sph.getSmoothingLength(); }
+  void setSphSmoothingLength(float smoothingLength) {
+    sph.setSmoothingLength(smoothingLength);
+  }
+
+  float getSphRestDensity() const { return sph.getRestDensity(); }
+  void setSphRestDensity(float restDensity) {
+    sph.setRestDensity(restDensity);
+  }
+
+  float getSphStiffness() const { return sph.getStiffness(); }
+  void setSphStiffness(float stiffness) { sph.setStiffness(stiffness); }
+
+  float getSphViscosity() const { return sph.getViscosity(); }
+  void setSphViscosity(float viscosity) { sph.setViscosity(viscosity); }
+
+  bool getEnableEmitters() const { return enableEmitters; }
+  void setEnableEmitters(bool enableEmitters) {
+    this->enableEmitters = enableEmitters;
+    if (enableEmitters && emitters.getNumberOfEmitters() == 0) {
+      emitters.addEmitter(Emitter());
+    }
+    placeParticles();
+  }
+
+  std::size_t getNumberOfEmitters() const {
+    return emitters.getNumberOfEmitters();
+  }
+
+  const Emitter& getEmitter(uint32_t index) const {
+    return emitters.getEmitter(index);
+  }
+  uint32_t addEmitter(const Emitter& emitter) {
+    return emitters.addEmitter(emitter);
+  }
+  void setEmitter(uint32_t index, const Emitter& emitter) {
+    emitters.setEmitter(index, emitter);
+  }
+  void removeEmitter(uint32_t index) { emitters.removeEmitter(index); }
+
+  bool getEnableOutOfCore() const { return enableOutOfCore; }
+  void setEnableOutOfCore(bool enableOutOfCore) {
+    this->enableOutOfCore = enableOutOfCore;
+    stopTrajectory();
+    placeParticles();
+  }
+
+  bool getOutOfCoreMapped() const { return outOfCoreMapped; }
+  // takes effect when particles are placed again
+  void setOutOfCoreMapped(bool outOfCoreMapped) {
+    this->outOfCoreMapped = outOfCoreMapped;
+  }
+
+  uint32_t getOutOfCoreChunkLength() const {
+    return outOfCore.getChunkLength();
+  }
+  // takes effect when particles are placed again
+  void setOutOfCoreChunkLength(uint32_t chunkLength) {
+    outOfCore.setChunkLength(chunkLength);
+  }
+
+  double getOutOfCoreStepTime() const { return outOfCore.getStepTime(); }
+  double getOutOfCoreBandwidth() const { return outOfCore.getBandwidth(); }
+
+  bool getEnableEnsemble() const { return enableEnsemble; }
+  void setEnableEnsemble(bool enableEnsemble) {
+    this->enableEnsemble = enableEnsemble;
+    if (enableEnsemble) {
+      resetEnsemble();
+    }
+  }
+
+  const Ensemble& getEnsemble() const { return ensemble; }
+
+  // n members of nParticles particles with parameters evenly spaced between
+  // first and last and seeds from the current one on
+  void sweepEnsemble(uint32_t n, uint32_t nParticles, EnsembleMember first,
+                     const EnsembleMember& last) {
+    first.seed = seed;
+    ensemble.setNumberOfParticles(nParticles);
+    ensemble.sweep(n, first, last);
+    resetEnsemble();
+  }
+
+  void resetEnsemble() {
+    ensemble.reset();
+    ensembleParticles.setParticles(&ensemble.getParticles());
+  }
+
+  uint32_t getEnsembleMember() const { return ensemble.getDrawnMember(); }
+  void setEnsembleMember(uint32_t member) { ensemble.setDrawnMember(member); }
+
+  uint32_t getReorderInterval() const { return reorderInterval; }
+  void setReorderInterval(uint32_t reorderInterval) {
+    this->reorderInterval = reorderInterval;
+  }
+
+  uint32_t getReorderBits() const { return mortonReorder.getBits(); }
+  void setReorderBits(uint32_t bits) { mortonReorder.setBits(bits); }
+
+  const ReorderReport& getReorderReport() const { return reorderReport; }
+
+  bool isRecordingTrajectory() const { return trajectory.isRecording(); }
+
+  void startTrajectory(const std::filesystem::path& filepath) {
+    if (enableOutOfCore) {
+      return;
+    }
+    slotsBuffer.allocate<GLuint>(nParticles, GL_DYNAMIC_COPY);
+    trajectory.start(filepath, nParticles,
+                     sizeof(Particle) / sizeof(glm::vec4));
+  }
+
+  void stopTrajectory() { trajectory.stop(); }
+
+  uint64_t getNumberOfRecordedFrames() const {
+    return trajectory.getNumberOfRecordedFrames();
+  }
+
+  uint32_t getTrajectoryInterval() const { return trajectoryInterval; }
+  void setTrajectoryInterval(uint32_t trajectoryInterval) {
+    this->trajectoryInterval = std::max(trajectoryInterval, 1u);
+  }
+
+  uint32_t getTrajectoryBits() const { return trajectory.getBits(); }
+  void setTrajectoryBits(uint32_t bits) { trajectory.setBits(bits); }
+
   glm::vec3 screenToWorld(const glm::vec2& screen) const {
     glm::vec3 origin, direction;
     camera.getRay(screen, resolution, origin, direction);
@@ -116,19 +506,38 @@ class Renderer {
     return p;
   }
 
+  // generate particles on the GPU, or on the CPU for out-of-core particles.
+  // the same seed gives the same particles.
   void placeParticles() {
-    std::random_device rnd_dev;
-    std::mt19937 mt(rnd_dev());
-    std::uniform_real_distribution<float> dist(-1, 1);
-
-    std::vector<Particle> data(nParticles);
-    for (std::size_t i = 0; i < nParticles; ++i) {
-      data[i].position = 0.5f * glm::vec4(dist(mt), dist(mt), dist(mt), 0);
-      data[i].velocity = glm::vec4(0);
-      data[i].mass = 1.0f;
+    if (enableOutOfCore) {
+      particlesBuffer.allocate<Particle>(0, GL_DYNAMIC_DRAW);
+      emitters.resize(0);
+      outOfCore.place(nParticles, seed,
+                      outOfCoreMapped ? std::filesystem::path("particles.ooc")
+                                      : std::filesystem::path());
+      particles.setParticles(&outOfCore.getPreview());
+      return;
     }
+    outOfCore.release();
+    particles.setParticles(&particlesBuffer);
+
+    particlesBuffer.allocate<Particle>(nParticles, GL_DYNAMIC_DRAW);
+    emitters.resize(nParticles);
+    emitters.beginUpdate();
+
+    // with emitters every slot starts dead
+    const float lifetime =
+        enableEmitters ? 0.0f : std::numeric_limits<float>::infinity();
+
+    particlesBuffer.bindToShaderStorageBuffer(0);
+    placeParticlesShader.setUniform("nParticles", nParticles);
+    placeParticlesShader.setUniform("seed", seed);
+    placeParticlesShader.setUniform("lifetime", lifetime);
+    placeParticlesPipeline.activate();
+    glDispatchCompute(std::ceil(nParticles / 128.0f), 1, 1);
+    placeParticlesPipeline.deactivate();
 
-    particlesBuffer.setData(data, GL_DYNAMIC_DRAW);
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
   }
 
   void move(const CameraMovement& movement_direction, float delta_time) {
@@ -139,33 +548,81 @@ class Renderer {
     camera.lookAround(d_phi, d_theta);
   }
 
+  // members of an ensemble are drawn as points and advance every frame
+  void renderEnsemble() {
+    const glm::mat4 view_projection =
+        camera.computeViewProjectionmatrix(resolution.x, resolution.y);
+    glClear(GL_COLOR_BUFFER_BIT);
+    glViewport(0, 0, resolution.x, resolution.y);
+    vertexShader.setUniform("viewProjection", view_projection);
+    fragmentShader.setUniform("baseColor", baseColor);
+    ensembleParticles.draw(renderPipeline, ensemble.getDrawList());
+
+    if (!pause) {
+      ensemble.update(true);
+    }
+    ensemble.poll();
+  }
+
   void render(float delta_time) {
+    if (enableEnsemble) {
+      renderEnsemble();
+      return;
+    }
+
+    elapsed_time += delta_time;
+    const bool update = elapsed_time > dt && !pause;
+    const bool reorder_due = update && !enableOutOfCore &&
+                             reorderInterval > 0 &&
+                             (step + 1) % reorderInterval == 0;
+
+    // the cost of a reorder is measured separately from the steps it speeds
+    // up
+    const bool time_frame = update && !reorder_due;
+    if (time_frame) {
+      frameTimer.begin();
+    }
+
     glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
 
     // render particles
-    vertexShader.setUniform(
-        "viewProjection",
-        camera.computeViewProjectionmatrix(resolution.x, resolution.y));
-    fragmentShader.setUniform("baseColor", baseColor);
+    const glm::mat4 view_projection =
+        camera.computeViewProjectionmatrix(resolution.x, resolution.y);
     glClear(GL_COLOR_BUFFER_BIT);
     glViewport(0, 0, resolution.x, resolution.y);
-    particles.draw(renderPipeline);
+    if (renderMode == RenderMode::SPLATTING) {
+      splatter.getProjectShader().setUniform("viewProjection", view_projection);
+      splatter.getProjectShader().setUniform("baseColor", baseColor);
+      if (enableOutOfCore) {
+        splatter.render(outOfCore.getPreview(), outOfCore.getPreviewLength());
+      } else {
+        splatter.render(particlesBuffer, nParticles);
+      }
+    } else {
+      vertexShader.setUniform("viewProjection", view_projection);
+      fragmentShader.setUniform("baseColor", baseColor);
+      particles.draw(renderPipeline, enableOutOfCore
+                                         ? outOfCore.getPreviewList()
+                                         : emitters.getAliveList());
+    }
 
     // update particles
-    elapsed_time += delta_time;
-    if (elapsed_time > dt && !pause) {
+    if (update) {
       elapsed_time = 0;
 
-      particlesBuffer.bindToShaderStorageBuffer(0);
-      updateParticles.setUniform("gravityCenter", gravityCenter);
-      updateParticles.setUniform("gravityIntensity", gravityIntensity);
-      updateParticles.setUniform("increaseK", increaseK);
-      updateParticles.setUniform("k", k);
-      updateParticles.setUniform("dt", dt);
-      updateParticlesPipeline.activate();
-      glDispatchCompute(std::ceil(nParticles / 128.0f), 1, 1);
-      updateParticlesPipeline.deactivate();
+      if (enableOutOfCore) {
+        stepOutOfCore();
+      } else {
+        stepInCore(reorder_due);
+      }
+      step++;
+    }
+    trajectory.poll();
+
+    if (time_frame) {
+      frameTimer.end();
     }
+    pollReorderTimers(reorder_due);
   }
 };
 
@@ -0,0 +1,156 @@
+#ifndef _SPH_H
+#define _SPH_H
+#include <cmath>
+#include <filesystem>
+#include <vector>
+
+#include "glad/gl.h"
+#include "glm/glm.hpp"
+//
+#include "gcss/buffer.h"
+#include "gcss/scan.h"
+#include "gcss/shader.h"
+//
+#include "particles.h"
+
+using namespace gcss;
+
+// smoothed particle hydrodynamics. a spatial hash grid is rebuilt every step
+// with a counting sort, and particles are reordered by bucket so that density
+// and pressure passes read neighbors of the 27 surrounding cells from
+// contiguous memory. particle indices are not stable across steps, ids of
+// particles are.
+class Sph {
+ private:
+  // same as HASH_GRID_SIZE in sph.glsl
+  static constexpr uint32_t HASH_GRID_SIZE = 64;
+  // the last one holds dead particles
+  static constexpr uint32_t N_BUCKETS =
+      HASH_GRID_SIZE * HASH_GRID_SIZE * HASH_GRID_SIZE + 1;
+
+  float smoothingLength;
+  float restDensity;
+  float stiffness;
+  float viscosity;
+
+  ComputeShader countParticles;
+  Pipeline countParticlesPipeline;
+  ExclusiveScan scan;
+  ComputeShader scatterParticles;
+  Pipeline scatterParticlesPipeline;
+  ComputeShader computeDensity;
+  Pipeline computeDensityPipeline;
+  ComputeShader computeForces;
+  Pipeline computeForcesPipeline;
+
+  Buffer cellCounts;
+  Buffer cellOffsets;
+  Buffer particleCells;
+  Buffer sortedParticles;
+  Buffer densities;
+  Buffer accelerations;
+
+  static std::filesystem::path getShaderPath(const std::string& filename) {
+    return std::filesystem::path(CMAKE_CURRENT_SOURCE_DIR) / "shaders" /
+           "sph" / filename;
+  }
+
+  void setUniforms(const ComputeShader& shader, uint32_t nParticles) const {
+    shader.setUniform("nParticles", nParticles);
+    shader.setUniform("smoothingLength", smoothingLength);
+    shader.setUniform("restDensity", restDensity);
+    shader.setUniform("stiffness", stiffness);
+    shader.setUniform("viscosity", viscosity);
+  }
+
+  void dispatch(const Pipeline& pipeline, uint32_t nParticles) const {
+    pipeline.activate();
+    glDispatchCompute(std::ceil(nParticles / 128.0f), 1, 1);
+    pipeline.deactivate();
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+  }
+
+ public:
+  Sph()
+      : smoothingLength{0.02f},
+        restDensity{1000000.0f},
+        stiffness{0.5f},
+        viscosity{0.0005f},
+        countParticles{getShaderPath("count-particles.comp")},
+        scatterParticles{getShaderPath("scatter-particles.comp")},
+        computeDensity{getShaderPath("compute-density.comp")},
+        computeForces{getShaderPath("compute-forces.comp")} {
+    countParticlesPipeline.attachComputeShader(countParticles);
+    scatterParticlesPipeline.attachComputeShader(scatterParticles);
+    computeDensityPipeline.attachComputeShader(computeDensity);
+    computeForcesPipeline.attachComputeShader(computeForces);
+
+    cellCounts.setData(std::vector<GLuint>(N_BUCKETS), GL_DYNAMIC_COPY);
+    cellOffsets.setData(std::vector<GLuint>(N_BUCKETS + 1), GL_DYNAMIC_COPY);
+  }
+
+  float getSmoothingLength() const { return smoothingLength; }
+  void setSmoothingLength(float smoothingLength) {
+    this->smoothingLength = smoothingLength;
+  }
+
+  // mass per unit volume, particles have unit mass
+  float getRestDensity() const { return restDensity; }
+  void setRestDensity(float restDensity) { this->restDensity = restDensity; }
+
+  float getStiffness() const { return stiffness; }
+  void setStiffness(float stiffness) { this->stiffness = stiffness; }
+
+  float getViscosity() const { return viscosity; }
+  void setViscosity(float viscosity) { this->viscosity = viscosity; }
+
+  // reorder particles by bucket and compute accelerations from pressure and
+  // viscosity
+  void update(const Buffer& particles, uint32_t nParticles) {
+    if (sortedParticles.getLength() < nParticles) {
+      particleCells.setData(std::vector<glm::uvec2>(nParticles),
+                            GL_DYNAMIC_COPY);
+      sortedParticles.setData(std::vector<Particle>(nParticles),
+                              GL_DYNAMIC_COPY);
+      densities.setData(std::vector<glm::vec2>(nParticles), GL_DYNAMIC_COPY);
+      accelerations.setData(std::vector<glm::vec4>(nParticles),
+                            GL_DYNAMIC_COPY);
+    }
+
+    // counting sort by bucket
+    cellCounts.clear();
+    particles.bindToShaderStorageBuffer(0);
+    cellCounts.bindToShaderStorageBuffer(2);
+    particleCells.bindToShaderStorageBuffer(3);
+    setUniforms(countParticles, nParticles);
+    dispatch(countParticlesPipeline, nParticles);
+
+    scan.run(cellCounts, cellOffsets, N_BUCKETS);
+
+    particles.bindToShaderStorageBuffer(0);
+    sortedParticles.bindToShaderStorageBuffer(1);
+    cellOffsets.bindToShaderStorageBuffer(2);
+    particleCells.bindToShaderStorageBuffer(3);
+    scatterParticles.setUniform("nParticles", nParticles);
+    dispatch(scatterParticlesPipeline, nParticles);
+
+    // the integrator updates particles in sorted order
+    glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+    particles.copySubData<Particle>(sortedParticles, 0, 0, nParticles);
+
+    particles.bindToShaderStorageBuffer(0);
+    cellOffsets.bindToShaderStorageBuffer(2);
+    densities.bindToShaderStorageBuffer(4);
+    setUniforms(computeDensity, nParticles);
+    dispatch(computeDensityPipeline, nParticles);
+
+    accelerations.bindToShaderStorageBuffer(5);
+    setUniforms(computeForces, nParticles);
+    dispatch(computeForcesPipeline, nParticles);
+  }
+
+  // bind accelerations for update-particles.comp
+  void bind() const { accelerations.bindToShaderStorageBuffer(6); }
+};
+
+#endif
@@ -0,0 +1,127 @@
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+
+#include "spdlog/spdlog.h"
+//
+#include "gcss/shared-frame.h"
+
+using namespace gcss;
+
+// attaches to frames exported by a sandbox and prints a summary of every new
+// one, computed in place in shared memory
+//
+// shared-frame-reader --name /gcss-n-body --frames 100
+// shared-frame-reader --name /gcss-life-game --interval 1000
+
+struct Options {
+  std::string name = "/gcss-n-body";
+  // polling interval in milliseconds
+  int interval = 100;
+  // 0: until interrupted
+  uint64_t nFrames = 0;
+};
+
+static Options parseOptions(int argc, char** argv) {
+  Options options;
+  for (int i = 1; i < argc; ++i) {
+    const std::string arg = argv[i];
+    const bool has_value = i + 1 < argc;
+    if (arg == "--name" && has_value) {
+      options.name = argv[++i];
+    } else if (arg == "--interval" && has_value) {
+      options.interval = std::max(std::atoi(argv[++i]), 1);
+    } else if (arg == "--frames" && has_value) {
+      options.nFrames = std::max(std::atoi(argv[++i]), 0);
+    } else {
+      spdlog::warn("unknown option {}", arg);
+    }
+  }
+  return options;
+}
+
+// elements of at least 3 floats are taken as particles starting with their
+// position, smaller ones as grid cells
+static std::string summarize(const SharedFrameInfo& info,
+                             const std::byte* data) {
+  const uint64_t n_elements =
+      info.elementSize > 0 ? info.size / info.elementSize : 0;
+
+  if (info.elementSize >= 3 * sizeof(float) &&
+      info.elementSize % sizeof(float) == 0) {
+    double center[3] = {0, 0, 0};
+    for (uint64_t i = 0; i < n_elements; ++i) {
+      float position[3];
+      std::memcpy(position, data + i * info.elementSize, sizeof(position));
+      for (int j = 0; j < 3; ++j) {
+        center[j] += position[j];
+      }
+    }
+    for (int j = 0; j < 3; ++j) {
+      center[j] /= std::max<uint64_t>(n_elements, 1);
+    }
+    return fmt::format("{} particles, center ({:.4f}, {:.4f}, {:.4f})",
+                       n_elements, center[0], center[1], center[2]);
+  }
+
+  uint64_t n_nonzero = 0;
+  for (uint64_t i = 0; i < n_elements; ++i) {
+    const std::byte* element = data + i * info.elementSize;
+    for (uint32_t j = 0; j < info.elementSize; ++j) {
+      if (element[j] != std::byte{0}) {
+        n_nonzero++;
+        break;
+      }
+    }
+  }
+  return fmt::format("{}x{}x{} cells, {} nonzero", info.dims[0], info.dims[1],
+                     info.dims[2], n_nonzero);
+}
+
+int main(int argc, char** argv) {
+  const Options options = parseOptions(argc, argv);
+
+  SharedFrameReader reader;
+  uint64_t last_frame = 0;
+  uint64_t n_frames = 0;
+  while (options.nFrames == 0 || n_frames < options.nFrames) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(options.interval));
+
+    // wait for the publisher, and follow it when it moves to a new object
+    if (reader.isClosed()) {
+      if (!reader.open(options.name)) {
+        continue;
+      }
+      last_frame = 0;
+      spdlog::info("attached to {} ({})", options.name, reader.getLayout());
+    }
+
+    if (reader.getLatestFrame() == last_frame) {
+      continue;
+    }
+
+    SharedFrameInfo frame_info;
+    std::string summary;
+    const bool complete =
+        reader.read([&](const SharedFrameInfo& info, const std::byte* data) {
+          frame_info = info;
+          summary = summarize(info, data);
+        });
+    if (!complete) {
+      spdlog::warn("frame was overwritten while reading");
+      continue;
+    }
+
+    if (last_frame > 0 && frame_info.frame > last_frame + 1) {
+      spdlog::info("skipped {} frames", frame_info.frame - last_frame - 1);
+    }
+    spdlog::info("frame {}, step {}: {}", frame_info.frame, frame_info.step,
+                 summary);
+    last_frame = frame_info.frame;
+    n_frames++;
+  }
+
+  return 0;
+}
@@ -0,0 +1,52 @@
+// bounding box of particle positions, reduced in each workgroup and then
+// across workgroups with atomics. a shader including this defines
+// mergeBounds, which merges the box of a workgroup into its buffer.
+layout(local_size_x = 128) in;
+
+layout(std430, binding = 0) readonly buffer layout_particles {
+  vec4 particles[];
+};
+
+uniform uint nParticles;
+// distance between particle positions in vec4s
+uniform uint stride;
+
+shared vec3 local_min[128];
+shared vec3 local_max[128];
+
+// map float to uint preserving order, so that atomicMin/Max can be used
+uint orderedBits(float f) {
+  uint u = floatBitsToUint(f);
+  return (u & 0x80000000u) != 0u ? ~u : u | 0x80000000u;
+}
+
+// ordered bits of the box of a workgroup along an axis
+void mergeBounds(int axis, uint minBits, uint maxBits);
+
+void main() {
+  uint gidx = gl_GlobalInvocationID.x;
+  uint lidx = gl_LocalInvocationIndex;
+
+  const float INF = 3.402823e38;
+  vec3 position = gidx < nParticles ? particles[gidx * stride].xyz : vec3(INF);
+  local_min[lidx] = position;
+  local_max[lidx] = gidx < nParticles ? position : vec3(-INF);
+  barrier();
+
+  // reduce in workgroup
+  for (uint s = gl_WorkGroupSize.x / 2; s > 0; s >>= 1) {
+    if (lidx < s) {
+      local_min[lidx] = min(local_min[lidx], local_min[lidx + s]);
+      local_max[lidx] = max(local_max[lidx], local_max[lidx + s]);
+    }
+    barrier();
+  }
+
+  // reduce across workgroups
+  if (lidx == 0) {
+    for (int i = 0; i < 3; ++i) {
+      mergeBounds(i, orderedBits(local_min[0][i]),
+                  orderedBits(local_max[0][i]));
+    }
+  }
+}
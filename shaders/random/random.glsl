@@ -0,0 +1,28 @@
+// counter based random numbers, same streams as gcss::Random in
+// include/gcss/random.h
+
+// PCG hash, Jarzynski and Olano 2020
+uint pcgHash(uint x) {
+  uint state = x * 747796405u + 2891336453u;
+  uint word = ((state >> ((state >> 28u) + 4u)) ^ state) * 277803737u;
+  return (word >> 22u) ^ word;
+}
+
+struct Random {
+  uint key;
+  uint counter;
+};
+
+// index selects the stream, e.g. one per particle
+Random createRandom(uint seed, uint index) {
+  return Random(pcgHash(pcgHash(seed) + index), 0u);
+}
+
+uint nextUint(inout Random rng) {
+  return pcgHash(rng.key ^ pcgHash(rng.counter++));
+}
+
+// [0, 1) in multiples of 2^-24
+float nextFloat(inout Random rng) {
+  return float(nextUint(rng) >> 8) / 16777216.0;
+}
@@ -0,0 +1,48 @@
+// exclusive prefix sum over many workgroups, reduce then scan. each
+// workgroup covers a block of BLOCK_SIZE elements, ITEMS contiguous ones per
+// invocation.
+
+const uint WORKGROUP_SIZE = 256;
+const uint ITEMS = 16;
+const uint BLOCK_SIZE = WORKGROUP_SIZE * ITEMS;
+
+uniform uint n;
+
+shared uint sums[WORKGROUP_SIZE];
+
+// elements [begin, end) of an invocation
+uvec2 getItems() {
+  uint begin = min(gl_WorkGroupID.x * BLOCK_SIZE +
+                       gl_LocalInvocationIndex * ITEMS,
+                   n);
+  return uvec2(begin, min(begin + ITEMS, n));
+}
+
+// sum of value over the workgroup in sums[0]
+void reduceWorkgroup(uint value) {
+  uint lidx = gl_LocalInvocationIndex;
+  sums[lidx] = value;
+  barrier();
+
+  for (uint stride = WORKGROUP_SIZE / 2; stride > 0; stride /= 2) {
+    if (lidx < stride) {
+      sums[lidx] += sums[lidx + stride];
+    }
+    barrier();
+  }
+}
+
+// Hillis-Steele inclusive scan of value over the workgroup
+uint scanWorkgroup(uint value) {
+  uint lidx = gl_LocalInvocationIndex;
+  sums[lidx] = value;
+  barrier();
+
+  for (uint offset = 1; offset < WORKGROUP_SIZE; offset *= 2) {
+    uint other = lidx >= offset ? sums[lidx - offset] : 0;
+    barrier();
+    sums[lidx] += other;
+    barrier();
+  }
+  return sums[lidx];
+}
@@ -0,0 +1,17 @@
+// stable LSD radix sort of uvec2 keys, 4 bits per pass. each workgroup sorts
+// a block of keys in chunks of one key per invocation.
+
+const uint RADIX_BITS = 4;
+const uint RADIX = 1 << RADIX_BITS;
+const uint WORKGROUP_SIZE = 256;
+const uint BLOCK_SIZE = 1024;
+
+uniform uint n;
+uniform uint nBlocks;
+// position of the digit of this pass
+uniform uint shift;
+
+uint getDigit(uvec2 key) {
+  uint word = shift < 32 ? key.x : key.y;
+  return (word >> (shift % 32)) & (RADIX - 1);
+}
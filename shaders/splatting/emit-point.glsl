@@ -0,0 +1,20 @@
+// included by the projection shader of each sandbox, which calls emitPoint
+// once per particle
+#include "splatting.glsl"
+
+// cull points outside of the view frustum, bin the others into screen tiles
+void emitPoint(vec4 clip_position, vec3 color) {
+  if (clip_position.w <= 0.0 ||
+      any(greaterThan(abs(clip_position.xyz), vec3(clip_position.w)))) {
+    return;
+  }
+
+  vec2 ndc = clip_position.xy / clip_position.w;
+  vec2 pixel = clamp((0.5 * ndc + 0.5) * resolution, vec2(0),
+                     resolution - vec2(1e-3));
+
+  uint index = atomicAdd(n_points, 1);
+  points[index].pixel = pixel;
+  points[index].color = packUnorm4x8(vec4(color, 1.0));
+  points[index].local_index = atomicAdd(tile_counts[getTile(pixel)], 1);
+}
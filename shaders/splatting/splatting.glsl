@@ -0,0 +1,33 @@
+// shared by the passes of point splatting
+
+const uint TILE_SIZE = 16;
+
+struct ProjectedPoint {
+  // position in pixels
+  vec2 pixel;
+  // packUnorm4x8 of color
+  uint color;
+  // index within its tile
+  uint local_index;
+};
+
+layout(std430, binding = 4) buffer layout_splat_header {
+  uint n_points;
+};
+layout(std430, binding = 5) buffer layout_tile_counts {
+  uint tile_counts[];
+};
+layout(std430, binding = 6) buffer layout_points {
+  ProjectedPoint points[];
+};
+
+uniform vec2 resolution;
+
+uint getNumberOfTilesX() {
+  return (uint(resolution.x) + TILE_SIZE - 1) / TILE_SIZE;
+}
+
+uint getTile(vec2 pixel) {
+  uvec2 tile = uvec2(pixel) / TILE_SIZE;
+  return tile.x + getNumberOfTilesX() * tile.y;
+}